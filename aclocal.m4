@@ -1895,6 +1895,7 @@ m4_include([auxdir/x_ac_json.m4])
 m4_include([auxdir/x_ac_jwt.m4])
 m4_include([auxdir/x_ac_lua.m4])
 m4_include([auxdir/x_ac_lz4.m4])
+m4_include([auxdir/x_ac_zstd.m4])
 m4_include([auxdir/x_ac_man2html.m4])
 m4_include([auxdir/x_ac_munge.m4])
 m4_include([auxdir/x_ac_netloc.m4])
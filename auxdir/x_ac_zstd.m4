@@ -0,0 +1,86 @@
+##*****************************************************************************
+#  AUTHOR:
+#    Slurm development team
+#
+#  SYNOPSIS:
+#    X_AC_ZSTD
+#
+#  DESCRIPTION:
+#    Test if we have libzstd installed. If found define appropriate ENVs.
+#
+##*****************************************************************************
+
+AC_DEFUN([X_AC_ZSTD],
+#
+# Handle user hints
+#
+[AC_MSG_CHECKING(if zstd is wanted)
+zstd_places="/usr/local /usr /opt/local /sw"
+AC_ARG_WITH([zstd],
+[  --with-zstd=PATH        Specify path to libzstd installation],
+[AS_IF([test "x$with_zstd" != xno && test "x$with_zstd" != xyes],
+       [zstd_places="$with_zstd"; AC_MSG_RESULT([yes])],
+       [AC_MSG_RESULT([no])])])
+
+#
+# Locate zstd, if installed
+#
+if [test "x$with_zstd" = xno]; then
+  AC_MSG_WARN([support for zstd disabled])
+else
+  # check the user supplied or any other more or less 'standard' place:
+  #   Most UNIX systems      : /usr/local and /usr
+  #   MacPorts / Fink on OSX : /opt/local respectively /sw
+  HAVE_ZSTD=0
+  for ZSTD_HOME in ${zstd_places} ; do
+    test -f "${ZSTD_HOME}/include/zstd.h" || continue
+
+    ZSTD_OLD_LDFLAGS=$LDFLAGS
+    ZSTD_OLD_CPPFLAGS=$CPPFLAGS
+    if test -n "${ZSTD_HOME}"; then
+      ZSTD_CPPFLAGS="-I${ZSTD_HOME}/include"
+      ZSTD_LDFLAGS="-L${ZSTD_HOME}/lib"
+      ZSTD_LIBS="-lzstd"
+
+      LDFLAGS="$LDFLAGS ${ZSTD_LDFLAGS}"
+      CPPFLAGS="$CPPFLAGS ${ZSTD_CPPFLAGS}"
+    fi
+    AC_LANG_SAVE
+    AC_LANG([C])
+    AC_CHECK_LIB([zstd], [ZSTD_compress], [ac_cv_zstd=yes], [ac_cv_zstd=no])
+    AC_CHECK_HEADER([zstd.h], [ac_cv_zstd_h=yes], [ac_cv_zstd_h=no])
+    AC_LANG_RESTORE
+
+    # Restore variables
+    LDFLAGS="$ZSTD_OLD_LDFLAGS"
+    CPPFLAGS="$ZSTD_OLD_CPPFLAGS"
+
+    if [ test "$ac_cv_zstd" = "yes" && test "$ac_cv_zstd_h" = "yes" ]; then
+        #
+        # If both library and header were found, action-if-found
+        #
+        AC_SUBST(ZSTD_CPPFLAGS)
+        AC_SUBST(ZSTD_LDFLAGS)
+        AC_SUBST(ZSTD_LIBS)
+        AC_DEFINE([HAVE_ZSTD], [1],
+                  [Define to 1 if you have 'zstd' library (-lzstd)])
+        AC_MSG_RESULT([ZSTD test program built properly.])
+        HAVE_ZSTD=1
+        break
+    else
+        AC_MSG_RESULT([ZSTD test program build failed.])
+    fi
+  done
+
+  if [test "$HAVE_ZSTD" != 1]; then
+    if [test -z "$with_zstd"]; then
+      AC_MSG_WARN([unable to locate working zstd installation])
+    else
+      AC_MSG_ERROR([unable to locate working zstd installation])
+    fi
+  fi
+
+
+fi
+
+])
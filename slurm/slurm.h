@@ -2086,6 +2086,8 @@ typedef struct {
 	/* START - only used if user_managed_io is false */
 	bool buffered_stdio;
 	bool labelio;
+	bool io_coalesce;	/* coalesce stdout/err into larger frames */
+	uint16_t io_compress;	/* compression of coalesced frames */
 	char *remote_output_filename;
 	char *remote_error_filename;
 	char *remote_input_filename;
@@ -246,6 +246,7 @@ typedef enum {
 	ESLURM_JOB_TIMEOUT_KILLED,
 	ESLURM_JOB_NODE_FAIL_KILLED,
 	ESLURM_EMPTY_LIST,
+	ESLURM_NODE_REG_STALE,
 
 	/* SPANK errors */
 	ESPANK_ERROR = 					3000,
@@ -286,6 +287,7 @@ typedef enum {
 	ESLURMD_CONTAINER_RUNTIME_INVALID,
 	ESLURMD_CPU_BIND_ERROR,
 	ESLURMD_CPU_LAYOUT_ERROR,
+	ESLURMD_BCAST_CACHE_MISS,
 
 	/* socket specific Slurm communications error */
 	ESLURM_PROTOCOL_INCOMPLETE_PACKET = 5003,
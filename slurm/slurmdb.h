@@ -208,6 +208,11 @@ enum cluster_fed_states {
 						    */
 #define JOBCOND_FLAG_SCRIPT           SLURM_BIT(8) /* Get batch script only */
 #define JOBCOND_FLAG_ENV              SLURM_BIT(9) /* Get job's env only */
+#define JOBCOND_FLAG_STREAM           SLURM_BIT(10) /* Send jobs back in
+						     * chunks as they are read,
+						     * set by
+						     * slurmdb_jobs_get_stream()
+						     */
 
 /* Archive / Purge time flags */
 #define SLURMDB_PURGE_BASE    0x0000ffff   /* Apply to get the number
@@ -251,6 +256,8 @@ enum cluster_fed_states {
 /* Flags for slurmdbd_conn->db_conn */
 #define DB_CONN_FLAG_CLUSTER_DEL SLURM_BIT(0)
 #define DB_CONN_FLAG_ROLLBACK SLURM_BIT(1)
+#define DB_CONN_FLAG_REPLICA SLURM_BIT(2)
+#define DB_CONN_FLAG_USAGE_CHANGED SLURM_BIT(3)
 
 /********************************************/
 
@@ -339,6 +346,9 @@ typedef struct {
 	List wckey_list;	/* list of char * */
 } slurmdb_job_cond_t;
 
+/* Called with each chunk of jobs handed back by slurmdb_jobs_get_stream() */
+typedef int (*slurmdb_job_stream_cb_t) (List job_list, void *arg);
+
 /* slurmdb_stats_t needs to be defined before slurmdb_job_rec_t and
  * slurmdb_step_rec_t.
  */
@@ -1365,6 +1375,18 @@ typedef struct {
 } slurmdb_rpc_obj_t;
 
 typedef struct {
+	uint64_t cnt;		/* times the statement was executed */
+	char *name;		/* name of the statement */
+	uint64_t prepare_cnt;	/* times it was not in the statement cache */
+	uint64_t time;		/* total usecs executing this statement */
+	uint64_t time_max;	/* longest usecs executing this statement */
+} slurmdb_stmt_stats_t;
+
+typedef struct {
+	uint64_t batch_cnt;		/* DBD_SEND_MULT_MSG transactions */
+	uint64_t batch_records;		/* messages in those transactions */
+	uint64_t batch_time;		/* total usecs of those transactions */
+	List stmt_stats;		/* list of slurmdb_stmt_stats_t */
 	slurmdb_rollup_stats_t *dbd_rollup_stats;
 	List rollup_stats;              /* List of Clusters rollup stats */
 	List rpc_list;                  /* list of RPCs sent to the dbd. */
@@ -1677,6 +1699,17 @@ extern List slurmdb_job_modify(void *db_conn,
  */
 extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond);
 
+/*
+ * get info from the storage without building the entire list
+ * IN:  callback - called for each chunk of jobs, a List of slurmdb_job_rec_t *
+ *      in job id order for each cluster. The List is freed when the callback
+ *      returns. If the callback returns anything other than SLURM_SUCCESS it
+ *      will not be called again.
+ * RET: SLURM_SUCCESS on success else error code
+ */
+extern int slurmdb_jobs_get_stream(void *db_conn, slurmdb_job_cond_t *job_cond,
+				   slurmdb_job_stream_cb_t callback, void *arg);
+
 /*
  * Fix runaway jobs
  * IN: jobs, a list of all the runaway jobs
@@ -1867,6 +1900,7 @@ extern void slurmdb_destroy_report_acct_grouping(void *object);
 extern void slurmdb_destroy_report_cluster_grouping(void *object);
 extern void slurmdb_destroy_rpc_obj(void *object);
 extern void slurmdb_destroy_rollup_stats(void *object);
+extern void slurmdb_destroy_stmt_stats(void *object);
 extern void slurmdb_free_stats_rec_members(void *object);
 extern void slurmdb_destroy_stats_rec(void *object);
 
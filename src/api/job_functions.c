@@ -70,6 +70,20 @@ extern List slurmdb_jobs_get(void *db_conn, slurmdb_job_cond_t *job_cond)
 	return jobacct_storage_g_get_jobs_cond(db_conn, db_api_uid, job_cond);
 }
 
+/*
+ * get info from the storage a chunk at a time
+ * RET: SLURM_SUCCESS on success else error code
+ */
+extern int slurmdb_jobs_get_stream(void *db_conn, slurmdb_job_cond_t *job_cond,
+				   slurmdb_job_stream_cb_t callback, void *arg)
+{
+	if (db_api_uid == -1)
+		db_api_uid = getuid();
+
+	return jobacct_storage_g_get_jobs_stream(db_conn, db_api_uid, job_cond,
+						 callback, arg);
+}
+
 /*
  * Fix runaway jobs
  * IN: jobs, a list of all the runaway jobs
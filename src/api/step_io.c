@@ -80,7 +80,7 @@ static void	_handle_io_init_msg(int fd, client_io_t *cio);
 static int _read_io_init_msg(int fd, client_io_t *cio, slurm_addr_t *host);
 static int      _wid(int n);
 static bool     _incoming_buf_free(client_io_t *cio);
-static bool     _outgoing_buf_free(client_io_t *cio);
+static bool _outgoing_bufs_free(client_io_t *cio, int count);
 
 /**********************************************************************
  * Listening socket declarations
@@ -112,11 +112,13 @@ struct server_io_info {
 	client_io_t *cio;
 	int node_id;
 	bool testing_connection;
+	uint16_t io_flags;	/* SLURM_IO_FLAG_* negotiated with the node */
 
 	/* incoming variables */
 	struct slurm_io_header header;
 	struct io_buf *in_msg;
 	int32_t in_remaining;
+	List batch_bufs;	/* buffers reserved for the current batch frame */
 	bool in_eof;
 	int remote_stdout_objs; /* active eio_obj_t's on the remote node */
 	int remote_stderr_objs; /* active eio_obj_t's on the remote node */
@@ -218,7 +220,7 @@ _set_listensocks_nonblocking(client_io_t *cio)
  **********************************************************************/
 static eio_obj_t *
 _create_server_eio_obj(int fd, client_io_t *cio, int nodeid,
-		       int stdout_objs, int stderr_objs)
+		       int stdout_objs, int stderr_objs, uint16_t io_flags)
 {
 	eio_obj_t *eio = NULL;
 	struct server_io_info *info = xmalloc(sizeof(*info));
@@ -226,8 +228,10 @@ _create_server_eio_obj(int fd, client_io_t *cio, int nodeid,
 	info->cio = cio;
 	info->node_id = nodeid;
 	info->testing_connection = false;
+	info->io_flags = io_flags;
 	info->in_msg = NULL;
 	info->in_remaining = 0;
+	info->batch_bufs = list_create(NULL);
 	info->in_eof = false;
 	info->remote_stdout_objs = stdout_objs;
 	info->remote_stderr_objs = stderr_objs;
@@ -242,6 +246,27 @@ _create_server_eio_obj(int fd, client_io_t *cio, int nodeid,
 	return eio;
 }
 
+/*
+ * Number of free buffers needed to read the next message from a server. A
+ * batch frame may carry up to SLURM_IO_BATCH_MAX_MSGS messages which all need
+ * a buffer.
+ */
+static int _server_bufs_needed(struct server_io_info *s)
+{
+	if (s->io_flags & SLURM_IO_FLAG_COALESCE)
+		return SLURM_IO_BATCH_MAX_MSGS;
+	return 1;
+}
+
+/* Return the buffers reserved for a batch frame to the free list */
+static void _server_release_batch_bufs(struct server_io_info *s)
+{
+	struct io_buf *msg;
+
+	while ((msg = list_dequeue(s->batch_bufs)))
+		list_enqueue(s->cio->free_outgoing, msg);
+}
+
 static bool
 _server_readable(eio_obj_t *obj)
 {
@@ -249,7 +274,7 @@ _server_readable(eio_obj_t *obj)
 
 	debug4("Called _server_readable");
 
-	if (!_outgoing_buf_free(s->cio)) {
+	if (!_outgoing_bufs_free(s->cio, _server_bufs_needed(s))) {
 		debug4("  false, free_io_buf is empty");
 		return false;
 	}
@@ -282,6 +307,128 @@ _server_readable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * Account for a remote stdout or stderr object having reached eof and shutdown
+ * the i/o channel with the stepd once all of them are gone.
+ */
+static void _server_handle_eof(eio_obj_t *obj, struct server_io_info *s,
+			       uint16_t type)
+{
+	if (type == SLURM_IO_STDOUT) {
+		s->remote_stdout_objs--;
+		debug3("got eof-stdout msg on _server_read header");
+	} else if (type == SLURM_IO_STDERR) {
+		s->remote_stderr_objs--;
+		debug3("got eof-stderr msg on _server_read header");
+	} else
+		error("Unrecognized output message type");
+	/* If all remote eios are gone, shutdown
+	 * the i/o channel with stepd.
+	 */
+	if (s->remote_stdout_objs == 0
+	    && s->remote_stderr_objs == 0) {
+		obj->shutdown = true;
+	}
+}
+
+/*
+ * Route the message to the proper output
+ */
+static void _server_route_msg(struct server_io_info *s, struct io_buf *msg)
+{
+	eio_obj_t *obj;
+	struct file_write_info *info;
+
+	msg->ref_count = 1;
+	if (msg->header.type == SLURM_IO_STDOUT)
+		obj = s->cio->stdout_obj;
+	else
+		obj = s->cio->stderr_obj;
+	info = (struct file_write_info *) obj->arg;
+	if (info->eof)
+		/* this output is closed, discard message */
+		list_enqueue(s->cio->free_outgoing, msg);
+	else
+		list_enqueue(info->msg_queue, msg);
+}
+
+/*
+ * Dispatch the messages carried by a complete SLURM_IO_BATCH frame as if they
+ * had been read from the stepd one at a time.
+ */
+static int _server_read_batch(eio_obj_t *obj, struct server_io_info *s)
+{
+	client_io_t *cio = s->cio;
+	io_hdr_t header;
+	struct io_buf *msg;
+	buf_t *buffer;
+	int raw_len;
+
+	if (!cio->batch_raw)
+		cio->batch_raw = xmalloc(io_batch_raw_size());
+
+	raw_len = io_batch_frame_unpack(cio->batch_frame[s->node_id],
+					s->header.length, cio->batch_raw);
+	if (raw_len < 0) {
+		error("%s: fd %d bad stdio batch frame from node %d",
+		      __func__, obj->fd, s->node_id);
+		if (cio->sls)
+			step_launch_notify_io_failure(cio->sls, s->node_id);
+		if (obj->fd > STDERR_FILENO)
+			close(obj->fd);
+		obj->fd = -1;
+		s->in_eof = true;
+		s->out_eof = true;
+		_server_release_batch_bufs(s);
+		return SLURM_SUCCESS;
+	}
+
+	cio->batch_cnt++;
+	cio->batch_raw_bytes += raw_len;
+	cio->batch_wire_bytes += io_hdr_packed_size() + s->header.length;
+
+	buffer = create_buf(cio->batch_raw, raw_len);
+	while (remaining_buf(buffer)) {
+		if ((io_hdr_unpack(&header, buffer) != SLURM_SUCCESS) ||
+		    (header.length > MAX_MSG_LEN) ||
+		    (header.length > remaining_buf(buffer))) {
+			error("%s: malformed message in stdio batch frame from node %d",
+			      __func__, s->node_id);
+			break;
+		}
+
+		if (header.type == SLURM_IO_CONNECTION_TEST) {
+			if (cio->sls)
+				step_launch_clear_questionable_state(
+					cio->sls, s->node_id);
+			s->testing_connection = false;
+			continue;
+		} else if (header.length == 0) {
+			_server_handle_eof(obj, s, header.type);
+			continue;
+		}
+
+		/* Buffers for the whole frame were reserved with its header */
+		if (!(msg = list_dequeue(s->batch_bufs))) {
+			error("%s: too many messages in stdio batch frame from node %d",
+			      __func__, s->node_id);
+			break;
+		}
+		memcpy(msg->data, get_buf_data(buffer) + get_buf_offset(buffer),
+		       header.length);
+		set_buf_offset(buffer, get_buf_offset(buffer) + header.length);
+		msg->length = header.length;
+		msg->header = header;
+		_server_route_msg(s, msg);
+	}
+	/* free buffer, but not the memory to which it points */
+	buffer->head = NULL;
+	FREE_NULL_BUFFER(buffer);
+	_server_release_batch_bufs(s);
+
+	return SLURM_SUCCESS;
+}
+
 static int
 _server_read(eio_obj_t *obj, List objs)
 {
@@ -291,7 +438,7 @@ _server_read(eio_obj_t *obj, List objs)
 
 	debug4("Entering _server_read");
 	if (s->in_msg == NULL) {
-		if (_outgoing_buf_free(s->cio)) {
+		if (_outgoing_bufs_free(s->cio, _server_bufs_needed(s))) {
 			s->in_msg = list_dequeue(s->cio->free_outgoing);
 		} else {
 			debug("List free_outgoing is empty!");
@@ -334,24 +481,37 @@ _server_read(eio_obj_t *obj, List objs)
 			s->testing_connection = false;
 			return SLURM_SUCCESS;
 
-		} else if (s->header.length == 0) { /* eof message */
-			if (s->header.type == SLURM_IO_STDOUT) {
-				s->remote_stdout_objs--;
-				debug3( "got eof-stdout msg on _server_read "
-					"header");
-			} else if (s->header.type == SLURM_IO_STDERR) {
-				s->remote_stderr_objs--;
-				debug3( "got eof-stderr msg on _server_read "
-					"header");
-			} else
-				error("Unrecognized output message type");
-			/* If all remote eios are gone, shutdown
-			 * the i/o channel with stepd.
-			 */
-			if (s->remote_stdout_objs == 0
-				&& s->remote_stderr_objs == 0) {
-				obj->shutdown = true;
+		} else if (s->header.type == SLURM_IO_BATCH) {
+			if (!(s->io_flags & SLURM_IO_FLAG_COALESCE) ||
+			    (s->header.length >
+			     (io_batch_frame_size() - io_hdr_packed_size()))) {
+				error("%s: fd %d unexpected stdio batch frame of %u bytes",
+				      __func__, obj->fd, s->header.length);
+				if (s->cio->sls)
+					step_launch_notify_io_failure(
+						s->cio->sls, s->node_id);
+				if (obj->fd > STDERR_FILENO)
+					close(obj->fd);
+				obj->fd = -1;
+				s->in_eof = true;
+				s->out_eof = true;
+				list_enqueue(s->cio->free_outgoing, s->in_msg);
+				s->in_msg = NULL;
+				return SLURM_SUCCESS;
 			}
+			if (!s->cio->batch_frame[s->node_id])
+				s->cio->batch_frame[s->node_id] =
+					xmalloc(io_batch_frame_size());
+			/*
+			 * Reserve a buffer for every message the frame may
+			 * carry so that other servers can not take them while
+			 * its body is read.
+			 */
+			for (int i = 1; i < SLURM_IO_BATCH_MAX_MSGS; i++)
+				list_enqueue(s->batch_bufs, list_dequeue(
+					s->cio->free_outgoing));
+		} else if (s->header.length == 0) { /* eof message */
+			_server_handle_eof(obj, s, s->header.type);
 			list_enqueue(s->cio->free_outgoing, s->in_msg);
 			s->in_msg = NULL;
 			return SLURM_SUCCESS;
@@ -365,7 +525,12 @@ _server_read(eio_obj_t *obj, List objs)
 	 * Read the body
 	 */
 	if (s->header.length != 0) {
-		buf = s->in_msg->data + (s->in_msg->length - s->in_remaining);
+		/* Coalesced frames do not fit in a message buffer */
+		if (s->header.type == SLURM_IO_BATCH)
+			buf = s->cio->batch_frame[s->node_id];
+		else
+			buf = s->in_msg->data;
+		buf += s->in_msg->length - s->in_remaining;
 	again:
 		if ((n = read(obj->fd, buf, s->in_remaining)) < 0) {
 			if (errno == EINTR)
@@ -399,6 +564,7 @@ _server_read(eio_obj_t *obj, List objs)
 			s->out_eof = true;
 			list_enqueue(s->cio->free_outgoing, s->in_msg);
 			s->in_msg = NULL;
+			_server_release_batch_bufs(s);
 			return SLURM_SUCCESS;
 		}
 
@@ -410,28 +576,15 @@ _server_read(eio_obj_t *obj, List objs)
 		debug3("***** passing on eof message");
 	}
 
-	/*
-	 * Route the message to the proper output
-	 */
-	{
-		eio_obj_t *obj;
-		struct file_write_info *info;
-
-		s->in_msg->ref_count = 1;
-		if (s->in_msg->header.type == SLURM_IO_STDOUT)
-			obj = s->cio->stdout_obj;
-		else
-			obj = s->cio->stderr_obj;
-		info = (struct file_write_info *) obj->arg;
-		if (info->eof)
-			/* this output is closed, discard message */
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
-		else
-			list_enqueue(info->msg_queue, s->in_msg);
-
+	if (s->header.type == SLURM_IO_BATCH) {
+		list_enqueue(s->batch_bufs, s->in_msg);
 		s->in_msg = NULL;
+		return _server_read_batch(obj, s);
 	}
 
+	_server_route_msg(s, s->in_msg);
+	s->in_msg = NULL;
+
 	return SLURM_SUCCESS;
 }
 
@@ -848,6 +1001,7 @@ static int _read_io_init_msg(int fd, client_io_t *cio, slurm_addr_t *host)
 
 	debug3("msg.stdout_objs = %d", msg.stdout_objs);
 	debug3("msg.stderr_objs = %d", msg.stderr_objs);
+	debug3("msg.io_flags = 0x%x", msg.io_flags);
 	/* sanity checks, just print warning */
 	if (cio->ioserver[msg.nodeid] != NULL) {
 		error("IO: Node %d already established stream!", msg.nodeid);
@@ -857,7 +1011,8 @@ static int _read_io_init_msg(int fd, client_io_t *cio, slurm_addr_t *host)
 
 	cio->ioserver[msg.nodeid] = _create_server_eio_obj(fd, cio, msg.nodeid,
 							   msg.stdout_objs,
-							   msg.stderr_objs);
+							   msg.stderr_objs,
+							   msg.io_flags);
 	slurm_mutex_lock(&cio->ioservers_lock);
 	bit_set(cio->ioservers_ready_bits, msg.nodeid);
 	cio->ioservers_ready = bit_set_count(cio->ioservers_ready_bits);
@@ -1041,21 +1196,20 @@ _incoming_buf_free(client_io_t *cio)
 	return false;
 }
 
-static bool
-_outgoing_buf_free(client_io_t *cio)
+/* Make sure count buffers are free without exceeding STDIO_MAX_FREE_BUF */
+static bool _outgoing_bufs_free(client_io_t *cio, int count)
 {
 	struct io_buf *buf;
 
-	if (list_count(cio->free_outgoing) > 0) {
-		return true;
-	} else if (cio->outgoing_count < STDIO_MAX_FREE_BUF) {
+	while (list_count(cio->free_outgoing) < count) {
+		if (cio->outgoing_count >= STDIO_MAX_FREE_BUF)
+			return false;
 		buf = _alloc_io_buf();
 		list_enqueue(cio->free_outgoing, buf);
 		cio->outgoing_count++;
-		return true;
 	}
 
-	return false;
+	return true;
 }
 
 static inline int
@@ -1108,6 +1262,7 @@ client_io_t *client_io_handler_create(slurm_step_io_fds_t fds, int num_tasks,
 	cio->listenport = xcalloc(cio->num_listen, sizeof(uint16_t));
 
 	cio->ioserver = xcalloc(num_nodes, sizeof(eio_obj_t *));
+	cio->batch_frame = xcalloc(num_nodes, sizeof(char *));
 	cio->ioservers_ready_bits = bit_alloc(num_nodes);
 	cio->ioservers_ready = 0;
 	slurm_mutex_init(&cio->ioservers_lock);
@@ -1199,6 +1354,11 @@ client_io_handler_finish(client_io_t *cio)
 		return SLURM_ERROR;
 	}
 
+	if (cio->batch_cnt)
+		verbose("Received %"PRIu64" bytes of stdio in %u coalesced frames of %"PRIu64" bytes",
+			cio->batch_raw_bytes, cio->batch_cnt,
+			cio->batch_wire_bytes);
+
 	return SLURM_SUCCESS;
 }
 
@@ -1214,6 +1374,12 @@ client_io_handler_destroy(client_io_t *cio)
 	slurm_mutex_destroy(&cio->ioservers_lock);
 	FREE_NULL_BITMAP(cio->ioservers_ready_bits);
 	xfree(cio->ioserver); /* need to destroy the obj first? */
+	if (cio->batch_frame) {
+		for (int i = 0; i < cio->num_nodes; i++)
+			xfree(cio->batch_frame[i]);
+		xfree(cio->batch_frame);
+	}
+	xfree(cio->batch_raw);
 	xfree(cio->listenport);
 	xfree(cio->listensock);
 	eio_handle_destroy(cio->eio);
@@ -92,6 +92,13 @@ struct client_io {
 
 	struct step_launch_state *sls; /* Used to notify the main thread of an
 				       I/O problem.  */
+
+	char **batch_frame;	/* Per node SLURM_IO_BATCH frames being read */
+	char *batch_raw;	/* Messages of the SLURM_IO_BATCH frame being
+				 * dispatched */
+	uint32_t batch_cnt;	/* Count of SLURM_IO_BATCH frames received */
+	uint64_t batch_raw_bytes; /* stdio bytes carried by those frames */
+	uint64_t batch_wire_bytes; /* Bytes of those frames on the wire */
 };
 
 typedef struct client_io client_io_t;
@@ -363,6 +363,11 @@ extern int slurm_step_launch(slurm_step_ctx_t *ctx,
 		launch.flags |= LAUNCH_BUFFERED_IO;
 	if (params->labelio)
 		launch.flags |= LAUNCH_LABEL_IO;
+	if (params->io_coalesce) {
+		launch.flags |= LAUNCH_IO_COALESCE;
+		if (params->io_compress == COMPRESS_LZ4)
+			launch.flags |= LAUNCH_IO_LZ4;
+	}
 	ctx->launch_state->io =
 		client_io_handler_create(params->local_fds,
 					 ctx->step_req->num_tasks,
@@ -561,6 +566,11 @@ extern int slurm_step_launch_add(slurm_step_ctx_t *ctx,
 		launch.flags	|= LAUNCH_BUFFERED_IO;
 	if (params->labelio)
 		launch.flags	|= LAUNCH_LABEL_IO;
+	if (params->io_coalesce) {
+		launch.flags	|= LAUNCH_IO_COALESCE;
+		if (params->io_compress == COMPRESS_LZ4)
+			launch.flags	|= LAUNCH_IO_LZ4;
+	}
 	ctx->launch_state->io =
 		client_io_handler_create(params->local_fds,
 					 ctx->step_req->num_tasks,
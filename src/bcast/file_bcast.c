@@ -42,9 +42,11 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -54,6 +56,10 @@
 # include <lz4.h>
 #endif
 
+#if HAVE_ZSTD
+# include <zstd.h>
+#endif
+
 #include "slurm/slurm_errno.h"
 #include "src/common/forward.h"
 #include "src/common/hostlist.h"
@@ -70,6 +76,7 @@
 #include "src/common/uid.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
+#include "src/interfaces/hash.h"
 
 #include "file_bcast.h"
 
@@ -81,6 +88,7 @@
 #define DEFAULT_THREADS 8
 #define MAX_THREADS     64	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_PIPELINE    16	/* Maximum blocks in flight at one time */
 
 int block_len;				/* block size */
 int fd;					/* source file descriptor */
@@ -88,6 +96,24 @@ void *src;				/* source mmap'd address */
 struct stat f_stat;			/* source file stats */
 job_sbcast_cred_msg_t *sbcast_cred;	/* job alloc info and sbcast cred */
 
+/* State shared by the threads sending blocks in a pipelined transfer */
+typedef struct {
+	pthread_cond_t cond;
+	int in_flight;		/* blocks sent but not yet acknowledged */
+	pthread_mutex_t mutex;
+	struct bcast_parameters *params;
+	int rc;			/* first error seen by any sender thread */
+} bcast_pipeline_t;
+
+typedef struct {
+	file_bcast_msg_t bcast_msg;	/* private copy, owns block */
+	bcast_pipeline_t *pipeline;
+} bcast_block_args_t;
+
+static pthread_mutex_t cache_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t cache_blocks = 0;	/* blocks sent with cache probe */
+static uint32_t cache_hit_blocks = 0;	/* blocks all nodes had cached */
+
 static int   _bcast_file(struct bcast_parameters *params);
 static int   _file_bcast(struct bcast_parameters *params,
 			 file_bcast_msg_t *bcast_msg,
@@ -163,10 +189,14 @@ static int _get_job_info(struct bcast_parameters *params)
 	return rc;
 }
 
-/* Issue the RPC to transfer the file's data */
-static int _file_bcast(struct bcast_parameters *params,
-		       file_bcast_msg_t *bcast_msg,
-		       job_sbcast_cred_msg_t *sbcast_cred)
+/*
+ * Issue the RPC to transfer the file's data to node_list.
+ * OUT cache_miss - if set, collect the nodes which do not have the block in
+ *	their cache instead of treating that as an error
+ */
+static int _file_bcast_nodes(struct bcast_parameters *params,
+			     file_bcast_msg_t *bcast_msg, char *node_list,
+			     hostlist_t *cache_miss)
 {
 	List ret_list = NULL;
 	ListIterator itr;
@@ -181,8 +211,7 @@ static int _file_bcast(struct bcast_parameters *params,
 	msg.forward.tree_width = params->fanout;
 	msg.msg_type = REQUEST_FILE_BCAST;
 
-	ret_list = slurm_send_recv_msgs(sbcast_cred->node_list, &msg,
-					params->timeout);
+	ret_list = slurm_send_recv_msgs(node_list, &msg, params->timeout);
 	if (ret_list == NULL) {
 		error("slurm_send_recv_msgs: %m");
 		exit(1);
@@ -194,6 +223,13 @@ static int _file_bcast(struct bcast_parameters *params,
 					       ret_data_info->data);
 		if (msg_rc == SLURM_SUCCESS)
 			continue;
+		if (cache_miss && (msg_rc == ESLURMD_BCAST_CACHE_MISS)) {
+			if (!*cache_miss)
+				*cache_miss = hostlist_create(NULL);
+			hostlist_push_host(*cache_miss,
+					   ret_data_info->node_name);
+			continue;
+		}
 
 		error("REQUEST_FILE_BCAST(%s): %s",
 		      ret_data_info->node_name,
@@ -206,6 +242,52 @@ static int _file_bcast(struct bcast_parameters *params,
 	return rc;
 }
 
+/*
+ * Issue the RPC to transfer the file's data. If the block is cacheable,
+ * first ask the nodes to use their cached copy and only send the data to
+ * the nodes which do not have it.
+ */
+static int _file_bcast(struct bcast_parameters *params,
+		       file_bcast_msg_t *bcast_msg,
+		       job_sbcast_cred_msg_t *sbcast_cred)
+{
+	file_bcast_msg_t probe_msg;
+	hostlist_t cache_miss = NULL;
+	char *miss_list;
+	int rc;
+
+	if (!(bcast_msg->flags & FILE_BCAST_CACHE))
+		return _file_bcast_nodes(params, bcast_msg,
+					 sbcast_cred->node_list, NULL);
+
+	memcpy(&probe_msg, bcast_msg, sizeof(probe_msg));
+	probe_msg.flags |= FILE_BCAST_CACHE_PROBE;
+	probe_msg.compress = COMPRESS_OFF;
+	probe_msg.block = NULL;
+	probe_msg.block_len = 0;
+
+	rc = _file_bcast_nodes(params, &probe_msg, sbcast_cred->node_list,
+			       &cache_miss);
+
+	slurm_mutex_lock(&cache_stats_mutex);
+	cache_blocks++;
+	if (!cache_miss && !rc)
+		cache_hit_blocks++;
+	slurm_mutex_unlock(&cache_stats_mutex);
+
+	if (rc || !cache_miss)
+		goto fini;
+
+	miss_list = hostlist_ranged_string_xmalloc(cache_miss);
+	debug("block %u not cached on %s", bcast_msg->block_no, miss_list);
+	rc = _file_bcast_nodes(params, bcast_msg, miss_list, NULL);
+	xfree(miss_list);
+
+fini:
+	FREE_NULL_HOSTLIST(cache_miss);
+	return rc;
+}
+
 /* load a buffer with data from the file to broadcast,
  * return number of bytes read, zero on end of file */
 static int _get_block_none(char **buffer, int *orig_len, bool *more,
@@ -221,10 +303,11 @@ static int _get_block_none(char **buffer, int *orig_len, bool *more,
 	}
 
 	if (remaining < 0) {
-		*buffer = xmalloc(block_len);
 		remaining = f_stat.st_size;
 		position = src;
 	}
+	if (!*buffer)
+		*buffer = xmalloc(block_len);
 
 	size = MIN(block_len, remaining);
 	memcpy(*buffer, position, size);
@@ -260,8 +343,9 @@ static int _get_block_lz4(struct bcast_parameters *params,
 	if (remaining < 0) {
 		position = src;
 		remaining = f_stat.st_size;
-		*buffer = xmalloc(block_len);
 	}
+	if (!*buffer)
+		*buffer = xmalloc(block_len);
 
 	/* intentionally limit decompressed size to 10x compressed
 	 * to avoid problems on receive size when decompressed */
@@ -285,6 +369,57 @@ static int _get_block_lz4(struct bcast_parameters *params,
 
 }
 
+static int _get_block_zstd(struct bcast_parameters *params,
+			   char **buffer,
+			   int32_t *orig_len,
+			   bool *more, bool file_start)
+{
+#if HAVE_ZSTD
+	static int64_t remaining = -1;
+	static void *position;
+	size_t size_out;
+	int size;
+
+	if (file_start) {
+		remaining = -1;
+		position = NULL;
+	}
+
+	if (!f_stat.st_size) {
+		*more = false;
+		return 0;
+	}
+
+	if (remaining < 0) {
+		position = src;
+		remaining = f_stat.st_size;
+	}
+	/*
+	 * Unlike lz4 there is no destination-sized compression call, so
+	 * compress one full block of input into a worst case sized buffer.
+	 */
+	if (!*buffer)
+		*buffer = xmalloc(ZSTD_compressBound(block_len));
+
+	size = MIN(block_len, remaining);
+	size_out = ZSTD_compress(*buffer, ZSTD_compressBound(block_len),
+				 position, size, ZSTD_CLEVEL_DEFAULT);
+	if (ZSTD_isError(size_out))
+		fatal("ZSTD compression error: %s",
+		      ZSTD_getErrorName(size_out));
+	position += size;
+	remaining -= size;
+
+	*orig_len = size;
+	*more = (remaining) ? true : false;
+	return size_out;
+#else
+	info("zstd compression not supported, sending uncompressed file.");
+	params->compress = 0;
+	return _get_block_none(buffer, orig_len, more, file_start);
+#endif
+}
+
 static int _next_block(struct bcast_parameters *params,
 		       char **buffer,
 		       int32_t *orig_len,
@@ -296,6 +431,9 @@ static int _next_block(struct bcast_parameters *params,
 	case COMPRESS_LZ4:
 		return _get_block_lz4(params, buffer, orig_len, more,
 				      file_start);
+	case COMPRESS_ZSTD:
+		return _get_block_zstd(params, buffer, orig_len, more,
+				       file_start);
 	}
 
 	/* compression type not recognized */
@@ -305,16 +443,83 @@ static int _next_block(struct bcast_parameters *params,
 	return _get_block_none(buffer, orig_len, more, file_start);
 }
 
+static void *_bcast_block_thread(void *arg)
+{
+	bcast_block_args_t *args = arg;
+	bcast_pipeline_t *pipeline = args->pipeline;
+	int rc;
+
+	rc = _file_bcast(pipeline->params, &args->bcast_msg, sbcast_cred);
+
+	slurm_mutex_lock(&pipeline->mutex);
+	if ((rc != SLURM_SUCCESS) && (pipeline->rc == SLURM_SUCCESS))
+		pipeline->rc = rc;
+	pipeline->in_flight--;
+	slurm_cond_broadcast(&pipeline->cond);
+	slurm_mutex_unlock(&pipeline->mutex);
+
+	xfree(args->bcast_msg.block);
+	xfree(args);
+	return NULL;
+}
+
+/*
+ * Wait until no more than max_in_flight blocks are outstanding.
+ * RET the first error reported by a sender thread, if any
+ */
+static int _bcast_pipeline_wait(bcast_pipeline_t *pipeline,
+				int max_in_flight)
+{
+	int rc;
+
+	slurm_mutex_lock(&pipeline->mutex);
+	while (pipeline->in_flight > max_in_flight)
+		slurm_cond_wait(&pipeline->cond, &pipeline->mutex);
+	rc = pipeline->rc;
+	slurm_mutex_unlock(&pipeline->mutex);
+
+	return rc;
+}
+
+/*
+ * Send a block from a new thread so that the next block can be read and
+ * compressed while this one travels down the forwarding tree. Ownership of
+ * the block's buffer passes to the thread.
+ */
+static void _bcast_block_async(bcast_pipeline_t *pipeline,
+			       file_bcast_msg_t *bcast_msg)
+{
+	bcast_block_args_t *args = xmalloc(sizeof(*args));
+
+	memcpy(&args->bcast_msg, bcast_msg, sizeof(args->bcast_msg));
+	args->pipeline = pipeline;
+
+	slurm_mutex_lock(&pipeline->mutex);
+	pipeline->in_flight++;
+	slurm_mutex_unlock(&pipeline->mutex);
+
+	slurm_thread_create_detached(NULL, _bcast_block_thread, args);
+}
+
 /* read and broadcast the file */
 static int _bcast_file(struct bcast_parameters *params)
 {
-	int rc = SLURM_SUCCESS;
+	int rc = SLURM_SUCCESS, rc2;
 	file_bcast_msg_t bcast_msg;
 	char *buffer = NULL;
 	int32_t orig_len = 0;
 	uint64_t size_uncompressed = 0, size_compressed = 0;
 	uint32_t time_compression = 0;
 	bool more = true, file_start = true;
+	bool use_cache = bcast_cache_enabled() &&
+			 (params->flags & (BCAST_FLAG_SEND_LIBS |
+					   BCAST_FLAG_SHARED_OBJECT));
+	bcast_pipeline_t pipeline = {
+		.cond = PTHREAD_COND_INITIALIZER,
+		.mutex = PTHREAD_MUTEX_INITIALIZER,
+		.params = params,
+		.rc = SLURM_SUCCESS,
+	};
 	DEF_TIMERS;
 
 	if (params->block_size)
@@ -348,6 +553,9 @@ static int _bcast_file(struct bcast_parameters *params)
 	else
 		params->fanout = MIN(MAX_THREADS, params->fanout);
 
+	if (params->pipeline > MAX_PIPELINE)
+		params->pipeline = MAX_PIPELINE;
+
 	while (more) {
 		START_TIMER;
 		bcast_msg.block_len = _next_block(params, &buffer, &orig_len,
@@ -362,10 +570,36 @@ static int _bcast_file(struct bcast_parameters *params)
 		bcast_msg.compress = params->compress;
 		bcast_msg.uncomp_len = orig_len;
 		bcast_msg.block = buffer;
+		if (use_cache && orig_len) {
+			bcast_msg.block_hash.type = HASH_PLUGIN_K12;
+			if (hash_g_compute(src + bcast_msg.block_offset,
+					   orig_len, NULL, 0,
+					   &bcast_msg.block_hash) < 0)
+				bcast_msg.flags &= ~FILE_BCAST_CACHE;
+			else
+				bcast_msg.flags |= FILE_BCAST_CACHE;
+		}
 		if (!more)
 			bcast_msg.flags |= FILE_BCAST_LAST_BLOCK;
 
-		rc = _file_bcast(params, &bcast_msg, sbcast_cred);
+		/*
+		 * The first block registers the file on the compute nodes and
+		 * the last one closes it, so only the blocks in between can
+		 * be in flight at the same time. The last block must not be
+		 * sent until every earlier block has been written.
+		 */
+		if ((params->pipeline > 1) && (bcast_msg.block_no > 1) &&
+		    more) {
+			if ((rc = _bcast_pipeline_wait(&pipeline,
+						       params->pipeline - 1)))
+				break;
+			_bcast_block_async(&pipeline, &bcast_msg);
+			buffer = NULL;
+		} else {
+			if ((rc = _bcast_pipeline_wait(&pipeline, 0)))
+				break;
+			rc = _file_bcast(params, &bcast_msg, sbcast_cred);
+		}
 		if (rc != SLURM_SUCCESS)
 			break;
 		if (bcast_msg.flags & FILE_BCAST_LAST_BLOCK)
@@ -373,6 +607,9 @@ static int _bcast_file(struct bcast_parameters *params)
 		bcast_msg.block_no++;
 		bcast_msg.block_offset += orig_len;
 	}
+	/* Don't release shared message fields while senders still use them */
+	if ((rc2 = _bcast_pipeline_wait(&pipeline, 0)) && !rc)
+		rc = rc2;
 	xfree(bcast_msg.user_name);
 	xfree(buffer);
 
@@ -389,6 +626,13 @@ static int _bcast_file(struct bcast_parameters *params)
 			time_compression);
 	}
 
+	slurm_mutex_lock(&cache_stats_mutex);
+	if (cache_blocks)
+		verbose("%u of %u blocks were already cached on all nodes",
+			cache_hit_blocks, cache_blocks);
+	cache_blocks = cache_hit_blocks = 0;
+	slurm_mutex_unlock(&cache_stats_mutex);
+
 	return rc;
 }
 
@@ -418,6 +662,36 @@ static int _decompress_data_lz4(file_bcast_msg_t *req)
 #endif
 }
 
+static int _decompress_data_zstd(file_bcast_msg_t *req)
+{
+#if HAVE_ZSTD
+	char *out_buf;
+	size_t out_len;
+
+	if (!req->block_len)
+		return 0;
+
+	out_buf = xmalloc(req->uncomp_len);
+	out_len = ZSTD_decompress(out_buf, req->uncomp_len, req->block,
+				  req->block_len);
+	xfree(req->block);
+	req->block = out_buf;
+	if (ZSTD_isError(out_len)) {
+		error("zstd decompression error: %s",
+		      ZSTD_getErrorName(out_len));
+		return -1;
+	}
+	if (req->uncomp_len != out_len) {
+		error("zstd decompression error, original block length != decompressed length");
+		return -1;
+	}
+	req->block_len = out_len;
+	return 0;
+#else
+	return -1;
+#endif
+}
+
 /*
  * IN: char pointer with the filename.
  * OUT: List of shared object direct and indirect dependencies.
@@ -656,6 +930,60 @@ extern int bcast_file(struct bcast_parameters *params)
 	return rc;
 }
 
+extern bool bcast_cache_enabled(void)
+{
+	char *tmp, *tok, *save_ptr = NULL;
+	bool enabled = false;
+
+	if (!slurm_conf.bcast_parameters)
+		return false;
+
+	tmp = xstrdup(slurm_conf.bcast_parameters);
+	tok = strtok_r(tmp, ",", &save_ptr);
+	while (tok) {
+		if (!xstrcasecmp(tok, "Cache")) {
+			enabled = true;
+			break;
+		}
+		tok = strtok_r(NULL, ",", &save_ptr);
+	}
+	xfree(tmp);
+
+	return enabled;
+}
+
+extern int bcast_parse_pipeline(const char *arg, int *pipeline)
+{
+	char *end_ptr = NULL;
+	long val;
+
+	errno = 0;
+	val = strtol(arg, &end_ptr, 10);
+	if (errno || (end_ptr == arg) || (*end_ptr != '\0') ||
+	    (val <= 0) || (val > INT_MAX))
+		return SLURM_ERROR;
+
+	*pipeline = val;
+	return SLURM_SUCCESS;
+}
+
+extern int bcast_conf_pipeline(int *pipeline)
+{
+	char *tmp, *sep;
+	int rc;
+
+	if (!(tmp = xstrcasestr(slurm_conf.bcast_parameters, "Pipeline=")))
+		return SLURM_SUCCESS;
+
+	tmp = xstrdup(tmp + 9);
+	if ((sep = strchr(tmp, ',')))
+		sep[0] = '\0';
+	rc = bcast_parse_pipeline(tmp, pipeline);
+	xfree(tmp);
+
+	return rc;
+}
+
 extern int bcast_decompress_data(file_bcast_msg_t *req)
 {
 	switch (req->compress) {
@@ -663,6 +991,8 @@ extern int bcast_decompress_data(file_bcast_msg_t *req)
 		return 0;
 	case COMPRESS_LZ4:
 		return _decompress_data_lz4(req);
+	case COMPRESS_ZSTD:
+		return _decompress_data_zstd(req);
 	}
 
 	/* compression type not recognized */
@@ -52,6 +52,7 @@ struct bcast_parameters {
 	char *dst_fname;
 	int fanout;
 	uint16_t flags;
+	int pipeline;		/* blocks in flight at one time */
 	slurm_selected_step_t *selected_step;
 	char *src_fname;
 	uint32_t step_id;
@@ -85,4 +86,19 @@ extern int bcast_file(struct bcast_parameters *params);
 
 extern int bcast_decompress_data(file_bcast_msg_t *req);
 
+/* Return true if BcastParameters enables the compute node block cache */
+extern bool bcast_cache_enabled(void);
+
+/*
+ * Parse a number of blocks in flight.
+ * Return SLURM_ERROR unless it is a positive number.
+ */
+extern int bcast_parse_pipeline(const char *arg, int *pipeline);
+
+/*
+ * Set pipeline from BcastParameters Pipeline= if present.
+ * Return SLURM_ERROR if its value is invalid.
+ */
+extern int bcast_conf_pipeline(int *pipeline);
+
 #endif
@@ -0,0 +1,476 @@
+/*****************************************************************************\
+ *  archive_file.c - columnar accounting archive files
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if HAVE_LZ4
+#  include <lz4.h>
+#endif
+
+#include "src/common/archive_file.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* "SLAR", never a valid version at the start of the older archive files */
+#define ARCHIVE_FILE_MAGIC 0x534c4152
+
+/* row_cnt, compress, raw_len and comp_len in front of every chunk */
+#define CHUNK_HDR_SIZE (3 * sizeof(uint32_t) + sizeof(uint16_t))
+
+static archive_file_t *_alloc_file(char *path)
+{
+	archive_file_t *af = xmalloc(sizeof(*af));
+
+	af->fd = -1;
+	af->path = xstrdup(path);
+
+	return af;
+}
+
+static int _write_chunk(archive_file_t *af)
+{
+	buf_t *raw = NULL, *hdr = init_buf(CHUNK_HDR_SIZE);
+	uint16_t compress = COMPRESS_OFF;
+	uint32_t raw_len = 0, comp_len;
+	char *payload;
+	int rc = SLURM_SUCCESS;
+
+	if (af->row_cnt) {
+		raw = init_buf(BUF_SIZE);
+		for (int i = 0; i < af->col_cnt; i++) {
+			packmem(get_buf_data(af->values[i]),
+				get_buf_offset(af->values[i]), raw);
+			set_buf_offset(af->values[i], 0);
+		}
+		raw_len = get_buf_offset(raw);
+	}
+	payload = raw ? get_buf_data(raw) : NULL;
+	comp_len = raw_len;
+
+#if HAVE_LZ4
+	if (raw_len > 1) {
+		int bound = LZ4_compressBound(raw_len);
+		char *comp = xmalloc_nz(bound);
+		int n = LZ4_compress_default(payload, comp, raw_len,
+					     raw_len - 1);
+
+		if (n > 0) {
+			compress = COMPRESS_LZ4;
+			comp_len = n;
+			payload = comp;
+		} else
+			xfree(comp);
+	}
+#endif
+
+	pack32(af->row_cnt, hdr);
+	pack16(compress, hdr);
+	pack32(raw_len, hdr);
+	pack32(comp_len, hdr);
+
+	safe_write(af->fd, get_buf_data(hdr), get_buf_offset(hdr));
+	if (comp_len)
+		safe_write(af->fd, payload, comp_len);
+
+	af->total_rows += af->row_cnt;
+	af->row_cnt = 0;
+	goto end_it;
+
+rwfail:
+	error("%s: Error writing archive file %s: %m", __func__, af->path);
+	rc = SLURM_ERROR;
+end_it:
+	if (compress != COMPRESS_OFF)
+		xfree(payload);
+	FREE_NULL_BUFFER(raw);
+	FREE_NULL_BUFFER(hdr);
+	return rc;
+}
+
+extern archive_file_t *archive_file_create(char *path, char *cluster_name,
+					   char *table, uint16_t type,
+					   uint16_t flags, char **columns,
+					   uint32_t col_cnt,
+					   uint32_t chunk_rows)
+{
+	archive_file_t *af;
+	buf_t *hdr;
+
+	xassert(col_cnt);
+	xassert(chunk_rows);
+
+	af = _alloc_file(path);
+	af->rpc_version = SLURM_PROTOCOL_VERSION;
+	af->time = time(NULL);
+	af->type = type;
+	af->cluster_name = xstrdup(cluster_name);
+	af->table = xstrdup(table);
+	af->flags = flags;
+	af->col_cnt = col_cnt;
+	af->chunk_rows = chunk_rows;
+	af->columns = xcalloc(col_cnt, sizeof(char *));
+	af->values = xcalloc(col_cnt, sizeof(buf_t *));
+	for (int i = 0; i < col_cnt; i++) {
+		af->columns[i] = xstrdup(columns[i]);
+		af->values[i] = init_buf(BUF_SIZE);
+	}
+
+	if ((af->fd = creat(path, 0600)) < 0) {
+		error("Can't save archive, create file %s error %m", path);
+		archive_file_free(af);
+		return NULL;
+	}
+
+	hdr = init_buf(BUF_SIZE);
+	pack32(ARCHIVE_FILE_MAGIC, hdr);
+	pack32(0, hdr); /* header length, filled in below */
+	pack16(af->rpc_version, hdr);
+	pack_time(af->time, hdr);
+	pack16(af->type, hdr);
+	packstr(af->cluster_name, hdr);
+	packstr(af->table, hdr);
+	pack16(af->flags, hdr);
+	pack32(af->col_cnt, hdr);
+	for (int i = 0; i < af->col_cnt; i++)
+		packstr(af->columns[i], hdr);
+	*(uint32_t *) (get_buf_data(hdr) + sizeof(uint32_t)) =
+		htonl(get_buf_offset(hdr) - (2 * sizeof(uint32_t)));
+
+	safe_write(af->fd, get_buf_data(hdr), get_buf_offset(hdr));
+	FREE_NULL_BUFFER(hdr);
+
+	return af;
+
+rwfail:
+	error("%s: Error writing archive file %s: %m", __func__, path);
+	FREE_NULL_BUFFER(hdr);
+	(void) unlink(path);
+	archive_file_free(af);
+	return NULL;
+}
+
+extern int archive_file_add_row(archive_file_t *af, char **row)
+{
+	xassert(af->fd >= 0);
+
+	for (int i = 0; i < af->col_cnt; i++)
+		packstr(row[i], af->values[i]);
+
+	if (++af->row_cnt < af->chunk_rows)
+		return SLURM_SUCCESS;
+
+	return _write_chunk(af);
+}
+
+extern int archive_file_close(archive_file_t *af)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (af->row_cnt)
+		rc = _write_chunk(af);
+
+	/* An empty chunk marks the end of the file */
+	if (!rc)
+		rc = _write_chunk(af);
+
+	if (!rc && fsync(af->fd)) {
+		error("%s: Error syncing archive file %s: %m",
+		      __func__, af->path);
+		rc = SLURM_ERROR;
+	}
+
+	if (close(af->fd) && !rc) {
+		error("%s: Error closing archive file %s: %m",
+		      __func__, af->path);
+		rc = SLURM_ERROR;
+	}
+	af->fd = -1;
+
+	if (rc)
+		(void) unlink(af->path);
+	else
+		debug("%s: wrote %"PRIu64" records to %s",
+		      __func__, af->total_rows, af->path);
+
+	archive_file_free(af);
+	return rc;
+}
+
+extern void archive_file_discard(archive_file_t *af)
+{
+	if (!af)
+		return;
+
+	(void) unlink(af->path);
+	archive_file_free(af);
+}
+
+extern bool archive_file_is_columnar(char *path)
+{
+	uint32_t magic = 0;
+	int fd;
+	bool rc = false;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return false;
+
+	if (read(fd, &magic, sizeof(magic)) == sizeof(magic))
+		rc = (ntohl(magic) == ARCHIVE_FILE_MAGIC);
+	close(fd);
+
+	return rc;
+}
+
+extern int archive_file_open(char *path, archive_file_t **af_out)
+{
+	archive_file_t *af = _alloc_file(path);
+	uint32_t magic, hdr_len, tmp32;
+	char *data = NULL;
+	buf_t *hdr = NULL;
+
+	*af_out = NULL;
+
+	if ((af->fd = open(path, O_RDONLY)) < 0) {
+		int rc = errno;
+		error("Could not open archive file `%s`: %m", path);
+		archive_file_free(af);
+		return rc;
+	}
+
+	safe_read(af->fd, &magic, sizeof(magic));
+	safe_read(af->fd, &hdr_len, sizeof(hdr_len));
+	if ((ntohl(magic) != ARCHIVE_FILE_MAGIC) ||
+	    ((hdr_len = ntohl(hdr_len)) > MAX_BUF_SIZE))
+		goto rwfail;
+
+	data = xmalloc_nz(hdr_len);
+	safe_read(af->fd, data, hdr_len);
+	hdr = create_buf(data, hdr_len);
+
+	safe_unpack16(&af->rpc_version, hdr);
+	if (af->rpc_version > SLURM_PROTOCOL_VERSION) {
+		error("Can not read archive file %s, incompatible version, got %u need <= %u",
+		      path, af->rpc_version, SLURM_PROTOCOL_VERSION);
+		goto unpack_error;
+	}
+	safe_unpack_time(&af->time, hdr);
+	safe_unpack16(&af->type, hdr);
+	safe_unpackstr_xmalloc(&af->cluster_name, &tmp32, hdr);
+	safe_unpackstr_xmalloc(&af->table, &tmp32, hdr);
+	safe_unpack16(&af->flags, hdr);
+	safe_unpack32(&af->col_cnt, hdr);
+	if (!af->col_cnt || (af->col_cnt > hdr_len))
+		goto unpack_error;
+	af->columns = xcalloc(af->col_cnt, sizeof(char *));
+	for (int i = 0; i < af->col_cnt; i++) {
+		safe_unpackstr_xmalloc(&af->columns[i], &tmp32, hdr);
+		if (!af->columns[i])
+			goto unpack_error;
+	}
+
+	FREE_NULL_BUFFER(hdr);
+	*af_out = af;
+	return SLURM_SUCCESS;
+
+rwfail:
+	xfree(data);
+unpack_error:
+	error("%s: Malformed archive file %s", __func__, path);
+	FREE_NULL_BUFFER(hdr);
+	archive_file_free(af);
+	return SLURM_ERROR;
+}
+
+extern int archive_file_read_chunk(archive_file_t *af, archive_chunk_t **out)
+{
+	archive_chunk_t *chunk = xmalloc(sizeof(*chunk));
+	char data[CHUNK_HDR_SIZE];
+	buf_t *hdr = NULL;
+
+	*out = NULL;
+
+	safe_read(af->fd, data, sizeof(data));
+	hdr = create_buf(data, sizeof(data));
+	safe_unpack32(&chunk->row_cnt, hdr);
+	safe_unpack16(&chunk->compress, hdr);
+	safe_unpack32(&chunk->raw_len, hdr);
+	safe_unpack32(&chunk->comp_len, hdr);
+	/* free hdr, but not the memory to which it points */
+	hdr->head = NULL;
+	FREE_NULL_BUFFER(hdr);
+
+	if (!chunk->row_cnt) {
+		/* end of the file */
+		archive_chunk_free(chunk);
+		return SLURM_SUCCESS;
+	}
+
+	if ((chunk->raw_len > MAX_BUF_SIZE) ||
+	    (chunk->comp_len > MAX_BUF_SIZE))
+		goto unpack_error;
+
+	chunk->data = xmalloc_nz(chunk->comp_len);
+	safe_read(af->fd, chunk->data, chunk->comp_len);
+
+	af->total_rows += chunk->row_cnt;
+	*out = chunk;
+	return SLURM_SUCCESS;
+
+rwfail:
+	error("%s: Archive file %s is truncated", __func__, af->path);
+	archive_chunk_free(chunk);
+	return SLURM_ERROR;
+
+unpack_error:
+	error("%s: Malformed archive file %s", __func__, af->path);
+	if (hdr) {
+		hdr->head = NULL;
+		FREE_NULL_BUFFER(hdr);
+	}
+	archive_chunk_free(chunk);
+	return SLURM_ERROR;
+}
+
+extern int archive_chunk_unpack(archive_file_t *af, archive_chunk_t *chunk)
+{
+	char *raw = NULL;
+	buf_t *buffer = NULL, *col = NULL;
+	uint32_t col_len;
+
+	/* Every packstr() takes at least 4 bytes, reject impossible counts */
+	if (((uint64_t) chunk->row_cnt * af->col_cnt * sizeof(uint32_t)) >
+	    chunk->raw_len)
+		goto unpack_error;
+
+	switch (chunk->compress) {
+	case COMPRESS_OFF:
+		if (chunk->comp_len != chunk->raw_len)
+			goto unpack_error;
+		raw = chunk->data;
+		chunk->data = NULL;
+		break;
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		raw = xmalloc_nz(chunk->raw_len);
+		if (LZ4_decompress_safe(chunk->data, raw, chunk->comp_len,
+					chunk->raw_len) != chunk->raw_len) {
+			xfree(raw);
+			goto unpack_error;
+		}
+		xfree(chunk->data);
+		break;
+#endif
+	default:
+		error("%s: unsupported compression type %hu in %s",
+		      __func__, chunk->compress, af->path);
+		return SLURM_ERROR;
+	}
+
+	buffer = create_buf(raw, chunk->raw_len);
+	chunk->col_cnt = af->col_cnt;
+	chunk->values = xcalloc((uint64_t) chunk->row_cnt * chunk->col_cnt,
+				sizeof(char *));
+	for (int i = 0; i < af->col_cnt; i++) {
+		char *col_data;
+
+		/* Each column is one packmem() of all its packstr() values */
+		safe_unpackmem_ptr(&col_data, &col_len, buffer);
+		col = create_buf(col_data, col_len);
+		for (int j = 0; j < chunk->row_cnt; j++) {
+			uint32_t tmp32;
+			safe_unpackstr_xmalloc(
+				&chunk->values[(j * af->col_cnt) + i],
+				&tmp32, col);
+		}
+		/* free col, but not the memory to which it points */
+		col->head = NULL;
+		FREE_NULL_BUFFER(col);
+	}
+	FREE_NULL_BUFFER(buffer);
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	error("%s: Malformed chunk in archive file %s", __func__, af->path);
+	if (col) {
+		col->head = NULL;
+		FREE_NULL_BUFFER(col);
+	}
+	FREE_NULL_BUFFER(buffer);
+	return SLURM_ERROR;
+}
+
+extern void archive_chunk_free(archive_chunk_t *chunk)
+{
+	if (!chunk)
+		return;
+
+	xfree(chunk->data);
+	if (chunk->values) {
+		uint64_t cnt = (uint64_t) chunk->row_cnt * chunk->col_cnt;
+		for (uint64_t i = 0; i < cnt; i++)
+			xfree(chunk->values[i]);
+	}
+	xfree(chunk->values);
+	xfree(chunk);
+}
+
+extern void archive_file_free(archive_file_t *af)
+{
+	if (!af)
+		return;
+
+	if (af->fd >= 0)
+		close(af->fd);
+	for (int i = 0; i < af->col_cnt; i++) {
+		if (af->columns)
+			xfree(af->columns[i]);
+		if (af->values)
+			FREE_NULL_BUFFER(af->values[i]);
+	}
+	xfree(af->columns);
+	xfree(af->values);
+	xfree(af->cluster_name);
+	xfree(af->path);
+	xfree(af->table);
+	xfree(af);
+}
@@ -0,0 +1,139 @@
+/*****************************************************************************\
+ *  archive_file.h - columnar accounting archive files
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _ARCHIVE_FILE_H
+#define _ARCHIVE_FILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "src/common/pack.h"
+
+/*
+ * An archive file holds the rows of one database table. The rows are split
+ * into chunks which are compressed on their own, and each chunk stores all
+ * the values of one column together.
+ */
+
+/* The table name is prefixed with the cluster name */
+#define ARCHIVE_FILE_CLUSTER_TABLE SLURM_BIT(0)
+
+typedef struct {
+	uint32_t col_cnt;
+	char **columns;		/* column names */
+	char *cluster_name;
+	uint16_t flags;		/* ARCHIVE_FILE_* */
+	uint16_t rpc_version;	/* version the file was written with */
+	char *table;		/* table the rows came from */
+	time_t time;		/* when the file was written */
+	uint16_t type;		/* slurmdbd_msg_type_t of the records */
+
+	/* private */
+	uint32_t chunk_rows;
+	int fd;
+	char *path;
+	buf_t **values;		/* one per column for the current chunk */
+	uint32_t row_cnt;	/* rows in the current chunk */
+	uint64_t total_rows;
+} archive_file_t;
+
+typedef struct {
+	uint32_t col_cnt;
+	uint16_t compress;
+	uint32_t comp_len;
+	char *data;
+	uint32_t raw_len;
+	uint32_t row_cnt;
+	char **values;		/* row_cnt * col_cnt, one row after another */
+} archive_chunk_t;
+
+/*
+ * Start a new archive file and write its header. Rows are written out each
+ * time chunk_rows of them have been added.
+ * IN path - file to create
+ * IN columns - names of the columns of each row
+ * IN chunk_rows - rows in each chunk
+ * RET archive file or NULL on error
+ */
+extern archive_file_t *archive_file_create(char *path, char *cluster_name,
+					   char *table, uint16_t type,
+					   uint16_t flags, char **columns,
+					   uint32_t col_cnt,
+					   uint32_t chunk_rows);
+
+/* Add a row of col_cnt values, any of which may be NULL */
+extern int archive_file_add_row(archive_file_t *af, char **row);
+
+/*
+ * Write out what is left and finish the file.
+ * RET SLURM_SUCCESS or error code, the file is removed on error
+ */
+extern int archive_file_close(archive_file_t *af);
+
+/* Stop writing and remove the file, after an error adding the rows */
+extern void archive_file_discard(archive_file_t *af);
+
+/* Return true if path is an archive file written by archive_file_create() */
+extern bool archive_file_is_columnar(char *path);
+
+/*
+ * Open an archive file for reading.
+ * OUT af - the file with its header filled in
+ * RET SLURM_SUCCESS or error code
+ */
+extern int archive_file_open(char *path, archive_file_t **af);
+
+/*
+ * Read the next chunk as it is stored in the file, archive_chunk_unpack()
+ * must be called before its values can be used.
+ * OUT chunk - next chunk or NULL at the end of the file
+ * RET SLURM_SUCCESS or error code
+ */
+extern int archive_file_read_chunk(archive_file_t *af, archive_chunk_t **chunk);
+
+/*
+ * Decompress a chunk and fill in its values. This does not use af other than
+ * to look at its header so it may be called from several threads at once.
+ */
+extern int archive_chunk_unpack(archive_file_t *af, archive_chunk_t *chunk);
+
+extern void archive_chunk_free(archive_chunk_t *chunk);
+
+/* Free an archive file opened with archive_file_open() */
+extern void archive_file_free(archive_file_t *af);
+
+#endif
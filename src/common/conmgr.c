@@ -2230,9 +2230,11 @@ static int _create_socket(void *x, void *arg)
 	struct addrinfo *addrlist = NULL;
 	parsed_host_port_t *parsed_hp;
 	con_mgr_callbacks_t callbacks;
+	bool reuse_port;
 
 	slurm_mutex_lock(&init->mgr->mutex);
 	callbacks = init->mgr->callbacks;
+	reuse_port = init->mgr->reuse_port;
 	slurm_mutex_unlock(&init->mgr->mutex);
 
 	/* check for name local sockets */
@@ -2312,6 +2314,15 @@ static int _create_socket(void *x, void *arg)
 			fatal("%s: [%s] setsockopt(SO_REUSEADDR) failed: %m",
 			      __func__, addrinfo_to_string(addr));
 
+		/*
+		 * allow other processes to bind the same address and have the
+		 * kernel balance new connections between them
+		 */
+		if (reuse_port &&
+		    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)))
+			fatal("%s: [%s] setsockopt(SO_REUSEPORT) failed: %m",
+			      __func__, addrinfo_to_string(addr));
+
 		if (bind(fd, addr->ai_addr, addr->ai_addrlen) != 0)
 			fatal("%s: [%s] Unable to bind socket: %m",
 			      __func__, addrinfo_to_string(addr));
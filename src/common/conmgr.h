@@ -292,6 +292,8 @@ struct con_mgr_s {
 	bool signaled;
 	/* Caller requests finish on error */
 	bool exit_on_error;
+	/* Set SO_REUSEPORT on listening inet sockets */
+	bool reuse_port;
 	/* First observed error */
 	int error;
 	/* list of work_t */
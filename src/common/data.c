@@ -73,6 +73,24 @@ static bool initialized = false; /* protected by init_mutex */
 #define DATA_MAGIC 0x1992189F
 #define DATA_LIST_MAGIC 0x1992F89F
 #define DATA_LIST_NODE_MAGIC 0x1921F89F
+#define DATA_ARENA_MAGIC 0x1992A89F
+
+/*
+ * Dictionaries are searched linearly until they have more than this many
+ * entries, at which point a hash index of the keys is built.
+ */
+#define DICT_INDEX_MIN_COUNT 16
+/* Smallest number of slots in a dictionary hash index (must be power of 2) */
+#define DICT_INDEX_MIN_SIZE 64
+
+/* Size of each slab of memory allocated by an arena */
+#define ARENA_SLAB_SIZE (64 * 1024)
+/* Allocations larger than this get a slab of their own */
+#define ARENA_LARGE_SIZE (ARENA_SLAB_SIZE / 8)
+/* Alignment of every allocation from an arena (must be power of 2) */
+#define ARENA_ALIGN 16
+/* Smallest number of slots in arena key intern table (must be power of 2) */
+#define ARENA_KEYS_MIN_SIZE 256
 
 typedef struct data_list_node_s data_list_node_t;
 struct data_list_node_s {
@@ -81,17 +99,71 @@ struct data_list_node_s {
 
 	data_t *data;
 	char *key; /* key for dictionary (only) */
+	uint32_t hash; /* hash of key for dictionary (only) */
 };
 
-/* single forward linked list */
+/*
+ * Single forward linked list
+ *
+ * Dictionaries keep insertion order in the linked list while large
+ * dictionaries also get an open addressing (linear probing) hash index of the
+ * nodes to avoid walking the list for every key lookup.
+ */
 struct data_list_s {
 	int magic;
 	size_t count;
 
 	data_list_node_t *begin;
 	data_list_node_t *end;
+
+	data_list_node_t **index; /* hash index of dictionary nodes or NULL */
+	size_t index_size; /* number of slots in index (power of 2) */
+	size_t index_used; /* number of non-empty slots including removed */
+
+	data_arena_t *arena; /* arena owning memory or NULL */
+};
+
+/*
+ * Slab of memory in arena
+ * Allocations are carved out of the memory after the (aligned) header.
+ */
+typedef struct data_arena_slab_s data_arena_slab_t;
+struct data_arena_slab_s {
+	data_arena_slab_t *next;
+	size_t size; /* bytes available after header */
+	size_t used; /* bytes already allocated after header */
 };
 
+#define ARENA_SLAB_HEADER_SIZE \
+	((sizeof(data_arena_slab_t) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+typedef struct {
+	uint32_t hash;
+	char *key;
+} arena_key_t;
+
+/*
+ * Memory arena of a data_t tree.
+ *
+ * Every data_t, data_list_t, data_list_node_t and string of the tree is
+ * allocated out of the slabs, which are only released when the root is freed.
+ * Dictionary keys are interned to avoid a copy of the same key for every
+ * entry in a list of dictionaries.
+ */
+struct data_arena_s {
+	int magic;
+	data_t *root; /* root of tree owning arena */
+	data_arena_slab_t *slabs; /* slab for small allocations always first */
+	size_t slab_count;
+
+	arena_key_t *keys; /* open addressing table of interned keys */
+	size_t keys_size; /* number of slots in keys (power of 2) */
+	size_t keys_count; /* number of interned keys */
+};
+
+/* Placeholder in hash index for removed node to keep probe chains intact */
+static data_list_node_t index_removed;
+
 typedef struct {
 	char *path;
 	char *at;
@@ -162,9 +234,147 @@ extern int data_init(void)
 	return rc;
 }
 
-static data_list_t *_data_list_new(void)
+static void *_arena_alloc(data_arena_t *arena, size_t size)
 {
-	data_list_t *dl = xmalloc(sizeof(*dl));
+	data_arena_slab_t *slab = arena->slabs;
+	void *ptr;
+
+	xassert(arena->magic == DATA_ARENA_MAGIC);
+
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	if (size > ARENA_LARGE_SIZE) {
+		data_arena_slab_t *large =
+			xmalloc(ARENA_SLAB_HEADER_SIZE + size);
+
+		large->size = large->used = size;
+		arena->slab_count++;
+
+		/* keep partially used slab first for smaller allocations */
+		if (slab) {
+			large->next = slab->next;
+			slab->next = large;
+		} else {
+			arena->slabs = large;
+		}
+
+		return ((char *) large) + ARENA_SLAB_HEADER_SIZE;
+	}
+
+	if (!slab || ((slab->used + size) > slab->size)) {
+		slab = xmalloc(ARENA_SLAB_HEADER_SIZE + ARENA_SLAB_SIZE);
+		slab->size = ARENA_SLAB_SIZE;
+		slab->next = arena->slabs;
+		arena->slabs = slab;
+		arena->slab_count++;
+	}
+
+	/* xmalloc() zeroes the slab so allocations are always zeroed */
+	ptr = ((char *) slab) + ARENA_SLAB_HEADER_SIZE + slab->used;
+	slab->used += size;
+
+	return ptr;
+}
+
+static char *_arena_strdup(data_arena_t *arena, const char *str)
+{
+	const size_t len = strlen(str);
+	char *dup = _arena_alloc(arena, (len + 1));
+
+	memcpy(dup, str, len);
+
+	return dup;
+}
+
+static void _arena_keys_grow(data_arena_t *arena)
+{
+	arena_key_t *old = arena->keys;
+	const size_t old_size = arena->keys_size;
+	size_t mask;
+
+	if (!arena->keys_size)
+		arena->keys_size = ARENA_KEYS_MIN_SIZE;
+	else
+		arena->keys_size *= 2;
+
+	mask = arena->keys_size - 1;
+	arena->keys = xcalloc(arena->keys_size, sizeof(*arena->keys));
+
+	for (size_t i = 0; i < old_size; i++) {
+		size_t slot;
+
+		if (!old[i].key)
+			continue;
+
+		slot = old[i].hash & mask;
+		while (arena->keys[slot].key)
+			slot = (slot + 1) & mask;
+
+		arena->keys[slot] = old[i];
+	}
+
+	xfree(old);
+}
+
+/* Get interned copy of key from arena */
+static char *_arena_intern(data_arena_t *arena, const char *key,
+			   uint32_t hash)
+{
+	size_t mask, slot;
+
+	/* keep load factor under 50% */
+	if (((arena->keys_count + 1) * 2) > arena->keys_size)
+		_arena_keys_grow(arena);
+
+	mask = arena->keys_size - 1;
+	slot = hash & mask;
+
+	while (arena->keys[slot].key) {
+		if ((arena->keys[slot].hash == hash) &&
+		    !xstrcmp(arena->keys[slot].key, key))
+			return arena->keys[slot].key;
+
+		slot = (slot + 1) & mask;
+	}
+
+	arena->keys[slot].hash = hash;
+	arena->keys[slot].key = _arena_strdup(arena, key);
+	arena->keys_count++;
+
+	return arena->keys[slot].key;
+}
+
+static void _arena_free(data_arena_t *arena)
+{
+	data_arena_slab_t *slab;
+
+	xassert(arena->magic == DATA_ARENA_MAGIC);
+
+	log_flag(DATA, "%s: free arena (0x%"PRIXPTR") with %zu slabs and %zu keys",
+		 __func__, (uintptr_t) arena, arena->slab_count,
+		 arena->keys_count);
+
+	while ((slab = arena->slabs)) {
+		arena->slabs = slab->next;
+		xfree(slab);
+	}
+
+	xfree(arena->keys);
+	arena->magic = ~DATA_ARENA_MAGIC;
+	xfree(arena);
+}
+
+static data_list_t *_data_list_new(data_arena_t *arena)
+{
+	data_list_t *dl;
+
+	if (arena) {
+		dl = _arena_alloc(arena, sizeof(*dl));
+		dl->arena = arena;
+	} else {
+		dl = xmalloc(sizeof(*dl));
+	}
+
 	dl->magic = DATA_LIST_MAGIC;
 
 	log_flag(DATA, "%s: new data list (0x%"PRIXPTR")",
@@ -173,6 +383,115 @@ static data_list_t *_data_list_new(void)
 	return dl;
 }
 
+/* FNV-1a hash of dictionary key */
+static uint32_t _hash_key(const char *key)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *key; key++) {
+		hash ^= (unsigned char) *key;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static void _index_add(data_list_t *dl, data_list_node_t *dn)
+{
+	const size_t mask = dl->index_size - 1;
+	size_t slot = dn->hash & mask;
+
+	while (dl->index[slot] && (dl->index[slot] != &index_removed))
+		slot = (slot + 1) & mask;
+
+	if (!dl->index[slot])
+		dl->index_used++;
+	dl->index[slot] = dn;
+}
+
+/* (Re)build index of dictionary sized to hold count nodes */
+static void _index_rebuild(data_list_t *dl)
+{
+	size_t size = DICT_INDEX_MIN_SIZE;
+
+	/* keep load factor under 50% */
+	while (size < (dl->count * 2))
+		size *= 2;
+
+	if (dl->arena) {
+		/* old index is released with the arena */
+		dl->index = _arena_alloc(dl->arena, (size * sizeof(*dl->index)));
+	} else {
+		xfree(dl->index);
+		dl->index = xcalloc(size, sizeof(*dl->index));
+	}
+	dl->index_size = size;
+	dl->index_used = 0;
+
+	for (data_list_node_t *i = dl->begin; i; i = i->next)
+		_index_add(dl, i);
+
+	log_flag(DATA, "%s: indexed %zu keys of data list (0x%"PRIXPTR") with %zu slots",
+		 __func__, dl->count, (uintptr_t) dl, size);
+}
+
+/* Add new node (already linked into list) to index of dictionary */
+static void _index_insert(data_list_t *dl, data_list_node_t *dn)
+{
+	if (!dl->index) {
+		if (dl->count > DICT_INDEX_MIN_COUNT)
+			_index_rebuild(dl);
+		return;
+	}
+
+	/* grow (or purge removed slots) before load factor exceeds 75% */
+	if (((dl->index_used + 1) * 4) > (dl->index_size * 3))
+		_index_rebuild(dl);
+	else
+		_index_add(dl, dn);
+}
+
+static void _index_remove(data_list_t *dl, data_list_node_t *dn)
+{
+	const size_t mask = dl->index_size - 1;
+	size_t slot = dn->hash & mask;
+
+	while (dl->index[slot] != dn) {
+		xassert(dl->index[slot]);
+		slot = (slot + 1) & mask;
+	}
+
+	dl->index[slot] = &index_removed;
+}
+
+/* Find node with key in dictionary */
+static data_list_node_t *_dict_find(const data_list_t *dl, const char *key,
+				    uint32_t hash)
+{
+	if (dl->index) {
+		const size_t mask = dl->index_size - 1;
+		size_t slot = hash & mask;
+		data_list_node_t *dn;
+
+		while ((dn = dl->index[slot])) {
+			if ((dn != &index_removed) && (dn->hash == hash) &&
+			    !xstrcmp(key, dn->key))
+				return dn;
+
+			slot = (slot + 1) & mask;
+		}
+
+		return NULL;
+	}
+
+	for (data_list_node_t *i = dl->begin; i; i = i->next) {
+		if ((i->hash == hash) && !xstrcmp(key, i->key))
+			return i;
+	}
+
+	return NULL;
+}
+
 static void _check_data_list_node_magic(const data_list_node_t *dn)
 {
 	xassert(dn);
@@ -267,12 +586,18 @@ static void _release_data_list_node(data_list_t *dl, data_list_node_t *dn)
 		prev->next = dn->next;
 	}
 
+	if (dl->index)
+		_index_remove(dl, dn);
+
 	dl->count--;
 	FREE_NULL_DATA(dn->data);
-	xfree(dn->key);
 
 	dn->magic = ~DATA_LIST_NODE_MAGIC;
-	xfree(dn);
+
+	if (!dl->arena) {
+		xfree(dn->key);
+		xfree(dn);
+	}
 }
 
 static void _release_data_list(data_list_t *dl)
@@ -284,6 +609,8 @@ static void _release_data_list(data_list_t *dl)
 #endif
 
 	_check_data_list_magic(dl);
+	/* arena lists are only released with the arena */
+	xassert(!dl->arena);
 
 	if (!n) {
 		xassert(!dl->count);
@@ -293,21 +620,35 @@ static void _release_data_list(data_list_t *dl)
 
 	xassert(dl->end);
 
+	/*
+	 * Always release from the front to avoid having to walk the list to
+	 * find the previous node for every node.
+	 */
 	while((i = n)) {
 		n = i->next;
-		_release_data_list_node(dl, i);
+
+		_check_data_list_node_magic(i);
+		xassert(i == dl->begin);
+		dl->begin = n;
+		dl->count--;
+
+		FREE_NULL_DATA(i->data);
+		xfree(i->key);
+		i->magic = ~DATA_LIST_NODE_MAGIC;
+		xfree(i);
 
 #ifndef NDEBUG
 		count++;
 #endif
 	}
 
-
 #ifndef NDEBUG
 	xassert(count == init_count);
 #endif
+	dl->end = NULL;
 
 finish:
+	xfree(dl->index);
 	dl->magic = ~DATA_LIST_MAGIC;
 	xfree(dl);
 }
@@ -317,15 +658,28 @@ finish:
  * IN d - data type to take ownership of
  * IN key - dictionary key to dup or NULL
  */
-static data_list_node_t *_new_data_list_node(data_t *d, const char *key)
+static data_list_node_t *_new_data_list_node(data_list_t *dl, data_t *d,
+					      const char *key)
 {
-	data_list_node_t *dn = xmalloc(sizeof(*dn));
+	data_list_node_t *dn;
+
+	if (dl->arena)
+		dn = _arena_alloc(dl->arena, sizeof(*dn));
+	else
+		dn = xmalloc(sizeof(*dn));
+
 	dn->magic = DATA_LIST_NODE_MAGIC;
 	_check_magic(d);
 
 	dn->data = d;
-	if (key)
-		dn->key = xstrdup(key);
+	if (key) {
+		dn->hash = _hash_key(key);
+
+		if (dl->arena)
+			dn->key = _arena_intern(dl->arena, key, dn->hash);
+		else
+			dn->key = xstrdup(key);
+	}
 
 	log_flag(DATA, "%s: new data list node (0x%"PRIXPTR")",
 		 __func__, (uintptr_t) dn);
@@ -335,7 +689,7 @@ static data_list_node_t *_new_data_list_node(data_t *d, const char *key)
 
 static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
 {
-	data_list_node_t *n = _new_data_list_node(d, key);
+	data_list_node_t *n = _new_data_list_node(dl, d, key);
 	_check_data_list_magic(dl);
 	_check_magic(d);
 
@@ -353,11 +707,14 @@ static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
 	}
 
 	dl->count++;
+
+	if (key)
+		_index_insert(dl, n);
 }
 
 static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
 {
-	data_list_node_t *n = _new_data_list_node(d, key);
+	data_list_node_t *n = _new_data_list_node(dl, d, key);
 	_check_data_list_magic(dl);
 	_check_magic(d);
 
@@ -374,9 +731,17 @@ static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
 	dl->count++;
 }
 
-data_t *data_new(void)
+static data_t *_data_new(data_arena_t *arena)
 {
-	data_t *data = xmalloc(sizeof(*data));
+	data_t *data;
+
+	if (arena) {
+		data = _arena_alloc(arena, sizeof(*data));
+		data->arena = arena;
+	} else {
+		data = xmalloc(sizeof(*data));
+	}
+
 	data->magic = DATA_MAGIC;
 	data->type = DATA_TYPE_NULL;
 
@@ -386,6 +751,24 @@ data_t *data_new(void)
 	return data;
 }
 
+data_t *data_new(void)
+{
+	return _data_new(NULL);
+}
+
+extern data_t *data_new_arena(void)
+{
+	data_arena_t *arena = xmalloc(sizeof(*arena));
+
+	arena->magic = DATA_ARENA_MAGIC;
+	arena->root = _data_new(arena);
+
+	log_flag(DATA, "%s: new arena (0x%"PRIXPTR") for data (0x%"PRIXPTR")",
+		 __func__, (uintptr_t) arena, (uintptr_t) arena->root);
+
+	return arena->root;
+}
+
 static void _check_magic(const data_t *data)
 {
 	if (!data)
@@ -394,6 +777,7 @@ static void _check_magic(const data_t *data)
 	xassert(data->type > DATA_TYPE_NONE);
 	xassert(data->type < DATA_TYPE_MAX);
 	xassert(data->magic == DATA_MAGIC);
+	xassert(!data->arena || (data->arena->magic == DATA_ARENA_MAGIC));
 
 	if (data->type == DATA_TYPE_NULL)
 		/* make sure NULL type has a NULL value */
@@ -408,6 +792,13 @@ static void _release(data_t *data)
 {
 	_check_magic(data);
 
+	if (data->arena) {
+		/* all memory is released with the arena */
+		data->type = DATA_TYPE_NONE;
+		xassert(memset(&data->data, 0, sizeof(data->data)));
+		return;
+	}
+
 	switch (data->type) {
 	case DATA_TYPE_LIST:
 		_release_data_list(data->data.list_u);
@@ -441,7 +832,11 @@ extern void data_free(data_t *data)
 
 	data->magic = ~DATA_MAGIC;
 	data->type = DATA_TYPE_NONE;
-	xfree(data);
+
+	if (!data->arena)
+		xfree(data);
+	else if (data->arena->root == data)
+		_arena_free(data->arena);
 }
 
 extern data_type_t data_get_type(const data_t *data)
@@ -537,7 +932,10 @@ extern data_t *data_set_string(data_t *data, const char *value)
 	       __func__, (uintptr_t) data, value);
 
 	data->type = DATA_TYPE_STRING;
-	data->data.string_u = xstrdup(value);
+	if (data->arena)
+		data->data.string_u = _arena_strdup(data->arena, value);
+	else
+		data->data.string_u = xstrdup(value);
 
 	return data;
 }
@@ -576,8 +974,14 @@ extern data_t *data_set_string_own(data_t *data, char *value)
 		 __func__, (uintptr_t) data, value);
 
 	data->type = DATA_TYPE_STRING;
-	/* take ownership of string */
-	data->data.string_u = value;
+
+	if (data->arena) {
+		data->data.string_u = _arena_strdup(data->arena, value);
+		xfree(value);
+	} else {
+		/* take ownership of string */
+		data->data.string_u = value;
+	}
 
 	return data;
 }
@@ -594,7 +998,7 @@ extern data_t *data_set_dict(data_t *data)
 		 __func__, (uintptr_t) data);
 
 	data->type = DATA_TYPE_DICT;
-	data->data.dict_u = _data_list_new();
+	data->data.dict_u = _data_list_new(data->arena);
 
 	return data;
 }
@@ -611,7 +1015,7 @@ extern data_t *data_set_list(data_t *data)
 		 __func__, (uintptr_t) data);
 
 	data->type = DATA_TYPE_LIST;
-	data->data.list_u = _data_list_new();
+	data->data.list_u = _data_list_new(data->arena);
 
 	return data;
 }
@@ -625,7 +1029,7 @@ extern data_t *data_list_append(data_t *data)
 	if (!data || data->type != DATA_TYPE_LIST)
 		return NULL;
 
-	ndata = data_new();
+	ndata = _data_new(data->arena);
 	_data_list_append(data->data.list_u, ndata, NULL);
 
 	log_flag(DATA, "%s: list append data (0x%"PRIXPTR") to (0x%"PRIXPTR")",
@@ -642,7 +1046,7 @@ extern data_t *data_list_prepend(data_t *data)
 	if (!data || data->type != DATA_TYPE_LIST)
 		return NULL;
 
-	ndata = data_new();
+	ndata = _data_new(data->arena);
 	_data_list_prepend(data->data.list_u, ndata, NULL);
 
 	log_flag(DATA, "%s: list prepend data (0x%"PRIXPTR") to (0x%"PRIXPTR")",
@@ -724,31 +1128,16 @@ const data_t *data_key_get_const(const data_t *data, const char *key)
 		return NULL;
 
 	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
 
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
-
-	if (i)
+	if ((i = _dict_find(data->data.dict_u, key, _hash_key(key))))
 		return i->data;
 	else
 		return NULL;
 }
 
-static bool _match_string(const char *key, data_t *data, void *needle_ptr)
-{
-	const char *needle = needle_ptr;
-	return !xstrcmp(key, needle);
-}
-
 data_t *data_key_get(data_t *data, const char *key)
 {
-	return data_dict_find_first(data, _match_string, (void *) key);
+	return (data_t *) data_key_get_const(data, key);
 }
 
 extern data_t *data_key_get_int(data_t *data, int64_t key)
@@ -836,6 +1225,7 @@ extern data_t *data_dict_find_first(
 data_t *data_key_set(data_t *data, const char *key)
 {
 	data_t *d;
+	data_list_node_t *i;
 
 	_check_magic(data);
 
@@ -847,13 +1237,16 @@ data_t *data_key_set(data_t *data, const char *key)
 	if (!key || !key[0] || data->type != DATA_TYPE_DICT)
 		return NULL;
 
-	if ((d = data_key_get(data, key))) {
+	_check_data_list_magic(data->data.dict_u);
+
+	if ((i = _dict_find(data->data.dict_u, key, _hash_key(key)))) {
+		d = i->data;
 		log_flag(DATA, "%s: set existing key in data (0x%"PRIXPTR") key: %s data (0x%"PRIXPTR")",
 			 __func__, (uintptr_t) data, key, (uintptr_t) d);
 		return d;
 	}
 
-	d = data_new();
+	d = _data_new(data->arena);
 	_data_list_append(data->data.dict_u, d, key);
 
 	log_flag(DATA, "%s: set new key in data (0x%"PRIXPTR") key: %s data (0x%"PRIXPTR")",
@@ -885,17 +1278,8 @@ bool data_key_unset(data_t *data, const char *key)
 		return NULL;
 
 	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
 
-	if (!i) {
+	if (!(i = _dict_find(data->data.dict_u, key, _hash_key(key)))) {
 		log_flag(DATA, "%s: remove non-existent key in data (0x%"PRIXPTR") key: %s",
 			 __func__, (uintptr_t) data, key);
 		return false;
@@ -1223,7 +1607,7 @@ extern int data_list_for_each_const(const data_t *d, DataListForFConst f, void *
 extern int data_list_for_each(data_t *d, DataListForF f, void *arg)
 {
 	int count = 0;
-	data_list_node_t *i;
+	data_list_node_t *i, *next;
 
 	_check_magic(d);
 
@@ -1237,6 +1621,8 @@ extern int data_list_for_each(data_t *d, DataListForF f, void *arg)
 	_check_data_list_magic(d->data.list_u);
 	while (i) {
 		_check_data_list_node_magic(i);
+		/* node may be released by DATA_FOR_EACH_DELETE */
+		next = i->next;
 
 		xassert(!i->key);
 		data_for_each_cmd_t cmd = f(i->data, arg);
@@ -1262,7 +1648,7 @@ extern int data_list_for_each(data_t *d, DataListForF f, void *arg)
 		}
 
 		if (i)
-			i = i->next;
+			i = next;
 	}
 
 	return count;
@@ -1321,7 +1707,7 @@ extern int data_dict_for_each_const(const data_t *d, DataDictForFConst f, void *
 extern int data_dict_for_each(data_t *d, DataDictForF f, void *arg)
 {
 	int count = 0;
-	data_list_node_t *i;
+	data_list_node_t *i, *next;
 
 	_check_magic(d);
 
@@ -1335,6 +1721,8 @@ extern int data_dict_for_each(data_t *d, DataDictForF f, void *arg)
 	_check_data_list_magic(d->data.dict_u);
 	while (i) {
 		_check_data_list_node_magic(i);
+		/* node may be released by DATA_FOR_EACH_DELETE */
+		next = i->next;
 
 		data_for_each_cmd_t cmd = f(i->key, i->data, arg);
 		count++;
@@ -1359,7 +1747,7 @@ extern int data_dict_for_each(data_t *d, DataDictForF f, void *arg)
 		}
 
 		if (i)
-			i = i->next;
+			i = next;
 	}
 
 	return count;
@@ -145,6 +145,9 @@ extern char *data_type_to_string(data_type_t type);
 /* opaque type for list_u and dict_u */
 typedef struct data_list_s data_list_t;
 
+/* opaque type for memory arena of data tree created by data_new_arena() */
+typedef struct data_arena_s data_arena_t;
+
 /*
  * Opaque data struct to hold generic data.
  * data is based on the JSON data type and has the same types.
@@ -164,6 +167,7 @@ typedef struct {
 		double float_u;
 		bool bool_u;
 	} data;
+	data_arena_t *arena; /* arena owning memory or NULL */
 } data_t;
 
 /*
@@ -222,8 +226,25 @@ extern void data_fini(void);
  * RET data structure or will abort()
  */
 extern data_t *data_new(void);
+/*
+ * Create new data struct whose entire tree is allocated from a memory arena.
+ *
+ * All children, dictionary keys and strings of the tree are carved out of
+ * large slabs instead of being individually allocated, and dictionary keys are
+ * interned. Calling data_free() on the root releases all of the slabs at once
+ * without walking the tree. Memory of children that are removed or replaced
+ * (including by data_list_dequeue()) is only released with the root, which
+ * must outlive all of them.
+ *
+ * 	Use for large trees that are built once and then freed together.
+ * 	must call FREE_NULL_DATA() against resultant.
+ * 	do not xfree().
+ * RET data structure or will abort()
+ */
+extern data_t *data_new_arena(void);
 /*
  * safely and recursively frees all parts of data struct.
+ * 	Freeing a child of a data_new_arena() tree only marks it as released.
  * 	Try to use FREE_NULL_DATA() instead.
  * IN data structure to free
  * */
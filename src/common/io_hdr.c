@@ -36,6 +36,12 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
+#include "config.h"
+
+#if HAVE_LZ4
+#  include <lz4.h>
+#endif
+
 #include "src/common/fd.h"
 #include "src/common/io_hdr.h"
 #include "src/common/slurm_protocol_defs.h"
@@ -49,7 +55,11 @@ static int g_io_init_msg_packed_size =
 	+ sizeof(uint32_t)  /* nodeid */
 	+ (SLURM_IO_KEY_SIZE + sizeof(uint32_t)) /* signature */
 	+ sizeof(uint32_t)  /* stdout_objs */
-	+ sizeof(uint32_t); /* stderr_objs */
+	+ sizeof(uint32_t)  /* stderr_objs */
+	+ sizeof(uint16_t); /* io_flags */
+
+/* If this changes, io_batch_frame_pack|unpack must change. */
+#define IO_BATCH_HDR_SIZE (sizeof(uint16_t) + sizeof(uint32_t))
 
 #define io_init_msg_packed_size() g_io_init_msg_packed_size
 
@@ -76,6 +86,106 @@ int io_hdr_unpack(io_hdr_t *hdr, buf_t *buffer)
 	return SLURM_ERROR;
 }
 
+extern uint32_t io_batch_raw_size(void)
+{
+	return SLURM_IO_BATCH_MAX_MSGS * (MAX_MSG_LEN + io_hdr_packed_size());
+}
+
+extern uint32_t io_batch_frame_size(void)
+{
+	return io_hdr_packed_size() + IO_BATCH_HDR_SIZE + io_batch_raw_size();
+}
+
+extern uint32_t io_batch_frame_pack(char *frame, const char *raw,
+				    uint32_t raw_len, uint16_t io_flags)
+{
+	io_hdr_t header = { .type = SLURM_IO_BATCH };
+	uint16_t compress = COMPRESS_OFF;
+	uint32_t payload_len = raw_len;
+	char *payload = frame + io_hdr_packed_size() + IO_BATCH_HDR_SIZE;
+	buf_t *packbuf;
+
+	xassert(raw_len <= io_batch_raw_size());
+
+#if HAVE_LZ4
+	/*
+	 * Capping the output below raw_len makes lz4 give up on data that
+	 * would not shrink, in which case the payload is sent as is.
+	 */
+	if ((io_flags & SLURM_IO_FLAG_LZ4) && (raw_len > 1)) {
+		int n = LZ4_compress_default(raw, payload, raw_len,
+					     raw_len - 1);
+		if (n > 0) {
+			compress = COMPRESS_LZ4;
+			payload_len = n;
+		}
+	}
+#endif
+	if (compress == COMPRESS_OFF)
+		memcpy(payload, raw, raw_len);
+
+	header.length = IO_BATCH_HDR_SIZE + payload_len;
+
+	packbuf = create_buf(frame, io_hdr_packed_size() + IO_BATCH_HDR_SIZE);
+	io_hdr_pack(&header, packbuf);
+	pack16(compress, packbuf);
+	pack32(raw_len, packbuf);
+	/* free packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	FREE_NULL_BUFFER(packbuf);
+
+	return io_hdr_packed_size() + header.length;
+}
+
+extern int io_batch_frame_unpack(const char *payload, uint32_t len, char *raw)
+{
+	uint16_t compress = COMPRESS_OFF;
+	uint32_t raw_len = 0;
+	buf_t *buffer;
+	int rc = SLURM_SUCCESS;
+
+	if (len < IO_BATCH_HDR_SIZE) {
+		error("%s: truncated stdio batch frame", __func__);
+		return -1;
+	}
+
+	buffer = create_buf((char *) payload, IO_BATCH_HDR_SIZE);
+	if (unpack16(&compress, buffer) || unpack32(&raw_len, buffer))
+		rc = SLURM_ERROR;
+	/* free buffer, but not the memory to which it points */
+	buffer->head = NULL;
+	FREE_NULL_BUFFER(buffer);
+
+	if (rc || (raw_len > io_batch_raw_size())) {
+		error("%s: malformed stdio batch frame", __func__);
+		return -1;
+	}
+
+	payload += IO_BATCH_HDR_SIZE;
+	len -= IO_BATCH_HDR_SIZE;
+
+	switch (compress) {
+	case COMPRESS_OFF:
+		if (len != raw_len)
+			break;
+		memcpy(raw, payload, raw_len);
+		return raw_len;
+#if HAVE_LZ4
+	case COMPRESS_LZ4:
+		if (LZ4_decompress_safe(payload, raw, len, raw_len) != raw_len)
+			break;
+		return raw_len;
+#endif
+	default:
+		error("%s: unsupported compression type %hu",
+		      __func__, compress);
+		return -1;
+	}
+
+	error("%s: stdio batch frame length mismatch", __func__);
+	return -1;
+}
+
 /*
  * Only return when the all of the bytes have been read, or an unignorable
  * error has occurred.
@@ -169,6 +279,8 @@ static int io_init_msg_pack(io_init_msg_t *hdr, buf_t *buffer)
 		pack32(hdr->stdout_objs, buffer);
 		pack32(hdr->stderr_objs, buffer);
 		packmem(hdr->io_key, hdr->io_key_len, buffer);
+		if (hdr->version >= SLURM_23_11_PROTOCOL_VERSION)
+			pack16(hdr->io_flags, buffer);
 
 		tail_offset = get_buf_offset(buffer);
 		len = tail_offset - top_offset - sizeof(len);
@@ -189,11 +301,18 @@ static int io_init_msg_unpack(io_init_msg_t *hdr, buf_t *buffer)
 	/* If this function changes, io_init_msg_packed_size must change. */
 
 	safe_unpack16(&hdr->version, buffer);
-	if (hdr->version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (hdr->version >= SLURM_23_11_PROTOCOL_VERSION) {
+		safe_unpack32(&hdr->nodeid, buffer);
+		safe_unpack32(&hdr->stdout_objs, buffer);
+		safe_unpack32(&hdr->stderr_objs, buffer);
+		safe_unpackmem_xmalloc(&hdr->io_key, &hdr->io_key_len, buffer);
+		safe_unpack16(&hdr->io_flags, buffer);
+	} else if (hdr->version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&hdr->nodeid, buffer);
 		safe_unpack32(&hdr->stdout_objs, buffer);
 		safe_unpack32(&hdr->stderr_objs, buffer);
 		safe_unpackmem_xmalloc(&hdr->io_key, &hdr->io_key_len, buffer);
+		hdr->io_flags = 0;
 	} else
 		goto unpack_error;
 
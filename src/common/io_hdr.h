@@ -54,6 +54,14 @@
 #define SLURM_IO_STDERR 2
 #define SLURM_IO_ALLSTDIN 3
 #define SLURM_IO_CONNECTION_TEST 4
+#define SLURM_IO_BATCH 5	/* several messages coalesced in one frame */
+
+/* io_init_msg_t io_flags, negotiated I/O modes */
+#define SLURM_IO_FLAG_COALESCE	SLURM_BIT(0) /* stepd may send SLURM_IO_BATCH */
+#define SLURM_IO_FLAG_LZ4	SLURM_BIT(1) /* SLURM_IO_BATCH may use lz4 */
+
+/* Most messages coalesced in one SLURM_IO_BATCH frame */
+#define SLURM_IO_BATCH_MAX_MSGS 16
 
 typedef struct {
 	uint16_t      version;
@@ -62,6 +70,7 @@ typedef struct {
 	uint32_t      nodeid;
 	uint32_t      stdout_objs;
 	uint32_t      stderr_objs;
+	uint16_t      io_flags;	/* SLURM_IO_FLAG_* */
 } io_init_msg_t;
 
 
@@ -82,6 +91,39 @@ void io_hdr_pack(io_hdr_t *hdr, buf_t *buffer);
 int io_hdr_unpack(io_hdr_t *hdr, buf_t *buffer);
 int io_hdr_read_fd(int fd, io_hdr_t *hdr);
 
+/*
+ * Return the largest number of bytes of packed messages (io_hdr_t plus data)
+ * carried by one SLURM_IO_BATCH frame.
+ */
+extern uint32_t io_batch_raw_size(void);
+
+/*
+ * Return the largest size of a complete SLURM_IO_BATCH frame, including its
+ * io_hdr_t.
+ */
+extern uint32_t io_batch_frame_size(void);
+
+/*
+ * Build a SLURM_IO_BATCH frame out of already packed messages.
+ * IN/OUT frame - buffer of at least io_batch_frame_size() bytes
+ * IN raw - packed messages to send
+ * IN raw_len - bytes in raw, no more than io_batch_raw_size()
+ * IN io_flags - SLURM_IO_FLAG_* negotiated for the connection, the payload
+ *	is only compressed when that makes it smaller
+ * RET size of the frame written into frame
+ */
+extern uint32_t io_batch_frame_pack(char *frame, const char *raw,
+				    uint32_t raw_len, uint16_t io_flags);
+
+/*
+ * Recover the packed messages carried by a SLURM_IO_BATCH frame.
+ * IN payload - frame body following its io_hdr_t
+ * IN len - length of the frame body
+ * IN/OUT raw - buffer of at least io_batch_raw_size() bytes
+ * RET bytes written into raw or -1 on error
+ */
+extern int io_batch_frame_unpack(const char *payload, uint32_t len, char *raw);
+
 /*
  * Validate io init msg
  */
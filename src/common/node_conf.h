@@ -153,6 +153,8 @@ struct node_record {
 	time_t power_save_req_time;	/* Time of power_save request */
 	uint16_t protocol_version;	/* Slurm version number */
 	uint64_t real_memory;		/* MB real memory on the node */
+	time_t reg_epoch;		/* timestamp of last registration that
+					 * passed full validation */
 	char *reason; 			/* why a node is DOWN or DRAINING */
 	time_t reason_time;		/* Time stamp when reason was
 					 * set, ignore if no reason is set. */
@@ -1630,6 +1630,8 @@ uint16_t parse_compress_type(const char *arg)
 
 	if (!strcasecmp(arg, "lz4"))
 		return COMPRESS_LZ4;
+	else if (!strcasecmp(arg, "zstd"))
+		return COMPRESS_ZSTD;
 	else if (!strcasecmp(arg, "none"))
 		return COMPRESS_OFF;
 
@@ -439,6 +439,8 @@ slurm_errtab_t slurm_errtab[] = {
 	  "Job killed due node failure" },
 	{ ERRTAB_ENTRY(ESLURM_EMPTY_LIST),
 	  "Empty list" },
+	{ ERRTAB_ENTRY(ESLURM_NODE_REG_STALE),
+	  "Node registration is stale, full registration required" },
 
 	/* SPANK errors */
 	{ ERRTAB_ENTRY(ESPANK_ERROR),
@@ -509,6 +511,8 @@ slurm_errtab_t slurm_errtab[] = {
 	  "Unable to satisfy cpu bind request"			},
 	{ ERRTAB_ENTRY(ESLURMD_CPU_LAYOUT_ERROR),
 	  "Unable to layout tasks on given cpus"		},
+	{ ERRTAB_ENTRY(ESLURMD_BCAST_CACHE_MISS),
+	  "File broadcast block not found in cache"		},
 
 	/* socket specific Slurm communications error */
 
@@ -973,6 +973,8 @@ static char *arg_get_compress(slurm_opt_t *opt)
 
 	if (opt->srun_opt->compress == COMPRESS_LZ4)
 		return xstrdup("lz4");
+	if (opt->srun_opt->compress == COMPRESS_ZSTD)
+		return xstrdup("zstd");
 	return xstrdup("none");
 }
 static void arg_reset_compress(slurm_opt_t *opt)
@@ -2383,6 +2385,55 @@ static slurm_cli_opt_t slurm_opt_interactive = {
 	.reset_func = arg_reset_interactive,
 };
 
+static int arg_set_io_coalesce(slurm_opt_t *opt, const char *arg)
+{
+	if (!opt->srun_opt)
+		return SLURM_ERROR;
+
+	/* unlike --compress, no argument means no compression */
+	if (!arg || !arg[0] || !xstrcasecmp(arg, "none")) {
+		opt->srun_opt->io_compress = COMPRESS_OFF;
+	} else if (!xstrcasecmp(arg, "lz4")) {
+		opt->srun_opt->io_compress = COMPRESS_LZ4;
+	} else {
+		error("Invalid --io-coalesce specification");
+		return SLURM_ERROR;
+	}
+	opt->srun_opt->io_coalesce = true;
+
+	return SLURM_SUCCESS;
+}
+
+static char *arg_get_io_coalesce(slurm_opt_t *opt)
+{
+	if (!opt->srun_opt)
+		return xstrdup("invalid-context");
+
+	if (!opt->srun_opt->io_coalesce)
+		return xstrdup("unset");
+	if (opt->srun_opt->io_compress == COMPRESS_LZ4)
+		return xstrdup("lz4");
+	return xstrdup("none");
+}
+
+static void arg_reset_io_coalesce(slurm_opt_t *opt)
+{
+	if (opt->srun_opt) {
+		opt->srun_opt->io_coalesce = false;
+		opt->srun_opt->io_compress = COMPRESS_OFF;
+	}
+}
+
+static slurm_cli_opt_t slurm_opt_io_coalesce = {
+	.name = "io-coalesce",
+	.has_arg = optional_argument,
+	.val = LONG_OPT_IO_COALESCE,
+	.set_func_srun = arg_set_io_coalesce,
+	.get_func = arg_get_io_coalesce,
+	.reset_func = arg_reset_io_coalesce,
+	.reset_each_pass = true,
+};
+
 static int arg_set_jobid(slurm_opt_t *opt, const char *arg)
 {
 	slurm_selected_step_t *step;
@@ -5217,6 +5268,7 @@ static const slurm_cli_opt_t *common_options[] = {
 	&slurm_opt_immediate,
 	&slurm_opt_input,
 	&slurm_opt_interactive,
+	&slurm_opt_io_coalesce,
 	&slurm_opt_jobid,
 	&slurm_opt_job_name,
 	&slurm_opt_kill_command,
@@ -118,6 +118,7 @@ enum {
 	LONG_OPT_HINT,
 	LONG_OPT_IGNORE_PBS,
 	LONG_OPT_INTERACTIVE,
+	LONG_OPT_IO_COALESCE,
 	LONG_OPT_JOBID,
 	LONG_OPT_KILL_INV_DEP,
 	LONG_OPT_LAUNCH_CMD,
@@ -249,6 +250,8 @@ typedef struct {
 	bool exact;			/* --exact			*/
 	bool exclusive;			/* --exclusive			*/
 	bool interactive;		/* --interactive		*/
+	bool io_coalesce;		/* --io-coalesce			*/
+	uint16_t io_compress;		/* --io-coalesce=<compression>	*/
 	uint32_t jobid;			/* --jobid			*/
 	uint32_t array_task_id;		/* --jobid			*/
 	int32_t kill_bad_exit;		/* --kill-on-bad-exit		*/
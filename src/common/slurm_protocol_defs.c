@@ -1887,6 +1887,18 @@ extern void slurm_free_epilog_complete_msg(epilog_complete_msg_t * msg)
 	}
 }
 
+extern void slurm_free_epilog_complete_batch_msg(
+	epilog_complete_batch_msg_t *msg)
+{
+	if (msg) {
+		for (int i = 0; msg->node_names && (i < msg->node_cnt); i++)
+			xfree(msg->node_names[i]);
+		xfree(msg->node_names);
+		xfree(msg->return_codes);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_srun_job_complete_msg(
 		srun_job_complete_msg_t * msg)
 {
@@ -5407,6 +5419,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case MESSAGE_EPILOG_COMPLETE:
 		slurm_free_epilog_complete_msg(data);
 		break;
+	case MESSAGE_EPILOG_COMPLETE_BATCH:
+		slurm_free_epilog_complete_batch_msg(data);
+		break;
 	case REQUEST_KILL_JOB:
 	case REQUEST_CANCEL_JOB_STEP:
 	case SRUN_STEP_SIGNAL:
@@ -6240,6 +6255,8 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:				/* 6019 */
 		return "RESPONSE_PROLOG_EXECUTING";
+	case MESSAGE_EPILOG_COMPLETE_BATCH:
+		return "MESSAGE_EPILOG_COMPLETE_BATCH";
 
 	case SRUN_PING:						/* 7001 */
 		return "SRUN_PING";
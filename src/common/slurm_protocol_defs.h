@@ -191,6 +191,7 @@
 
 /* was  SLURMD_REG_FLAG_STARTUP  0x0001, reusable in v23.11 */
 #define SLURMD_REG_FLAG_RESP     0x0002
+#define SLURMD_REG_FLAG_UNCHANGED 0x0004 /* nothing changed since reg_epoch */
 
 #define RESV_FREE_STR_USER      SLURM_BIT(0)
 #define RESV_FREE_STR_ACCT      SLURM_BIT(1)
@@ -428,6 +429,7 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,	/* 6019 */
+	MESSAGE_EPILOG_COMPLETE_BATCH,
 
 	REQUEST_PERSIST_INIT = 6500,
 
@@ -758,6 +760,13 @@ typedef struct epilog_complete_msg {
 	char    *node_name;
 } epilog_complete_msg_t;
 
+typedef struct {
+	uint32_t job_id;
+	uint32_t node_cnt;	/* number of nodes reported */
+	char **node_names;
+	uint32_t *return_codes;	/* epilog return code of each node */
+} epilog_complete_batch_msg_t;
+
 #define REBOOT_FLAGS_ASAP 0x0001	/* Drain to reboot ASAP */
 typedef struct reboot_msg {
 	char *features;
@@ -866,9 +875,10 @@ typedef struct job_step_create_response_msg {
 #define LAUNCH_PTY		SLURM_BIT(2)
 #define LAUNCH_BUFFERED_IO	SLURM_BIT(3)
 #define LAUNCH_LABEL_IO		SLURM_BIT(4)
-/* free for reuse two versions after 22.05: SLURM_BIT(5) */
+#define LAUNCH_IO_COALESCE	SLURM_BIT(5)
 #define LAUNCH_NO_ALLOC 	SLURM_BIT(6)
 #define LAUNCH_OVERCOMMIT 	SLURM_BIT(7)
+#define LAUNCH_IO_LZ4		SLURM_BIT(8)
 
 typedef struct launch_tasks_request_msg {
 	uint32_t  het_job_node_offset;	/* Hetjob node offset or NO_VAL */
@@ -1213,6 +1223,7 @@ enum compress_type {
 	COMPRESS_OFF = 0,	/* no compression */
 				/* = 1 was zlib */
 	COMPRESS_LZ4 = 2,	/* lz4 compression */
+	COMPRESS_ZSTD = 3,	/* zstd compression */
 };
 
 typedef enum {
@@ -1221,6 +1232,8 @@ typedef enum {
 	FILE_BCAST_LAST_BLOCK = 1 << 1,	/* last file block */
 	FILE_BCAST_SO = 1 << 2, 	/* shared object */
 	FILE_BCAST_EXE = 1 << 3,	/* executable ahead of shared object */
+	FILE_BCAST_CACHE = 1 << 4,	/* block_hash set, cache the block */
+	FILE_BCAST_CACHE_PROBE = 1 << 5, /* no data, use cached block_hash */
 } file_bcast_flags_t;
 
 typedef struct file_bcast_msg {
@@ -1239,6 +1252,7 @@ typedef struct file_bcast_msg {
 	uint64_t block_offset;	/* offset for this data block */
 	uint32_t uncomp_len;	/* uncompressed length of this data block */
 	char *block;		/* data for this block */
+	slurm_hash_t block_hash; /* hash of uncompressed block data */
 	uint64_t file_size;	/* file size */
 } file_bcast_msg_t;
 
@@ -1342,6 +1356,8 @@ typedef struct slurm_node_registration_status_msg {
 	uint16_t boards;
 	char *os;
 	uint64_t real_memory;
+	time_t reg_epoch;	/* timestamp of the last full registration
+				 * this one is unchanged from */
 	time_t slurmd_start_time;
 	uint32_t status;	/* node status code, same as return codes */
 	slurm_step_id_t *step_id;	/* IDs of running job steps (if any) */
@@ -1715,6 +1731,8 @@ extern void slurm_free_reattach_tasks_response_msg(
 extern void slurm_free_kill_job_msg(kill_job_msg_t * msg);
 extern void slurm_free_job_step_kill_msg(job_step_kill_msg_t * msg);
 extern void slurm_free_epilog_complete_msg(epilog_complete_msg_t * msg);
+extern void slurm_free_epilog_complete_batch_msg(
+	epilog_complete_batch_msg_t *msg);
 extern void slurm_free_srun_job_complete_msg(srun_job_complete_msg_t * msg);
 extern void slurm_free_srun_ping_msg(srun_ping_msg_t * msg);
 extern void slurm_free_net_forward_msg(net_forward_msg_t *msg);
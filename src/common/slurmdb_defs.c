@@ -4415,6 +4415,17 @@ extern void slurmdb_destroy_rollup_stats(void *object)
 	xfree(rollup_stats);
 }
 
+extern void slurmdb_destroy_stmt_stats(void *object)
+{
+	slurmdb_stmt_stats_t *stmt_stats = object;
+
+	if (!stmt_stats)
+		return;
+
+	xfree(stmt_stats->name);
+	xfree(stmt_stats);
+}
+
 extern void slurmdb_free_stats_rec_members(void *object)
 {
 	slurmdb_stats_rec_t *rpc_stats = (slurmdb_stats_rec_t *)object;
@@ -4426,6 +4437,7 @@ extern void slurmdb_free_stats_rec_members(void *object)
 
 	FREE_NULL_LIST(rpc_stats->rollup_stats);
 	FREE_NULL_LIST(rpc_stats->rpc_list);
+	FREE_NULL_LIST(rpc_stats->stmt_stats);
 	FREE_NULL_LIST(rpc_stats->user_list);
 }
 
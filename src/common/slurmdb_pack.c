@@ -5104,6 +5104,51 @@ unpack_error:
 
 }
 
+extern void slurmdb_pack_stmt_stats(void *in, uint16_t protocol_version,
+				    buf_t *buffer)
+{
+	slurmdb_stmt_stats_t *object = in;
+
+	if (protocol_version >= SLURM_23_11_PROTOCOL_VERSION) {
+		pack64(object->cnt, buffer);
+		packstr(object->name, buffer);
+		pack64(object->prepare_cnt, buffer);
+		pack64(object->time, buffer);
+		pack64(object->time_max, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+	}
+}
+
+extern int slurmdb_unpack_stmt_stats(void **object, uint16_t protocol_version,
+				     buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+	slurmdb_stmt_stats_t *object_ptr = xmalloc(sizeof(*object_ptr));
+
+	*object = object_ptr;
+
+	if (protocol_version >= SLURM_23_11_PROTOCOL_VERSION) {
+		safe_unpack64(&object_ptr->cnt, buffer);
+		safe_unpackstr_xmalloc(&object_ptr->name, &uint32_tmp, buffer);
+		safe_unpack64(&object_ptr->prepare_cnt, buffer);
+		safe_unpack64(&object_ptr->time, buffer);
+		safe_unpack64(&object_ptr->time_max, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurmdb_destroy_stmt_stats(object_ptr);
+	*object = NULL;
+	return SLURM_ERROR;
+}
+
 extern void slurmdb_pack_rpc_obj(void *in, uint16_t protocol_version,
 				 buf_t *buffer)
 {
@@ -5224,7 +5269,31 @@ extern void slurmdb_pack_stats_msg(void *object, uint16_t protocol_version,
 {
 	slurmdb_stats_rec_t *stats_ptr = (slurmdb_stats_rec_t *) object;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_23_11_PROTOCOL_VERSION) {
+		slurmdb_pack_rollup_stats(stats_ptr->dbd_rollup_stats,
+					  protocol_version, buffer);
+		slurm_pack_list(stats_ptr->rollup_stats,
+				slurmdb_pack_rollup_stats,
+				buffer, protocol_version);
+
+		slurm_pack_list(stats_ptr->rpc_list,
+				slurmdb_pack_rpc_obj,
+				buffer, protocol_version);
+
+		pack_time(stats_ptr->time_start, buffer);
+
+		slurm_pack_list(stats_ptr->user_list,
+				slurmdb_pack_rpc_obj,
+				buffer, protocol_version);
+
+		pack64(stats_ptr->batch_cnt, buffer);
+		pack64(stats_ptr->batch_records, buffer);
+		pack64(stats_ptr->batch_time, buffer);
+
+		slurm_pack_list(stats_ptr->stmt_stats,
+				slurmdb_pack_stmt_stats,
+				buffer, protocol_version);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		slurmdb_pack_rollup_stats(stats_ptr->dbd_rollup_stats,
 					  protocol_version, buffer);
 		slurm_pack_list(stats_ptr->rollup_stats,
@@ -5253,7 +5322,47 @@ extern int slurmdb_unpack_stats_msg(void **object, uint16_t protocol_version,
 		xmalloc(sizeof(slurmdb_stats_rec_t));
 
 	*object = stats_ptr;
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_23_11_PROTOCOL_VERSION) {
+		/* Rollup statistics */
+		if (slurmdb_unpack_rollup_stats(
+			    (void **)&stats_ptr->dbd_rollup_stats,
+			    protocol_version, buffer)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+		if (slurm_unpack_list(&stats_ptr->rollup_stats,
+				      slurmdb_unpack_rollup_stats,
+				      slurmdb_destroy_rollup_stats,
+				      buffer, protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+
+		if (slurm_unpack_list(&stats_ptr->rpc_list,
+				      slurmdb_unpack_rpc_obj,
+				      slurmdb_destroy_rpc_obj,
+				      buffer, protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+
+		safe_unpack_time(&stats_ptr->time_start, buffer);
+
+		if (slurm_unpack_list(&stats_ptr->user_list,
+				      slurmdb_unpack_rpc_obj,
+				      slurmdb_destroy_rpc_obj,
+				      buffer, protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+
+		safe_unpack64(&stats_ptr->batch_cnt, buffer);
+		safe_unpack64(&stats_ptr->batch_records, buffer);
+		safe_unpack64(&stats_ptr->batch_time, buffer);
+
+		if (slurm_unpack_list(&stats_ptr->stmt_stats,
+				      slurmdb_unpack_stmt_stats,
+				      slurmdb_destroy_stmt_stats,
+				      buffer, protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		/* Rollup statistics */
 		if (slurmdb_unpack_rollup_stats(
 			    (void **)&stats_ptr->dbd_rollup_stats,
@@ -232,6 +232,11 @@ extern void slurmdb_pack_rpc_obj(void *in, uint16_t protocol_version,
 extern int slurmdb_unpack_rpc_obj(void **object, uint16_t protocol_version,
 				  buf_t *buffer);
 
+extern void slurmdb_pack_stmt_stats(void *in, uint16_t protocol_version,
+				    buf_t *buffer);
+extern int slurmdb_unpack_stmt_stats(void **object, uint16_t protocol_version,
+				     buf_t *buffer);
+
 extern void slurmdb_pack_rollup_stats(void *object, uint16_t protocol_version,
 				      buf_t *buffer);
 extern int slurmdb_unpack_rollup_stats(void **object, uint16_t protocol_version,
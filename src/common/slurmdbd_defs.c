@@ -117,6 +117,8 @@ extern slurmdbd_msg_type_t str_2_slurmdbd_msg_type(char *msg_type)
 		return DBD_GOT_FEDERATIONS;
 	} else if (!xstrcasecmp(msg_type, "Got Jobs")) {
 		return DBD_GOT_JOBS;
+	} else if (!xstrcasecmp(msg_type, "Got Jobs Chunk")) {
+		return DBD_GOT_JOBS_CHUNK;
 	} else if (!xstrcasecmp(msg_type, "Got List")) {
 		return DBD_GOT_LIST;
 	} else if (!xstrcasecmp(msg_type, "Got Problems")) {
@@ -434,6 +436,12 @@ extern char *slurmdbd_msg_type_2_str(slurmdbd_msg_type_t msg_type, int get_enum)
 		} else
 			return "Got Jobs";
 		break;
+	case DBD_GOT_JOBS_CHUNK:
+		if (get_enum) {
+			return "DBD_GOT_JOBS_CHUNK";
+		} else
+			return "Got Jobs Chunk";
+		break;
 	case DBD_GOT_LIST:
 		if (get_enum) {
 			return "DBD_GOT_LIST";
@@ -846,6 +854,7 @@ extern void slurmdbd_free_msg(persist_msg_t *msg)
 	case DBD_GOT_EVENTS:
 	case DBD_GOT_FEDERATIONS:
 	case DBD_GOT_JOBS:
+	case DBD_GOT_JOBS_CHUNK:
 	case DBD_GOT_LIST:
 	case DBD_GOT_PROBS:
 	case DBD_GOT_RES:
@@ -49,6 +49,10 @@
 #include "src/common/read_config.h"
 
 #define MAX_DEADLOCK_ATTEMPTS 10
+#define MAX_STMT_CACHE 128
+
+static List stmt_stats_list = NULL;
+static pthread_mutex_t stmt_stats_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static char *table_defs_table = "table_defs_table";
 
@@ -57,6 +61,11 @@ typedef struct {
 	char *columns;
 } db_key_t;
 
+typedef struct {
+	char *query;
+	MYSQL_STMT *stmt;
+} db_stmt_t;
+
 static void _destroy_db_key(void *arg)
 {
 	db_key_t *db_key = (db_key_t *)arg;
@@ -134,7 +143,7 @@ static MYSQL_RES *_get_last_result(MYSQL *db_conn)
 }
 
 /* NOTE: Ensure that mysql_conn->lock is set on function entry */
-static int _mysql_query_internal(MYSQL *db_conn, char *query)
+static int _mysql_query_quiet(MYSQL *db_conn, char *query, bool quiet)
 {
 	int rc = SLURM_SUCCESS;
 	int deadlock_attempt = 0;
@@ -188,7 +197,12 @@ try_again:
 			      "You will need to call 'mysqladmin flush-hosts' "
 			      "to regain connectivity.");
 		}
-		error("mysql_query failed: %d %s\n%s", errno, err_str, query);
+		if (quiet)
+			debug("mysql_query failed: %d %s\n%s",
+			      errno, err_str, query);
+		else
+			error("mysql_query failed: %d %s\n%s",
+			      errno, err_str, query);
 		rc = SLURM_ERROR;
 	}
 end_it:
@@ -202,6 +216,11 @@ end_it:
 	return rc;
 }
 
+static int _mysql_query_internal(MYSQL *db_conn, char *query)
+{
+	return _mysql_query_quiet(db_conn, query, false);
+}
+
 /*
  * Determine if a database server upgrade has taken place and if so, check to
  * see if the candidate table alteration query should be used to alter the table
@@ -790,10 +809,16 @@ extern int destroy_mysql_conn(mysql_conn_t *mysql_conn)
 {
 	if (mysql_conn) {
 		mysql_db_close_db_connection(mysql_conn);
+		xfree(mysql_conn->batch_query);
+		xfree(mysql_conn->batch_rows);
 		xfree(mysql_conn->pre_commit_query);
 		xfree(mysql_conn->cluster_name);
+		destroy_mysql_conn(mysql_conn->replica);
+		destroy_mysql_conn(mysql_conn->shared_conn);
+		xhash_free(mysql_conn->stmt_cache);
 		slurm_mutex_destroy(&mysql_conn->lock);
 		FREE_NULL_LIST(mysql_conn->update_list);
+		FREE_NULL_LIST(mysql_conn->job_cache_list);
 		xfree(mysql_conn);
 	}
 
@@ -855,6 +880,9 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 
 	slurm_mutex_lock(&mysql_conn->lock);
 
+	/* Prepared statements do not survive the connection */
+	xhash_clear(mysql_conn->stmt_cache);
+
 	if (!(mysql_conn->db_conn = mysql_init(mysql_conn->db_conn))) {
 		slurm_mutex_unlock(&mysql_conn->lock);
 		fatal("mysql_init failed: %s",
@@ -884,7 +912,9 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 			const char *err_str = NULL;
 			int err = mysql_errno(mysql_conn->db_conn);
 
-			if (err == ER_BAD_DB_ERROR) {
+			/* Never write to a read replica */
+			if ((err == ER_BAD_DB_ERROR) &&
+			    !(mysql_conn->flags & DB_CONN_FLAG_REPLICA)) {
 				debug("Database %s not created.  Creating",
 				      db_name);
 				rc = _create_db(db_name, db_info);
@@ -932,6 +962,7 @@ extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
 	slurm_mutex_lock(&mysql_conn->lock);
 	if (mysql_conn && mysql_conn->db_conn) {
+		xhash_clear(mysql_conn->stmt_cache);
 		if (mysql_thread_safe())
 			mysql_thread_end();
 		mysql_close(mysql_conn->db_conn);
@@ -1057,13 +1088,14 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 
 }
 
-extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
-				     char *query, bool last)
+static MYSQL_RES *_query_ret(mysql_conn_t *mysql_conn, char *query, bool last,
+			     bool quiet)
 {
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
-	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
+	if (_mysql_query_quiet(mysql_conn->db_conn, query, quiet) !=
+	    SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
 		else if (last)
@@ -1087,6 +1119,49 @@ fini:
 	return result;
 }
 
+extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
+				     char *query, bool last)
+{
+	return _query_ret(mysql_conn, query, last, false);
+}
+
+extern MYSQL_RES *mysql_db_query_ret_quiet(mysql_conn_t *mysql_conn,
+					   char *query, bool last)
+{
+	return _query_ret(mysql_conn, query, last, true);
+}
+
+/*
+ * Like mysql_db_query_ret() but the rows are not read into memory up front,
+ * they are pulled from the server as mysql_fetch_row() is called.  Nothing
+ * else can be sent over this connection until the result has been freed.
+ */
+extern MYSQL_RES *mysql_db_query_use(mysql_conn_t *mysql_conn, char *query)
+{
+	MYSQL_RES *result = NULL;
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR) {
+		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
+			goto fini;
+		result = mysql_use_result(mysql_conn->db_conn);
+		/*
+		 * Starting in MariaDB 10.2 many of the api commands started
+		 * setting errno erroneously.
+		 */
+		errno = 0;
+		if (!result && mysql_field_count(mysql_conn->db_conn)) {
+			/* should have returned data */
+			error("We should have gotten a result: '%m' '%s'",
+			      mysql_error(mysql_conn->db_conn));
+		}
+	}
+
+fini:
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return result;
+}
+
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 {
 	int rc = SLURM_SUCCESS;
@@ -1117,6 +1192,326 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+static void _destroy_db_stmt(void *arg)
+{
+	db_stmt_t *db_stmt = arg;
+
+	if (!db_stmt)
+		return;
+
+	if (db_stmt->stmt)
+		mysql_stmt_close(db_stmt->stmt);
+	xfree(db_stmt->query);
+	xfree(db_stmt);
+}
+
+static void _db_stmt_id(void *item, const char **key, uint32_t *key_len)
+{
+	db_stmt_t *db_stmt = item;
+
+	*key = db_stmt->query;
+	*key_len = strlen(db_stmt->query);
+}
+
+static int _find_stmt_stats(void *x, void *key)
+{
+	slurmdb_stmt_stats_t *stmt_stats = x;
+
+	return !xstrcmp(stmt_stats->name, key);
+}
+
+static void _record_stmt_stats(const char *name, bool prepared,
+			       uint64_t usec)
+{
+	slurmdb_stmt_stats_t *stmt_stats;
+
+	slurm_mutex_lock(&stmt_stats_lock);
+	if (!stmt_stats_list)
+		stmt_stats_list = list_create(slurmdb_destroy_stmt_stats);
+	if (!(stmt_stats = list_find_first(stmt_stats_list, _find_stmt_stats,
+					   (void *) name))) {
+		stmt_stats = xmalloc(sizeof(*stmt_stats));
+		stmt_stats->name = xstrdup(name);
+		list_append(stmt_stats_list, stmt_stats);
+	}
+	stmt_stats->cnt++;
+	if (prepared)
+		stmt_stats->prepare_cnt++;
+	stmt_stats->time += usec;
+	stmt_stats->time_max = MAX(stmt_stats->time_max, usec);
+	slurm_mutex_unlock(&stmt_stats_lock);
+}
+
+/*
+ * Strings coming from slurmdbd are escaped for use in a text query already.
+ * Undo that since bound values go to the server as is.
+ */
+static char *_unescape(const char *str, unsigned long *len)
+{
+	char *out = xmalloc(strlen(str) + 1);
+	char *pos = out;
+
+	for (; *str; str++) {
+		if ((*str == '\\') && str[1])
+			str++;
+		*pos++ = *str;
+	}
+	*len = pos - out;
+
+	return out;
+}
+
+static void _bind_params(MYSQL_BIND *bind, char **strs, db_param_t *params,
+			 uint32_t param_cnt)
+{
+	for (int i = 0; i < param_cnt; i++) {
+		switch (params[i].type) {
+		case DB_PARAM_NULL:
+			bind[i].buffer_type = MYSQL_TYPE_NULL;
+			break;
+		case DB_PARAM_DOUBLE:
+			bind[i].buffer_type = MYSQL_TYPE_DOUBLE;
+			bind[i].buffer = &params[i].value.d;
+			break;
+		case DB_PARAM_ESCAPED:
+			strs[i] = _unescape(params[i].value.s,
+					    &bind[i].buffer_length);
+			bind[i].buffer_type = MYSQL_TYPE_STRING;
+			bind[i].buffer = strs[i];
+			break;
+		case DB_PARAM_INT:
+			bind[i].buffer_type = MYSQL_TYPE_LONGLONG;
+			bind[i].buffer = &params[i].value.i;
+			break;
+		case DB_PARAM_STR:
+			bind[i].buffer_type = MYSQL_TYPE_STRING;
+			bind[i].buffer = (char *) params[i].value.s;
+			bind[i].buffer_length = strlen(params[i].value.s);
+			break;
+		case DB_PARAM_UINT:
+			bind[i].buffer_type = MYSQL_TYPE_LONGLONG;
+			bind[i].buffer = &params[i].value.u;
+			bind[i].is_unsigned = true;
+			break;
+		}
+	}
+}
+
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static db_stmt_t *_prepare_stmt(mysql_conn_t *mysql_conn, char *query,
+				uint32_t param_cnt)
+{
+	db_stmt_t *db_stmt = xmalloc(sizeof(*db_stmt));
+
+	db_stmt->query = xstrdup(query);
+	if (!(db_stmt->stmt = mysql_stmt_init(mysql_conn->db_conn))) {
+		error("mysql_stmt_init failed: %d %s",
+		      mysql_errno(mysql_conn->db_conn),
+		      mysql_error(mysql_conn->db_conn));
+		_destroy_db_stmt(db_stmt);
+		return NULL;
+	}
+
+	if (mysql_stmt_prepare(db_stmt->stmt, query, strlen(query))) {
+		error("mysql_stmt_prepare failed: %d %s\n%s",
+		      mysql_stmt_errno(db_stmt->stmt),
+		      mysql_stmt_error(db_stmt->stmt), query);
+		_destroy_db_stmt(db_stmt);
+		return NULL;
+	}
+
+	if (mysql_stmt_param_count(db_stmt->stmt) != param_cnt) {
+		error("%s: statement takes %lu parameters, %u given\n%s",
+		      __func__, mysql_stmt_param_count(db_stmt->stmt),
+		      param_cnt, query);
+		_destroy_db_stmt(db_stmt);
+		return NULL;
+	}
+
+	return db_stmt;
+}
+
+extern int mysql_db_stmt_query(mysql_conn_t *mysql_conn, const char *name,
+			       char *query, db_param_t *params,
+			       uint32_t param_cnt)
+{
+	int rc = SLURM_SUCCESS;
+	int deadlock_attempt = 0;
+	bool prepared = false, cached = true;
+	db_stmt_t *db_stmt;
+	MYSQL_BIND *bind;
+	char **strs;
+	DEF_TIMERS;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+
+	START_TIMER;
+	bind = xcalloc(param_cnt ? param_cnt : 1, sizeof(*bind));
+	strs = xcalloc(param_cnt ? param_cnt : 1, sizeof(*strs));
+	_bind_params(bind, strs, params, param_cnt);
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	/* clear out the old results so we don't get a 2014 error */
+	_clear_results(mysql_conn->db_conn);
+
+	if (!mysql_conn->stmt_cache)
+		mysql_conn->stmt_cache = xhash_init(_db_stmt_id,
+						    _destroy_db_stmt);
+	if (!(db_stmt = xhash_get_str(mysql_conn->stmt_cache, query))) {
+		if (!(db_stmt = _prepare_stmt(mysql_conn, query, param_cnt))) {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+		prepared = true;
+		if (xhash_count(mysql_conn->stmt_cache) < MAX_STMT_CACHE)
+			xhash_add(mysql_conn->stmt_cache, db_stmt);
+		else
+			cached = false;
+	}
+
+try_again:
+	if (mysql_stmt_bind_param(db_stmt->stmt, bind) ||
+	    mysql_stmt_execute(db_stmt->stmt)) {
+		const char *err_str = mysql_stmt_error(db_stmt->stmt);
+		errno = mysql_stmt_errno(db_stmt->stmt);
+		if (errno == ER_LOCK_DEADLOCK) {
+			deadlock_attempt++;
+
+			if (deadlock_attempt < MAX_DEADLOCK_ATTEMPTS) {
+				error("%s: deadlock detected attempt %u/%u: %d %s",
+				      __func__, deadlock_attempt,
+				      MAX_DEADLOCK_ATTEMPTS, errno, err_str);
+				goto try_again;
+			} else {
+				fatal("%s: unable to resolve deadlock with attempts %u/%u: %d %s\nPlease call 'show engine innodb status;' in MySQL/MariaDB and open a bug report with SchedMD.",
+				      __func__, deadlock_attempt,
+				      MAX_DEADLOCK_ATTEMPTS, errno, err_str);
+			}
+		} else if (errno == ER_LOCK_WAIT_TIMEOUT) {
+			fatal("mysql gave ER_LOCK_WAIT_TIMEOUT as an error. "
+			      "The only way to fix this is restart the "
+			      "calling program");
+		}
+		error("mysql_stmt_execute failed: %d %s\n%s",
+		      errno, err_str, query);
+		rc = SLURM_ERROR;
+		/* The statement may be stale, prepare it again next time */
+		if (cached) {
+			xhash_delete_str(mysql_conn->stmt_cache, query);
+			db_stmt = NULL;
+		}
+	} else {
+		mysql_stmt_free_result(db_stmt->stmt);
+	}
+
+	if (!cached)
+		_destroy_db_stmt(db_stmt);
+end_it:
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	for (int i = 0; i < param_cnt; i++)
+		xfree(strs[i]);
+	xfree(strs);
+	xfree(bind);
+
+	END_TIMER;
+	_record_stmt_stats(name, prepared, DELTA_TIMER);
+
+	/*
+	 * Starting in MariaDB 10.2 many of the api commands started
+	 * setting errno erroneously.
+	 */
+	if (!rc)
+		errno = 0;
+	return rc;
+}
+
+extern char *mysql_db_stmt_text(char *query, db_param_t *params,
+				uint32_t param_cnt)
+{
+	char *text = NULL, *pos = NULL, *tmp;
+	uint32_t i = 0, cnt = 0;
+
+	/*
+	 * Every '?' is taken as a placeholder, as the server does for prepared
+	 * statements, so values must never be quoted in the template.
+	 */
+	xassert(!xstrchr(query, '\''));
+
+	for (char *c = query; *c; c++) {
+		if (*c != '?')
+			continue;
+		if (cnt++ >= param_cnt)
+			continue;
+		xstrncat(text, (pos ? pos : query), c - (pos ? pos : query));
+		pos = c + 1;
+
+		switch (params[i].type) {
+		case DB_PARAM_NULL:
+			xstrcat(text, "NULL");
+			break;
+		case DB_PARAM_DOUBLE:
+			xstrfmtcat(text, "%lf", params[i].value.d);
+			break;
+		case DB_PARAM_ESCAPED:
+			xstrfmtcat(text, "'%s'", params[i].value.s);
+			break;
+		case DB_PARAM_INT:
+			xstrfmtcat(text, "%"PRId64, params[i].value.i);
+			break;
+		case DB_PARAM_STR:
+			tmp = slurm_add_slash_to_quotes(
+				(char *) params[i].value.s);
+			xstrfmtcat(text, "'%s'", tmp);
+			xfree(tmp);
+			break;
+		case DB_PARAM_UINT:
+			xstrfmtcat(text, "%"PRIu64, params[i].value.u);
+			break;
+		}
+		i++;
+	}
+	xstrcat(text, (pos ? pos : query));
+
+	if (cnt != param_cnt)
+		error("%s: statement takes %u parameters, %u given\n%s",
+		      __func__, cnt, param_cnt, query);
+
+	return text;
+}
+
+extern List mysql_db_stmt_stats_get(void)
+{
+	List stats = list_create(slurmdb_destroy_stmt_stats);
+
+	slurm_mutex_lock(&stmt_stats_lock);
+	if (stmt_stats_list) {
+		ListIterator itr = list_iterator_create(stmt_stats_list);
+		slurmdb_stmt_stats_t *stmt_stats, *copy;
+
+		while ((stmt_stats = list_next(itr))) {
+			copy = xmalloc(sizeof(*copy));
+			*copy = *stmt_stats;
+			copy->name = xstrdup(stmt_stats->name);
+			list_append(stats, copy);
+		}
+		list_iterator_destroy(itr);
+	}
+	slurm_mutex_unlock(&stmt_stats_lock);
+
+	return stats;
+}
+
+extern void mysql_db_stmt_stats_clear(void)
+{
+	slurm_mutex_lock(&stmt_stats_lock);
+	FREE_NULL_LIST(stmt_stats_list);
+	slurm_mutex_unlock(&stmt_stats_lock);
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
@@ -47,6 +47,7 @@
 
 #include "slurm/slurm_errno.h"
 #include "src/common/list.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include <mysql.h>
@@ -58,16 +59,60 @@ typedef enum {
 	SLURM_MYSQL_PLUGIN_JC, /* jobcomp */
 } slurm_mysql_plugin_type_t;
 
-typedef struct {
+typedef struct mysql_conn {
+	uint32_t batch_cnt;	/* records queued in batch_query/batch_rows */
+	char *batch_query;	/* statements queued until the next flush */
+	char *batch_rows;	/* rows of the pending multi-row insert */
 	char *cluster_name;
 	MYSQL *db_conn;
 	uint32_t flags;
+	List job_cache_list;	/* job cache updates to publish on commit */
 	pthread_mutex_t lock;
 	char *pre_commit_query;
+	struct mysql_conn *replica; /* connection to the read replica */
+	time_t replica_check;	/* when to check the replica lag next */
+	bool replica_ok;	/* replica is close enough to the primary */
+	struct mysql_conn *shared_conn; /* writes rows shared by all jobs */
+	xhash_t *stmt_cache;	/* prepared statements by query text */
 	List update_list;
 	int conn;
 } mysql_conn_t;
 
+typedef enum {
+	DB_PARAM_NULL,
+	DB_PARAM_DOUBLE,
+	DB_PARAM_ESCAPED,	/* string already escaped for a text query */
+	DB_PARAM_INT,
+	DB_PARAM_STR,
+	DB_PARAM_UINT,
+} db_param_type_t;
+
+/* A value bound to a '?' of a prepared statement */
+typedef struct {
+	db_param_type_t type;
+	union {
+		double d;
+		int64_t i;
+		const char *s;
+		uint64_t u;
+	} value;
+} db_param_t;
+
+#define DB_PARAM_D(_d) \
+	((db_param_t) { .type = DB_PARAM_DOUBLE, .value.d = (_d) })
+#define DB_PARAM_I(_i) \
+	((db_param_t) { .type = DB_PARAM_INT, .value.i = (_i) })
+#define DB_PARAM_U(_u) \
+	((db_param_t) { .type = DB_PARAM_UINT, .value.u = (_u) })
+/* NULL strings are bound as NULL */
+#define DB_PARAM_S(_s) \
+	((db_param_t) { .type = (_s) ? DB_PARAM_STR : DB_PARAM_NULL, \
+			.value.s = (_s) })
+#define DB_PARAM_ESC(_s) \
+	((db_param_t) { .type = (_s) ? DB_PARAM_ESCAPED : DB_PARAM_NULL, \
+			.value.s = (_s) })
+#define DB_PARAM_NULL_VAL ((db_param_t) { .type = DB_PARAM_NULL })
+
 typedef struct {
 	char *backup;
 	uint32_t port;
@@ -100,10 +145,40 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn);
 
 extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 				     char *query, bool last);
+/* Like mysql_db_query_ret() but a failed query is only logged at debug */
+extern MYSQL_RES *mysql_db_query_ret_quiet(mysql_conn_t *mysql_conn,
+					   char *query, bool last);
+extern MYSQL_RES *mysql_db_query_use(mysql_conn_t *mysql_conn, char *query);
 extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
 extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Execute a statement that returns no rows as a prepared statement. The
+ * statement is prepared the first time the query text is seen on this
+ * connection and reused after that, even across transactions.
+ * IN name - short name of the statement for the statistics
+ * IN query - statement with a '?' for each parameter
+ * IN params - param_cnt values for the '?'s
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+extern int mysql_db_stmt_query(mysql_conn_t *mysql_conn, const char *name,
+			       char *query, db_param_t *params,
+			       uint32_t param_cnt);
+
+/*
+ * Substitute the params into a statement for mysql_db_stmt_query() to get
+ * the equivalent text query, e.g. to add it to a multi-statement batch.
+ * Every '?' is replaced, so the statement must not contain quoted literals.
+ * RET xmalloc'ed query text
+ */
+extern char *mysql_db_stmt_text(char *query, db_param_t *params,
+				uint32_t param_cnt);
+
+/* RET copy of the prepared statement statistics of all connections */
+extern List mysql_db_stmt_stats_get(void);
+extern void mysql_db_stmt_stats_clear(void);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
@@ -61,6 +61,7 @@ typedef struct slurm_acct_storage_ops {
 	void *(*get_conn)          (int conn_num, uint16_t *persist_conn_flags,
 				    bool rollback, char *cluster_name);
 	int  (*close_conn)         (void **db_conn);
+	void *(*get_read_conn)     (void *db_conn);
 	int  (*commit)             (void *db_conn, bool commit);
 	int  (*add_users)          (void *db_conn, uint32_t uid,
 				    List user_list);
@@ -192,6 +193,10 @@ typedef struct slurm_acct_storage_ops {
 	int  (*job_suspend)        (void *db_conn, job_record_t *job_ptr);
 	List (*get_jobs_cond)      (void *db_conn, uint32_t uid,
 				    slurmdb_job_cond_t *job_cond);
+	int  (*get_jobs_stream)    (void *db_conn, uint32_t uid,
+				    slurmdb_job_cond_t *job_cond,
+				    slurmdb_job_stream_cb_t callback,
+				    void *arg);
 	int (*archive_dump)        (void *db_conn,
 				    slurmdb_archive_cond_t *arch_cond);
 	int (*archive_load)        (void *db_conn,
@@ -217,6 +222,7 @@ typedef struct slurm_acct_storage_ops {
 static const char *syms[] = {
 	"acct_storage_p_get_connection",
 	"acct_storage_p_close_connection",
+	"acct_storage_p_get_read_connection",
 	"acct_storage_p_commit",
 	"acct_storage_p_add_users",
 	"acct_storage_p_add_coord",
@@ -280,6 +286,7 @@ static const char *syms[] = {
 	"jobacct_storage_p_step_complete",
 	"jobacct_storage_p_suspend",
 	"jobacct_storage_p_get_jobs_cond",
+	"jobacct_storage_p_get_jobs_stream",
 	"jobacct_storage_p_archive",
 	"jobacct_storage_p_archive_load",
 	"acct_storage_p_update_shares_used",
@@ -369,6 +376,12 @@ extern int acct_storage_g_close_connection(void **db_conn)
 
 }
 
+extern void *acct_storage_g_get_read_connection(void *db_conn)
+{
+	xassert(plugin_context);
+	return (*(ops.get_read_conn))(db_conn);
+}
+
 extern int acct_storage_g_commit(void *db_conn, bool commit)
 {
 	xassert(plugin_context);
@@ -923,6 +936,19 @@ extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 	return ret_list;
 }
 
+/*
+ * get info from the storage a chunk at a time
+ * RET SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_g_get_jobs_stream(void *db_conn, uint32_t uid,
+					     slurmdb_job_cond_t *job_cond,
+					     slurmdb_job_stream_cb_t callback,
+					     void *arg)
+{
+	xassert(plugin_context);
+	return (*(ops.get_jobs_stream))(db_conn, uid, job_cond, callback, arg);
+}
+
 /*
  * expire old info from the storage
  */
@@ -81,6 +81,14 @@ extern void *acct_storage_g_get_connection(
  */
 extern int acct_storage_g_close_connection(void **db_conn);
 
+/*
+ * get the connection to use for a query that does not change anything
+ * IN: void * pointer returned from acct_storage_g_get_connection()
+ * RET: connection to a read replica if one is configured and it is not too
+ *      far behind, db_conn otherwise. It must not be closed by the caller.
+ */
+extern void *acct_storage_g_get_read_connection(void *db_conn);
+
 /*
  * commit or rollback changes made without closing connection
  * IN: void * pointer returned from acct_storage_g_get_connection()
@@ -661,6 +669,18 @@ extern int jobacct_storage_g_job_suspend(void *db_conn,
 extern List jobacct_storage_g_get_jobs_cond(void *db_conn, uint32_t uid,
 					    slurmdb_job_cond_t *job_cond);
 
+/*
+ * get info from the storage a chunk at a time
+ * IN callback - called with each chunk, a List of slurmdb_job_rec_t *, in
+ *               job id order for each cluster. The List is freed once the
+ *               callback returns.
+ * RET SLURM_SUCCESS or error code
+ */
+extern int jobacct_storage_g_get_jobs_stream(void *db_conn, uint32_t uid,
+					     slurmdb_job_cond_t *job_cond,
+					     slurmdb_job_stream_cb_t callback,
+					     void *arg);
+
 /*
  * expire old info from the storage
  */
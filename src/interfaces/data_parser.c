@@ -74,6 +74,9 @@ typedef struct {
 	void (*free)(void *arg);
 	int (*assign)(void *arg, data_parser_attr_type_t type, void *obj);
 	int (*specify)(void *arg, data_t *dst);
+	int (*dump_stream)(void *arg, data_parser_type_t type, void *src,
+			   ssize_t src_bytes, const char *key,
+			   serializer_stream_t *stream);
 } parse_funcs_t;
 
 /*
@@ -86,6 +89,7 @@ static const char *parse_syms[] = {
 	"data_parser_p_free",
 	"data_parser_p_assign",
 	"data_parser_p_specify",
+	"data_parser_p_dump_stream",
 };
 
 static plugins_t *plugins = NULL;
@@ -140,6 +144,31 @@ extern int data_parser_g_dump(data_parser_t *parser, data_parser_type_t type,
 	return rc;
 }
 
+extern int data_parser_g_dump_stream(data_parser_t *parser,
+				     data_parser_type_t type, void *src,
+				     ssize_t src_bytes, const char *key,
+				     serializer_stream_t *stream)
+{
+	DEF_TIMERS;
+	int rc;
+	const parse_funcs_t *funcs = plugins->functions[parser->plugin_offset];
+
+	xassert(stream);
+	xassert(type > DATA_PARSER_TYPE_INVALID);
+	xassert(type < DATA_PARSER_TYPE_MAX);
+	xassert(parser->magic == PARSE_MAGIC);
+	xassert(plugins && (plugins->magic == PLUGINS_MAGIC));
+	xassert(parser->plugin_offset < plugins->count);
+	xassert(plugins->functions[parser->plugin_offset]);
+
+	START_TIMER;
+	rc = funcs->dump_stream(parser->arg, type, src, src_bytes, key,
+				stream);
+	END_TIMER2(__func__);
+
+	return rc;
+}
+
 extern data_parser_t *data_parser_g_new(data_parser_on_error_t on_parse_error,
 					data_parser_on_error_t on_dump_error,
 					data_parser_on_error_t on_query_error,
@@ -353,13 +382,92 @@ static void _populate_cli_response_meta(data_t *meta, int argc, char **argv,
 		data_set_string(data_list_append(cmd), argv[i]);
 }
 
+typedef struct {
+	data_parser_t *parser;
+	data_parser_type_t type;
+	void *obj;
+	int obj_bytes;
+	const char *key;
+	serializer_stream_t *stream;
+	int rc;
+} stream_cli_args_t;
+
+static int _write_stdout(const char *data, size_t length, void *arg)
+{
+	if (fwrite(data, 1, length, stdout) != length)
+		return errno;
+
+	return SLURM_SUCCESS;
+}
+
+static data_for_each_cmd_t _stream_cli_key(const char *key, const data_t *data,
+					   void *arg)
+{
+	stream_cli_args_t *args = arg;
+
+	if (!xstrcmp(key, args->key))
+		args->rc = data_parser_g_dump_stream(args->parser, args->type,
+						     args->obj,
+						     args->obj_bytes, key,
+						     args->stream);
+	else
+		args->rc = serialize_g_stream_data(args->stream, key, data);
+
+	return (args->rc ? DATA_FOR_EACH_FAIL : DATA_FOR_EACH_CONT);
+}
+
+/*
+ * Stream response to stdout while dumping the object one entry at a time.
+ * The placeholder for key in resp is skipped in favor of dumping obj directly.
+ * Errors and warnings are always after key in resp and will be populated by the
+ * time they are written.
+ * RET SLURM_SUCCESS, error or ESLURM_NOT_SUPPORTED if mime_type can't stream
+ */
+static int _stream_cli_stdout(data_t *resp, data_parser_t *parser,
+			      data_parser_type_t type, void *obj,
+			      int obj_bytes, const char *key,
+			      const char *mime_type)
+{
+	int rc;
+	stream_cli_args_t args = {
+		.parser = parser,
+		.type = type,
+		.obj = obj,
+		.obj_bytes = obj_bytes,
+		.key = key,
+	};
+
+	if ((rc = serialize_g_stream_new(&args.stream, mime_type,
+					 SER_FLAGS_PRETTY, _write_stdout,
+					 NULL)))
+		return rc;
+
+	if (!(rc = serialize_g_stream_begin(args.stream, NULL,
+					    DATA_TYPE_DICT))) {
+		(void) data_dict_for_each_const(resp, _stream_cli_key, &args);
+
+		if (!(rc = args.rc))
+			rc = serialize_g_stream_end(args.stream);
+	}
+
+	if (!rc)
+		rc = serialize_g_stream_fini(&args.stream);
+	else
+		(void) serialize_g_stream_fini(&args.stream);
+
+	if (!rc)
+		printf("\n");
+
+	return rc;
+}
+
 extern int data_parser_dump_cli_stdout(data_parser_type_t type, void *obj,
 				       int obj_bytes, const char *key, int argc,
 				       char **argv, void *acct_db_conn,
 				       const char *mime_type)
 {
 	int rc = SLURM_SUCCESS;
-	data_t *resp = data_set_dict(data_new());
+	data_t *resp = data_set_dict(data_new_arena());
 	data_t *meta = data_set_dict(data_key_set(resp, "meta"));
 	data_t *dout = data_key_set(resp, key);
 	char *out = NULL;
@@ -382,6 +490,13 @@ extern int data_parser_dump_cli_stdout(data_parser_type_t type, void *obj,
 	_populate_cli_response_meta(meta, argc, argv, parser);
 
 	data_parser_g_assign(parser, DATA_PARSER_ATTR_DBCONN_PTR, acct_db_conn);
+
+	rc = _stream_cli_stdout(resp, parser, type, obj, obj_bytes, key,
+				mime_type);
+	if (rc != ESLURM_NOT_SUPPORTED)
+		goto cleanup;
+	rc = SLURM_SUCCESS;
+
 	data_parser_g_dump(parser, type, obj, obj_bytes, dout);
 	serialize_g_data_to_string(&out, NULL, resp, mime_type,
 				   SER_FLAGS_PRETTY);
@@ -391,6 +506,7 @@ extern int data_parser_dump_cli_stdout(data_parser_type_t type, void *obj,
 cleanup:
 	xfree(out);
 	FREE_NULL_DATA_PARSER(parser);
+	FREE_NULL_DATA(resp);
 
 	return rc;
 }
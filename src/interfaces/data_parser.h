@@ -38,6 +38,7 @@
 #define _DATA_PARSER_H
 
 #include "src/common/data.h"
+#include "src/interfaces/serializer.h"
 
 typedef enum {
 	/* there is an implied * on every type */
@@ -296,9 +297,21 @@ typedef enum {
 	DATA_PARSER_ATTR_DBCONN_PTR, /* return of slurmdb_connection_get() - will not xfree */
 	DATA_PARSER_ATTR_QOS_LIST, /* List<slurmdb_qos_rec_t *> - will xfree() */
 	DATA_PARSER_ATTR_TRES_LIST, /* List<slurmdb_tres_rec_t *> - will xfree() */
+	DATA_PARSER_ATTR_FIELDS, /* data_parser_fields_t * - will not xfree */
 	DATA_PARSER_ATTR_MAX /* place holder - do not use */
 } data_parser_attr_type_t;
 
+/*
+ * Only dump requested fields of each record for DATA_PARSER_ATTR_FIELDS.
+ * 	Fields are matched against the dumped keys of the record. A field
+ * 	matches every key at or below its path, and a key that is a parent of
+ * 	the field is dumped whole.
+ */
+typedef struct {
+	data_parser_type_t type; /* type of each record */
+	const char *fields; /* comma delimited list of fields or NULL for all */
+} data_parser_fields_t;
+
 /*
  * Assign additional resource to parser
  * IN parser - parser to add resource
@@ -373,6 +386,32 @@ extern int data_parser_g_dump(data_parser_t *parser, data_parser_type_t type,
 #define DATA_DUMP(parser, type, src, dst) \
 	data_parser_g_dump(parser, DATA_PARSER_##type, &src, sizeof(src), dst)
 
+/*
+ * Dump given target struct src directly into serializer stream
+ * use DATA_DUMP_STREAM() macro instead of calling directly!
+ *
+ * Arrays and lists are dumped one entry at a time to avoid holding the entire
+ * dump in memory as a single data_t.
+ *
+ * IN parser - return from data_parser_g_new()
+ * IN type - type of obj
+ * IN src - ptr to struct/scalar to dump
+ * 	This *must* be a pointer to the object and not just a value of the object.
+ * IN src_bytes - size of object pointed to by src
+ * IN key - key to place dump under in current dictionary of stream or NULL if
+ * 	current container of stream is a list
+ * IN stream - serializer stream to write dump into
+ * RET SLURM_SUCCESS or error
+ */
+extern int data_parser_g_dump_stream(data_parser_t *parser,
+				     data_parser_type_t type, void *src,
+				     ssize_t src_bytes, const char *key,
+				     serializer_stream_t *stream);
+
+#define DATA_DUMP_STREAM(parser, type, src, key, stream)                     \
+	data_parser_g_dump_stream(parser, DATA_PARSER_##type, &src,          \
+				  sizeof(src), key, stream)
+
 /*
  * Dump object of given type to STDOUT
  * Uses the current release version of the data_parser plugin.
@@ -51,6 +51,7 @@
 #define MAGIC_PATH 0x1121baef
 #define MAGIC_OAS 0x1211be0f
 #define MAGIC_FOREACH_PATH 0xaba1aaab
+#define MAGIC_ROUTE 0xaba1abab
 
 typedef struct {
 	int (*init)(void);
@@ -91,11 +92,27 @@ typedef struct {
 	http_request_method_t method;
 } entry_method_t;
 
+typedef struct route_s route_t;
+
 typedef struct {
 	entry_method_t *methods;
 	int tag;
+	route_t *route; /* route ending with this path */
 } path_t;
 
+/*
+ * Router tree node with one level per path component. Matching a request
+ * walks down one node per component instead of testing every registered path.
+ */
+struct route_s {
+	int magic; /* MAGIC_ROUTE */
+	char *entry; /* string to match or NULL for parameter */
+	route_t **children; /* string match children sorted by entry */
+	int child_count;
+	route_t *param; /* child matching any parameter */
+	List paths; /* list of path_t ending at this route */
+};
+
 typedef struct {
 	entry_method_t *method;
 	entry_t *entries;
@@ -145,6 +162,13 @@ struct openapi_s {
 	int magic;
 	List paths;
 	int path_tag_counter;
+	pthread_rwlock_t routes_lock;
+	route_t *routes; /* router tree of all paths */
+
+	pthread_mutex_t spec_str_lock;
+	char **spec_str_mime; /* MIME type of each serialized spec */
+	char **spec_str; /* joined spec serialized once per MIME type */
+	int spec_str_count;
 	data_t **spec;
 	openapi_spec_flags_t *spec_flags;
 
@@ -323,6 +347,95 @@ static void _list_delete_path_t(void *x)
 	xfree(path);
 }
 
+static route_t *_new_route(const char *entry)
+{
+	route_t *route = xmalloc(sizeof(*route));
+
+	route->magic = MAGIC_ROUTE;
+	route->entry = xstrdup(entry);
+
+	return route;
+}
+
+static void _free_route(route_t *route)
+{
+	if (!route)
+		return;
+
+	xassert(route->magic == MAGIC_ROUTE);
+
+	for (int i = 0; i < route->child_count; i++)
+		_free_route(route->children[i]);
+	xfree(route->children);
+
+	_free_route(route->param);
+	FREE_NULL_LIST(route->paths);
+	xfree(route->entry);
+
+	route->magic = ~MAGIC_ROUTE;
+	xfree(route);
+}
+
+/* Find index of child with entry or index to insert at if not found */
+static int _find_route_child(const route_t *route, const char *entry,
+			     bool *found)
+{
+	int low = 0, high = route->child_count;
+
+	*found = false;
+
+	while (low < high) {
+		const int mid = (low + high) / 2;
+		const int cmp = xstrcmp(route->children[mid]->entry, entry);
+
+		if (!cmp) {
+			*found = true;
+			return mid;
+		} else if (cmp < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/* Add path entries to router tree and return route for last entry */
+static route_t *_add_route(route_t *route, const entry_t *entries)
+{
+	for (const entry_t *entry = entries; entry->type; entry++) {
+		bool found;
+		int i;
+
+		if (entry->type == OPENAPI_PATH_ENTRY_MATCH_PARAMETER) {
+			if (!route->param)
+				route->param = _new_route(NULL);
+			route = route->param;
+			continue;
+		}
+
+		i = _find_route_child(route, entry->entry, &found);
+
+		if (!found) {
+			xrecalloc(route->children, (route->child_count + 1),
+				  sizeof(*route->children));
+			memmove(&route->children[i + 1], &route->children[i],
+				((route->child_count - i) *
+				 sizeof(*route->children)));
+			route->children[i] = _new_route(entry->entry);
+			route->child_count++;
+		}
+
+		route = route->children[i];
+	}
+
+	if (!route->paths)
+		route->paths = list_create(NULL);
+
+	return route;
+}
+
 static entry_t *_parse_openapi_path(const char *str_path)
 {
 	char *save_ptr = NULL;
@@ -729,7 +842,11 @@ extern int register_path_tag(openapi_t *oas, const char *str_path)
 	if (data_dict_for_each_const(spec_entry, _populate_methods, &args) < 0)
 		fatal_abort("%s: failed", __func__);
 
+	slurm_rwlock_wrlock(&oas->routes_lock);
+	path->route = _add_route(oas->routes, entries);
+	list_append(path->route->paths, path);
 	list_append(oas->paths, path);
+	slurm_rwlock_unlock(&oas->routes_lock);
 
 	rc = path->tag;
 
@@ -750,6 +867,8 @@ static int _rm_path_by_tag(void *x, void *tptr)
 
 	debug5("%s: removing tag %d", __func__, path->tag);
 
+	list_delete_ptr(path->route->paths, path);
+
 	return 1;
 }
 
@@ -757,7 +876,9 @@ extern void unregister_path_tag(openapi_t *oas, int tag)
 {
 	xassert(oas->magic == MAGIC_OAS);
 
+	slurm_rwlock_wrlock(&oas->routes_lock);
 	list_delete_all(oas->paths, _rm_path_by_tag, &tag);
+	slurm_rwlock_unlock(&oas->routes_lock);
 }
 
 /*
@@ -897,10 +1018,62 @@ static int _match_path_from_data(void *x, void *key)
 	return (args->matched ? 1 : 0);
 }
 
+static data_for_each_cmd_t _foreach_path_segment(const data_t *data,
+						  void *arg)
+{
+	const data_t ***segment = arg;
+
+	**segment = data;
+	(*segment)++;
+
+	return DATA_FOR_EACH_CONT;
+}
+
+/*
+ * Walk router tree to find path matching segments. String matches are
+ * preferred over parameters, which only match if the parameter types of one
+ * of the candidate paths accept the segments.
+ */
+static path_t *_find_route(const route_t *route, const data_t **segments,
+			   int count, match_path_from_data_t *args)
+{
+	path_t *path;
+
+	xassert(route->magic == MAGIC_ROUTE);
+
+	if (!count) {
+		if (!route->paths)
+			return NULL;
+		return list_find_first(route->paths, _match_path_from_data,
+				       args);
+	}
+
+	if (data_get_type(segments[0]) == DATA_TYPE_STRING) {
+		bool found;
+		int i = _find_route_child(route,
+					  data_get_string_const(segments[0]),
+					  &found);
+
+		if (found && (path = _find_route(route->children[i],
+						 (segments + 1), (count - 1),
+						 args)))
+			return path;
+	}
+
+	if (route->param)
+		return _find_route(route->param, (segments + 1), (count - 1),
+				   args);
+
+	return NULL;
+}
+
 extern int find_path_tag(openapi_t *oas, const data_t *dpath, data_t *params,
 			 http_request_method_t method)
 {
+	int rc = -1;
 	path_t *path;
+	const data_t **segments, **segment;
+	const size_t count = data_get_list_length(dpath);
 	match_path_from_data_t args = {
 		.params = params,
 		.dpath = dpath,
@@ -909,17 +1082,28 @@ extern int find_path_tag(openapi_t *oas, const data_t *dpath, data_t *params,
 	xassert(oas->magic == MAGIC_OAS);
 	xassert(data_get_type(params) == DATA_TYPE_DICT);
 
-	path = list_find_first(oas->paths, _match_path_from_data, &args);
-	if (!path)
-		return -1;
+	segment = segments = xcalloc((count + 1), sizeof(*segments));
+	(void) data_list_for_each_const(dpath, _foreach_path_segment, &segment);
+	xassert(segment == (segments + count));
+
+	slurm_rwlock_rdlock(&oas->routes_lock);
+
+	if (!(path = _find_route(oas->routes, segments, count, &args)))
+		goto cleanup;
 
 	/* Make sure the path tag actually contains the method requested */
+	rc = -2;
 	for (entry_method_t *em = path->methods; em->entries; em++) {
-		if (em->method == method)
-			return path->tag;
+		if (em->method == method) {
+			rc = path->tag;
+			break;
+		}
 	}
 
-	return -2;
+cleanup:
+	slurm_rwlock_unlock(&oas->routes_lock);
+	xfree(segments);
+	return rc;
 }
 
 static void _oas_plugrack_foreach(const char *full_type, const char *fq_path,
@@ -961,6 +1145,9 @@ extern int init_openapi(openapi_t **oas, const char *plugins,
 	*oas = t = xmalloc(sizeof(*t));
 	t->magic = MAGIC_OAS;
 	t->paths = list_create(_list_delete_path_t);
+	slurm_rwlock_init(&t->routes_lock);
+	t->routes = _new_route(NULL);
+	slurm_mutex_init(&t->spec_str_lock);
 
 	t->rack = plugrack_create("openapi");
 	plugrack_read_dir(t->rack, slurm_conf.plugindir);
@@ -1071,6 +1258,16 @@ extern void destroy_openapi(openapi_t *oas)
 	xfree(oas->context);
 
 	FREE_NULL_LIST(oas->paths);
+	_free_route(oas->routes);
+	slurm_rwlock_destroy(&oas->routes_lock);
+
+	for (int i = 0; i < oas->spec_str_count; i++) {
+		xfree(oas->spec_str_mime[i]);
+		xfree(oas->spec_str[i]);
+	}
+	xfree(oas->spec_str_mime);
+	xfree(oas->spec_str);
+	slurm_mutex_destroy(&oas->spec_str_lock);
 
 	for (size_t i = 0; oas->spec[i]; i++)
 		FREE_NULL_DATA(oas->spec[i]);
@@ -1466,6 +1663,52 @@ extern int get_openapi_specification(openapi_t *oas, data_t *resp)
 	return SLURM_SUCCESS;
 }
 
+extern int get_openapi_specification_serialized(openapi_t *oas,
+						const char *mime_type,
+						const char **str_ptr)
+{
+	int rc = SLURM_SUCCESS;
+	data_t *spec = NULL;
+	char *str = NULL;
+
+	xassert(oas->magic == MAGIC_OAS);
+	xassert(str_ptr);
+
+	slurm_mutex_lock(&oas->spec_str_lock);
+
+	for (int i = 0; i < oas->spec_str_count; i++) {
+		if (!xstrcmp(oas->spec_str_mime[i], mime_type)) {
+			*str_ptr = oas->spec_str[i];
+			goto done;
+		}
+	}
+
+	/* the loaded specs never change so the joined spec can be kept */
+	spec = data_new();
+	if ((rc = get_openapi_specification(oas, spec)))
+		goto done;
+
+	if ((rc = serialize_g_data_to_string(&str, NULL, spec, mime_type,
+					     SER_FLAGS_PRETTY)))
+		goto done;
+
+	debug3("%s: serialized OpenAPI specification as %s in %zu bytes",
+	       __func__, mime_type, strlen(str));
+
+	xrecalloc(oas->spec_str_mime, (oas->spec_str_count + 1),
+		  sizeof(*oas->spec_str_mime));
+	xrecalloc(oas->spec_str, (oas->spec_str_count + 1),
+		  sizeof(*oas->spec_str));
+	oas->spec_str_mime[oas->spec_str_count] = xstrdup(mime_type);
+	*str_ptr = oas->spec_str[oas->spec_str_count] = str;
+	oas->spec_str_count++;
+
+done:
+	slurm_mutex_unlock(&oas->spec_str_lock);
+	FREE_NULL_DATA(spec);
+	return rc;
+}
+
 static data_for_each_cmd_t _foreach_join_path_str(data_t *data, void *arg)
 {
 	merge_path_strings_t *args = arg;
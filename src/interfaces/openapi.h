@@ -95,6 +95,8 @@ extern void unregister_path_tag(openapi_t *oas, int tag);
 
 /*
  * Find tag assigned to given path
+ * Every component of path must be matched. Exact string components are
+ * preferred over parameters when more than one registered path matches.
  * IN path - split up path to match
  * IN/OUT params - on match, will populate any OAS parameters in path.
  * 	params must be DATA_TYPE_DICT.
@@ -134,6 +136,19 @@ extern void destroy_openapi(openapi_t *oas);
  */
 extern int get_openapi_specification(openapi_t *oas, data_t *resp);
 
+/*
+ * Get joined specs serialized for the given MIME type.
+ * 	Spec is only joined and serialized on the first call per MIME type.
+ * IN oas - openapi state
+ * IN mime_type - MIME type to serialize spec as
+ * OUT str_ptr - set to serialized spec (do not modify or xfree). Valid until
+ * 	destroy_openapi().
+ * RET SLURM_SUCCESS or error
+ */
+extern int get_openapi_specification_serialized(openapi_t *oas,
+						const char *mime_type,
+						const char **str_ptr);
+
 /*
  * Extracts the db_conn using given auth context
  * Note: This must be implemented in process calling openapi functions.
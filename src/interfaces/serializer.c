@@ -47,17 +47,29 @@
 #define SERIALIZER_MAJOR_TYPE "serializer"
 #define SERIALIZER_MIME_TYPES_SYM "mime_types"
 #define PMT_MAGIC 0xaaba8031
+#define STREAM_MAGIC 0xa1ba8032
 
 typedef struct {
 	int (*data_to_string)(char **dest, size_t *length, const data_t *src,
 			      serializer_flags_t flags);
 	int (*string_to_data)(data_t **dest, const char *src, size_t length);
+	int (*stream_new)(void **state_ptr, serializer_flags_t flags,
+			  serializer_write_t write_func, void *write_arg);
+	int (*stream_begin)(void *state, const char *key, data_type_t type);
+	int (*stream_end)(void *state);
+	int (*stream_data)(void *state, const char *key, const data_t *src);
+	int (*stream_fini)(void *state);
 } funcs_t;
 
 /* Must be synchronized with funcs_t above */
 static const char *syms[] = {
 	"serialize_p_data_to_string",
 	"serialize_p_string_to_data",
+	"serialize_p_stream_new",
+	"serialize_p_stream_begin",
+	"serialize_p_stream_end",
+	"serialize_p_stream_data",
+	"serialize_p_stream_fini",
 };
 
 /* serializer plugin state */
@@ -74,6 +86,13 @@ static List mime_types_list = NULL;
 
 static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+struct serializer_stream_s {
+	int magic; /* STREAM_MAGIC */
+	const funcs_t *funcs;
+	void *state; /* plugin specific state */
+	int depth; /* number of open containers */
+};
+
 static int _find_serializer_full_type(void *x, void *key)
 {
 	plugin_mime_type_t *pmt = x;
@@ -171,6 +190,95 @@ extern int serialize_g_string_to_data(data_t **dest, const char *src,
 	return rc;
 }
 
+extern int serialize_g_stream_new(serializer_stream_t **stream_ptr,
+				  const char *mime_type,
+				  serializer_flags_t flags,
+				  serializer_write_t write_func,
+				  void *write_arg)
+{
+	int rc;
+	void *state = NULL;
+	serializer_stream_t *stream;
+	const funcs_t *func_ptr;
+	plugin_mime_type_t *pmt = NULL;
+
+	xassert(stream_ptr && (*stream_ptr == NULL));
+	xassert(write_func);
+
+	pmt = _find_serializer(mime_type);
+	if (!pmt)
+		return ESLURM_DATA_UNKNOWN_MIME_TYPE;
+
+	xassert(pmt->magic == PMT_MAGIC);
+	func_ptr = plugins->functions[pmt->index];
+
+	if ((rc = (*func_ptr->stream_new)(&state, flags, write_func,
+					  write_arg)))
+		return rc;
+
+	stream = xmalloc(sizeof(*stream));
+	stream->magic = STREAM_MAGIC;
+	stream->funcs = func_ptr;
+	stream->state = state;
+	*stream_ptr = stream;
+
+	return SLURM_SUCCESS;
+}
+
+extern int serialize_g_stream_begin(serializer_stream_t *stream,
+				    const char *key, data_type_t type)
+{
+	int rc;
+
+	xassert(stream->magic == STREAM_MAGIC);
+	xassert((type == DATA_TYPE_DICT) || (type == DATA_TYPE_LIST));
+
+	if (!(rc = (*stream->funcs->stream_begin)(stream->state, key, type)))
+		stream->depth++;
+
+	return rc;
+}
+
+extern int serialize_g_stream_end(serializer_stream_t *stream)
+{
+	int rc;
+
+	xassert(stream->magic == STREAM_MAGIC);
+	xassert(stream->depth > 0);
+
+	if (!(rc = (*stream->funcs->stream_end)(stream->state)))
+		stream->depth--;
+
+	return rc;
+}
+
+extern int serialize_g_stream_data(serializer_stream_t *stream,
+				   const char *key, const data_t *src)
+{
+	xassert(stream->magic == STREAM_MAGIC);
+
+	return (*stream->funcs->stream_data)(stream->state, key, src);
+}
+
+extern int serialize_g_stream_fini(serializer_stream_t **stream_ptr)
+{
+	int rc;
+	serializer_stream_t *stream = *stream_ptr;
+
+	if (!stream)
+		return SLURM_SUCCESS;
+
+	xassert(stream->magic == STREAM_MAGIC);
+
+	rc = (*stream->funcs->stream_fini)(stream->state);
+
+	stream->magic = ~STREAM_MAGIC;
+	xfree(stream);
+	*stream_ptr = NULL;
+
+	return rc;
+}
+
 extern const char *resolve_mime_type(const char *mime_type)
 {
 	plugin_mime_type_t *pmt = _find_serializer(mime_type);
@@ -85,6 +85,78 @@ extern int serialize_g_data_to_string(char **dest, size_t *length,
 extern int serialize_g_string_to_data(data_t **dest, const char *src,
 				      size_t length, const char *mime_type);
 
+/*
+ * Opaque handle for incrementally serializing a document.
+ *
+ * Streams allow callers to emit a document in pieces without ever holding the
+ * entire document as a data_t tree. Output is handed to write_func in chunks
+ * as it is generated.
+ */
+typedef struct serializer_stream_s serializer_stream_t;
+
+/*
+ * Write serialized output from a stream
+ * IN data - bytes of serialized output (not '\0' terminated)
+ * IN length - number of bytes in data
+ * IN arg - arbitrary pointer given to serialize_g_stream_new()
+ * RET SLURM_SUCCESS or error to abort the stream
+ */
+typedef int (*serializer_write_t)(const char *data, size_t length, void *arg);
+
+/*
+ * Create new serializer stream
+ * IN/OUT stream_ptr - ptr to NULL stream ptr to set with new stream.
+ * 	caller must call serialize_g_stream_fini() if set.
+ * IN mime_type - serialize data into the given mime_type
+ * IN flags - optional flags to specify to serilzier to change presentation of
+ * 	data
+ * IN write_func - function to call with serialized output
+ * IN write_arg - arbitrary pointer to hand to write_func
+ * RET SLURM_SUCCESS or error
+ * 	ESLURM_NOT_SUPPORTED if plugin for mime_type is unable to stream
+ */
+extern int serialize_g_stream_new(serializer_stream_t **stream_ptr,
+				  const char *mime_type,
+				  serializer_flags_t flags,
+				  serializer_write_t write_func,
+				  void *write_arg);
+
+/*
+ * Open a new dictionary or list in stream
+ * IN stream - stream to write into
+ * IN key - key of new container if the current container is a dictionary or
+ * 	NULL if current container is a list or there is no container yet
+ * IN type - DATA_TYPE_DICT or DATA_TYPE_LIST
+ * RET SLURM_SUCCESS or error
+ */
+extern int serialize_g_stream_begin(serializer_stream_t *stream,
+				    const char *key, data_type_t type);
+
+/*
+ * Close the last container opened by serialize_g_stream_begin()
+ * IN stream - stream to write into
+ * RET SLURM_SUCCESS or error
+ */
+extern int serialize_g_stream_end(serializer_stream_t *stream);
+
+/*
+ * Serialize data into current container of stream
+ * IN stream - stream to write into
+ * IN key - key of data if the current container is a dictionary or NULL if
+ * 	current container is a list
+ * IN src - populated data ptr to serialize
+ * RET SLURM_SUCCESS or error
+ */
+extern int serialize_g_stream_data(serializer_stream_t *stream,
+				   const char *key, const data_t *src);
+
+/*
+ * Flush any pending output and release stream
+ * IN/OUT stream_ptr - ptr to stream to release. Will be set to NULL.
+ * RET SLURM_SUCCESS or first error encountered by stream
+ */
+extern int serialize_g_stream_fini(serializer_stream_t **stream_ptr);
+
 /*
  * Check if there is a plugin loaded that can handle the requested mime type
  * RET ptr to best matching mime type or NULL if none can match
@@ -875,21 +875,21 @@ static char *_make_archive_name(time_t period_start, time_t period_end,
 	return fullname;
 }
 
-extern int archive_write_file(buf_t *buffer, char *cluster_name,
-			      time_t period_start, time_t period_end,
-			      char *arch_dir, char *arch_type,
-			      uint32_t archive_period)
+extern archive_file_t *archive_create_file(char *cluster_name,
+					   time_t period_start,
+					   time_t period_end, char *arch_dir,
+					   char *arch_type,
+					   uint32_t archive_period,
+					   uint16_t msg_type, uint16_t flags,
+					   char **columns, uint32_t col_cnt,
+					   uint32_t chunk_rows)
 {
-	int fd = 0;
-	int rc = SLURM_SUCCESS;
+	archive_file_t *af;
 	char *new_file = NULL;
 	static pthread_mutex_t local_file_lock = PTHREAD_MUTEX_INITIALIZER;
 
-	xassert(buffer);
-
 	slurm_mutex_lock(&local_file_lock);
 
-	/* write the buffer to file */
 	new_file = _make_archive_name(period_start, period_end,
 				      cluster_name, arch_dir,
 				      arch_type, archive_period);
@@ -897,26 +897,11 @@ extern int archive_write_file(buf_t *buffer, char *cluster_name,
 	debug("Storing %s archive for %s at %s",
 	      arch_type, cluster_name, new_file);
 
-	fd = creat(new_file, 0600);
-	if (fd < 0) {
-		error("Can't save archive, create file %s error %m", new_file);
-		rc = SLURM_ERROR;
-	} else {
-		safe_write(fd, get_buf_data(buffer), get_buf_offset(buffer));
-		fsync(fd);
-		close(fd);
-	}
-
-	xfree(new_file);
-	slurm_mutex_unlock(&local_file_lock);
-
-	return rc;
+	af = archive_file_create(new_file, cluster_name, arch_type, msg_type,
+				 flags, columns, col_cnt, chunk_rows);
 
-rwfail:
-	error("Error writing file %s, %m", new_file);
-	close(fd);
 	xfree(new_file);
 	slurm_mutex_unlock(&local_file_lock);
 
-	return SLURM_ERROR;
+	return af;
 }
@@ -39,6 +39,7 @@
 #ifndef _HAVE_COMMON_AS_H
 #define _HAVE_COMMON_AS_H
 
+#include "src/common/archive_file.h"
 #include "src/common/assoc_mgr.h"
 
 extern int addto_update_list(List update_list, slurmdb_update_type_t type,
@@ -80,9 +81,19 @@ extern char* acct_get_db_name(void);
 extern time_t archive_setup_end_time(time_t last_submit, uint32_t purge);
 extern int archive_run_script(slurmdb_archive_cond_t *arch_cond,
 			      char *cluster_name, time_t last_submit);
-extern int archive_write_file(buf_t *buffer, char *cluster_name,
-			      time_t period_start, time_t period_end,
-			      char *arch_dir, char *arch_type,
-			      uint32_t archive_period);
+
+/*
+ * Create the archive file for the records of arch_type (the sql table)
+ * archived from the given period.
+ * RET archive file to add the records to or NULL on error
+ */
+extern archive_file_t *archive_create_file(char *cluster_name,
+					   time_t period_start,
+					   time_t period_end, char *arch_dir,
+					   char *arch_type,
+					   uint32_t archive_period,
+					   uint16_t msg_type, uint16_t flags,
+					   char **columns, uint32_t col_cnt,
+					   uint32_t chunk_rows);
 
 #endif
@@ -54,6 +54,7 @@
 #include "as_mysql_federation.h"
 #include "as_mysql_fix_runaway_jobs.h"
 #include "as_mysql_job.h"
+#include "as_mysql_job_cache.h"
 #include "as_mysql_jobacct_process.h"
 #include "as_mysql_problems.h"
 #include "as_mysql_qos.h"
@@ -87,6 +88,8 @@ List as_mysql_cluster_list = NULL;
 */
 List as_mysql_total_cluster_list = NULL;
 pthread_rwlock_t as_mysql_cluster_list_lock = PTHREAD_RWLOCK_INITIALIZER;
+/* Shared rows are written one connection at a time, see get_shared_conn() */
+static pthread_mutex_t shared_conn_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -119,9 +122,13 @@ const char plugin_type[] = "accounting_storage/as_mysql";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 static mysql_db_info_t *mysql_db_info = NULL;
+static mysql_db_info_t *mysql_replica_info = NULL;
+/* Reading the replication status failed, it was logged already */
+static bool replica_status_failed = false;
 static char *mysql_db_name = NULL;
 
 #define DELETE_SEC_BACK 86400
+#define REPLICA_RETRY_SEC 60	/* wait before connecting again on failure */
 
 char *acct_coord_table = "acct_coord_table";
 char *acct_table = "acct_table";
@@ -1224,10 +1231,14 @@ extern int check_connection(mysql_conn_t *mysql_conn)
 		errno = ESLURM_DB_CONNECTION;
 		return ESLURM_DB_CONNECTION;
 	} else if (mysql_db_ping(mysql_conn) != 0) {
+		mysql_db_info_t *db_info =
+			(mysql_conn->flags & DB_CONN_FLAG_REPLICA) ?
+			mysql_replica_info : mysql_db_info;
+
 		/* avoid memory leak and end thread */
 		mysql_db_close_db_connection(mysql_conn);
 		if (mysql_db_get_db_connection(
-			    mysql_conn, mysql_db_name, mysql_db_info)
+			    mysql_conn, mysql_db_name, db_info)
 		    != SLURM_SUCCESS) {
 			error("unable to re-connect to as_mysql database");
 			errno = ESLURM_DB_CONNECTION;
@@ -1279,6 +1290,72 @@ extern void reset_mysql_conn(mysql_conn_t *mysql_conn)
 	list_flush(mysql_conn->update_list);
 }
 
+/*
+ * Get the connection to write rows shared by every job of a cluster on, like
+ * the last_ran_table row, wckeys and the env and script hashes.
+ *
+ * When the slurmdbd may write the job records of a DBD_SEND_MULT_MSG in
+ * parallel, the connections of a run are only committed once every one of
+ * them is done. A connection waiting on a shared row written by another one
+ * would then only stop at the lock wait timeout. Shared rows are written on a
+ * connection of their own instead, one at a time, and committed right away.
+ * Committing them before the job records is harmless: a job sent again after
+ * a rollback finds them already there.
+ *
+ * RET mysql_conn, or its shared connection locked until release_shared_conn()
+ */
+extern mysql_conn_t *get_shared_conn(mysql_conn_t *mysql_conn)
+{
+	mysql_conn_t *shared_conn;
+
+	if (!slurmdbd_conf || (slurmdbd_conf->max_batch_records <= 1) ||
+	    (slurmdbd_conf->max_batch_threads <= 1) ||
+	    slurmdbd_conf->commit_delay ||
+	    !(mysql_conn->flags & DB_CONN_FLAG_ROLLBACK))
+		return mysql_conn;
+
+	slurm_mutex_lock(&shared_conn_lock);
+
+	if (!(shared_conn = mysql_conn->shared_conn)) {
+		shared_conn = create_mysql_conn(mysql_conn->conn, true,
+						mysql_conn->cluster_name);
+		mysql_conn->shared_conn = shared_conn;
+	}
+
+	/* The cluster name may have been set after the connection was made */
+	if (xstrcmp(shared_conn->cluster_name, mysql_conn->cluster_name)) {
+		xfree(shared_conn->cluster_name);
+		shared_conn->cluster_name = xstrdup(mysql_conn->cluster_name);
+	}
+
+	if (check_connection(shared_conn) != SLURM_SUCCESS) {
+		slurm_mutex_unlock(&shared_conn_lock);
+		return mysql_conn;
+	}
+
+	return shared_conn;
+}
+
+/*
+ * Commit or roll back what was written on the connection returned by
+ * get_shared_conn()
+ * IN commit - true to commit, false to roll back
+ * RET SLURM_SUCCESS or error of the commit
+ */
+extern int release_shared_conn(mysql_conn_t *mysql_conn,
+			       mysql_conn_t *shared_conn, bool commit)
+{
+	int rc;
+
+	if (shared_conn == mysql_conn)
+		return SLURM_SUCCESS;
+
+	rc = acct_storage_p_commit(shared_conn, commit);
+	slurm_mutex_unlock(&shared_conn_lock);
+
+	return rc;
+}
+
 extern int create_cluster_assoc_table(
 	mysql_conn_t *mysql_conn, char *cluster_name)
 {
@@ -2574,6 +2651,8 @@ extern int remove_common(mysql_conn_t *mysql_conn,
 			error("couldn't remove assoc");
 			break;
 		}
+		as_mysql_job_cache_mark(mysql_conn, cluster_name, 0);
+		mysql_conn->flags |= DB_CONN_FLAG_USAGE_CHANGED;
 	}
 	mysql_free_result(result);
 	/* This already happened before, but we need to run it again
@@ -2855,6 +2934,15 @@ extern int init(void)
 	mysql_db_info = create_mysql_db_info(SLURM_MYSQL_PLUGIN_AS);
 	mysql_db_name = acct_get_db_name();
 
+	if (slurmdbd_conf->storage_replica_host) {
+		mysql_replica_info = create_mysql_db_info(SLURM_MYSQL_PLUGIN_AS);
+		xfree(mysql_replica_info->backup);
+		xfree(mysql_replica_info->host);
+		mysql_replica_info->host =
+			xstrdup(slurmdbd_conf->storage_replica_host);
+		mysql_replica_info->port = slurmdbd_conf->storage_replica_port;
+	}
+
 	debug2("mysql_connect() called for db %s", mysql_db_name);
 	mysql_conn = create_mysql_conn(0, 1, NULL);
 	while (mysql_db_get_db_connection(
@@ -2884,17 +2972,23 @@ extern int init(void)
 
 	destroy_mysql_conn(mysql_conn);
 
+	if (rc == SLURM_SUCCESS)
+		as_mysql_job_cache_init();
+
 	return rc;
 }
 
 extern int fini ( void )
 {
+	as_mysql_job_cache_fini();
+	as_mysql_usage_cache_clear(NULL, 0);
 	slurm_rwlock_wrlock(&as_mysql_cluster_list_lock);
 	FREE_NULL_LIST(as_mysql_cluster_list);
 	FREE_NULL_LIST(as_mysql_total_cluster_list);
 	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 	slurm_rwlock_destroy(&as_mysql_cluster_list_lock);
 	destroy_mysql_db_info(mysql_db_info);
+	destroy_mysql_db_info(mysql_replica_info);
 	xfree(mysql_db_name);
 	xfree(default_qos_str);
 
@@ -2980,9 +3074,115 @@ extern int acct_storage_p_close_connection(mysql_conn_t **mysql_conn)
 	return rc;
 }
 
+/*
+ * RET how many seconds the replica is behind the primary, 0 if it is not
+ * replicating from anything, -1 if replication is broken or unknown, or -2 if
+ * the replication status can't be read
+ */
+static int _replica_lag(mysql_conn_t *replica)
+{
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	MYSQL_FIELD *fields;
+	unsigned int i, field_cnt;
+	int lag = 0;
+
+	/*
+	 * Both need the REPLICATION CLIENT privilege. "show slave status" is
+	 * deprecated in favor of "show replica status" since MySQL 8.0.22 and
+	 * MariaDB 10.5.1, older servers only know the former.
+	 */
+	if (!(result = mysql_db_query_ret_quiet(replica, "show replica status",
+						0)) &&
+	    !(result = mysql_db_query_ret_quiet(replica, "show slave status",
+						0)))
+		return -2;
+
+	if ((row = mysql_fetch_row(result))) {
+		lag = -1;
+		fields = mysql_fetch_fields(result);
+		field_cnt = mysql_num_fields(result);
+		for (i = 0; i < field_cnt; i++) {
+			if (xstrcasecmp(fields[i].name,
+					"Seconds_Behind_Source") &&
+			    xstrcasecmp(fields[i].name,
+					"Seconds_Behind_Master"))
+				continue;
+			if (row[i])
+				lag = atoi(row[i]);
+			break;
+		}
+	}
+	mysql_free_result(result);
+
+	return lag;
+}
+
+extern void *acct_storage_p_get_read_connection(mysql_conn_t *mysql_conn)
+{
+	mysql_conn_t *replica;
+	time_t now;
+	int lag;
+
+	if (!mysql_replica_info || !mysql_conn ||
+	    (mysql_conn->flags & DB_CONN_FLAG_REPLICA))
+		return mysql_conn;
+
+	if (!(replica = mysql_conn->replica)) {
+		/* Without rollback every query sees the latest replicated data */
+		replica = create_mysql_conn(mysql_conn->conn, false,
+					    mysql_conn->cluster_name);
+		replica->flags |= DB_CONN_FLAG_REPLICA;
+		mysql_conn->replica = replica;
+	}
+
+	now = time(NULL);
+	if (now < mysql_conn->replica_check)
+		return mysql_conn->replica_ok ? replica : mysql_conn;
+
+	mysql_conn->replica_check = now + REPLICA_CHECK_SEC;
+	mysql_conn->replica_ok = false;
+
+	/* The cluster name may have been set after the replica was made */
+	if (xstrcmp(replica->cluster_name, mysql_conn->cluster_name)) {
+		xfree(replica->cluster_name);
+		replica->cluster_name = xstrdup(mysql_conn->cluster_name);
+	}
+
+	if (check_connection(replica) != SLURM_SUCCESS) {
+		error("Unable to connect to the StorageReplicaHost %s, sending queries to the primary for %d seconds",
+		      mysql_replica_info->host, REPLICA_RETRY_SEC);
+		mysql_conn->replica_check = now + REPLICA_RETRY_SEC;
+	} else if ((lag = _replica_lag(replica)) == -2) {
+		if (!replica_status_failed)
+			error("Unable to read the replication status of StorageReplicaHost %s, StorageUser needs the REPLICATION CLIENT privilege. Sending queries to the primary.",
+			      mysql_replica_info->host);
+		else
+			debug("Unable to read the replication status of StorageReplicaHost %s, sending queries to the primary for %d seconds",
+			      mysql_replica_info->host, REPLICA_RETRY_SEC);
+		replica_status_failed = true;
+		mysql_conn->replica_check = now + REPLICA_RETRY_SEC;
+	} else if (lag < 0) {
+		replica_status_failed = false;
+		error("Replication to StorageReplicaHost %s is not running, sending queries to the primary",
+		      mysql_replica_info->host);
+	} else if (lag > slurmdbd_conf->storage_replica_max_lag) {
+		replica_status_failed = false;
+		debug("StorageReplicaHost %s is %d seconds behind, sending queries to the primary",
+		      mysql_replica_info->host, lag);
+	} else {
+		replica_status_failed = false;
+		mysql_conn->replica_ok = true;
+	}
+
+	return mysql_conn->replica_ok ? replica : mysql_conn;
+}
+
 extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 {
 	int rc = check_connection(mysql_conn);
+	int commit_rc = SLURM_SUCCESS;
+	bool committed = false;
 	List update_list = NULL;
 
 	/* always reset this here */
@@ -3004,15 +3204,18 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 
 	if (mysql_conn->flags & DB_CONN_FLAG_ROLLBACK) {
 		if (!commit) {
+			as_mysql_batch_discard(mysql_conn);
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
+			/* Write anything batched before committing */
+			int rc = commit_rc = as_mysql_batch_flush(mysql_conn);
 			/*
 			 * Handle anything here we were unable to do
 			 * because of rollback issues.
 			 */
-			if (mysql_conn->pre_commit_query) {
+			if ((rc == SLURM_SUCCESS) &&
+			    mysql_conn->pre_commit_query) {
 				DB_DEBUG(DB_ASSOC, mysql_conn->conn,
 				         "query\n%s",
 				         mysql_conn->pre_commit_query);
@@ -3021,15 +3224,26 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 					mysql_conn->pre_commit_query);
 			}
 
+			/*
+			 * Report anything that was not stored so callers
+			 * like DBD_SEND_MULT_MSG can have it sent again.
+			 */
 			if (rc != SLURM_SUCCESS) {
+				commit_rc = rc;
 				if (mysql_db_rollback(mysql_conn))
 					error("rollback failed");
+			} else if (mysql_db_commit(mysql_conn)) {
+				error("commit failed");
+				commit_rc = SLURM_ERROR;
 			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
+				committed = true;
 			}
 		}
 	}
+	as_mysql_job_cache_commit(mysql_conn, committed);
+	if (committed && (mysql_conn->flags & DB_CONN_FLAG_USAGE_CHANGED))
+		as_mysql_usage_cache_clear(NULL, 0);
+	mysql_conn->flags &= ~DB_CONN_FLAG_USAGE_CHANGED;
 
 	if (commit && list_count(update_list)) {
 		ListIterator itr = NULL;
@@ -3077,7 +3291,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	FREE_NULL_LIST(update_list);
 
-	return SLURM_SUCCESS;
+	return commit_rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
@@ -3608,6 +3822,23 @@ extern List jobacct_storage_p_get_jobs_cond(mysql_conn_t *mysql_conn,
 	return job_list;
 }
 
+/*
+ * get info from the storage a chunk at a time
+ */
+extern int jobacct_storage_p_get_jobs_stream(mysql_conn_t *mysql_conn,
+					     uid_t uid,
+					     slurmdb_job_cond_t *job_cond,
+					     slurmdb_job_stream_cb_t callback,
+					     void *arg)
+{
+	if (check_connection(mysql_conn) != SLURM_SUCCESS)
+		return ESLURM_DB_CONNECTION;
+
+	return as_mysql_jobacct_process_get_jobs_stream(mysql_conn, uid,
+							job_cond, callback,
+							arg);
+}
+
 /*
  * expire old info from the storage
  */
@@ -3666,13 +3897,21 @@ extern int acct_storage_p_reset_lft_rgt(mysql_conn_t *mysql_conn, uid_t uid,
 	return as_mysql_reset_lft_rgt(mysql_conn, uid, cluster_list);
 }
 
-extern int acct_storage_p_get_stats(void *db_conn, bool dbd)
+extern int acct_storage_p_get_stats(void *db_conn, slurmdb_stats_rec_t **stats)
 {
+	if (!stats || !*stats)
+		return SLURM_ERROR;
+
+	FREE_NULL_LIST((*stats)->stmt_stats);
+	(*stats)->stmt_stats = mysql_db_stmt_stats_get();
+
 	return SLURM_SUCCESS;
 }
 
-extern int acct_storage_p_clear_stats(void *db_conn, bool dbd)
+extern int acct_storage_p_clear_stats(void *db_conn)
 {
+	mysql_db_stmt_stats_clear();
+
 	return SLURM_SUCCESS;
 }
 
@@ -64,6 +64,8 @@
  */
 #define TRES_OFFSET 1000
 
+#define REPLICA_CHECK_SEC 5	/* how often to check the replica lag */
+
 #include "src/common/assoc_mgr.h"
 #include "src/common/macros.h"
 #include "src/common/slurmdbd_defs.h"
@@ -130,6 +132,9 @@ extern int check_connection(mysql_conn_t *mysql_conn);
 extern char *fix_double_quotes(char *str);
 extern int last_affected_rows(mysql_conn_t *mysql_conn);
 extern void reset_mysql_conn(mysql_conn_t *mysql_conn);
+extern mysql_conn_t *get_shared_conn(mysql_conn_t *mysql_conn);
+extern int release_shared_conn(mysql_conn_t *mysql_conn,
+			       mysql_conn_t *shared_conn, bool commit);
 extern int create_cluster_assoc_table(
 	mysql_conn_t *mysql_conn, char *cluster_name);
 extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name);
@@ -42,6 +42,8 @@
 #include <unistd.h>
 
 #include "as_mysql_archive.h"
+#include "as_mysql_job_cache.h"
+#include "as_mysql_usage.h"
 #include "src/common/env.h"
 #include "src/common/slurm_time.h"
 #include "src/common/slurmdbd_defs.h"
@@ -76,6 +78,23 @@
 #define RECORDS_PER_PASS 1000	/* Records per single sql statement. */
 #endif /* RECORDS_PER_PASS */
 
+#define ARCHIVE_LOAD_THREADS 4	/* Threads decoding columnar archive chunks */
+#define ARCHIVE_LOAD_QUEUED (ARCHIVE_LOAD_THREADS * 2) /* Statements waiting
+							* to be loaded. */
+
+typedef struct {
+	archive_file_t *af;
+	pthread_cond_t cond;
+	bool done;		/* stop reading chunks */
+	char *insert;		/* start of each insert statement */
+	pthread_mutex_t lock;
+	char *on_dup;		/* end of each insert statement */
+	list_t *queries;	/* statements waiting to be loaded */
+	int queued;		/* chunks being decoded or in queries */
+	int rc;
+	int workers;		/* threads still running */
+} archive_load_t;
+
 typedef struct {
 	char *cluster_nodes;
 	char *node_name;
@@ -908,21 +927,6 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 			       char *arch_dir, uint32_t archive_period,
 			       char *sql_table, uint32_t usage_info);
 
-static uint32_t high_buffer_size = (1024 * 1024);
-
-static void _pack_local_event(local_event_t *object, uint16_t rpc_version,
-			      buf_t *buffer)
-{
-	packstr(object->cluster_nodes, buffer);
-	packstr(object->node_name, buffer);
-	packstr(object->period_end, buffer);
-	packstr(object->period_start, buffer);
-	packstr(object->reason, buffer);
-	packstr(object->reason_uid, buffer);
-	packstr(object->state, buffer);
-	packstr(object->tres_str, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_event(local_event_t *object, uint16_t rpc_version,
@@ -960,66 +964,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_job(local_job_t *object, uint16_t rpc_version,
-			    buf_t *buffer)
-{
-	packstr(object->account, buffer);
-	packstr(object->admin_comment, buffer);
-	packstr(object->alloc_nodes, buffer);
-	packstr(object->associd, buffer);
-	packstr(object->array_jobid, buffer);
-	packstr(object->array_max_tasks, buffer);
-	packstr(object->array_taskid, buffer);
-	packstr(object->array_task_pending, buffer);
-	packstr(object->array_task_str, buffer);
-	packstr(object->script_hash_inx, buffer);
-	packstr(object->blockid, buffer);
-	packstr(object->constraints, buffer);
-	packstr(object->container, buffer);
-	packstr(object->deleted, buffer);
-	packstr(object->derived_ec, buffer);
-	packstr(object->derived_es, buffer);
-	packstr(object->env_hash_inx, buffer);
-	packstr(object->exit_code, buffer);
-	packstr(object->extra, buffer);
-	packstr(object->flags, buffer);
-	packstr(object->timelimit, buffer);
-	packstr(object->eligible, buffer);
-	packstr(object->end, buffer);
-	packstr(object->gid, buffer);
-	packstr(object->gres_used, buffer);
-	packstr(object->job_db_inx, buffer);
-	packstr(object->jobid, buffer);
-	packstr(object->kill_requid, buffer);
-	packstr(object->licenses, buffer);
-	packstr(object->mcs_label, buffer);
-	packstr(object->mod_time, buffer);
-	packstr(object->name, buffer);
-	packstr(object->nodelist, buffer);
-	packstr(object->node_inx, buffer);
-	packstr(object->het_job_id, buffer);
-	packstr(object->het_job_offset, buffer);
-	packstr(object->partition, buffer);
-	packstr(object->priority, buffer);
-	packstr(object->qos, buffer);
-	packstr(object->req_cpus, buffer);
-	packstr(object->req_mem, buffer);
-	packstr(object->resvid, buffer);
-	packstr(object->start, buffer);
-	packstr(object->state, buffer);
-	packstr(object->state_reason_prev, buffer);
-	packstr(object->submit, buffer);
-	packstr(object->suspended, buffer);
-	packstr(object->submit_line, buffer);
-	packstr(object->system_comment, buffer);
-	packstr(object->tres_alloc_str, buffer);
-	packstr(object->tres_req_str, buffer);
-	packstr(object->uid, buffer);
-	packstr(object->wckey, buffer);
-	packstr(object->wckey_id, buffer);
-	packstr(object->work_dir, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_job(local_job_t *object, uint16_t rpc_version,
@@ -1741,15 +1685,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_job_env(local_job_env_t *object, uint16_t rpc_version,
-				buf_t *buffer)
-{
-	packstr(object->hash_inx, buffer);
-	packstr(object->last_used, buffer);
-	packstr(object->env_hash, buffer);
-	packstr(object->env_vars, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_job_env(local_job_env_t *object, uint16_t rpc_version,
@@ -1769,15 +1704,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_job_script(local_job_script_t *object,
-				   uint16_t rpc_version, buf_t *buffer)
-{
-	packstr(object->hash_inx, buffer);
-	packstr(object->last_used, buffer);
-	packstr(object->script_hash, buffer);
-	packstr(object->batch_script, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_job_script(local_job_script_t *object,
@@ -1797,23 +1723,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_resv(local_resv_t *object, uint16_t rpc_version,
-			     buf_t *buffer)
-{
-	packstr(object->assocs, buffer);
-	packstr(object->comment, buffer);
-	packstr(object->deleted, buffer);
-	packstr(object->flags, buffer);
-	packstr(object->id, buffer);
-	packstr(object->name, buffer);
-	packstr(object->nodes, buffer);
-	packstr(object->node_inx, buffer);
-	packstr(object->time_end, buffer);
-	packstr(object->time_start, buffer);
-	packstr(object->tres_str, buffer);
-	packstr(object->unused_wall, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_resv(local_resv_t *object, uint16_t rpc_version,
@@ -1889,55 +1798,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_step(local_step_t *object, uint16_t rpc_version,
-			     buf_t *buffer)
-{
-	packstr(object->act_cpufreq, buffer);
-	packstr(object->deleted, buffer);
-	packstr(object->exit_code, buffer);
-	packstr(object->consumed_energy, buffer);
-	packstr(object->container, buffer);
-	packstr(object->job_db_inx, buffer);
-	packstr(object->kill_requid, buffer);
-	packstr(object->name, buffer);
-	packstr(object->nodelist, buffer);
-	packstr(object->nodes, buffer);
-	packstr(object->node_inx, buffer);
-	packstr(object->period_end, buffer);
-	packstr(object->period_start, buffer);
-	packstr(object->period_suspended, buffer);
-	packstr(object->req_cpufreq_min, buffer);
-	packstr(object->req_cpufreq_max, buffer);
-	packstr(object->req_cpufreq_gov, buffer);
-	packstr(object->state, buffer);
-	packstr(object->stepid, buffer);
-	packstr(object->step_het_comp, buffer);
-	packstr(object->submit_line, buffer);
-	packstr(object->sys_sec, buffer);
-	packstr(object->sys_usec, buffer);
-	packstr(object->tasks, buffer);
-	packstr(object->task_dist, buffer);
-	packstr(object->tres_alloc_str, buffer);
-	packstr(object->tres_usage_in_ave, buffer);
-	packstr(object->tres_usage_in_max, buffer);
-	packstr(object->tres_usage_in_max_nodeid, buffer);
-	packstr(object->tres_usage_in_max_taskid, buffer);
-	packstr(object->tres_usage_in_min, buffer);
-	packstr(object->tres_usage_in_min_nodeid, buffer);
-	packstr(object->tres_usage_in_min_taskid, buffer);
-	packstr(object->tres_usage_in_tot, buffer);
-	packstr(object->tres_usage_out_ave, buffer);
-	packstr(object->tres_usage_out_max, buffer);
-	packstr(object->tres_usage_out_max_nodeid, buffer);
-	packstr(object->tres_usage_out_max_taskid, buffer);
-	packstr(object->tres_usage_out_min, buffer);
-	packstr(object->tres_usage_out_min_nodeid, buffer);
-	packstr(object->tres_usage_out_min_taskid, buffer);
-	packstr(object->tres_usage_out_tot, buffer);
-	packstr(object->user_sec, buffer);
-	packstr(object->user_usec, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_step(local_step_t *object, uint16_t rpc_version,
@@ -2582,15 +2442,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_suspend(local_suspend_t *object, uint16_t rpc_version,
-				buf_t *buffer)
-{
-	packstr(object->associd, buffer);
-	packstr(object->job_db_inx, buffer);
-	packstr(object->period_end, buffer);
-	packstr(object->period_start, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_suspend(local_suspend_t *object, uint16_t rpc_version,
@@ -2610,18 +2461,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_txn(local_txn_t *object, uint16_t rpc_version,
-			    buf_t *buffer)
-{
-	packstr(object->id, buffer);
-	packstr(object->timestamp, buffer);
-	packstr(object->action, buffer);
-	packstr(object->name, buffer);
-	packstr(object->actor, buffer);
-	packstr(object->info, buffer);
-	packstr(object->cluster, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_txn(local_txn_t *object, uint16_t rpc_version,
@@ -2644,18 +2483,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_usage(local_usage_t *object, uint16_t rpc_version,
-			      buf_t *buffer)
-{
-	packstr(object->id, buffer);
-	packstr(object->tres_id, buffer);
-	packstr(object->time_start, buffer);
-	packstr(object->alloc_secs, buffer);
-	packstr(object->creation_time, buffer);
-	packstr(object->mod_time, buffer);
-	packstr(object->deleted, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_usage(local_usage_t *object, uint16_t rpc_version,
@@ -2685,23 +2512,6 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-static void _pack_local_cluster_usage(local_cluster_usage_t *object,
-				      uint16_t rpc_version, buf_t *buffer)
-{
-	packstr(object->tres_id, buffer);
-	packstr(object->time_start, buffer);
-	packstr(object->tres_cnt, buffer);
-	packstr(object->alloc_secs, buffer);
-	packstr(object->down_secs, buffer);
-	packstr(object->pdown_secs, buffer);
-	packstr(object->idle_secs, buffer);
-	packstr(object->plan_secs, buffer);
-	packstr(object->over_secs, buffer);
-	packstr(object->creation_time, buffer);
-	packstr(object->mod_time, buffer);
-	packstr(object->deleted, buffer);
-}
-
 /* this needs to be allocated before calling, and since we aren't
  * doing any copying it needs to be used before destroying buffer */
 static int _unpack_local_cluster_usage(local_cluster_usage_t *object,
@@ -3305,59 +3115,54 @@ static int _process_old_sql(char **data)
 	return rc;
 }
 
-static char *_get_archive_columns(purge_type_t type)
+static char **_get_archive_inx(purge_type_t type, int *col_count)
 {
-	char **cols = NULL;
-	char *tmp = NULL;
-	int col_count = 0, i = 0;
-
-	xfree(cols);
-
 	switch (type) {
 	case PURGE_EVENT:
-		cols      = event_req_inx;
-		col_count = EVENT_REQ_COUNT;
-		break;
+		*col_count = EVENT_REQ_COUNT;
+		return event_req_inx;
 	case PURGE_SUSPEND:
-		cols      = suspend_req_inx;
-		col_count = SUSPEND_REQ_COUNT;
-		break;
+		*col_count = SUSPEND_REQ_COUNT;
+		return suspend_req_inx;
 	case PURGE_RESV:
-		cols      = resv_req_inx;
-		col_count = RESV_REQ_COUNT;
-		break;
+		*col_count = RESV_REQ_COUNT;
+		return resv_req_inx;
 	case PURGE_JOB:
-		cols      = job_req_inx;
-		col_count = JOB_REQ_COUNT;
-		break;
+		*col_count = JOB_REQ_COUNT;
+		return job_req_inx;
 	case PURGE_JOB_ENV:
-		cols      = job_env_inx;
-		col_count = JOB_ENV_COUNT;
-		break;
+		*col_count = JOB_ENV_COUNT;
+		return job_env_inx;
 	case PURGE_JOB_SCRIPT:
-		cols      = job_script_inx;
-		col_count = JOB_SCRIPT_COUNT;
-		break;
+		*col_count = JOB_SCRIPT_COUNT;
+		return job_script_inx;
 	case PURGE_STEP:
-		cols      = step_req_inx;
-		col_count = STEP_REQ_COUNT;
-		break;
+		*col_count = STEP_REQ_COUNT;
+		return step_req_inx;
 	case PURGE_TXN:
-		cols      = txn_req_inx;
-		col_count = TXN_REQ_COUNT;
-		break;
+		*col_count = TXN_REQ_COUNT;
+		return txn_req_inx;
 	case PURGE_USAGE:
-		cols      = usage_req_inx;
-		col_count = USAGE_COUNT;
-		break;
+		*col_count = USAGE_COUNT;
+		return usage_req_inx;
 	case PURGE_CLUSTER_USAGE:
-		cols      = cluster_req_inx;
-		col_count = CLUSTER_COUNT;
-		break;
+		*col_count = CLUSTER_COUNT;
+		return cluster_req_inx;
 	default:
 		xassert(0);
+		*col_count = 0;
 		return NULL;
 	}
+}
+
+static char *_get_archive_columns(purge_type_t type)
+{
+	char **cols = NULL;
+	char *tmp = NULL;
+	int col_count = 0, i = 0;
+
+	if (!(cols = _get_archive_inx(type, &col_count)))
+		return NULL;
 
 	xstrfmtcat(tmp, "%s", cols[0]);
 	for (i=1; i<col_count; i++) {
@@ -3368,42 +3173,6 @@ static char *_get_archive_columns(purge_type_t type)
 }
 
 
-static buf_t *_pack_archive_events(MYSQL_RES *result, char *cluster_name,
-				   uint32_t cnt, uint32_t usage_info,
-				   time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_event_t event;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_EVENTS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[EVENT_REQ_START]);
-
-		memset(&event, 0, sizeof(local_event_t));
-
-		event.cluster_nodes = row[EVENT_REQ_CNODES];
-		event.node_name = row[EVENT_REQ_NODE];
-		event.period_end = row[EVENT_REQ_END];
-		event.period_start = row[EVENT_REQ_START];
-		event.reason = row[EVENT_REQ_REASON];
-		event.reason_uid = row[EVENT_REQ_REASON_UID];
-		event.state = row[EVENT_REQ_STATE];
-		event.tres_str = row[EVENT_REQ_TRES];
-
-		_pack_local_event(&event, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_events(uint16_t rpc_version, buf_t *buffer,
 			  char *cluster_name, uint32_t rec_cnt)
@@ -3455,89 +3224,6 @@ static char *_load_events(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
-				 uint32_t cnt, uint32_t usage_info,
-				 time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_job_t job;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_JOBS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[JOB_REQ_SUBMIT]);
-
-		memset(&job, 0, sizeof(local_job_t));
-
-		job.account = row[JOB_REQ_ACCOUNT];
-		job.admin_comment = row[JOB_REQ_ADMIN_COMMENT];
-		job.alloc_nodes = row[JOB_REQ_ALLOC_NODES];
-		job.associd = row[JOB_REQ_ASSOCID];
-		job.array_jobid = row[JOB_REQ_ARRAYJOBID];
-		job.array_max_tasks = row[JOB_REQ_ARRAY_MAX];
-		job.array_taskid = row[JOB_REQ_ARRAYTASKID];
-		job.array_task_pending = row[JOB_REQ_ARRAY_TASK_PENDING];
-		job.array_task_str = row[JOB_REQ_ARRAY_TASK_STR];
-		job.script_hash_inx = row[JOB_REQ_SCRIPT_HASH_INX];
-		job.blockid = row[JOB_REQ_BLOCKID];
-		job.constraints = row[JOB_REQ_CONSTRAINTS];
-		job.container = row[JOB_REQ_CONTAINER];
-		job.deleted = row[JOB_REQ_DELETED];
-		job.derived_ec = row[JOB_REQ_DERIVED_EC];
-		job.derived_es = row[JOB_REQ_DERIVED_ES];
-		job.env_hash_inx = row[JOB_REQ_ENV_HASH_INX];
-		job.exit_code = row[JOB_REQ_EXIT_CODE];
-		job.extra = row[JOB_REQ_EXTRA];
-		job.flags = row[JOB_REQ_FLAGS];
-		job.timelimit = row[JOB_REQ_TIMELIMIT];
-		job.eligible = row[JOB_REQ_ELIGIBLE];
-		job.end = row[JOB_REQ_END];
-		job.gid = row[JOB_REQ_GID];
-		job.gres_used = row[JOB_REQ_GRES_USED];
-		job.het_job_id = row[JOB_REQ_HET_JOB_ID];
-		job.het_job_offset = row[JOB_REQ_HET_JOB_OFFSET];
-		job.job_db_inx = row[JOB_REQ_DB_INX];
-		job.jobid = row[JOB_REQ_JOBID];
-		job.kill_requid = row[JOB_REQ_KILL_REQUID];
-		job.licenses = row[JOB_REQ_LICENSES];
-		job.mcs_label = row[JOB_REQ_MCS_LABEL];
-		job.mod_time = row[JOB_REQ_MOD_TIME];
-		job.name = row[JOB_REQ_NAME];
-		job.nodelist = row[JOB_REQ_NODELIST];
-		job.node_inx = row[JOB_REQ_NODE_INX];
-		job.partition = row[JOB_REQ_PARTITION];
-		job.priority = row[JOB_REQ_PRIORITY];
-		job.qos = row[JOB_REQ_QOS];
-		job.req_cpus = row[JOB_REQ_REQ_CPUS];
-		job.req_mem = row[JOB_REQ_REQ_MEM];
-		job.resvid = row[JOB_REQ_RESVID];
-		job.start = row[JOB_REQ_START];
-		job.state = row[JOB_REQ_STATE];
-		job.state_reason_prev = row[JOB_REQ_STATE_REASON];
-		job.submit = row[JOB_REQ_SUBMIT];
-		job.submit_line = row[JOB_REQ_SUBMIT_LINE];
-		job.suspended = row[JOB_REQ_SUSPENDED];
-		job.system_comment = row[JOB_REQ_SYSTEM_COMMENT];
-		job.tres_alloc_str = row[JOB_REQ_TRESA];
-		job.tres_req_str = row[JOB_REQ_TRESR];
-		job.uid = row[JOB_REQ_UID];
-		job.wckey = row[JOB_REQ_WCKEY];
-		job.wckey_id = row[JOB_REQ_WCKEYID];
-		job.work_dir = row[JOB_REQ_WORK_DIR];
-
-		_pack_local_job(&job, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 			char *cluster_name, uint32_t rec_cnt)
@@ -3783,38 +3469,6 @@ static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_job_env(MYSQL_RES *result, char *cluster_name,
-				    uint32_t cnt, uint32_t usage_info,
-				    time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_job_env_t job;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_JOB_ENV, buffer); // FIXME
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			error("period_start should already be set");
-
-		memset(&job, 0, sizeof(local_job_env_t));
-
-		job.hash_inx = row[JOB_ENV_HASH_INX];
-		job.last_used = row[JOB_ENV_LAST_USED];
-		job.env_hash = row[JOB_ENV_ENV_HASH];
-		job.env_vars = row[JOB_ENV_ENV_VARS];
-
-		_pack_local_job_env(&job, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_job_env(uint16_t rpc_version, buf_t *buffer,
 			   char *cluster_name, uint32_t rec_cnt)
@@ -3891,38 +3545,6 @@ static char *_load_job_env(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_job_script(MYSQL_RES *result, char *cluster_name,
-				       uint32_t cnt, uint32_t usage_info,
-				       time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_job_script_t job;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_JOB_SCRIPT, buffer); //FIXME
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			error("period_start should already be set");
-
-		memset(&job, 0, sizeof(local_job_script_t));
-
-		job.hash_inx = row[JOB_SCRIPT_HASH_INX];
-		job.last_used = row[JOB_SCRIPT_LAST_USED];
-		job.script_hash = row[JOB_SCRIPT_SCRIPT_HASH];
-		job.batch_script = row[JOB_SCRIPT_BATCH_SCRIPT];
-
-		_pack_local_job_script(&job, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_job_script(uint16_t rpc_version, buf_t *buffer,
 			      char *cluster_name, uint32_t rec_cnt)
@@ -4001,46 +3623,6 @@ static char *_load_job_script(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
-				  uint32_t cnt, uint32_t usage_info,
-				  time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_resv_t resv;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_RESVS, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[RESV_REQ_START]);
-
-		memset(&resv, 0, sizeof(local_resv_t));
-
-		resv.assocs = row[RESV_REQ_ASSOCS];
-		resv.deleted = row[RESV_REQ_DELETED];
-		resv.flags = row[RESV_REQ_FLAGS];
-		resv.id = row[RESV_REQ_ID];
-		resv.name = row[RESV_REQ_NAME];
-		resv.nodes = row[RESV_REQ_NODES];
-		resv.node_inx = row[RESV_REQ_NODE_INX];
-		resv.time_end = row[RESV_REQ_END];
-		resv.time_start = row[RESV_REQ_START];
-		resv.tres_str = row[RESV_REQ_TRES];
-		resv.unused_wall = row[RESV_REQ_UNUSED];
-		resv.comment = row[RESV_REQ_COMMENT];
-
-		_pack_local_resv(&resv, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_resvs(uint16_t rpc_version, buf_t *buffer,
 			 char *cluster_name, uint32_t rec_cnt)
@@ -4134,86 +3716,6 @@ static char *_load_resvs(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_steps(MYSQL_RES *result, char *cluster_name,
-				  uint32_t cnt, uint32_t usage_info,
-				  time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_step_t step;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_STEP_START, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[STEP_REQ_START]);
-
-		memset(&step, 0, sizeof(local_step_t));
-
-		step.act_cpufreq = row[STEP_REQ_ACT_CPUFREQ];
-		step.deleted = row[STEP_REQ_DELETED];
-		step.consumed_energy = row[STEP_REQ_CONSUMED_ENERGY];
-		step.container = row[STEP_REQ_CONTAINER];
-		step.exit_code = row[STEP_REQ_EXIT_CODE];
-		step.job_db_inx = row[STEP_REQ_DB_INX];
-		step.kill_requid = row[STEP_REQ_KILL_REQUID];
-		step.name = row[STEP_REQ_NAME];
-		step.nodelist = row[STEP_REQ_NODELIST];
-		step.nodes = row[STEP_REQ_NODES];
-		step.node_inx = row[STEP_REQ_NODE_INX];
-		step.period_end = row[STEP_REQ_END];
-		step.period_start = row[STEP_REQ_START];
-		step.period_suspended = row[STEP_REQ_SUSPENDED];
-		step.req_cpufreq_min = row[STEP_REQ_REQ_CPUFREQ_MIN];
-		step.req_cpufreq_max = row[STEP_REQ_REQ_CPUFREQ_MAX];
-		step.req_cpufreq_gov = row[STEP_REQ_REQ_CPUFREQ_GOV];
-		step.state = row[STEP_REQ_STATE];
-		step.stepid = row[STEP_REQ_STEPID];
-		step.step_het_comp = row[STEP_REQ_STEP_HET_COMP];
-		step.submit_line = row[STEP_REQ_SUBMIT_LINE];
-		step.sys_sec = row[STEP_REQ_SYS_SEC];
-		step.sys_usec = row[STEP_REQ_SYS_USEC];
-		step.tasks = row[STEP_REQ_TASKS];
-		step.task_dist = row[STEP_REQ_TASKDIST];
-		step.tres_alloc_str = row[STEP_REQ_TRES];
-		step.tres_usage_in_ave = row[STEP_TRES_USAGE_IN_AVE];
-		step.tres_usage_in_max = row[STEP_TRES_USAGE_IN_MAX];
-		step.tres_usage_in_max_nodeid =
-			row[STEP_TRES_USAGE_IN_MAX_NODEID];
-		step.tres_usage_in_max_taskid =
-			row[STEP_TRES_USAGE_IN_MAX_TASKID];
-		step.tres_usage_in_min = row[STEP_TRES_USAGE_IN_MIN];
-		step.tres_usage_in_min_nodeid =
-			row[STEP_TRES_USAGE_IN_MIN_NODEID];
-		step.tres_usage_in_min_taskid =
-			row[STEP_TRES_USAGE_IN_MIN_TASKID];
-		step.tres_usage_in_tot = row[STEP_TRES_USAGE_IN_TOT];
-		step.tres_usage_out_ave = row[STEP_TRES_USAGE_OUT_AVE];
-		step.tres_usage_out_max = row[STEP_TRES_USAGE_OUT_MAX];
-		step.tres_usage_out_max_nodeid =
-			row[STEP_TRES_USAGE_OUT_MAX_NODEID];
-		step.tres_usage_out_max_taskid =
-			row[STEP_TRES_USAGE_OUT_MAX_TASKID];
-		step.tres_usage_out_min = row[STEP_TRES_USAGE_OUT_MAX];
-		step.tres_usage_out_min_nodeid =
-			row[STEP_TRES_USAGE_OUT_MIN_NODEID];
-		step.tres_usage_out_min_taskid =
-			row[STEP_TRES_USAGE_OUT_MIN_TASKID];
-		step.tres_usage_out_tot = row[STEP_TRES_USAGE_OUT_TOT];
-		step.user_sec = row[STEP_REQ_USER_SEC];
-		step.user_usec = row[STEP_REQ_USER_USEC];
-
-		_pack_local_step(&step, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
 			 char *cluster_name, uint32_t rec_cnt)
@@ -4385,38 +3887,6 @@ static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
-				     uint32_t cnt, uint32_t usage_info,
-				     time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_suspend_t suspend;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_JOB_SUSPEND, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[SUSPEND_REQ_START]);
-
-		memset(&suspend, 0, sizeof(local_suspend_t));
-
-		suspend.job_db_inx = row[SUSPEND_REQ_DB_INX];
-		suspend.associd = row[SUSPEND_REQ_ASSOCID];
-		suspend.period_start = row[SUSPEND_REQ_START];
-		suspend.period_end = row[SUSPEND_REQ_END];
-
-		_pack_local_suspend(&suspend, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 
 /* returns sql statement from archived data or NULL on error */
 static char *_load_suspend(uint16_t rpc_version, buf_t *buffer,
@@ -4464,41 +3934,6 @@ static char *_load_suspend(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_txns(MYSQL_RES *result, char *cluster_name,
-				 uint32_t cnt, uint32_t usage_info,
-				 time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_txn_t txn;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_TXN, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[TXN_REQ_TS]);
-
-		memset(&txn, 0, sizeof(local_txn_t));
-
-		txn.id = row[TXN_REQ_ID];
-		txn.timestamp = row[TXN_REQ_TS];
-		txn.action = row[TXN_REQ_ACTION];
-		txn.name = row[TXN_REQ_NAME];
-		txn.actor = row[TXN_REQ_ACTOR];
-		txn.info = row[TXN_REQ_INFO];
-		txn.cluster = row[TXN_REQ_CLUSTER];
-
-		_pack_local_txn(&txn, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 
 /* returns sql statement from archived data or NULL on error */
 static char *_load_txn(uint16_t rpc_version, buf_t *buffer,
@@ -4576,44 +4011,6 @@ static char *_load_txn(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_usage(MYSQL_RES *result, char *cluster_name,
-				  uint32_t cnt, uint32_t usage_info,
-				  time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_usage_t usage;
-	uint16_t type = usage_info & 0x0000ffff;
-	uint16_t period = usage_info >> 16;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(type, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-	pack16(period, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[USAGE_START]);
-
-		memset(&usage, 0, sizeof(local_usage_t));
-
-		usage.id = row[USAGE_ID];
-		usage.tres_id = row[USAGE_TRES];
-		usage.time_start = row[USAGE_START];
-		usage.alloc_secs = row[USAGE_ALLOC];
-		usage.creation_time = row[USAGE_CREATION_TIME];
-		usage.mod_time = row[USAGE_MOD_TIME];
-		usage.deleted = row[USAGE_DELETED];
-
-		_pack_local_usage(&usage, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_usage(uint16_t rpc_version, buf_t *buffer,
 			 char *cluster_name, uint16_t type, uint16_t period,
@@ -4704,49 +4101,6 @@ static char *_load_usage(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-static buf_t *_pack_archive_cluster_usage(MYSQL_RES *result, char *cluster_name,
-					  uint32_t cnt, uint32_t usage_info,
-					  time_t *period_start)
-{
-	MYSQL_ROW row;
-	buf_t *buffer;
-	local_cluster_usage_t usage;
-	uint16_t period = usage_info >> 16;
-
-	buffer = init_buf(high_buffer_size);
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
-	pack16(DBD_GOT_CLUSTER_USAGE, buffer);
-	packstr(cluster_name, buffer);
-	pack32(cnt, buffer);
-	pack16(period, buffer);
-
-	while ((row = mysql_fetch_row(result))) {
-		if (period_start && !*period_start)
-			*period_start = slurm_atoul(row[CLUSTER_START]);
-
-		memset(&usage, 0, sizeof(local_cluster_usage_t));
-
-		usage.tres_id = row[CLUSTER_TRES];
-		usage.time_start = row[CLUSTER_START];
-		usage.tres_cnt = row[CLUSTER_CNT];
-		usage.alloc_secs = row[CLUSTER_ACPU];
-		usage.down_secs = row[CLUSTER_DCPU];
-		usage.pdown_secs = row[CLUSTER_PDCPU];
-		usage.idle_secs = row[CLUSTER_ICPU];
-		usage.plan_secs = row[CLUSTER_PCPU];
-		usage.over_secs = row[CLUSTER_OCPU];
-		usage.creation_time = row[CLUSTER_CREATION_TIME];
-		usage.mod_time = row[CLUSTER_MOD_TIME];
-		usage.deleted = row[CLUSTER_DELETED];
-
-		_pack_local_cluster_usage(
-			&usage, SLURM_PROTOCOL_VERSION, buffer);
-	}
-
-	return buffer;
-}
-
 /* returns sql statement from archived data or NULL on error */
 static char *_load_cluster_usage(uint16_t rpc_version, buf_t *buffer,
 				 char *cluster_name, uint16_t period,
@@ -4818,7 +4172,11 @@ static char *_load_cluster_usage(uint16_t rpc_version, buf_t *buffer,
 	return insert;
 }
 
-/* returns count of events archived or SLURM_ERROR on error */
+/*
+ * Stream the rows straight from the query into a columnar archive file, so
+ * a whole period never has to be held in memory.
+ * returns count of events archived or SLURM_ERROR on error
+ */
 static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 			       char *cluster_name, char *col_name,
 			       time_t *period_start, time_t period_end,
@@ -4826,57 +4184,66 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 			       char *sql_table, uint32_t usage_info)
 {
 	MYSQL_RES *result = NULL;
-	char *cols = NULL, *query = NULL, *parent_table = NULL,
+	MYSQL_ROW row;
+	archive_file_t *af = NULL;
+	char **inx, *cols = NULL, *query = NULL, *parent_table = NULL,
 		*hash_col = NULL;
 	uint32_t cnt = 0;
-	buf_t *buffer;
-	int error_code = 0;
-	buf_t *(*pack_func)(MYSQL_RES *result, char *cluster_name,
-			    uint32_t cnt, uint32_t usage_info,
-			    time_t *period_start);
-
-	cols = _get_archive_columns(type);
+	int col_cnt = 0, start_inx = -1, error_code = SLURM_SUCCESS;
+	uint16_t msg_type, flags = ARCHIVE_FILE_CLUSTER_TABLE;
 
 	switch (type) {
 	case PURGE_EVENT:
-		pack_func = &_pack_archive_events;
+		msg_type = DBD_GOT_EVENTS;
+		start_inx = EVENT_REQ_START;
 		break;
 	case PURGE_SUSPEND:
-		pack_func = &_pack_archive_suspends;
+		msg_type = DBD_JOB_SUSPEND;
+		start_inx = SUSPEND_REQ_START;
 		break;
 	case PURGE_RESV:
-		pack_func = &_pack_archive_resvs;
+		msg_type = DBD_GOT_RESVS;
+		start_inx = RESV_REQ_START;
 		break;
 	case PURGE_JOB:
-		pack_func = &_pack_archive_jobs;
+		msg_type = DBD_GOT_JOBS;
+		start_inx = JOB_REQ_SUBMIT;
 		break;
 	case PURGE_JOB_ENV:
 		parent_table = job_table;
 		hash_col = "env_hash_inx";
-		pack_func = &_pack_archive_job_env;
+		msg_type = DBD_GOT_JOB_ENV;
 		break;
 	case PURGE_JOB_SCRIPT:
 		parent_table = job_table;
 		hash_col = "script_hash_inx";
-		pack_func = &_pack_archive_job_script;
+		msg_type = DBD_GOT_JOB_SCRIPT;
 		break;
 	case PURGE_STEP:
-		pack_func = &_pack_archive_steps;
+		msg_type = DBD_STEP_START;
+		start_inx = STEP_REQ_START;
 		break;
 	case PURGE_TXN:
-		pack_func = &_pack_archive_txns;
+		msg_type = DBD_GOT_TXN;
+		start_inx = TXN_REQ_TS;
+		flags &= ~ARCHIVE_FILE_CLUSTER_TABLE;
 		break;
 	case PURGE_USAGE:
-		pack_func = &_pack_archive_usage;
+		msg_type = usage_info & 0x0000ffff;
+		start_inx = USAGE_START;
 		break;
 	case PURGE_CLUSTER_USAGE:
-		pack_func = &_pack_archive_cluster_usage;
+		msg_type = DBD_GOT_CLUSTER_USAGE;
+		start_inx = CLUSTER_START;
 		break;
 	default:
 		fatal("Unknown purge type: %d", type);
 		return SLURM_ERROR;
 	}
 
+	inx = _get_archive_inx(type, &col_cnt);
+	cols = _get_archive_columns(type);
+
 	switch (type) {
 	case PURGE_TXN:
 		query = xstrdup_printf("select %s from \"%s\" where "
@@ -4918,29 +4285,52 @@ static uint32_t _archive_table(purge_type_t type, mysql_conn_t *mysql_conn,
 	xfree(cols);
 
 	DB_DEBUG(DB_ARCHIVE, mysql_conn->conn, "query\n%s", query);
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+	if (!(result = mysql_db_query_use(mysql_conn, query))) {
 		xfree(query);
 		return SLURM_ERROR;
 	}
 	xfree(query);
 
-	if (!(cnt = mysql_num_rows(result))) {
-		mysql_free_result(result);
-		return 0;
+	while ((row = mysql_fetch_row(result))) {
+		if (!af) {
+			/* The file is named after the first record */
+			if ((start_inx >= 0) && !*period_start)
+				*period_start = slurm_atoul(row[start_inx]);
+			if (!(af = archive_create_file(cluster_name,
+						       *period_start,
+						       period_end, arch_dir,
+						       sql_table,
+						       archive_period,
+						       msg_type, flags, inx,
+						       col_cnt,
+						       RECORDS_PER_PASS))) {
+				error_code = SLURM_ERROR;
+				break;
+			}
+		}
+
+		if ((error_code = archive_file_add_row(af, row)))
+			break;
+		cnt++;
 	}
 
-	buffer = (*pack_func)(result, cluster_name, cnt, usage_info,
-			      period_start);
+	if (!error_code && mysql_errno(mysql_conn->db_conn)) {
+		error("%s: Error reading %s records: %s",
+		      __func__, sql_table, mysql_error(mysql_conn->db_conn));
+		error_code = SLURM_ERROR;
+	}
 	mysql_free_result(result);
 
-	error_code = archive_write_file(buffer, cluster_name,
-					*period_start, period_end,
-					arch_dir, sql_table,
-					archive_period);
-	FREE_NULL_BUFFER(buffer);
+	if (!af)
+		return error_code ? SLURM_ERROR : 0;
+
+	if (error_code) {
+		archive_file_discard(af);
+		return SLURM_ERROR;
+	}
 
-	if (error_code != SLURM_SUCCESS)
-		return error_code;
+	if (archive_file_close(af) != SLURM_SUCCESS)
+		return SLURM_ERROR;
 
 	return cnt;
 }
@@ -5359,6 +4749,14 @@ static int _execute_archive(mysql_conn_t *mysql_conn,
 			return rc;
 	}
 
+	if ((arch_cond->purge_suspend != NO_VAL) ||
+	    (arch_cond->purge_step != NO_VAL) ||
+	    (arch_cond->purge_job != NO_VAL)) {
+		/* The purges are already committed */
+		as_mysql_job_cache_mark(mysql_conn, cluster_name, 0);
+		as_mysql_job_cache_commit(mysql_conn, true);
+	}
+
 	if (arch_cond->purge_resv != NO_VAL) {
 		if ((rc = _archive_purge_table(PURGE_RESV, 0, mysql_conn,
 					       cluster_name, arch_cond)))
@@ -5393,6 +4791,8 @@ static int _execute_archive(mysql_conn_t *mysql_conn,
 				     mysql_conn, cluster_name, arch_cond)))
 			return rc;
 		}
+		/* The purges are already committed */
+		as_mysql_usage_cache_clear(cluster_name, 0);
 	}
 
 	return SLURM_SUCCESS;
@@ -5586,6 +4986,304 @@ unpack_error:
 	goto cleanup;
 }
 
+/* Build a multi-row insert of all the rows of a chunk */
+static char *_load_chunk(archive_load_t *load, archive_chunk_t *chunk)
+{
+	char *insert = NULL, *insert_pos = NULL, *tmp;
+	char **values = chunk->values;
+
+	xstrcatat(insert, &insert_pos, load->insert);
+	for (int i = 0; i < chunk->row_cnt; i++) {
+		xstrcatat(insert, &insert_pos, i ? ", (" : "(");
+		for (int j = 0; j < load->af->col_cnt; j++, values++) {
+			if (j)
+				xstrcatat(insert, &insert_pos, ", ");
+			if (!*values) {
+				xstrcatat(insert, &insert_pos, "NULL");
+				continue;
+			}
+			tmp = slurm_add_slash_to_quotes(*values);
+			xstrfmtcatat(insert, &insert_pos, "'%s'", tmp);
+			xfree(tmp);
+		}
+		xstrcatat(insert, &insert_pos, ")");
+	}
+	if (load->on_dup)
+		xstrcatat(insert, &insert_pos, load->on_dup);
+
+	return insert;
+}
+
+static void *_load_chunk_thread(void *arg)
+{
+	archive_load_t *load = arg;
+	archive_chunk_t *chunk;
+	char *query;
+	int rc;
+
+	slurm_mutex_lock(&load->lock);
+	while (!load->done) {
+		if (load->queued >= ARCHIVE_LOAD_QUEUED) {
+			slurm_cond_wait(&load->cond, &load->lock);
+			continue;
+		}
+
+		/* Chunks are read in turn but decoded in parallel */
+		if ((rc = archive_file_read_chunk(load->af, &chunk)) ||
+		    !chunk) {
+			load->rc = rc;
+			load->done = true;
+			break;
+		}
+		load->queued++;
+		slurm_mutex_unlock(&load->lock);
+
+		query = NULL;
+		if (!archive_chunk_unpack(load->af, chunk))
+			query = _load_chunk(load, chunk);
+		archive_chunk_free(chunk);
+
+		slurm_mutex_lock(&load->lock);
+		if (query) {
+			list_enqueue(load->queries, query);
+		} else {
+			load->queued--;
+			load->rc = SLURM_ERROR;
+			load->done = true;
+		}
+		slurm_cond_broadcast(&load->cond);
+	}
+	load->workers--;
+	slurm_cond_broadcast(&load->cond);
+	slurm_mutex_unlock(&load->lock);
+
+	return NULL;
+}
+
+/*
+ * The header of an archive file names the table and columns to insert into.
+ * Only accept the table and columns the archive of its record type is written
+ * with, for a cluster known to this database.
+ */
+static int _check_archive_file(archive_file_t *af)
+{
+	purge_type_t purge_type;
+	char **tables, **inx;
+	char *usage_tables[] = { assoc_hour_table, assoc_day_table,
+				 assoc_month_table, NULL };
+	char *wckey_tables[] = { wckey_hour_table, wckey_day_table,
+				 wckey_month_table, NULL };
+	char *cluster_tables[] = { cluster_hour_table, cluster_day_table,
+				   cluster_month_table, NULL };
+	char *event_tables[] = { event_table, NULL };
+	char *suspend_tables[] = { suspend_table, NULL };
+	char *resv_tables[] = { resv_table, NULL };
+	char *job_tables[] = { job_table, NULL };
+	char *job_env_tables[] = { job_env_table, NULL };
+	char *job_script_tables[] = { job_script_table, NULL };
+	char *step_tables[] = { step_table, NULL };
+	char *txn_tables[] = { txn_table, NULL };
+	bool cluster_table = true, found = false;
+	int col_cnt = 0;
+
+	switch (af->type) {
+	case DBD_GOT_EVENTS:
+		purge_type = PURGE_EVENT;
+		tables = event_tables;
+		break;
+	case DBD_JOB_SUSPEND:
+		purge_type = PURGE_SUSPEND;
+		tables = suspend_tables;
+		break;
+	case DBD_GOT_RESVS:
+		purge_type = PURGE_RESV;
+		tables = resv_tables;
+		break;
+	case DBD_GOT_JOBS:
+		purge_type = PURGE_JOB;
+		tables = job_tables;
+		break;
+	case DBD_GOT_JOB_ENV:
+		purge_type = PURGE_JOB_ENV;
+		tables = job_env_tables;
+		break;
+	case DBD_GOT_JOB_SCRIPT:
+		purge_type = PURGE_JOB_SCRIPT;
+		tables = job_script_tables;
+		break;
+	case DBD_STEP_START:
+		purge_type = PURGE_STEP;
+		tables = step_tables;
+		break;
+	case DBD_GOT_TXN:
+		purge_type = PURGE_TXN;
+		tables = txn_tables;
+		cluster_table = false;
+		break;
+	case DBD_GOT_ASSOC_USAGE:
+		purge_type = PURGE_USAGE;
+		tables = usage_tables;
+		break;
+	case DBD_GOT_WCKEY_USAGE:
+		purge_type = PURGE_USAGE;
+		tables = wckey_tables;
+		break;
+	case DBD_GOT_CLUSTER_USAGE:
+		purge_type = PURGE_CLUSTER_USAGE;
+		tables = cluster_tables;
+		break;
+	default:
+		error("Unknown type '%u' to load from archive", af->type);
+		return SLURM_ERROR;
+	}
+
+	if (cluster_table != !!(af->flags & ARCHIVE_FILE_CLUSTER_TABLE)) {
+		error("Archive of type '%s' has the wrong table flags",
+		      slurmdbd_msg_type_2_str(af->type, 0));
+		return SLURM_ERROR;
+	}
+
+	for (int i = 0; tables[i]; i++) {
+		if (!xstrcmp(af->table, tables[i])) {
+			found = true;
+			break;
+		}
+	}
+	if (!found) {
+		error("Archive of type '%s' can't be loaded into table '%s'",
+		      slurmdbd_msg_type_2_str(af->type, 0), af->table);
+		return SLURM_ERROR;
+	}
+
+	inx = _get_archive_inx(purge_type, &col_cnt);
+	for (int i = 0; i < af->col_cnt; i++) {
+		found = false;
+		for (int j = 0; j < col_cnt; j++) {
+			if (!xstrcmp(af->columns[i], inx[j])) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			error("Archive column '%s' is not a column of table '%s'",
+			      af->columns[i], af->table);
+			return SLURM_ERROR;
+		}
+	}
+
+	/* The cluster name is part of the table name */
+	if (cluster_table) {
+		slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
+		found = list_find_first(as_mysql_cluster_list,
+					slurm_find_char_exact_in_list,
+					af->cluster_name);
+		slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
+		if (!found) {
+			error("Archive is for unknown cluster '%s'",
+			      af->cluster_name);
+			return SLURM_ERROR;
+		}
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Load a columnar archive file. Worker threads decompress the chunks and
+ * build the inserts while the statements are all run here, on the one
+ * connection, so the load stays a single transaction.
+ */
+static int _process_archive_file(char *path, mysql_conn_t *mysql_conn)
+{
+	archive_load_t load = {
+		.cond = PTHREAD_COND_INITIALIZER,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+	};
+	pthread_t threads[ARCHIVE_LOAD_THREADS];
+	char *query;
+	int rc;
+	uint64_t loaded = 0;
+
+	if ((rc = archive_file_open(path, &load.af)))
+		return rc;
+
+	DB_DEBUG(DB_ARCHIVE, mysql_conn->conn,
+		 "Version in archive header is %u", load.af->rpc_version);
+
+	if ((rc = _check_archive_file(load.af))) {
+		archive_file_free(load.af);
+		return rc;
+	}
+
+	if (load.af->flags & ARCHIVE_FILE_CLUSTER_TABLE)
+		xstrfmtcat(load.insert, "insert into \"%s_%s\" (",
+			   load.af->cluster_name, load.af->table);
+	else
+		xstrfmtcat(load.insert, "insert into \"%s\" (", load.af->table);
+	for (int i = 0; i < load.af->col_cnt; i++)
+		xstrfmtcat(load.insert, "%s%s", i ? ", " : "",
+			   load.af->columns[i]);
+	xstrcat(load.insert, ") values ");
+
+	/* env and script records are shared, keep the existing ones */
+	if ((load.af->type == DBD_GOT_JOB_ENV) ||
+	    (load.af->type == DBD_GOT_JOB_SCRIPT))
+		load.on_dup = xstrdup(
+			" on duplicate key update hash_inx=hash_inx;");
+
+	load.queries = list_create(xfree_ptr);
+	load.workers = ARCHIVE_LOAD_THREADS;
+	for (int i = 0; i < ARCHIVE_LOAD_THREADS; i++)
+		slurm_thread_create(&threads[i], _load_chunk_thread, &load);
+
+	slurm_mutex_lock(&load.lock);
+	while (true) {
+		/* Once something failed only wait for the threads to end */
+		if (!load.rc && (query = list_dequeue(load.queries))) {
+			slurm_mutex_unlock(&load.lock);
+			rc = _load_data(&query, mysql_conn);
+			slurm_mutex_lock(&load.lock);
+
+			load.queued--;
+			if (rc) {
+				load.rc = rc;
+				load.done = true;
+			}
+			slurm_cond_broadcast(&load.cond);
+			continue;
+		}
+
+		if (!load.workers)
+			break;
+		slurm_cond_wait(&load.cond, &load.lock);
+	}
+	rc = load.rc;
+	slurm_mutex_unlock(&load.lock);
+
+	for (int i = 0; i < ARCHIVE_LOAD_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	loaded = load.af->total_rows;
+	if (!rc && !loaded) {
+		error("we didn't get any records from this file of type '%s'",
+		      slurmdbd_msg_type_2_str(load.af->type, 0));
+		rc = SLURM_ERROR;
+	} else if (!rc) {
+		DB_DEBUG(DB_ARCHIVE, mysql_conn->conn,
+			 "%s: loaded %"PRIu64" records into %s",
+			 __func__, loaded, load.af->table);
+	}
+
+	FREE_NULL_LIST(load.queries);
+	archive_file_free(load.af);
+	xfree(load.insert);
+	xfree(load.on_dup);
+	slurm_cond_destroy(&load.cond);
+	slurm_mutex_destroy(&load.lock);
+
+	return rc;
+}
+
 extern int as_mysql_jobacct_process_archive_load(
 	mysql_conn_t *mysql_conn, slurmdb_archive_rec_t *arch_rec)
 {
@@ -5603,6 +5301,11 @@ extern int as_mysql_jobacct_process_archive_load(
 
 	if (arch_rec->insert) {
 		data = xstrdup(arch_rec->insert);
+	} else if (arch_rec->archive_file &&
+		   archive_file_is_columnar(arch_rec->archive_file)) {
+		error_code = _process_archive_file(arch_rec->archive_file,
+						   mysql_conn);
+		goto end_it;
 	} else if (arch_rec->archive_file) {
 		int data_allocated, data_read = 0;
 		int state_fd = open(arch_rec->archive_file, O_RDONLY);
@@ -5668,12 +5371,17 @@ extern int as_mysql_jobacct_process_archive_load(
 	}
 	data = NULL; /* Free'd by above functions. */
 
+end_it:
 	if (error_code)
 		error("%s: failure loading archive: %s", __func__,
 		      slurm_strerror(error_code));
-	else
+	else {
+		/* The archive may hold jobs of any cluster */
+		as_mysql_job_cache_mark(mysql_conn, NULL, 0);
+		mysql_conn->flags |= DB_CONN_FLAG_USAGE_CHANGED;
 		DB_DEBUG(DB_ARCHIVE, mysql_conn->conn,
 		         "%s: archive loaded successfully.", __func__);
+	}
 
 	return error_code;
 }
@@ -37,6 +37,7 @@
 \*****************************************************************************/
 
 #include "as_mysql_assoc.h"
+#include "as_mysql_job_cache.h"
 #include "as_mysql_usage.h"
 
 static char *tmp_cluster_name = "slurmredolftrgttemp";
@@ -595,6 +596,9 @@ static int _move_account(mysql_conn_t *mysql_conn, uint32_t *lft, uint32_t *rgt,
 		return SLURM_ERROR;
 	}
 	xfree(query);
+	/* The jobs and usage report the lft of their association */
+	as_mysql_job_cache_mark(mysql_conn, cluster, 0);
+	mysql_conn->flags |= DB_CONN_FLAG_USAGE_CHANGED;
 	if ((row = mysql_fetch_row(result))) {
 		debug4("lft and rgt were %u %u and now is %s %s",
 		       *lft, *rgt, row[0], row[1]);
@@ -2792,6 +2796,10 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 						mysql_conn,
 						up_query);
 					xfree(up_query);
+					as_mysql_job_cache_mark(mysql_conn,
+								old_cluster, 0);
+					mysql_conn->flags |=
+						DB_CONN_FLAG_USAGE_CHANGED;
 					if (rc != SLURM_SUCCESS) {
 						error("Couldn't do update");
 						xfree(cols);
@@ -3021,6 +3029,8 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 		xfree(up_query);
 		if (rc != SLURM_SUCCESS)
 			error("Couldn't do update 2");
+		as_mysql_job_cache_mark(mysql_conn, old_cluster, 0);
+		mysql_conn->flags |= DB_CONN_FLAG_USAGE_CHANGED;
 
 	}
 
@@ -39,6 +39,7 @@
 #include "as_mysql_tres.h"
 #include "as_mysql_assoc.h"
 #include "as_mysql_cluster.h"
+#include "as_mysql_job_cache.h"
 #include "as_mysql_federation.h"
 #include "as_mysql_usage.h"
 #include "as_mysql_wckey.h"
@@ -868,6 +869,8 @@ extern List as_mysql_remove_clusters(mysql_conn_t *mysql_conn, uint32_t uid,
 			if ((rc = remove_cluster_tables(mysql_conn, object))
 			    != SLURM_SUCCESS)
 				break;
+			as_mysql_job_cache_mark(mysql_conn, object, 0);
+			mysql_conn->flags |= DB_CONN_FLAG_USAGE_CHANGED;
 			cluster_name = xstrdup(object);
 			if (addto_update_list(mysql_conn->update_list,
 					      SLURMDB_REMOVE_CLUSTER,
@@ -1409,6 +1412,29 @@ empty:
 	return ret_list;
 }
 
+/* End the open event of a node, the statement is kept prepared */
+static int _close_node_event(mysql_conn_t *mysql_conn, node_record_t *node_ptr,
+			     time_t event_time)
+{
+	int rc;
+	char *query;
+	db_param_t params[] = {
+		DB_PARAM_I(event_time),
+		DB_PARAM_ESC(node_ptr->name),
+	};
+
+	query = xstrdup_printf(
+		"update \"%s_%s\" set time_end=? where "
+		"time_end=0 and node_name=?",
+		mysql_conn->cluster_name, event_table);
+	DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
+	rc = mysql_db_stmt_query(mysql_conn, "node_event_end", query, params,
+				 ARRAY_SIZE(params));
+	xfree(query);
+
+	return rc;
+}
+
 extern int as_mysql_node_down(mysql_conn_t *mysql_conn,
 			      node_record_t *node_ptr,
 			      time_t event_time, char *reason,
@@ -1499,11 +1525,9 @@ extern int as_mysql_node_down(mysql_conn_t *mysql_conn,
 	         "inserting %s(%s) with tres of '%s'",
 		 node_ptr->name, mysql_conn->cluster_name, node_ptr->tres_str);
 
-	query = xstrdup_printf(
-		"update \"%s_%s\" set time_end=%ld where "
-		"time_end=0 and node_name='%s';",
-		mysql_conn->cluster_name, event_table,
-		event_time, node_ptr->name);
+	if ((rc = _close_node_event(mysql_conn, node_ptr, event_time)) !=
+	    SLURM_SUCCESS)
+		return rc;
 
 	/*
 	 * Reason for "on duplicate": slurmctld will send a time_start based on
@@ -1512,17 +1536,25 @@ extern int as_mysql_node_down(mysql_conn_t *mysql_conn,
 	 * same time_start for the node and cause a "Duplicate entry" error.
 	 * This can particually happen when doing clean starts.
 	 */
-	xstrfmtcat(query,
-		   "insert into \"%s_%s\" "
-		   "(node_name, state, tres, time_start, "
-		   "reason, reason_uid) "
-		   "values ('%s', %u, '%s', %ld, '%s', %u) "
-		   "on duplicate key update time_end=0;",
-		   mysql_conn->cluster_name, event_table,
-		   node_ptr->name, node_ptr->node_state,
-		   node_ptr->tres_str, event_time, my_reason, reason_uid);
+	db_param_t params[] = {
+		DB_PARAM_ESC(node_ptr->name),
+		DB_PARAM_U(node_ptr->node_state),
+		DB_PARAM_ESC(node_ptr->tres_str),
+		DB_PARAM_I(event_time),
+		DB_PARAM_ESC(my_reason),
+		DB_PARAM_U(reason_uid),
+	};
+
+	query = xstrdup_printf(
+		"insert into \"%s_%s\" "
+		"(node_name, state, tres, time_start, "
+		"reason, reason_uid) "
+		"values (?, ?, ?, ?, ?, ?) "
+		"on duplicate key update time_end=0",
+		mysql_conn->cluster_name, event_table);
 	DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_stmt_query(mysql_conn, "node_event_start", query, params,
+				 ARRAY_SIZE(params));
 	xfree(query);
 
 	return rc;
@@ -1532,9 +1564,6 @@ extern int as_mysql_node_up(mysql_conn_t *mysql_conn,
 			    node_record_t *node_ptr,
 			    time_t event_time)
 {
-	char* query;
-	int rc = SLURM_SUCCESS;
-
 	if (check_connection(mysql_conn) != SLURM_SUCCESS)
 		return ESLURM_DB_CONNECTION;
 
@@ -1543,15 +1572,7 @@ extern int as_mysql_node_up(mysql_conn_t *mysql_conn,
 		return SLURM_ERROR;
 	}
 
-	query = xstrdup_printf(
-		"update \"%s_%s\" set time_end=%ld where "
-		"time_end=0 and node_name='%s';",
-		mysql_conn->cluster_name, event_table,
-		event_time, node_ptr->name);
-	DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
-	xfree(query);
-	return rc;
+	return _close_node_event(mysql_conn, node_ptr, event_time);
 }
 
 /* This function is not used in the slurmdbd. */
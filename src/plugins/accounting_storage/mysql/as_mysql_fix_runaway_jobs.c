@@ -35,6 +35,7 @@
 \*****************************************************************************/
 
 #include "as_mysql_fix_runaway_jobs.h"
+#include "as_mysql_job_cache.h"
 #include "src/common/list.h"
 #include "src/common/slurmdb_defs.h"
 
@@ -187,6 +188,8 @@ extern int as_mysql_fix_runaway_jobs(mysql_conn_t *mysql_conn, uint32_t uid,
 		goto bail;
 	}
 
+	as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name, 0);
+
 	/* Set rollup to the last day of the previous month of the first
 	 * runaway job */
 	rc = _first_job_roll_up(mysql_conn, first_job->submit);
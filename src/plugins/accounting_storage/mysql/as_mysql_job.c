@@ -37,6 +37,7 @@
 \*****************************************************************************/
 
 #include "as_mysql_job.h"
+#include "as_mysql_job_cache.h"
 #include "as_mysql_jobacct_process.h"
 #include "as_mysql_usage.h"
 #include "as_mysql_wckey.h"
@@ -220,6 +221,7 @@ static uint32_t _get_wckeyid(mysql_conn_t *mysql_conn, char **name,
 					    NULL, false) != SLURM_SUCCESS) {
 			List wckey_list = NULL;
 			slurmdb_wckey_rec_t *wckey_ptr = NULL;
+			mysql_conn_t *shared_conn;
 			/* we have already checked to make
 			   sure this was the slurm user before
 			   calling this */
@@ -258,11 +260,13 @@ static uint32_t _get_wckeyid(mysql_conn_t *mysql_conn, char **name,
 				wckey_rec.name = (*name);
 			}
 
-			if (as_mysql_add_wckeys(mysql_conn,
+			shared_conn = get_shared_conn(mysql_conn);
+			if (as_mysql_add_wckeys(shared_conn,
 			                        slurm_conf.slurm_user_id,
 			                        wckey_list)
 			    == SLURM_SUCCESS)
-				acct_storage_p_commit(mysql_conn, 1);
+				acct_storage_p_commit(shared_conn, 1);
+			release_shared_conn(mysql_conn, shared_conn, false);
 			/* If that worked lets get it */
 			assoc_mgr_fill_in_wckey(mysql_conn, &wckey_rec,
 						ACCOUNTING_ENFORCE_WCKEYS,
@@ -286,6 +290,7 @@ static uint64_t _get_hash_inx(mysql_conn_t *mysql_conn,
 	char *query, *hash;
 	char *hash_col = NULL, *type_table = NULL;
 	MYSQL_RES *result = NULL;
+	mysql_conn_t *shared_conn;
 	uint64_t hash_inx = 0;
 
 	switch (flag) {
@@ -315,7 +320,10 @@ static uint64_t _get_hash_inx(mysql_conn_t *mysql_conn,
 		mysql_conn->cluster_name, type_table,
 		hash_col, hash);
 
-	hash_inx = mysql_db_insert_ret_id(mysql_conn, query);
+	shared_conn = get_shared_conn(mysql_conn);
+	hash_inx = mysql_db_insert_ret_id(shared_conn, query);
+	if (release_shared_conn(mysql_conn, shared_conn, hash_inx))
+		hash_inx = 0;
 	if (!hash_inx)
 		hash_inx = NO_VAL64;
 	else
@@ -330,6 +338,104 @@ static uint64_t _get_hash_inx(mysql_conn_t *mysql_conn,
 
 /* extern functions */
 
+/*
+ * Step records sent in a DBD_SEND_MULT_MSG are queued on the connection and
+ * written in as few statements as possible when the batch is flushed.
+ * Batching only happens in the slurmdbd on connections that are committed
+ * explicitly, since the commit is what flushes the batch.
+ */
+static bool _batch_enabled(mysql_conn_t *mysql_conn)
+{
+	return (slurmdbd_conf && (slurmdbd_conf->max_batch_records > 1) &&
+		(mysql_conn->flags & DB_CONN_FLAG_ROLLBACK));
+}
+
+static char *_step_start_query(mysql_conn_t *mysql_conn, char *rows)
+{
+	return xstrdup_printf(
+		"insert into \"%s_%s\" (job_db_inx, id_step, step_het_comp, "
+		"time_start, step_name, state, tres_alloc, "
+		"nodes_alloc, task_cnt, nodelist, node_inx, "
+		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov, "
+		"submit_line, container) values %s "
+		"on duplicate key update "
+		"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+		"time_end=0, state=VALUES(state), nodelist=VALUES(nodelist), "
+		"node_inx=VALUES(node_inx), task_dist=VALUES(task_dist), "
+		"req_cpufreq=VALUES(req_cpufreq), "
+		"req_cpufreq_min=VALUES(req_cpufreq_min), "
+		"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+		"tres_alloc=VALUES(tres_alloc), "
+		"submit_line=IFNULL(VALUES(submit_line), submit_line), "
+		"container=IFNULL(VALUES(container), container)",
+		mysql_conn->cluster_name, step_table, rows);
+}
+
+/* Turn the pending step rows into a statement at the end of the batch */
+static void _batch_close_rows(mysql_conn_t *mysql_conn)
+{
+	char *query;
+
+	if (!mysql_conn->batch_rows)
+		return;
+
+	query = _step_start_query(mysql_conn, mysql_conn->batch_rows);
+	xstrfmtcat(mysql_conn->batch_query, "%s;", query);
+	xfree(query);
+	xfree(mysql_conn->batch_rows);
+}
+
+/*
+ * Queue a step_table row (row != NULL) or complete statements (query != NULL)
+ * and flush once the batch holds MaxBatchRecords records.
+ */
+static int _batch_add(mysql_conn_t *mysql_conn, char *row, char *query)
+{
+	if (row) {
+		xstrfmtcat(mysql_conn->batch_rows, "%s%s",
+			   mysql_conn->batch_rows ? ", " : "", row);
+	} else {
+		_batch_close_rows(mysql_conn);
+		xstrcat(mysql_conn->batch_query, query);
+	}
+
+	if (++mysql_conn->batch_cnt >= slurmdbd_conf->max_batch_records)
+		return as_mysql_batch_flush(mysql_conn);
+
+	return SLURM_SUCCESS;
+}
+
+extern int as_mysql_batch_flush(mysql_conn_t *mysql_conn)
+{
+	int rc;
+
+	_batch_close_rows(mysql_conn);
+	if (!mysql_conn->batch_query)
+		return SLURM_SUCCESS;
+
+	DB_DEBUG(DB_STEP, mysql_conn->conn, "query (%u records)\n%s",
+		 mysql_conn->batch_cnt, mysql_conn->batch_query);
+	rc = mysql_db_query_check_after(mysql_conn, mysql_conn->batch_query);
+	if (rc != SLURM_SUCCESS)
+		error("%s: writing %u batched records failed",
+		      __func__, mysql_conn->batch_cnt);
+
+	xfree(mysql_conn->batch_query);
+	mysql_conn->batch_cnt = 0;
+
+	return rc;
+}
+
+extern void as_mysql_batch_discard(mysql_conn_t *mysql_conn)
+{
+	if (mysql_conn->batch_cnt)
+		debug("%s: discarding %u batched records",
+		      __func__, mysql_conn->batch_cnt);
+	xfree(mysql_conn->batch_query);
+	xfree(mysql_conn->batch_rows);
+	mysql_conn->batch_cnt = 0;
+}
+
 extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 {
 	int rc = SLURM_SUCCESS;
@@ -401,7 +507,9 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 
 	slurm_mutex_lock(&rollup_lock);
 	if (check_time < global_last_rollup) {
+		mysql_conn_t *shared_conn;
 		MYSQL_ROW row;
+		int commit_rc;
 
 		/* check to see if we are hearing about this time for the
 		 * first time.
@@ -465,7 +573,12 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 				       last_ran_table, check_time,
 				       check_time, check_time);
 		DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
-		rc = mysql_db_query(mysql_conn, query);
+		shared_conn = get_shared_conn(mysql_conn);
+		rc = mysql_db_query(shared_conn, query);
+		if ((commit_rc = release_shared_conn(mysql_conn, shared_conn,
+						     (rc == SLURM_SUCCESS))) &&
+		    (rc == SLURM_SUCCESS))
+			rc = commit_rc;
 		xfree(query);
 	} else
 		slurm_mutex_unlock(&rollup_lock);
@@ -802,6 +915,9 @@ no_rollup_change:
 	if (rc != SLURM_SUCCESS)
 		return rc;
 
+	as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+				job_ptr->db_index);
+
 	/* now we will reset all the steps */
 	if (IS_JOB_RESIZING(job_ptr)) {
 		/* FIXME : Verify this is still needed */
@@ -992,6 +1108,9 @@ extern List as_mysql_modify_job(mysql_conn_t *mysql_conn, uint32_t uid,
 
 		if (rc != SLURM_SUCCESS)
 			break;
+
+		as_mysql_job_cache_mark(mysql_conn, job_rec->cluster,
+					job_rec->db_index);
 	}
 	list_iterator_destroy(itr);
 
@@ -1194,39 +1313,6 @@ extern int as_mysql_job_complete(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/*
-	 * make sure we handle any quotes that may be in the comment
-	 */
-
-	query = xstrdup_printf("update \"%s_%s\" set "
-			       "mod_time=UNIX_TIMESTAMP(), "
-			       "time_end=%ld, state=%d",
-			       mysql_conn->cluster_name, job_table,
-			       end_time, job_state);
-
-	if (job_ptr->derived_ec != NO_VAL)
-		xstrfmtcat(query, ", derived_ec=%u", job_ptr->derived_ec);
-
-	if (job_ptr->tres_alloc_str)
-		xstrfmtcat(query, ", tres_alloc='%s'", job_ptr->tres_alloc_str);
-
-	if (job_ptr->comment)
-		xstrfmtcat(query, ", derived_es='%s'", job_ptr->comment);
-
-	if (job_ptr->admin_comment)
-		xstrfmtcat(query, ", admin_comment='%s'",
-			   job_ptr->admin_comment);
-
-	if (job_ptr->system_comment)
-		xstrfmtcat(query, ", system_comment='%s'",
-			   job_ptr->system_comment);
-
-	if (job_ptr->extra)
-		xstrfmtcat(query, ", extra='%s'", job_ptr->extra);
-
-	if (job_ptr->failed_node)
-		xstrfmtcat(query, ", failed_node='%s'", job_ptr->failed_node);
-
 	exit_code = job_ptr->exit_code;
 	if (exit_code == 1) {
 		/* This wasn't signaled, it was set by Slurm so don't
@@ -1234,19 +1320,51 @@ extern int as_mysql_job_complete(mysql_conn_t *mysql_conn,
 		 */
 		exit_code = 256;
 	}
-	xstrfmtcat(query, ", exit_code=%d, ", exit_code);
 
-	if (job_ptr->requid == (uid_t) -1)
-		xstrfmtcat(query, "kill_requid=null ");
-	else
-		xstrfmtcat(query, "kill_requid=%u ", job_ptr->requid);
+	/*
+	 * Every job completion has the same statement so it can stay
+	 * prepared, optional values left unset are bound as NULL.
+	 */
+	db_param_t params[] = {
+		DB_PARAM_I(end_time),
+		DB_PARAM_I(job_state),
+		(job_ptr->derived_ec != NO_VAL) ?
+			DB_PARAM_U(job_ptr->derived_ec) : DB_PARAM_NULL_VAL,
+		DB_PARAM_ESC(job_ptr->tres_alloc_str),
+		DB_PARAM_ESC(job_ptr->comment),
+		DB_PARAM_ESC(job_ptr->admin_comment),
+		DB_PARAM_ESC(job_ptr->system_comment),
+		DB_PARAM_ESC(job_ptr->extra),
+		DB_PARAM_ESC(job_ptr->failed_node),
+		DB_PARAM_I(exit_code),
+		(job_ptr->requid == (uid_t) -1) ?
+			DB_PARAM_NULL_VAL : DB_PARAM_U(job_ptr->requid),
+		DB_PARAM_U(job_ptr->db_index),
+	};
 
-	xstrfmtcat(query, "where job_db_inx=%"PRIu64";", job_ptr->db_index);
+	query = xstrdup_printf("update \"%s_%s\" set "
+			       "mod_time=UNIX_TIMESTAMP(), "
+			       "time_end=?, state=?, "
+			       "derived_ec=IFNULL(?, derived_ec), "
+			       "tres_alloc=IFNULL(?, tres_alloc), "
+			       "derived_es=IFNULL(?, derived_es), "
+			       "admin_comment=IFNULL(?, admin_comment), "
+			       "system_comment=IFNULL(?, system_comment), "
+			       "extra=IFNULL(?, extra), "
+			       "failed_node=IFNULL(?, failed_node), "
+			       "exit_code=?, kill_requid=? "
+			       "where job_db_inx=?;",
+			       mysql_conn->cluster_name, job_table);
 
 	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_stmt_query(mysql_conn, "job_complete", query, params,
+				 ARRAY_SIZE(params));
 	xfree(query);
 
+	if (rc == SLURM_SUCCESS)
+		as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+					job_ptr->db_index);
+
 	return rc;
 }
 
@@ -1259,7 +1377,7 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char *node_list = NULL;
 	char *node_inx = NULL;
 	time_t start_time, submit_time;
-	char *query = NULL;
+	char *query = NULL, *row = NULL;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1358,57 +1476,64 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* we want to print a -1 for the requid so leave it a
-	   %d */
-	/* The stepid could be negative so use %d not %u */
-	query = xstrdup_printf(
-		"insert into \"%s_%s\" (job_db_inx, id_step, step_het_comp, "
-		"time_start, step_name, state, tres_alloc, "
-		"nodes_alloc, task_cnt, nodelist, node_inx, "
-		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov",
-		mysql_conn->cluster_name, step_table);
-
-	if (step_ptr->submit_line)
-		xstrcat(query, ", submit_line");
-	if (step_ptr->container)
-		xstrcat(query, ", container");
+	as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+				step_ptr->job_ptr->db_index);
+
+	if (_batch_enabled(mysql_conn)) {
+		/* The stepid could be negative so use %d not %u */
+		row = xstrdup_printf(
+			"(%"PRIu64", %d, %u, %d, '%s', %d, '%s', %d, %d, "
+			"'%s', '%s', %d, %u, %u, %u",
+			step_ptr->job_ptr->db_index,
+			step_ptr->step_id.step_id,
+			step_ptr->step_id.step_het_comp,
+			(int)start_time, step_ptr->name,
+			JOB_RUNNING, step_ptr->tres_alloc_str,
+			nodes, tasks, node_list, node_inx, task_dist,
+			step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
+			step_ptr->cpu_freq_gov);
+
+		if (step_ptr->submit_line)
+			xstrfmtcat(row, ", '%s'", step_ptr->submit_line);
+		else
+			xstrcat(row, ", NULL");
+		if (step_ptr->container)
+			xstrfmtcat(row, ", '%s')", step_ptr->container);
+		else
+			xstrcat(row, ", NULL)");
 
-	xstrfmtcat(query,
-		   ") values (%"PRIu64", %d, %u, %d, '%s', %d, '%s', %d, %d, "
-		   "'%s', '%s', %d, %u, %u, %u",
-		   step_ptr->job_ptr->db_index,
-		   step_ptr->step_id.step_id,
-		   step_ptr->step_id.step_het_comp,
-		   (int)start_time, step_ptr->name,
-		   JOB_RUNNING, step_ptr->tres_alloc_str,
-		   nodes, tasks, node_list, node_inx, task_dist,
-		   step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
-		   step_ptr->cpu_freq_gov);
-
-	if (step_ptr->submit_line)
-		xstrfmtcat(query, ", '%s'", step_ptr->submit_line);
-	if (step_ptr->container)
-		xstrfmtcat(query, ", '%s'", step_ptr->container);
+		rc = _batch_add(mysql_conn, row, NULL);
+		xfree(row);
+		return rc;
+	}
 
-	xstrfmtcat(query,
-		   ") on duplicate key update "
-		   "nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		   "nodelist='%s', node_inx='%s', task_dist=%d, "
-		   "req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		   "tres_alloc='%s'",
-		   nodes, tasks, JOB_RUNNING,
-		   node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		   step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		   step_ptr->tres_alloc_str);
-
-	if (step_ptr->submit_line)
-		xstrfmtcat(query, ", submit_line='%s'", step_ptr->submit_line);
-
-	if (step_ptr->container)
-		xstrfmtcat(query, ", container='%s'", step_ptr->container);
+	db_param_t params[] = {
+		DB_PARAM_U(step_ptr->job_ptr->db_index),
+		DB_PARAM_I(step_ptr->step_id.step_id),
+		DB_PARAM_U(step_ptr->step_id.step_het_comp),
+		DB_PARAM_I(start_time),
+		DB_PARAM_ESC(step_ptr->name ? step_ptr->name : ""),
+		DB_PARAM_I(JOB_RUNNING),
+		DB_PARAM_ESC(step_ptr->tres_alloc_str ?
+			     step_ptr->tres_alloc_str : ""),
+		DB_PARAM_I(nodes),
+		DB_PARAM_I(tasks),
+		DB_PARAM_ESC(node_list ? node_list : ""),
+		DB_PARAM_ESC(node_inx),
+		DB_PARAM_I(task_dist),
+		DB_PARAM_U(step_ptr->cpu_freq_max),
+		DB_PARAM_U(step_ptr->cpu_freq_min),
+		DB_PARAM_U(step_ptr->cpu_freq_gov),
+		DB_PARAM_ESC(step_ptr->submit_line),
+		DB_PARAM_ESC(step_ptr->container),
+	};
+
+	query = _step_start_query(mysql_conn, "(?, ?, ?, ?, ?, ?, ?, ?, ?, "
+				  "?, ?, ?, ?, ?, ?, ?, ?)");
 
 	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_stmt_query(mysql_conn, "step_start", query, params,
+				 ARRAY_SIZE(params));
 	xfree(query);
 
 	return rc;
@@ -1425,6 +1550,9 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 	int rc = SLURM_SUCCESS;
 	uint32_t exit_code = 0;
 	time_t submit_time;
+	slurmdb_stats_t stats = { 0 };
+	db_param_t params[32];
+	uint32_t param_cnt = 0;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1508,24 +1636,21 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* The stepid could be negative so use %d not %u */
-	query = xstrdup_printf(
-		"update \"%s_%s\" set time_end=%d, state=%u, exit_code=%d, ",
-		mysql_conn->cluster_name, step_table, (int)now,
-		comp_status,
-		exit_code);
+	as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+				step_ptr->job_ptr->db_index);
 
-	if (step_ptr->requid == (uid_t) -1)
-		xstrfmtcat(query, "kill_requid=null");
-	else
-		xstrfmtcat(query, "kill_requid=%u", step_ptr->requid);
+	params[param_cnt++] = DB_PARAM_I(now);
+	params[param_cnt++] = DB_PARAM_U(comp_status);
+	params[param_cnt++] = DB_PARAM_I(exit_code);
+	params[param_cnt++] = (step_ptr->requid == (uid_t) -1) ?
+		DB_PARAM_NULL_VAL : DB_PARAM_U(step_ptr->requid);
 
+	query = xstrdup_printf(
+		"update \"%s_%s\" set time_end=?, state=?, exit_code=?, "
+		"kill_requid=?",
+		mysql_conn->cluster_name, step_table);
 
 	if (jobacct) {
-		slurmdb_stats_t stats;
-
-		memset(&stats, 0, sizeof(slurmdb_stats_t));
-
 		/* figure out the ave of the totals sent */
 		if (tasks > 0) {
 			stats.tres_usage_in_ave =
@@ -1602,80 +1727,102 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 			jobacct->tres_usage_out_tot,
 			jobacct->tres_count, 1);
 
-		xstrfmtcat(query,
-			   ", user_sec=%"PRIu64", user_usec=%u, "
-			   "sys_sec=%"PRIu64", sys_usec=%u, "
-			   "act_cpufreq=%u, consumed_energy=%"PRIu64", "
-			   "tres_usage_in_ave='%s', "
-			   "tres_usage_out_ave='%s', "
-			   "tres_usage_in_max='%s', "
-			   "tres_usage_in_max_taskid='%s', "
-			   "tres_usage_in_max_nodeid='%s', "
-			   "tres_usage_in_min='%s', "
-			   "tres_usage_in_min_taskid='%s', "
-			   "tres_usage_in_min_nodeid='%s', "
-			   "tres_usage_in_tot='%s', "
-			   "tres_usage_out_max='%s', "
-			   "tres_usage_out_max_taskid='%s', "
-			   "tres_usage_out_max_nodeid='%s', "
-			   "tres_usage_out_min='%s', "
-			   "tres_usage_out_min_taskid='%s', "
-			   "tres_usage_out_min_nodeid='%s', "
-			   "tres_usage_out_tot='%s'",
-			   /* user seconds */
-			   jobacct->user_cpu_sec,
-			   /* user microseconds */
-			   jobacct->user_cpu_usec,
-			   /* system seconds */
-			   jobacct->sys_cpu_sec,
-			   /* system microsecs */
-			   jobacct->sys_cpu_usec,
-			   jobacct->act_cpufreq,
-			   jobacct->energy.consumed_energy,
-			   stats.tres_usage_in_ave,
-			   stats.tres_usage_out_ave,
-			   stats.tres_usage_in_max,
-			   stats.tres_usage_in_max_taskid,
-			   stats.tres_usage_in_max_nodeid,
-			   stats.tres_usage_in_min,
-			   stats.tres_usage_in_min_taskid,
-			   stats.tres_usage_in_min_nodeid,
-			   stats.tres_usage_in_tot,
-			   stats.tres_usage_out_max,
-			   stats.tres_usage_out_max_taskid,
-			   stats.tres_usage_out_max_nodeid,
-			   stats.tres_usage_out_min,
-			   stats.tres_usage_out_min_taskid,
-			   stats.tres_usage_out_min_nodeid,
-			   stats.tres_usage_out_tot);
-
-		slurmdb_free_slurmdb_stats_members(&stats);
+		xstrcat(query,
+			", user_sec=?, user_usec=?, sys_sec=?, sys_usec=?, "
+			"act_cpufreq=?, consumed_energy=?, "
+			"tres_usage_in_ave=?, tres_usage_out_ave=?, "
+			"tres_usage_in_max=?, tres_usage_in_max_taskid=?, "
+			"tres_usage_in_max_nodeid=?, tres_usage_in_min=?, "
+			"tres_usage_in_min_taskid=?, "
+			"tres_usage_in_min_nodeid=?, tres_usage_in_tot=?, "
+			"tres_usage_out_max=?, tres_usage_out_max_taskid=?, "
+			"tres_usage_out_max_nodeid=?, tres_usage_out_min=?, "
+			"tres_usage_out_min_taskid=?, "
+			"tres_usage_out_min_nodeid=?, tres_usage_out_tot=?");
+		params[param_cnt++] = DB_PARAM_U(jobacct->user_cpu_sec);
+		params[param_cnt++] = DB_PARAM_U(jobacct->user_cpu_usec);
+		params[param_cnt++] = DB_PARAM_U(jobacct->sys_cpu_sec);
+		params[param_cnt++] = DB_PARAM_U(jobacct->sys_cpu_usec);
+		params[param_cnt++] = DB_PARAM_U(jobacct->act_cpufreq);
+		params[param_cnt++] =
+			DB_PARAM_U(jobacct->energy.consumed_energy);
+		/* Without tasks there are no averages, store what we always have */
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_ave ?
+						 stats.tres_usage_in_ave :
+						 "(null)");
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_out_ave ?
+						 stats.tres_usage_out_ave :
+						 "(null)");
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_max);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_max_taskid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_max_nodeid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_min);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_min_taskid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_min_nodeid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_in_tot);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_out_max);
+		params[param_cnt++] =
+			DB_PARAM_S(stats.tres_usage_out_max_taskid);
+		params[param_cnt++] =
+			DB_PARAM_S(stats.tres_usage_out_max_nodeid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_out_min);
+		params[param_cnt++] =
+			DB_PARAM_S(stats.tres_usage_out_min_taskid);
+		params[param_cnt++] =
+			DB_PARAM_S(stats.tres_usage_out_min_nodeid);
+		params[param_cnt++] = DB_PARAM_S(stats.tres_usage_out_tot);
+	}
+
+	xstrcat(query, " where job_db_inx=? and id_step=? and step_het_comp=?");
+	params[param_cnt++] = DB_PARAM_U(step_ptr->job_ptr->db_index);
+	/* id_step is signed to handle the batch and extern steps */
+	params[param_cnt++] = DB_PARAM_I(step_ptr->step_id.step_id);
+	params[param_cnt++] = DB_PARAM_U(step_ptr->step_id.step_het_comp);
+	xassert(param_cnt <= ARRAY_SIZE(params));
+
+	if (_batch_enabled(mysql_conn)) {
+		char *text = mysql_db_stmt_text(query, params, param_cnt);
+
+		xstrcat(text, ";");
+		/* set the energy for the entire job. */
+		if (step_ptr->job_ptr->tres_alloc_str)
+			xstrfmtcat(text,
+				   "update \"%s_%s\" set tres_alloc='%s' where "
+				   "job_db_inx=%"PRIu64";",
+				   mysql_conn->cluster_name, job_table,
+				   step_ptr->job_ptr->tres_alloc_str,
+				   step_ptr->job_ptr->db_index);
+		rc = _batch_add(mysql_conn, NULL, text);
+		xfree(text);
+		goto end_it;
 	}
 
-	/* id_step has to be %d here to handle the negative values for the batch
-	   and extern steps.  Don't change it to a %u.
-	*/
-	xstrfmtcat(query,
-		   " where job_db_inx=%"PRIu64" and id_step=%d and step_het_comp=%u",
-		   step_ptr->job_ptr->db_index, step_ptr->step_id.step_id,
-		   step_ptr->step_id.step_het_comp);
 	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	rc = mysql_db_stmt_query(mysql_conn, "step_complete", query, params,
+				 param_cnt);
 	xfree(query);
 
 	/* set the energy for the entire job. */
 	if (step_ptr->job_ptr->tres_alloc_str) {
+		db_param_t job_params[] = {
+			DB_PARAM_ESC(step_ptr->job_ptr->tres_alloc_str),
+			DB_PARAM_U(step_ptr->job_ptr->db_index),
+		};
+
 		query = xstrdup_printf(
-			"update \"%s_%s\" set tres_alloc='%s' where "
-			"job_db_inx=%"PRIu64,
-			mysql_conn->cluster_name, job_table,
-			step_ptr->job_ptr->tres_alloc_str,
-			step_ptr->job_ptr->db_index);
+			"update \"%s_%s\" set tres_alloc=? where "
+			"job_db_inx=?",
+			mysql_conn->cluster_name, job_table);
 		DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-		rc = mysql_db_query(mysql_conn, query);
-		xfree(query);
+		rc = mysql_db_stmt_query(mysql_conn, "step_complete_job_tres",
+					 query, job_params,
+					 ARRAY_SIZE(job_params));
 	}
 
+end_it:
+	xfree(query);
+	slurmdb_free_slurmdb_stats_members(&stats);
+
 	return rc;
 }
 
@@ -1690,6 +1837,10 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn, uint64_t old_db_inx,
 	if (check_connection(mysql_conn) != SLURM_SUCCESS)
 		return ESLURM_DB_CONNECTION;
 
+	/* The step records of the job must be written first */
+	if ((rc = as_mysql_batch_flush(mysql_conn)) != SLURM_SUCCESS)
+		return rc;
+
 	if (job_ptr->resize_time)
 		submit_time = job_ptr->resize_time;
 	else
@@ -1770,6 +1921,12 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn, uint64_t old_db_inx,
 		xfree(query);
 	}
 
+	as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+				job_ptr->db_index);
+	if (job_db_inx != job_ptr->db_index)
+		as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+					job_db_inx);
+
 	return rc;
 }
 
@@ -1789,6 +1946,9 @@ again:
 	if (check_connection(mysql_conn) != SLURM_SUCCESS)
 		return ESLURM_DB_CONNECTION;
 
+	if ((rc = as_mysql_batch_flush(mysql_conn)) != SLURM_SUCCESS)
+		return rc;
+
 	/* First we need to get the job_db_inx's and states so we can clean up
 	 * the suspend table and the step table
 	 */
@@ -1864,6 +2024,8 @@ again:
 
 		rc = mysql_db_query(mysql_conn, query);
 		xfree(query);
+		as_mysql_job_cache_mark(mysql_conn, mysql_conn->cluster_name,
+					0);
 	}
 
 	/* all rows were returned, there may be more to check */
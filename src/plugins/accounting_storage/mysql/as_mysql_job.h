@@ -58,6 +58,16 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 			          step_record_t *step_ptr);
 
+/*
+ * Write the step records queued on this connection by as_mysql_step_start()
+ * and as_mysql_step_complete() when MaxBatchRecords is more than 1.
+ * RET SLURM_SUCCESS or error
+ */
+extern int as_mysql_batch_flush(mysql_conn_t *mysql_conn);
+
+/* Drop the queued step records, used on rollback */
+extern void as_mysql_batch_discard(mysql_conn_t *mysql_conn);
+
 extern int as_mysql_suspend(mysql_conn_t *mysql_conn, uint64_t old_db_inx,
 			    job_record_t *job_ptr);
 
@@ -0,0 +1,694 @@
+/*****************************************************************************\
+ *  as_mysql_job_cache.c - in memory cache of recent job records
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "as_mysql_job_cache.h"
+#include "as_mysql_jobacct_process.h"
+
+/* Most jobs of one cluster kept, past that the cluster isn't cached */
+#define MAX_CACHE_JOBS 500000
+/* Most job records marked before reading the whole cluster again instead */
+#define MAX_CACHE_DIRTY 10000
+/* How often jobs that ended before the window are dropped */
+#define CACHE_EVICT_SEC 60
+/* How long to wait after failing to cache a cluster */
+#define CACHE_RETRY_SEC 600
+
+typedef struct {
+	char *cluster_name;
+	List dirty;		/* db_index strings to read again */
+	time_t evict_time;	/* when to drop the jobs out of the window */
+	xhash_t *jobs;		/* job_cache_rec_t by db_index */
+	bool loaded;
+	bool reload;		/* read every job again */
+	time_t retry;		/* don't try to load the jobs before this */
+	time_t start;		/* every job that ended after this is cached */
+} cache_cluster_t;
+
+typedef struct {
+	char *cluster_name;	/* NULL for every cluster */
+	uint64_t db_index;	/* 0 for every job */
+} cache_mark_t;
+
+typedef struct {
+	List old;
+	time_t start;
+} evict_args_t;
+
+static bool cache_enabled = false;
+static time_t cache_window = 0;
+
+/* Protects cache_clusters and the dirty and reload of each cluster */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static List cache_clusters = NULL;
+
+/* Protects the rest of each cluster and cache_conn */
+static pthread_rwlock_t jobs_lock = PTHREAD_RWLOCK_INITIALIZER;
+/* Jobs are read off the primary so a lagging replica can't be cached */
+static mysql_conn_t *cache_conn = NULL;
+
+static char **_copy_row(MYSQL_ROW row, int cnt)
+{
+	char **copy = xcalloc(cnt, sizeof(char *));
+
+	for (int i = 0; i < cnt; i++)
+		copy[i] = xstrdup(row[i]);
+
+	return copy;
+}
+
+static void _free_row(char **row, int cnt)
+{
+	if (!row)
+		return;
+
+	for (int i = 0; i < cnt; i++)
+		xfree(row[i]);
+	xfree(row);
+}
+
+static void _destroy_step_row(void *object)
+{
+	_free_row(object, STEP_REQ_COUNT);
+}
+
+static void _destroy_rec(void *object)
+{
+	job_cache_rec_t *rec = object;
+
+	if (rec) {
+		_free_row(rec->job_row, JOB_REQ_COUNT);
+		FREE_NULL_LIST(rec->step_rows);
+		xfree(rec->suspend);
+		xfree(rec);
+	}
+}
+
+static void _rec_id(void *item, const char **key, uint32_t *key_len)
+{
+	job_cache_rec_t *rec = item;
+
+	*key = rec->job_row[JOB_REQ_DB_INX];
+	*key_len = strlen(*key);
+}
+
+static void _destroy_cluster(void *object)
+{
+	cache_cluster_t *cluster = object;
+
+	if (cluster) {
+		xfree(cluster->cluster_name);
+		FREE_NULL_LIST(cluster->dirty);
+		xhash_free(cluster->jobs);
+		xfree(cluster);
+	}
+}
+
+static void _destroy_mark(void *object)
+{
+	cache_mark_t *mark = object;
+
+	if (mark) {
+		xfree(mark->cluster_name);
+		xfree(mark);
+	}
+}
+
+static int _find_cluster(void *x, void *key)
+{
+	cache_cluster_t *cluster = x;
+
+	return !xstrcmp(cluster->cluster_name, key);
+}
+
+/* Get the cache of cluster_name, making it if needed. cache_lock locked */
+static cache_cluster_t *_get_cluster(char *cluster_name)
+{
+	cache_cluster_t *cluster;
+
+	if ((cluster = list_find_first(cache_clusters, _find_cluster,
+				       cluster_name)))
+		return cluster;
+
+	cluster = xmalloc(sizeof(*cluster));
+	cluster->cluster_name = xstrdup(cluster_name);
+	cluster->dirty = list_create(xfree_ptr);
+	cluster->jobs = xhash_init(_rec_id, _destroy_rec);
+	list_append(cache_clusters, cluster);
+
+	return cluster;
+}
+
+/* cache_lock locked */
+static int _apply_mark(void *x, void *arg)
+{
+	cache_mark_t *mark = x;
+	cache_cluster_t *cluster;
+	list_itr_t *itr = list_iterator_create(cache_clusters);
+
+	while ((cluster = list_next(itr))) {
+		if (mark->cluster_name &&
+		    xstrcmp(mark->cluster_name, cluster->cluster_name))
+			continue;
+
+		if (cluster->reload)
+			continue;
+
+		if (!mark->db_index ||
+		    (list_count(cluster->dirty) >= MAX_CACHE_DIRTY)) {
+			cluster->reload = true;
+			list_flush(cluster->dirty);
+		} else {
+			list_append(cluster->dirty,
+				    xstrdup_printf("%"PRIu64, mark->db_index));
+		}
+	}
+	list_iterator_destroy(itr);
+
+	return 0;
+}
+
+/*
+ * Read the jobs matching cond (a where clause of the job table), their steps
+ * and suspended periods into cluster.
+ */
+static int _load_jobs(cache_cluster_t *cluster, char *cond)
+{
+	char *name = cluster->cluster_name;
+	char *fields, *query;
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	job_cache_rec_t *rec;
+
+	if (check_connection(cache_conn) != SLURM_SUCCESS)
+		return ESLURM_DB_CONNECTION;
+
+	fields = job_req_fields(NULL);
+	query = job_req_query(fields, name);
+	xfree(fields);
+	xstrfmtcat(query, " where t1.job_db_inx in "
+		   "(select job_db_inx from \"%s_%s\" where %s)",
+		   name, job_table, cond);
+
+	DB_DEBUG(DB_JOB, cache_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(cache_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		rec = xmalloc(sizeof(*rec));
+		rec->job_row = _copy_row(row, JOB_REQ_COUNT);
+		rec->db_index = slurm_atoull(row[JOB_REQ_DB_INX]);
+		rec->end = slurm_atoul(row[JOB_REQ_END]);
+		rec->job_id = slurm_atoul(row[JOB_REQ_JOBID]);
+		rec->step_rows = list_create(_destroy_step_row);
+		rec->submit = slurm_atoul(row[JOB_REQ_SUBMIT]);
+		xhash_add(cluster->jobs, rec);
+	}
+	mysql_free_result(result);
+
+	/* In primary key order, as the step query of each job gives them */
+	fields = step_req_fields();
+	query = xstrdup_printf("select t1.job_db_inx, %s from \"%s_%s\" as t1 "
+			       "where t1.job_db_inx in "
+			       "(select job_db_inx from \"%s_%s\" where %s) "
+			       "order by t1.job_db_inx, t1.id_step, "
+			       "t1.step_het_comp",
+			       fields, name, step_table, name, job_table, cond);
+	xfree(fields);
+
+	DB_DEBUG(DB_STEP, cache_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(cache_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		if (!(rec = xhash_get_str(cluster->jobs, row[0])))
+			continue;
+		list_append(rec->step_rows, _copy_row(&row[1], STEP_REQ_COUNT));
+	}
+	mysql_free_result(result);
+
+	query = xstrdup_printf("select job_db_inx, time_start, time_end "
+			       "from \"%s_%s\" where job_db_inx in "
+			       "(select job_db_inx from \"%s_%s\" where %s) "
+			       "order by job_db_inx, time_start",
+			       name, suspend_table, name, job_table, cond);
+
+	DB_DEBUG(DB_JOB, cache_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(cache_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		if (!(rec = xhash_get_str(cluster->jobs, row[0])))
+			continue;
+		xrecalloc(rec->suspend, (rec->suspend_cnt + 1) * 2,
+			  sizeof(time_t));
+		rec->suspend[rec->suspend_cnt * 2] = slurm_atoul(row[1]);
+		rec->suspend[(rec->suspend_cnt * 2) + 1] = slurm_atoul(row[2]);
+		rec->suspend_cnt++;
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
+static void _find_old_jobs(void *item, void *arg)
+{
+	job_cache_rec_t *rec = item;
+	evict_args_t *args = arg;
+
+	if (rec->end && (rec->end < args->start))
+		list_append(args->old, rec);
+}
+
+/* Drop the jobs of cluster that ended before start */
+static void _evict_jobs(cache_cluster_t *cluster, time_t start)
+{
+	evict_args_t args = { .start = start };
+	job_cache_rec_t *rec;
+
+	args.old = list_create(NULL);
+	xhash_walk(cluster->jobs, _find_old_jobs, &args);
+	while ((rec = list_pop(args.old)))
+		xhash_delete_str(cluster->jobs, rec->job_row[JOB_REQ_DB_INX]);
+	FREE_NULL_LIST(args.old);
+	cluster->start = start;
+}
+
+/* Does cluster need _update_cluster()? cache_lock locked */
+static bool _needs_update(cache_cluster_t *cluster, time_t now)
+{
+	if (!cluster->loaded)
+		return (now >= cluster->retry);
+
+	return (cluster->reload || list_count(cluster->dirty) ||
+		(now >= cluster->evict_time));
+}
+
+/*
+ * Bring the jobs of cluster up to date with the database, reading all of
+ * them if not loaded yet. jobs_lock write locked.
+ */
+static void _update_cluster(cache_cluster_t *cluster)
+{
+	time_t now = time(NULL);
+	char *cond = NULL, *db_inx, *sep = "";
+	List dirty = NULL;
+	bool reload = false;
+	int rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&cache_lock);
+	if (!_needs_update(cluster, now)) {
+		slurm_mutex_unlock(&cache_lock);
+		return;
+	}
+	if (!cluster->loaded || cluster->reload) {
+		reload = true;
+		cluster->reload = false;
+		list_flush(cluster->dirty);
+	} else if (list_count(cluster->dirty)) {
+		dirty = cluster->dirty;
+		cluster->dirty = list_create(xfree_ptr);
+	}
+	slurm_mutex_unlock(&cache_lock);
+
+	if (reload) {
+		xhash_clear(cluster->jobs);
+		cluster->loaded = false;
+		cluster->start = now - cache_window;
+		cluster->evict_time = now + CACHE_EVICT_SEC;
+		cond = xstrdup_printf("time_end=0 || time_end >= %ld",
+				      cluster->start);
+	} else if (dirty) {
+		xstrcat(cond, "job_db_inx in (");
+		while ((db_inx = list_pop(dirty))) {
+			/* It might be gone from the database now */
+			_destroy_rec(xhash_pop_str(cluster->jobs, db_inx));
+			xstrfmtcat(cond, "%s%s", sep, db_inx);
+			sep = ", ";
+			xfree(db_inx);
+		}
+		xstrcat(cond, ")");
+		FREE_NULL_LIST(dirty);
+	}
+
+	if (cond) {
+		rc = _load_jobs(cluster, cond);
+		xfree(cond);
+	}
+
+	if (rc != SLURM_SUCCESS) {
+		error("%s: couldn't read the jobs of cluster %s, not caching them for %d seconds",
+		      __func__, cluster->cluster_name, CACHE_RETRY_SEC);
+	} else if (xhash_count(cluster->jobs) > MAX_CACHE_JOBS) {
+		info("%s: cluster %s has more than the %d jobs the job cache holds, not caching them for %d seconds",
+		     __func__, cluster->cluster_name, MAX_CACHE_JOBS,
+		     CACHE_RETRY_SEC);
+		rc = SLURM_ERROR;
+	} else {
+		if (reload)
+			debug("%s: cached %u jobs of cluster %s",
+			      __func__, xhash_count(cluster->jobs),
+			      cluster->cluster_name);
+		cluster->loaded = true;
+	}
+
+	if (rc != SLURM_SUCCESS) {
+		xhash_clear(cluster->jobs);
+		cluster->loaded = false;
+		cluster->retry = now + CACHE_RETRY_SEC;
+		return;
+	}
+
+	if (now >= cluster->evict_time) {
+		_evict_jobs(cluster, now - cache_window);
+		cluster->evict_time = now + CACHE_EVICT_SEC;
+	}
+}
+
+static bool _list_set(List list)
+{
+	return (list && list_count(list));
+}
+
+static int _find_str_case(void *x, void *key)
+{
+	return !xstrcasecmp(x, key);
+}
+
+static int _find_uint(void *x, void *key)
+{
+	return (slurm_atoul(x) == *(uint32_t *) key);
+}
+
+/* Filters of job_cond the cache applies the same way the database does */
+static bool _cond_supported(slurmdb_job_cond_t *job_cond)
+{
+	uint32_t flags = JOBCOND_FLAG_DUP | JOBCOND_FLAG_NO_STEP |
+		JOBCOND_FLAG_NO_TRUNC | JOBCOND_FLAG_NO_WAIT |
+		JOBCOND_FLAG_STREAM;
+	uint32_t suspended = JOB_SUSPENDED;
+
+	if (!job_cond || (job_cond->flags & ~flags) || !job_cond->usage_start)
+		return false;
+
+	if (_list_set(job_cond->associd_list) ||
+	    _list_set(job_cond->constraint_list) ||
+	    _list_set(job_cond->groupid_list) ||
+	    _list_set(job_cond->jobname_list) ||
+	    _list_set(job_cond->qos_list) ||
+	    _list_set(job_cond->reason_list) ||
+	    _list_set(job_cond->resv_list) ||
+	    _list_set(job_cond->resvid_list) ||
+	    _list_set(job_cond->step_list) ||
+	    _list_set(job_cond->wckey_list))
+		return false;
+
+	if (job_cond->cpus_min || job_cond->nodes_min ||
+	    job_cond->timelimit_min || job_cond->used_nodes ||
+	    (job_cond->db_flags != SLURMDB_JOB_FLAG_NOTSET))
+		return false;
+
+	/* Suspended jobs are found by their suspended periods */
+	if (job_cond->state_list &&
+	    list_find_first(job_cond->state_list, _find_uint, &suspended))
+		return false;
+
+	return true;
+}
+
+/* Same as the query _state_time_string() makes when usage_start is set */
+static bool _state_match(char **row, uint32_t want, time_t usage_start,
+			 time_t usage_end)
+{
+	uint32_t state = slurm_atoul(row[JOB_REQ_STATE]);
+	time_t eligible = slurm_atoul(row[JOB_REQ_ELIGIBLE]);
+	time_t end = slurm_atoul(row[JOB_REQ_END]);
+	time_t start = slurm_atoul(row[JOB_REQ_START]);
+
+	switch (want) {
+	case JOB_PENDING:
+		return (eligible &&
+			((start && (usage_start < start)) ||
+			 (!start && end && (usage_start < end)) ||
+			 (!start && !end && (state == want))) &&
+			(usage_end > eligible));
+	case JOB_RUNNING:
+		return (start &&
+			((usage_start < end) || (!end && (state == want))) &&
+			(usage_end > start));
+	case JOB_COMPLETE:
+	case JOB_CANCELLED:
+	case JOB_FAILED:
+	case JOB_TIMEOUT:
+	case JOB_NODE_FAIL:
+	case JOB_PREEMPTED:
+	case JOB_BOOT_FAIL:
+	case JOB_DEADLINE:
+	case JOB_OOM:
+	case JOB_REQUEUE:
+	case JOB_RESIZING:
+	case JOB_REVOKED:
+		return ((state == want) && end && (end >= usage_start) &&
+			(end <= usage_end));
+	default:
+		return (state == want);
+	}
+}
+
+/* Same as the where clause setup_job_cond_limits() makes */
+static bool _job_match(job_cache_rec_t *rec, slurmdb_job_cond_t *job_cond)
+{
+	char **row = rec->job_row;
+	uint32_t uid = slurm_atoul(row[JOB_REQ_UID]);
+
+	if (!(job_cond->flags & JOBCOND_FLAG_DUP) &&
+	    (slurm_atoul(row[JOB_REQ_STATE]) == JOB_REVOKED))
+		return false;
+
+	if (_list_set(job_cond->acct_list) &&
+	    !list_find_first(job_cond->acct_list, _find_str_case,
+			     row[JOB_REQ_ACCOUNT1]))
+		return false;
+
+	if (_list_set(job_cond->userid_list) &&
+	    !list_find_first(job_cond->userid_list, _find_uint, &uid))
+		return false;
+
+	if (_list_set(job_cond->partition_list) &&
+	    !list_find_first(job_cond->partition_list, _find_str_case,
+			     row[JOB_REQ_PARTITION]))
+		return false;
+
+	if (_list_set(job_cond->state_list)) {
+		list_itr_t *itr = list_iterator_create(job_cond->state_list);
+		char *state;
+		bool match = false;
+
+		while (!match && (state = list_next(itr)))
+			match = _state_match(row, slurm_atoul(state),
+					     job_cond->usage_start,
+					     job_cond->usage_end);
+		list_iterator_destroy(itr);
+
+		return match;
+	}
+
+	/* Time window should be exclusive of the end time, ie [start,end) */
+	if (rec->end && (rec->end < job_cond->usage_start))
+		return false;
+
+	if (job_cond->usage_end) {
+		time_t eligible = slurm_atoul(row[JOB_REQ_ELIGIBLE]);
+
+		if (!eligible || (eligible >= job_cond->usage_end))
+			return false;
+	}
+
+	return true;
+}
+
+typedef struct {
+	slurmdb_job_cond_t *job_cond;
+	List matches;
+} match_args_t;
+
+static void _add_match(void *item, void *arg)
+{
+	match_args_t *args = arg;
+
+	if (_job_match(item, args->job_cond))
+		list_append(args->matches, item);
+}
+
+/* By job id and then latest submit first */
+static int _sort_matches(void *x, void *y)
+{
+	job_cache_rec_t *rec_a = *(job_cache_rec_t **) x;
+	job_cache_rec_t *rec_b = *(job_cache_rec_t **) y;
+
+	if (rec_a->job_id != rec_b->job_id)
+		return (rec_a->job_id < rec_b->job_id) ? -1 : 1;
+	if (rec_a->submit != rec_b->submit)
+		return (rec_a->submit > rec_b->submit) ? -1 : 1;
+	return 0;
+}
+
+extern void as_mysql_job_cache_init(void)
+{
+	if (!slurmdbd_conf->job_cache_window)
+		return;
+
+	cache_window = slurmdbd_conf->job_cache_window * 3600;
+	cache_clusters = list_create(_destroy_cluster);
+	cache_conn = create_mysql_conn(0, false, NULL);
+	cache_enabled = true;
+
+	debug("%s: caching jobs of the last %u hours",
+	      __func__, slurmdbd_conf->job_cache_window);
+}
+
+extern void as_mysql_job_cache_fini(void)
+{
+	if (!cache_enabled)
+		return;
+
+	cache_enabled = false;
+	slurm_rwlock_wrlock(&jobs_lock);
+	slurm_mutex_lock(&cache_lock);
+	FREE_NULL_LIST(cache_clusters);
+	slurm_mutex_unlock(&cache_lock);
+	destroy_mysql_conn(cache_conn);
+	cache_conn = NULL;
+	slurm_rwlock_unlock(&jobs_lock);
+}
+
+extern void as_mysql_job_cache_mark(mysql_conn_t *mysql_conn,
+				    char *cluster_name, uint64_t db_index)
+{
+	cache_mark_t *mark;
+
+	if (!cache_enabled)
+		return;
+
+	mark = xmalloc(sizeof(*mark));
+	mark->cluster_name = xstrdup(cluster_name);
+	mark->db_index = db_index;
+
+	/* Without rollback the change is already in the database */
+	if (!(mysql_conn->flags & DB_CONN_FLAG_ROLLBACK)) {
+		slurm_mutex_lock(&cache_lock);
+		_apply_mark(mark, NULL);
+		slurm_mutex_unlock(&cache_lock);
+		_destroy_mark(mark);
+		return;
+	}
+
+	if (!mysql_conn->job_cache_list)
+		mysql_conn->job_cache_list = list_create(_destroy_mark);
+	list_append(mysql_conn->job_cache_list, mark);
+}
+
+extern void as_mysql_job_cache_commit(mysql_conn_t *mysql_conn, bool commit)
+{
+	if (!mysql_conn->job_cache_list ||
+	    !list_count(mysql_conn->job_cache_list))
+		return;
+
+	if (commit && cache_enabled) {
+		slurm_mutex_lock(&cache_lock);
+		(void) list_for_each(mysql_conn->job_cache_list, _apply_mark,
+				     NULL);
+		slurm_mutex_unlock(&cache_lock);
+	}
+	list_flush(mysql_conn->job_cache_list);
+}
+
+extern int as_mysql_job_cache_for_each(char *cluster_name,
+				       slurmdb_job_cond_t *job_cond,
+				       job_cache_cb_t callback, void *arg)
+{
+	cache_cluster_t *cluster;
+	match_args_t args;
+	job_cache_rec_t *rec;
+	list_itr_t *itr;
+	bool update;
+	int rc = SLURM_SUCCESS;
+
+	if (!cache_enabled || !_cond_supported(job_cond))
+		return ESLURM_NOT_SUPPORTED;
+
+	slurm_rwlock_rdlock(&jobs_lock);
+	slurm_mutex_lock(&cache_lock);
+	cluster = _get_cluster(cluster_name);
+	update = _needs_update(cluster, time(NULL));
+	slurm_mutex_unlock(&cache_lock);
+
+	if (update) {
+		slurm_rwlock_unlock(&jobs_lock);
+		slurm_rwlock_wrlock(&jobs_lock);
+		_update_cluster(cluster);
+		slurm_rwlock_unlock(&jobs_lock);
+		slurm_rwlock_rdlock(&jobs_lock);
+	}
+
+	/* The jobs before the window might not all be here */
+	if (!cluster->loaded || (job_cond->usage_start < cluster->start)) {
+		slurm_rwlock_unlock(&jobs_lock);
+		return ESLURM_NOT_SUPPORTED;
+	}
+
+	args.job_cond = job_cond;
+	args.matches = list_create(NULL);
+	xhash_walk(cluster->jobs, _add_match, &args);
+	list_sort(args.matches, _sort_matches);
+
+	itr = list_iterator_create(args.matches);
+	while ((rec = list_next(itr))) {
+		if ((rc = (callback)(rec, arg)) != SLURM_SUCCESS)
+			break;
+	}
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(args.matches);
+
+	slurm_rwlock_unlock(&jobs_lock);
+
+	return rc;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************\
+ *  as_mysql_job_cache.h - in memory cache of recent job records
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _HAVE_MYSQL_JOB_CACHE_H
+#define _HAVE_MYSQL_JOB_CACHE_H
+
+#include "accounting_storage_mysql.h"
+
+/* A job record of the cache, as rows read from the database */
+typedef struct {
+	uint64_t db_index;
+	time_t end;
+	char **job_row;		/* JOB_REQ_COUNT columns of job_req_inx */
+	uint32_t job_id;
+	List step_rows;		/* STEP_REQ_COUNT columns of step_req_inx */
+	time_t submit;
+	time_t *suspend;	/* time_start and time_end of each period */
+	uint32_t suspend_cnt;
+} job_cache_rec_t;
+
+typedef int (*job_cache_cb_t)(job_cache_rec_t *rec, void *arg);
+
+/* Start caching the recent jobs if JobCacheWindow is set */
+extern void as_mysql_job_cache_init(void);
+extern void as_mysql_job_cache_fini(void);
+
+/*
+ * Have the cache read the job record db_index of cluster_name again once
+ * the changes of mysql_conn are committed.
+ * A db_index of 0 reads all jobs of cluster_name again, a NULL cluster_name
+ * all jobs of every cluster.
+ */
+extern void as_mysql_job_cache_mark(mysql_conn_t *mysql_conn,
+				    char *cluster_name, uint64_t db_index);
+
+/* Apply the marks queued on mysql_conn if committed, else drop them */
+extern void as_mysql_job_cache_commit(mysql_conn_t *mysql_conn, bool commit);
+
+/*
+ * Call callback on every cached job of cluster_name matching job_cond,
+ * ordered by job id and latest submit first like the database query.
+ * job_cond must already have its default start and end times.
+ * RET ESLURM_NOT_SUPPORTED if the cache can't answer job_cond, else
+ *     SLURM_SUCCESS or the first error returned by callback
+ */
+extern int as_mysql_job_cache_for_each(char *cluster_name,
+				       slurmdb_job_cond_t *job_cond,
+				       job_cache_cb_t callback, void *arg);
+
+#endif
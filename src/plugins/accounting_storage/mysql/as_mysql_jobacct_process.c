@@ -42,6 +42,7 @@
 \*****************************************************************************/
 
 #include "as_mysql_jobacct_process.h"
+#include "as_mysql_job_cache.h"
 
 typedef struct {
 	hostlist_t hl;
@@ -50,8 +51,28 @@ typedef struct {
 	bitstr_t *asked_bitmap;
 } local_cluster_t;
 
+/* Most jobs handed back at once when streaming */
+#define JOB_STREAM_CHUNK_SIZE 1000
+
+typedef struct {
+	slurmdb_job_stream_cb_t callback;
+	void *arg;
+	mysql_conn_t cursor_conn; /* reads the job query a row at a time */
+	int rc; /* first error returned by callback or reading the jobs */
+} local_job_stream_t;
+
+typedef struct {
+	char *cluster_name;
+	List job_list;
+	slurmdb_job_cond_t *job_cond;
+	int last_id;
+	time_t now;
+	int only_pending;
+	local_job_stream_t *stream;
+} local_job_cache_t;
+
 /* if this changes you will need to edit the corresponding
- * enum below also t1 is job_table */
+ * enum in as_mysql_jobacct_process.h also t1 is job_table */
 char *job_req_inx[] = {
 	"t1.account",
 	"t1.admin_comment",
@@ -112,69 +133,8 @@ char *job_req_inx[] = {
 	"t2.user"
 };
 
-enum {
-	JOB_REQ_ACCOUNT1,
-	JOB_REQ_ADMIN_COMMENT,
-	JOB_REQ_ARRAY_MAX,
-	JOB_REQ_ARRAY_STR,
-	JOB_REQ_CONSTRAINTS,
-	JOB_REQ_CONTAINER,
-	JOB_REQ_REQ_CPUS,
-	JOB_REQ_DERIVED_EC,
-	JOB_REQ_DERIVED_ES,
-	JOB_REQ_EXIT_CODE,
-	JOB_REQ_EXTRA,
-	JOB_REQ_FAILED_NODE,
-	JOB_REQ_FLAGS,
-	JOB_REQ_ARRAYJOBID,
-	JOB_REQ_ARRAYTASKID,
-	JOB_REQ_ASSOCID,
-	JOB_REQ_BLOCKID,
-	JOB_REQ_GID,
-	JOB_REQ_JOBID,
-	JOB_REQ_HET_JOB_ID,
-	JOB_REQ_HET_JOB_OFFSET,
-	JOB_REQ_QOS,
-	JOB_REQ_RESVID,
-	JOB_REQ_RESV_NAME,
-	JOB_REQ_UID,
-	JOB_REQ_WCKEYID,
-	JOB_REQ_DB_INX,
-	JOB_REQ_NAME,
-	JOB_REQ_KILL_REQUID,
-	JOB_REQ_LICENSES,
-	JOB_REQ_REQ_MEM,
-	JOB_REQ_NODE_INX,
-	JOB_REQ_NODELIST,
-	JOB_REQ_ALLOC_NODES,
-	JOB_REQ_PARTITION,
-	JOB_REQ_PRIORITY,
-	JOB_REQ_STATE,
-	JOB_REQ_STATE_REASON,
-	JOB_REQ_SYSTEM_COMMENT,
-	JOB_REQ_ELIGIBLE,
-	JOB_REQ_END,
-	JOB_REQ_START,
-	JOB_REQ_SUBMIT,
-	JOB_REQ_SUSPENDED,
-	JOB_REQ_TIMELIMIT,
-	JOB_REQ_WCKEY,
-	JOB_REQ_GRES_USED,
-	JOB_REQ_TRESA,
-	JOB_REQ_TRESR,
-	JOB_REQ_WORK_DIR,
-	JOB_REQ_MCS_LABEL,
-	JOB_REQ_SCRIPT,
-	JOB_REQ_SUBMIT_LINE,
-	JOB_REQ_ENV,
-	JOB_REQ_ACCOUNT,
-	JOB_REQ_LFT,
-	JOB_REQ_USER_NAME,
-	JOB_REQ_COUNT
-};
-
 /* if this changes you will need to edit the corresponding
- * enum below also t1 is step_table */
+ * enum in as_mysql_jobacct_process.h also t1 is step_table */
 char *step_req_inx[] = {
 	"t1.id_step",
 	"t1.step_het_comp",
@@ -220,52 +180,6 @@ char *step_req_inx[] = {
 	"t1.tres_usage_out_tot",
 };
 
-enum {
-	STEP_REQ_STEPID,
-	STEP_REQ_STEP_HET_COMP,
-	STEP_REQ_START,
-	STEP_REQ_END,
-	STEP_REQ_SUSPENDED,
-	STEP_REQ_NAME,
-	STEP_REQ_NODELIST,
-	STEP_REQ_NODE_INX,
-	STEP_REQ_STATE,
-	STEP_REQ_KILL_REQUID,
-	STEP_REQ_EXIT_CODE,
-	STEP_REQ_NODES,
-	STEP_REQ_TASKS,
-	STEP_REQ_TASKDIST,
-	STEP_REQ_USER_SEC,
-	STEP_REQ_USER_USEC,
-	STEP_REQ_SYS_SEC,
-	STEP_REQ_SYS_USEC,
-	STEP_REQ_ACT_CPUFREQ,
-	STEP_REQ_CONSUMED_ENERGY,
-	STEP_REQ_CONTAINER,
-	STEP_REQ_REQ_CPUFREQ_MIN,
-	STEP_REQ_REQ_CPUFREQ_MAX,
-	STEP_REQ_REQ_CPUFREQ_GOV,
-	STEP_REQ_SUBMIT_LINE,
-	STEP_REQ_TRES,
-	STEP_REQ_TRES_USAGE_IN_MAX,
-	STEP_REQ_TRES_USAGE_IN_MAX_TASKID,
-	STEP_REQ_TRES_USAGE_IN_MAX_NODEID,
-	STEP_REQ_TRES_USAGE_IN_AVE,
-	STEP_REQ_TRES_USAGE_IN_MIN,
-	STEP_REQ_TRES_USAGE_IN_MIN_TASKID,
-	STEP_REQ_TRES_USAGE_IN_MIN_NODEID,
-	STEP_REQ_TRES_USAGE_IN_TOT,
-	STEP_REQ_TRES_USAGE_OUT_MAX,
-	STEP_REQ_TRES_USAGE_OUT_MAX_TASKID,
-	STEP_REQ_TRES_USAGE_OUT_MAX_NODEID,
-	STEP_REQ_TRES_USAGE_OUT_AVE,
-	STEP_REQ_TRES_USAGE_OUT_MIN,
-	STEP_REQ_TRES_USAGE_OUT_MIN_TASKID,
-	STEP_REQ_TRES_USAGE_OUT_MIN_NODEID,
-	STEP_REQ_TRES_USAGE_OUT_TOT,
-	STEP_REQ_COUNT
-};
-
 static void _setup_job_cond_selected_steps(slurmdb_job_cond_t *job_cond,
 					   char *cluster_name, char **extra)
 {
@@ -468,21 +382,447 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+/* Hand job_list to the stream callback and empty it */
+static int _stream_jobs(local_job_stream_t *stream, List job_list)
+{
+	if (!list_count(job_list))
+		return stream->rc;
+
+	if (stream->rc == SLURM_SUCCESS)
+		stream->rc = (stream->callback)(job_list, stream->arg);
+	list_flush(job_list);
+
+	return stream->rc;
+}
+
+/*
+ * Make a job record out of a row of job_req_inx. Unless job_cond asks
+ * otherwise the times are truncated to its window, the caller takes out the
+ * suspended time and makes sure elapsed isn't negative.
+ */
+static slurmdb_job_rec_t *_job_rec_from_row(char **row, char *cluster_name,
+					    slurmdb_job_cond_t *job_cond,
+					    time_t now)
+{
+	slurmdb_job_rec_t *job = slurmdb_create_job_rec();
+
+	job->state = slurm_atoul(row[JOB_REQ_STATE]);
+	job->alloc_nodes = slurm_atoul(row[JOB_REQ_ALLOC_NODES]);
+	job->associd = slurm_atoul(row[JOB_REQ_ASSOCID]);
+	job->array_job_id = slurm_atoul(row[JOB_REQ_ARRAYJOBID]);
+	job->array_task_id = slurm_atoul(row[JOB_REQ_ARRAYTASKID]);
+	job->het_job_id = slurm_atoul(row[JOB_REQ_HET_JOB_ID]);
+	job->het_job_offset = slurm_atoul(row[JOB_REQ_HET_JOB_OFFSET]);
+	job->resvid = slurm_atoul(row[JOB_REQ_RESVID]);
+
+	/* This shouldn't happen with new jobs, but older jobs
+	 * could of been added without a start and so the
+	 * array_task_id would be 0 instead of it's real value */
+	if (!job->array_job_id && !job->array_task_id)
+		job->array_task_id = NO_VAL;
+
+	/*
+	 * This shouldn't happen with new jobs.
+	 * If older jobs have het_job_id == 0 and het_job_offset == 0,
+	 * then correct het_job_offset to be NO_VAL.
+	 */
+	if (!job->het_job_id && !job->het_job_offset)
+		job->het_job_offset = NO_VAL;
+
+	if (row[JOB_REQ_RESV_NAME] && row[JOB_REQ_RESV_NAME][0])
+		job->resv_name = xstrdup(row[JOB_REQ_RESV_NAME]);
+
+	job->cluster = xstrdup(cluster_name);
+
+	/* we want a blank wckey if the name is null */
+	if (row[JOB_REQ_WCKEY])
+		job->wckey = xstrdup(row[JOB_REQ_WCKEY]);
+	else
+		job->wckey = xstrdup("");
+	job->wckeyid = slurm_atoul(row[JOB_REQ_WCKEYID]);
+	if (row[JOB_REQ_MCS_LABEL])
+		job->mcs_label = xstrdup(row[JOB_REQ_MCS_LABEL]);
+	else
+		job->mcs_label = xstrdup("");
+	if (row[JOB_REQ_USER_NAME])
+		job->user = xstrdup(row[JOB_REQ_USER_NAME]);
+
+	if (row[JOB_REQ_UID])
+		job->uid = slurm_atoul(row[JOB_REQ_UID]);
+
+	if (row[JOB_REQ_LFT])
+		job->lft = slurm_atoul(row[JOB_REQ_LFT]);
+
+	if (row[JOB_REQ_ACCOUNT] && row[JOB_REQ_ACCOUNT][0])
+		job->account = xstrdup(row[JOB_REQ_ACCOUNT]);
+	else if (row[JOB_REQ_ACCOUNT1] && row[JOB_REQ_ACCOUNT1][0])
+		job->account = xstrdup(row[JOB_REQ_ACCOUNT1]);
+
+	if (row[JOB_REQ_ARRAY_STR] && row[JOB_REQ_ARRAY_STR][0])
+		job->array_task_str = xstrdup(row[JOB_REQ_ARRAY_STR]);
+
+	if (row[JOB_REQ_ARRAY_MAX])
+		job->array_max_tasks =
+			slurm_atoul(row[JOB_REQ_ARRAY_MAX]);
+
+	if (row[JOB_REQ_BLOCKID])
+		job->blockid = xstrdup(row[JOB_REQ_BLOCKID]);
+
+	if (row[JOB_REQ_WORK_DIR])
+		job->work_dir = xstrdup(row[JOB_REQ_WORK_DIR]);
+
+	job->eligible = slurm_atoul(row[JOB_REQ_ELIGIBLE]);
+	job->submit = slurm_atoul(row[JOB_REQ_SUBMIT]);
+	job->start = slurm_atoul(row[JOB_REQ_START]);
+	job->end = slurm_atoul(row[JOB_REQ_END]);
+	job->timelimit = slurm_atoul(row[JOB_REQ_TIMELIMIT]);
+
+	job->script = xstrdup(row[JOB_REQ_SCRIPT]);
+
+	job->env = xstrdup(row[JOB_REQ_ENV]);
+
+	job->submit_line = xstrdup(row[JOB_REQ_SUBMIT_LINE]);
+
+	/* since the job->end could be set later end it here */
+	if (job->end) {
+		if (job->start > job->end)
+			job->start = job->end;
+	}
+
+	if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) ){
+
+		if (!job_cond->usage_end ||
+		    (job_cond->usage_end > now)) {
+			job_cond->usage_end = now;
+		}
+
+		if (job->start && (job->start < job_cond->usage_start))
+			job->start = job_cond->usage_start;
+
+		if (!job->end || job->end > job_cond->usage_end)
+			job->end = job_cond->usage_end;
+
+		if (!job->start)
+			job->start = job->end;
+
+		job->elapsed = job->end - job->start;
+	} else {
+		job->suspended = slurm_atoul(row[JOB_REQ_SUSPENDED]);
+
+		/* fix the suspended number to be correct */
+		if (job->state == JOB_SUSPENDED)
+			job->suspended = now - job->suspended;
+		if (!job->start) {
+			job->elapsed = 0;
+		} else if (!job->end) {
+			job->elapsed = now - job->start;
+		} else {
+			job->elapsed = job->end - job->start;
+		}
+
+		job->elapsed -= job->suspended;
+	}
+
+	job->db_index = slurm_atoull(row[JOB_REQ_DB_INX]);
+	job->jobid = slurm_atoul(row[JOB_REQ_JOBID]);
+	job->jobname = xstrdup(row[JOB_REQ_NAME]);
+	job->gid = slurm_atoul(row[JOB_REQ_GID]);
+	job->exitcode = slurm_atoul(row[JOB_REQ_EXIT_CODE]);
+	job->failed_node = xstrdup(row[JOB_REQ_FAILED_NODE]);
+	job->derived_ec = slurm_atoul(row[JOB_REQ_DERIVED_EC]);
+	job->derived_es = xstrdup(row[JOB_REQ_DERIVED_ES]);
+	job->admin_comment = xstrdup(row[JOB_REQ_ADMIN_COMMENT]);
+	job->system_comment = xstrdup(row[JOB_REQ_SYSTEM_COMMENT]);
+	job->constraints = xstrdup(row[JOB_REQ_CONSTRAINTS]);
+	job->container = xstrdup(row[JOB_REQ_CONTAINER]);
+	job->extra = xstrdup(row[JOB_REQ_EXTRA]);
+	job->licenses = xstrdup(row[JOB_REQ_LICENSES]);
+	job->flags = slurm_atoul(row[JOB_REQ_FLAGS]);
+
+	/*
+	 * This tells us we never had a start time so the job was
+	 * canceled before it ran.
+	 */
+	if (!job->start && job->end &&
+	    (job->flags & SLURMDB_JOB_FLAG_START_R))
+		job->start = NO_VAL;
+
+	job->state_reason_prev = slurm_atoul(row[JOB_REQ_STATE_REASON]);
+
+	if (row[JOB_REQ_PARTITION])
+		job->partition = xstrdup(row[JOB_REQ_PARTITION]);
+
+	if (row[JOB_REQ_NODELIST])
+		job->nodes = xstrdup(row[JOB_REQ_NODELIST]);
+
+	if (!job->nodes || !xstrcmp(job->nodes, "(null)")) {
+		xfree(job->nodes);
+		job->nodes = xstrdup("(unknown)");
+	}
+
+	job->priority = slurm_atoul(row[JOB_REQ_PRIORITY]);
+	job->req_cpus = slurm_atoul(row[JOB_REQ_REQ_CPUS]);
+	job->req_mem = slurm_atoull(row[JOB_REQ_REQ_MEM]);
+	if (!row[JOB_REQ_KILL_REQUID])
+		job->requid = INFINITE;
+	else
+		job->requid = slurm_atoul(row[JOB_REQ_KILL_REQUID]);
+	job->qosid = slurm_atoul(row[JOB_REQ_QOS]);
+	job->show_full = 1;
+
+	if (row[JOB_REQ_TRESA])
+		job->tres_alloc_str = xstrdup(row[JOB_REQ_TRESA]);
+	if (row[JOB_REQ_TRESR])
+		job->tres_req_str = xstrdup(row[JOB_REQ_TRESR]);
+
+	return job;
+}
+
+/* Take a suspended period out of the truncated elapsed time of job */
+static void _job_rec_suspended(slurmdb_job_rec_t *job, time_t local_start,
+			       time_t local_end)
+{
+	if (!local_start)
+		return;
+
+	if (job->start > local_start)
+		local_start = job->start;
+	if (job->end < local_end)
+		local_end = job->end;
+
+	if ((local_end - local_start) < 1)
+		return;
+
+	job->elapsed -= (local_end - local_start);
+	job->suspended += (local_end - local_start);
+}
+
+/* Make a step record of job out of a row of step_req_inx */
+static void _step_rec_from_row(slurmdb_job_rec_t *job, char **step_row,
+			       bool job_ended, slurmdb_job_cond_t *job_cond,
+			       time_t now)
+{
+	slurmdb_step_rec_t *step = slurmdb_create_step_rec();
+
+	step->tot_cpu_sec = 0;
+	step->tot_cpu_usec = 0;
+	step->job_ptr = job;
+	if (!job->first_step_ptr)
+		job->first_step_ptr = step;
+	list_append(job->steps, step);
+	step->step_id.job_id = job->jobid;
+	step->step_id.step_id = slurm_atoul(step_row[STEP_REQ_STEPID]);
+	step->step_id.step_het_comp =
+		slurm_atoul(step_row[STEP_REQ_STEP_HET_COMP]);
+	/* info("got %ps", &step->step_id); */
+	step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
+	step->exitcode = slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
+	step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
+
+	step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
+	step->task_dist = slurm_atoul(step_row[STEP_REQ_TASKDIST]);
+
+	step->start = slurm_atoul(step_row[STEP_REQ_START]);
+
+	step->end = slurm_atoul(step_row[STEP_REQ_END]);
+	/* if the job has ended end the step also */
+	if (!step->end && job_ended) {
+		step->end = job->end;
+		step->state = job->state;
+	}
+
+	if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC)
+	    && job_cond->usage_start) {
+		if (step->start && (step->start < job_cond->usage_start))
+			step->start = job_cond->usage_start;
+
+		if (!step->start && step->end)
+			step->start = step->end;
+
+		if (!step->end || (step->end > job_cond->usage_end))
+			step->end = job_cond->usage_end;
+
+		if (step->start && step->end && (step->start > step->end))
+			step->start = step->end = 0;
+	}
+
+	/* figure this out by start stop */
+	step->suspended = slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
+
+	/* fix the suspended number to be correct */
+	if (step->state == JOB_SUSPENDED)
+		step->suspended = now - step->suspended;
+	if (!step->start) {
+		step->elapsed = 0;
+	} else if (!step->end) {
+		step->elapsed = now - step->start;
+	} else {
+		step->elapsed = step->end - step->start;
+	}
+	step->elapsed -= step->suspended;
+
+	if ((int)step->elapsed < 0)
+		step->elapsed = 0;
+
+	step->req_cpufreq_min = slurm_atoul(step_row[STEP_REQ_REQ_CPUFREQ_MIN]);
+	step->req_cpufreq_max = slurm_atoul(step_row[STEP_REQ_REQ_CPUFREQ_MAX]);
+	step->req_cpufreq_gov =	slurm_atoul(step_row[STEP_REQ_REQ_CPUFREQ_GOV]);
+
+	step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
+	step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
+	if (!step_row[STEP_REQ_KILL_REQUID])
+		step->requid = INFINITE;
+	else
+		step->requid = slurm_atoul(step_row[STEP_REQ_KILL_REQUID]);
+
+	step->submit_line = xstrdup(step_row[STEP_REQ_SUBMIT_LINE]);
+
+	step->user_cpu_sec = slurm_atoull(step_row[STEP_REQ_USER_SEC]);
+	step->user_cpu_usec = slurm_atoul(step_row[STEP_REQ_USER_USEC]);
+	step->sys_cpu_sec =slurm_atoull(step_row[STEP_REQ_SYS_SEC]);
+	step->sys_cpu_usec = slurm_atoul(step_row[STEP_REQ_SYS_USEC]);
+	step->tot_cpu_sec += step->user_cpu_sec + step->sys_cpu_sec;
+	step->tot_cpu_usec += step->user_cpu_usec + step->sys_cpu_usec;
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX])
+		step->stats.tres_usage_in_max =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID])
+		step->stats.tres_usage_in_max_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID])
+		step->stats.tres_usage_in_max_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_AVE])
+		step->stats.tres_usage_in_ave =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_AVE]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN])
+		step->stats.tres_usage_in_min =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID])
+		step->stats.tres_usage_in_min_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID])
+		step->stats.tres_usage_in_min_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_IN_TOT])
+		step->stats.tres_usage_in_tot =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_TOT]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX])
+		step->stats.tres_usage_out_max =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID])
+		step->stats.tres_usage_out_max_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID])
+		step->stats.tres_usage_out_max_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_AVE])
+		step->stats.tres_usage_out_ave =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_AVE]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN])
+		step->stats.tres_usage_out_min =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID])
+		step->stats.tres_usage_out_min_taskid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID])
+		step->stats.tres_usage_out_min_nodeid =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID]);
+	if (step_row[STEP_REQ_TRES_USAGE_OUT_TOT])
+		step->stats.tres_usage_out_tot =
+			xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_TOT]);
+	step->stats.act_cpufreq = atof(step_row[STEP_REQ_ACT_CPUFREQ]);
+	step->stats.consumed_energy =
+		slurm_atoull(step_row[STEP_REQ_CONSUMED_ENERGY]);
+	step->container = xstrdup(step_row[STEP_REQ_CONTAINER]);
+
+	if (step_row[STEP_REQ_TRES])
+		step->tres_alloc_str = xstrdup(step_row[STEP_REQ_TRES]);
+}
+
+/* Add a job of the job cache the same way _cluster_get_jobs() adds a row */
+static int _add_cached_job(job_cache_rec_t *rec, void *arg)
+{
+	local_job_cache_t *cache = arg;
+	slurmdb_job_cond_t *job_cond = cache->job_cond;
+	slurmdb_job_rec_t *job;
+	ListIterator itr;
+	char **step_row;
+	int curr_id = rec->job_id;
+
+	if (!(job_cond->flags & JOBCOND_FLAG_DUP) &&
+	    (curr_id == cache->last_id) &&
+	    (slurm_atoul(rec->job_row[JOB_REQ_STATE]) != JOB_RESIZING))
+		return SLURM_SUCCESS;
+
+	if (cache->stream && (curr_id != cache->last_id) &&
+	    (list_count(cache->job_list) >= JOB_STREAM_CHUNK_SIZE) &&
+	    (_stream_jobs(cache->stream, cache->job_list) != SLURM_SUCCESS))
+		return cache->stream->rc;
+
+	job = _job_rec_from_row(rec->job_row, cache->cluster_name, job_cond,
+				cache->now);
+	if (curr_id == cache->last_id)
+		list_prepend(cache->job_list, job);
+	else
+		list_append(cache->job_list, job);
+	cache->last_id = curr_id;
+
+	if (!(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) &&
+	    rec->job_row[JOB_REQ_SUSPENDED]) {
+		for (int i = 0; i < rec->suspend_cnt; i++) {
+			time_t start = rec->suspend[i * 2];
+			time_t end = rec->suspend[(i * 2) + 1];
+
+			/* Same periods the suspend_table query would find */
+			if ((start >= job_cond->usage_end) ||
+			    (end && (end < job_cond->usage_start)))
+				continue;
+			_job_rec_suspended(job, start, end);
+		}
+	}
+
+	if ((int)job->elapsed < 0)
+		job->elapsed = 0;
+
+	if (cache->only_pending || (job_cond->flags & JOBCOND_FLAG_NO_STEP))
+		return SLURM_SUCCESS;
+
+	itr = list_iterator_create(rec->step_rows);
+	while ((step_row = list_next(itr))) {
+		time_t start = slurm_atoul(step_row[STEP_REQ_START]);
+		time_t end = slurm_atoul(step_row[STEP_REQ_END]);
+
+		if ((start > job_cond->usage_end) ||
+		    (end && (end < job_cond->usage_start)))
+			continue;
+		_step_rec_from_row(job, step_row, rec->end, job_cond,
+				   cache->now);
+	}
+	list_iterator_destroy(itr);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Get the jobs of one cluster. They are either added to sent_list or, if
+ * stream is set, handed to its callback in chunks as they are read.
+ */
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
 			     char *cluster_name,
 			     char *job_fields, char *step_fields,
 			     char *sent_extra,
-			     bool is_admin, int only_pending, List sent_list)
+			     bool is_admin, int only_pending, List sent_list,
+			     local_job_stream_t *stream)
 {
 	char *query = NULL;
-	char *extra = xstrdup(sent_extra);
+	char *extra = NULL;
 	slurm_selected_step_t *selected_step = NULL;
 	MYSQL_RES *result = NULL, *step_result = NULL;
 	MYSQL_ROW row, step_row;
 	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
 	time_t now = time(NULL);
 	List job_list = list_create(slurmdb_destroy_job_rec);
 	ListIterator itr = NULL, itr2 = NULL;
@@ -493,6 +833,30 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	int last_id = -1, curr_id = -1;
 	local_cluster_t *curr_cluster = NULL;
 
+	/*
+	 * Recent jobs may come out of the job cache, but only when all of
+	 * them may be seen as the association check below needs the database.
+	 */
+	if (is_admin || !(slurm_conf.private_data & PRIVATE_DATA_JOBS)) {
+		local_job_cache_t cache = {
+			.cluster_name = cluster_name,
+			.job_cond = job_cond,
+			.job_list = job_list,
+			.last_id = -1,
+			.now = now,
+			.only_pending = only_pending,
+			.stream = stream,
+		};
+
+		if ((rc = as_mysql_job_cache_for_each(
+			     cluster_name, job_cond, _add_cached_job, &cache))
+		    != ESLURM_NOT_SUPPORTED)
+			goto end_it;
+		rc = SLURM_SUCCESS;
+	}
+
+	extra = xstrdup(sent_extra);
+
 	/* This is here to make sure we are looking at only this user
 	 * if this flag is set.  We also include any accounts they may be
 	 * coordinator of.
@@ -564,23 +928,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	setup_job_cluster_cond_limits(mysql_conn, job_cond,
 				      cluster_name, &extra);
 
-	query = xstrdup_printf("select %s from \"%s_%s\" as t1 "
-			       "left join \"%s_%s\" as t2 "
-			       "on t1.id_assoc=t2.id_assoc "
-			       "left join \"%s_%s\" as t3 "
-			       "on t1.id_resv=t3.id_resv && "
-			       "((t1.time_start && "
-			       "(t3.time_start < t1.time_start && "
-			       "(t3.time_end >= t1.time_start || "
-			       "t3.time_end = 0))) || "
-			       "(t1.time_start = 0 && "
-			       "((t3.time_start < t1.time_submit && "
-			       "(t3.time_end >= t1.time_submit || "
-			       "t3.time_end = 0)) || "
-			       "(t3.time_start > t1.time_submit))))",
-			       job_fields, cluster_name, job_table,
-			       cluster_name, assoc_table,
-			       cluster_name, resv_table);
+	query = job_req_query(job_fields, cluster_name);
 
 	if (job_cond->flags & JOBCOND_FLAG_SCRIPT)
 		xstrfmtcat(query,
@@ -612,7 +960,15 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	xstrcat(query, " order by id_job, time_submit desc");
 
 	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+	/*
+	 * When streaming don't pull the whole result into memory, the other
+	 * queries below go over mysql_conn while the rows are being read.
+	 */
+	if (stream)
+		result = mysql_db_query_use(&stream->cursor_conn, query);
+	else
+		result = mysql_db_query_ret(mysql_conn, query, 0);
+	if (!result) {
 		xfree(query);
 		rc = SLURM_ERROR;
 		goto end_it;
@@ -638,7 +994,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 
 	while ((row = mysql_fetch_row(result))) {
 		char *db_inx_char = row[JOB_REQ_DB_INX];
-		bool job_ended = 0;
+		bool job_ended = slurm_atoul(row[JOB_REQ_END]);
 		int start = slurm_atoul(row[JOB_REQ_START]);
 
 		curr_id = slurm_atoul(row[JOB_REQ_JOBID]);
@@ -659,8 +1015,16 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			continue;
 		}
 
-		job = slurmdb_create_job_rec();
-		job->state = slurm_atoul(row[JOB_REQ_STATE]);
+		/*
+		 * Only hand back a chunk at a job id boundary, the records
+		 * of a resized job are ordered against each other here.
+		 */
+		if (stream && (curr_id != last_id) &&
+		    (list_count(job_list) >= JOB_STREAM_CHUNK_SIZE) &&
+		    ((rc = _stream_jobs(stream, job_list)) != SLURM_SUCCESS))
+			break;
+
+		job = _job_rec_from_row(row, cluster_name, job_cond, now);
 		if (curr_id == last_id)
 			/* put in reverse so we order by the submit getting
 			   larger which it is given to us in reverse
@@ -670,236 +1034,47 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			list_append(job_list, job);
 		last_id = curr_id;
 
-		job->alloc_nodes = slurm_atoul(row[JOB_REQ_ALLOC_NODES]);
-		job->associd = slurm_atoul(row[JOB_REQ_ASSOCID]);
-		job->array_job_id = slurm_atoul(row[JOB_REQ_ARRAYJOBID]);
-		job->array_task_id = slurm_atoul(row[JOB_REQ_ARRAYTASKID]);
-		job->het_job_id = slurm_atoul(row[JOB_REQ_HET_JOB_ID]);
-		job->het_job_offset = slurm_atoul(row[JOB_REQ_HET_JOB_OFFSET]);
-		job->resvid = slurm_atoul(row[JOB_REQ_RESVID]);
-
-		/* This shouldn't happen with new jobs, but older jobs
-		 * could of been added without a start and so the
-		 * array_task_id would be 0 instead of it's real value */
-		if (!job->array_job_id && !job->array_task_id)
-			job->array_task_id = NO_VAL;
-
-		/*
-		 * This shouldn't happen with new jobs.
-		 * If older jobs have het_job_id == 0 and het_job_offset == 0,
-		 * then correct het_job_offset to be NO_VAL.
-		 */
-		if (!job->het_job_id && !job->het_job_offset)
-			job->het_job_offset = NO_VAL;
-
-		if (row[JOB_REQ_RESV_NAME] && row[JOB_REQ_RESV_NAME][0])
-			job->resv_name = xstrdup(row[JOB_REQ_RESV_NAME]);
-
-		job->cluster = xstrdup(cluster_name);
-
-		/* we want a blank wckey if the name is null */
-		if (row[JOB_REQ_WCKEY])
-			job->wckey = xstrdup(row[JOB_REQ_WCKEY]);
-		else
-			job->wckey = xstrdup("");
-		job->wckeyid = slurm_atoul(row[JOB_REQ_WCKEYID]);
-		if (row[JOB_REQ_MCS_LABEL])
-			job->mcs_label = xstrdup(row[JOB_REQ_MCS_LABEL]);
-		else
-			job->mcs_label = xstrdup("");
-		if (row[JOB_REQ_USER_NAME])
-			job->user = xstrdup(row[JOB_REQ_USER_NAME]);
-
-		if (row[JOB_REQ_UID])
-			job->uid = slurm_atoul(row[JOB_REQ_UID]);
-
-		if (row[JOB_REQ_LFT])
-			job->lft = slurm_atoul(row[JOB_REQ_LFT]);
-
-		if (row[JOB_REQ_ACCOUNT] && row[JOB_REQ_ACCOUNT][0])
-			job->account = xstrdup(row[JOB_REQ_ACCOUNT]);
-		else if (row[JOB_REQ_ACCOUNT1] && row[JOB_REQ_ACCOUNT1][0])
-			job->account = xstrdup(row[JOB_REQ_ACCOUNT1]);
-
-		if (row[JOB_REQ_ARRAY_STR] && row[JOB_REQ_ARRAY_STR][0])
-			job->array_task_str = xstrdup(row[JOB_REQ_ARRAY_STR]);
-
-		if (row[JOB_REQ_ARRAY_MAX])
-			job->array_max_tasks =
-				slurm_atoul(row[JOB_REQ_ARRAY_MAX]);
-
-		if (row[JOB_REQ_BLOCKID])
-			job->blockid = xstrdup(row[JOB_REQ_BLOCKID]);
-
-		if (row[JOB_REQ_WORK_DIR])
-			job->work_dir = xstrdup(row[JOB_REQ_WORK_DIR]);
-
-		job->eligible = slurm_atoul(row[JOB_REQ_ELIGIBLE]);
-		job->submit = slurm_atoul(row[JOB_REQ_SUBMIT]);
-		job->start = start;
-		job->end = slurm_atoul(row[JOB_REQ_END]);
-		job->timelimit = slurm_atoul(row[JOB_REQ_TIMELIMIT]);
-
-		job->script = xstrdup(row[JOB_REQ_SCRIPT]);
-
-		job->env = xstrdup(row[JOB_REQ_ENV]);
-
-		job->submit_line = xstrdup(row[JOB_REQ_SUBMIT_LINE]);
-
-		/* since the job->end could be set later end it here */
-		if (job->end) {
-			job_ended = 1;
-			if (job->start > job->end)
-				job->start = job->end;
-		}
-
-		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) ){
-
-			if (!job_cond->usage_end ||
-			    (job_cond->usage_end > now)) {
-				job_cond->usage_end = now;
-			}
-
-			if (job->start && (job->start < job_cond->usage_start))
-				job->start = job_cond->usage_start;
-
-			if (!job->end || job->end > job_cond->usage_end)
-				job->end = job_cond->usage_end;
-
-			if (!job->start)
-				job->start = job->end;
-
-			job->elapsed = job->end - job->start;
-
-			if (row[JOB_REQ_SUSPENDED]) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
-				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select time_start, time_end from "
-					"\"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					cluster_name, suspend_table,
-					job_cond->usage_end,
-					job_cond->usage_start,
-					db_inx_char);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					      mysql_conn,
-					      query, 0))) {
-					FREE_NULL_LIST(job_list);
-					job_list = NULL;
-					xfree(query);
-					break;
-				}
+		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) &&
+		    row[JOB_REQ_SUSPENDED]) {
+			MYSQL_RES *result2 = NULL;
+			MYSQL_ROW row2;
+			/* get the suspended time for this job */
+			query = xstrdup_printf(
+				"select time_start, time_end from "
+				"\"%s_%s\" where "
+				"(time_start < %ld && (time_end >= %ld "
+				"|| time_end = 0)) && job_db_inx=%s "
+				"order by time_start",
+				cluster_name, suspend_table,
+				job_cond->usage_end,
+				job_cond->usage_start,
+				db_inx_char);
+
+			debug4("%d(%s:%d) query\n%s",
+			       mysql_conn->conn, THIS_FILE,
+			       __LINE__, query);
+			if (!(result2 = mysql_db_query_ret(
+				      mysql_conn,
+				      query, 0))) {
 				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
-					time_t local_start =
-						slurm_atoul(row2[0]);
-					time_t local_end =
-						slurm_atoul(row2[1]);
-
-					if (!local_start)
-						continue;
-
-					if (job->start > local_start)
-						local_start = job->start;
-					if (job->end < local_end)
-						local_end = job->end;
-
-					if ((local_end - local_start) < 1)
-						continue;
-
-					job->elapsed -=
-						(local_end - local_start);
-					job->suspended +=
-						(local_end - local_start);
-				}
-				mysql_free_result(result2);
-
-			}
-		} else {
-			job->suspended = slurm_atoul(row[JOB_REQ_SUSPENDED]);
-
-			/* fix the suspended number to be correct */
-			if (job->state == JOB_SUSPENDED)
-				job->suspended = now - job->suspended;
-			if (!job->start) {
-				job->elapsed = 0;
-			} else if (!job->end) {
-				job->elapsed = now - job->start;
-			} else {
-				job->elapsed = job->end - job->start;
+				rc = SLURM_ERROR;
+				break;
 			}
-
-			job->elapsed -= job->suspended;
+			xfree(query);
+			while ((row2 = mysql_fetch_row(result2)))
+				_job_rec_suspended(job, slurm_atoul(row2[0]),
+						   slurm_atoul(row2[1]));
+			mysql_free_result(result2);
 		}
 
 		if ((int)job->elapsed < 0)
 			job->elapsed = 0;
 
-		job->db_index = slurm_atoull(db_inx_char);
-		job->jobid = curr_id;
-		job->jobname = xstrdup(row[JOB_REQ_NAME]);
-		job->gid = slurm_atoul(row[JOB_REQ_GID]);
-		job->exitcode = slurm_atoul(row[JOB_REQ_EXIT_CODE]);
-		job->failed_node = xstrdup(row[JOB_REQ_FAILED_NODE]);
-		job->derived_ec = slurm_atoul(row[JOB_REQ_DERIVED_EC]);
-		job->derived_es = xstrdup(row[JOB_REQ_DERIVED_ES]);
-		job->admin_comment = xstrdup(row[JOB_REQ_ADMIN_COMMENT]);
-		job->system_comment = xstrdup(row[JOB_REQ_SYSTEM_COMMENT]);
-		job->constraints = xstrdup(row[JOB_REQ_CONSTRAINTS]);
-		job->container = xstrdup(row[JOB_REQ_CONTAINER]);
-		job->extra = xstrdup(row[JOB_REQ_EXTRA]);
-		job->licenses = xstrdup(row[JOB_REQ_LICENSES]);
-		job->flags = slurm_atoul(row[JOB_REQ_FLAGS]);
-
-		/*
-		 * This tells us we never had a start time so the job was
-		 * canceled before it ran.
-		 */
-		if (!job->start && job->end &&
-		    (job->flags & SLURMDB_JOB_FLAG_START_R))
-			job->start = NO_VAL;
-
-		job->state_reason_prev = slurm_atoul(row[JOB_REQ_STATE_REASON]);
-
-		if (row[JOB_REQ_PARTITION])
-			job->partition = xstrdup(row[JOB_REQ_PARTITION]);
-
-		if (row[JOB_REQ_NODELIST])
-			job->nodes = xstrdup(row[JOB_REQ_NODELIST]);
-
-		if (!job->nodes || !xstrcmp(job->nodes, "(null)")) {
-			xfree(job->nodes);
-			job->nodes = xstrdup("(unknown)");
-		}
-
-		job->priority = slurm_atoul(row[JOB_REQ_PRIORITY]);
-		job->req_cpus = slurm_atoul(row[JOB_REQ_REQ_CPUS]);
-		job->req_mem = slurm_atoull(row[JOB_REQ_REQ_MEM]);
-		if (!row[JOB_REQ_KILL_REQUID])
-			job->requid = INFINITE;
-		else
-			job->requid = slurm_atoul(row[JOB_REQ_KILL_REQUID]);
-		job->qosid = slurm_atoul(row[JOB_REQ_QOS]);
-		job->show_full = 1;
-
-		if (row[JOB_REQ_TRESA])
-			job->tres_alloc_str = xstrdup(row[JOB_REQ_TRESA]);
-		if (row[JOB_REQ_TRESR])
-			job->tres_req_str = xstrdup(row[JOB_REQ_TRESR]);
-
 		if (only_pending ||
 		    (job_cond &&
 		     (job_cond->flags & (JOBCOND_FLAG_NO_STEP |
 					 JOBCOND_FLAG_RUNAWAY))))
-			goto skip_steps;
+			continue;
 
 		if (job_cond && job_cond->step_list
 		    && list_count(job_cond->step_list)) {
@@ -986,167 +1161,22 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 						 start))
 				continue;
 
-			step = slurmdb_create_step_rec();
-			step->tot_cpu_sec = 0;
-			step->tot_cpu_usec = 0;
-			step->job_ptr = job;
-			if (!job->first_step_ptr)
-				job->first_step_ptr = step;
-			list_append(job->steps, step);
-			step->step_id.job_id = job->jobid;
-			step->step_id.step_id = slurm_atoul(
-				step_row[STEP_REQ_STEPID]);
-			step->step_id.step_het_comp =
-				slurm_atoul(step_row[STEP_REQ_STEP_HET_COMP]);
-			/* info("got %ps", &step->step_id); */
-			step->state = slurm_atoul(step_row[STEP_REQ_STATE]);
-			step->exitcode =
-				slurm_atoul(step_row[STEP_REQ_EXIT_CODE]);
-			step->nnodes = slurm_atoul(step_row[STEP_REQ_NODES]);
-
-			step->ntasks = slurm_atoul(step_row[STEP_REQ_TASKS]);
-			step->task_dist =
-				slurm_atoul(step_row[STEP_REQ_TASKDIST]);
-
-			step->start = slurm_atoul(step_row[STEP_REQ_START]);
-
-			step->end = slurm_atoul(step_row[STEP_REQ_END]);
-			/* if the job has ended end the step also */
-			if (!step->end && job_ended) {
-				step->end = job->end;
-				step->state = job->state;
-			}
-
-			if (job_cond &&
-			    !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC)
-			    && job_cond->usage_start) {
-				if (step->start
-				    && (step->start < job_cond->usage_start))
-					step->start = job_cond->usage_start;
-
-				if (!step->start && step->end)
-					step->start = step->end;
-
-				if (!step->end
-				    || (step->end > job_cond->usage_end))
-					step->end = job_cond->usage_end;
-
-				if (step->start && step->end &&
-				   (step->start > step->end))
-					step->start = step->end = 0;
-			}
-
-			/* figure this out by start stop */
-			step->suspended =
-				slurm_atoul(step_row[STEP_REQ_SUSPENDED]);
-
-			/* fix the suspended number to be correct */
-			if (step->state == JOB_SUSPENDED)
-				step->suspended = now - step->suspended;
-			if (!step->start) {
-				step->elapsed = 0;
-			} else if (!step->end) {
-				step->elapsed = now - step->start;
-			} else {
-				step->elapsed = step->end - step->start;
-			}
-			step->elapsed -= step->suspended;
-
-			if ((int)step->elapsed < 0)
-				step->elapsed = 0;
-
-			step->req_cpufreq_min = slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_MIN]);
-			step->req_cpufreq_max = slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_MAX]);
-			step->req_cpufreq_gov =	slurm_atoul(
-				step_row[STEP_REQ_REQ_CPUFREQ_GOV]);
-
-			step->stepname = xstrdup(step_row[STEP_REQ_NAME]);
-			step->nodes = xstrdup(step_row[STEP_REQ_NODELIST]);
-			if (!step_row[STEP_REQ_KILL_REQUID])
-				step->requid = INFINITE;
-			else
-				step->requid = slurm_atoul(
-					step_row[STEP_REQ_KILL_REQUID]);
-
-			step->submit_line =
-				xstrdup(step_row[STEP_REQ_SUBMIT_LINE]);
-
-			step->user_cpu_sec = slurm_atoull(
-				step_row[STEP_REQ_USER_SEC]);
-			step->user_cpu_usec = slurm_atoul(
-				step_row[STEP_REQ_USER_USEC]);
-			step->sys_cpu_sec =slurm_atoull(
-				step_row[STEP_REQ_SYS_SEC]);
-			step->sys_cpu_usec = slurm_atoul(
-				step_row[STEP_REQ_SYS_USEC]);
-			step->tot_cpu_sec +=
-				step->user_cpu_sec + step->sys_cpu_sec;
-			step->tot_cpu_usec += step->user_cpu_usec +
-				step->sys_cpu_usec;
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX])
-				step->stats.tres_usage_in_max =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID])
-				step->stats.tres_usage_in_max_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID])
-				step->stats.tres_usage_in_max_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MAX_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_AVE])
-				step->stats.tres_usage_in_ave =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_AVE]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN])
-				step->stats.tres_usage_in_min =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID])
-				step->stats.tres_usage_in_min_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID])
-				step->stats.tres_usage_in_min_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_MIN_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_IN_TOT])
-				step->stats.tres_usage_in_tot =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_IN_TOT]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX])
-				step->stats.tres_usage_out_max =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID])
-				step->stats.tres_usage_out_max_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID])
-				step->stats.tres_usage_out_max_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MAX_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_AVE])
-				step->stats.tres_usage_out_ave =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_AVE]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN])
-				step->stats.tres_usage_out_min =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID])
-				step->stats.tres_usage_out_min_taskid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_TASKID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID])
-				step->stats.tres_usage_out_min_nodeid =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_MIN_NODEID]);
-			if (step_row[STEP_REQ_TRES_USAGE_OUT_TOT])
-				step->stats.tres_usage_out_tot =
-					xstrdup(step_row[STEP_REQ_TRES_USAGE_OUT_TOT]);
-			step->stats.act_cpufreq =
-				atof(step_row[STEP_REQ_ACT_CPUFREQ]);
-			step->stats.consumed_energy = slurm_atoull(
-				step_row[STEP_REQ_CONSUMED_ENERGY]);
-			step->container = xstrdup(step_row[STEP_REQ_CONTAINER]);
-
-			if (step_row[STEP_REQ_TRES])
-				step->tres_alloc_str =
-					xstrdup(step_row[STEP_REQ_TRES]);
+			_step_rec_from_row(job, step_row, job_ended, job_cond,
+					   now);
 		}
 		mysql_free_result(step_result);
-	skip_steps:
-		/* need to reset here to make the above test valid */
-		step = NULL;
+	}
+
+	/*
+	 * mysql_fetch_row() also returns NULL when a result read with
+	 * mysql_db_query_use() fails part way, don't end it as if complete.
+	 */
+	if (stream && (rc == SLURM_SUCCESS) &&
+	    mysql_errno(stream->cursor_conn.db_conn)) {
+		error("%s: Error reading jobs of cluster %s: %s",
+		      __func__, cluster_name,
+		      mysql_error(stream->cursor_conn.db_conn));
+		rc = SLURM_ERROR;
 	}
 	mysql_free_result(result);
 
@@ -1156,13 +1186,66 @@ end_it:
 
 	FREE_NULL_LIST(local_cluster_list);
 
-	if (rc == SLURM_SUCCESS)
-		list_transfer(sent_list, job_list);
+	if (rc == SLURM_SUCCESS) {
+		if (stream)
+			rc = _stream_jobs(stream, job_list);
+		else
+			list_transfer(sent_list, job_list);
+	}
 
 	FREE_NULL_LIST(job_list);
 	return rc;
 }
 
+extern char *job_req_fields(slurmdb_job_cond_t *job_cond)
+{
+	char *fields = xstrdup(job_req_inx[0]);
+
+	for (int i = 1; i < JOB_REQ_COUNT; i++) {
+		/* Only get the script if requesting it */
+		if (((i == JOB_REQ_SCRIPT) &&
+		     (!job_cond || !(job_cond->flags & JOBCOND_FLAG_SCRIPT))) ||
+		    ((i == JOB_REQ_ENV) &&
+		     (!job_cond || !(job_cond->flags & JOBCOND_FLAG_ENV))))
+			xstrcat(fields, ", ''");
+		else
+			xstrfmtcat(fields, ", %s", job_req_inx[i]);
+	}
+
+	return fields;
+}
+
+extern char *step_req_fields(void)
+{
+	char *fields = xstrdup(step_req_inx[0]);
+
+	for (int i = 1; i < STEP_REQ_COUNT; i++)
+		xstrfmtcat(fields, ", %s", step_req_inx[i]);
+
+	return fields;
+}
+
+extern char *job_req_query(char *job_fields, char *cluster_name)
+{
+	return xstrdup_printf("select %s from \"%s_%s\" as t1 "
+			      "left join \"%s_%s\" as t2 "
+			      "on t1.id_assoc=t2.id_assoc "
+			      "left join \"%s_%s\" as t3 "
+			      "on t1.id_resv=t3.id_resv && "
+			      "((t1.time_start && "
+			      "(t3.time_start < t1.time_start && "
+			      "(t3.time_end >= t1.time_start || "
+			      "t3.time_end = 0))) || "
+			      "(t1.time_start = 0 && "
+			      "((t3.time_start < t1.time_submit && "
+			      "(t3.time_end >= t1.time_submit || "
+			      "t3.time_end = 0)) || "
+			      "(t3.time_start > t1.time_submit))))",
+			      job_fields, cluster_name, job_table,
+			      cluster_name, assoc_table,
+			      cluster_name, resv_table);
+}
+
 extern List setup_cluster_list_with_inx(mysql_conn_t *mysql_conn,
 					slurmdb_job_cond_t *job_cond,
 					void **curr_cluster)
@@ -1725,23 +1808,65 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 	return set;
 }
 
-extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
-					      uid_t uid,
-					      slurmdb_job_cond_t *job_cond)
+/*
+ * Replace the name and coordinator accounts user points to in the assoc_mgr
+ * with copies, so no assoc_mgr lock has to be held while the jobs are read.
+ * A stream may block on its client for a long time.
+ */
+static void _copy_user_coords(mysql_conn_t *mysql_conn,
+			      slurmdb_user_rec_t *user)
+{
+	slurmdb_user_rec_t lookup = { .uid = user->uid };
+	slurmdb_user_rec_t *found_user = NULL;
+	slurmdb_coord_rec_t *coord, *coord_copy;
+	ListIterator itr;
+	assoc_mgr_lock_t locks = { .user = READ_LOCK };
+
+	user->name = NULL;
+	user->coord_accts = NULL;
+	user->assoc_list = NULL;
+	user->default_acct = NULL;
+	user->default_wckey = NULL;
+	user->wckey_list = NULL;
+
+	assoc_mgr_lock(&locks);
+	if (assoc_mgr_fill_in_user(mysql_conn, &lookup, 0, &found_user,
+				   true) || !found_user) {
+		assoc_mgr_unlock(&locks);
+		return;
+	}
+
+	user->name = xstrdup(found_user->name);
+	user->coord_accts = list_create(slurmdb_destroy_coord_rec);
+	itr = list_iterator_create(found_user->coord_accts);
+	while ((coord = list_next(itr))) {
+		coord_copy = xmalloc(sizeof(*coord_copy));
+		coord_copy->name = xstrdup(coord->name);
+		coord_copy->direct = coord->direct;
+		list_append(user->coord_accts, coord_copy);
+	}
+	list_iterator_destroy(itr);
+	assoc_mgr_unlock(&locks);
+}
+
+/*
+ * Get the jobs of every cluster asked for, adding them to job_list or handing
+ * them to stream.
+ */
+static int _get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
+		     slurmdb_job_cond_t *job_cond, List job_list,
+		     local_job_stream_t *stream)
 {
 	char *extra = NULL;
 	char *tmp = NULL, *tmp2 = NULL;
 	ListIterator itr = NULL;
 	int is_admin=1;
-	int i;
-	List job_list = NULL;
 	slurmdb_user_rec_t user;
 	int only_pending = 0;
 	List use_cluster_list = NULL;
 	char *cluster_name;
 	bool locked = false;
-	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-				   READ_LOCK, NO_LOCK, NO_LOCK };
+	bool copied_user = false;
 
 	memset(&user, 0, sizeof(slurmdb_user_rec_t));
 	user.uid = uid;
@@ -1764,7 +1889,7 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 		if (!is_admin && !user.name) {
 			debug("User %u has no associations, and is not admin, "
 			      "so not returning any jobs.", user.uid);
-			return NULL;
+			return SLURM_ERROR;
 		}
 	}
 
@@ -1786,30 +1911,14 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 		if (reason) {
 			error("User %u is requesting %s, but no job requested, this is not allowed",
 			      user.uid, reason);
-			return NULL;
+			return SLURM_ERROR;
 		}
 	}
 
 	setup_job_cond_limits(job_cond, &extra);
 
-	xfree(tmp);
-	xstrfmtcat(tmp, "%s", job_req_inx[0]);
-	for (i = 1; i < JOB_REQ_COUNT; i++) {
-		/* Only get the script if requesting it */
-		if (((i == JOB_REQ_SCRIPT) &&
-		     (!job_cond || !(job_cond->flags & JOBCOND_FLAG_SCRIPT))) ||
-		    ((i == JOB_REQ_ENV) &&
-		     (!job_cond || !(job_cond->flags & JOBCOND_FLAG_ENV))))
-			xstrcat(tmp, ", ''");
-		else
-			xstrfmtcat(tmp, ", %s", job_req_inx[i]);
-	}
-
-	xfree(tmp2);
-	xstrfmtcat(tmp2, "%s", step_req_inx[0]);
-	for (i = 1; i < STEP_REQ_COUNT; i++) {
-		xstrfmtcat(tmp2, ", %s", step_req_inx[i]);
-	}
+	tmp = job_req_fields(job_cond);
+	tmp2 = step_req_fields();
 
 	if (job_cond
 	    && job_cond->cluster_list && list_count(job_cond->cluster_list))
@@ -1820,23 +1929,41 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 		locked = true;
 	}
 
-	assoc_mgr_lock(&locks);
+	if (user.name) {
+		_copy_user_coords(mysql_conn, &user);
+		copied_user = true;
+		if (!user.name) {
+			debug("User %u has no associations, and is not admin, "
+			      "so not returning any jobs.", user.uid);
+			goto end_it;
+		}
+	}
 
-	job_list = list_create(slurmdb_destroy_job_rec);
 	itr = list_iterator_create(use_cluster_list);
 	while ((cluster_name = list_next(itr))) {
 		int rc;
 		_setup_job_cond_selected_steps(job_cond, cluster_name, &extra);
 		if ((rc = _cluster_get_jobs(mysql_conn, &user, job_cond,
 					    cluster_name, tmp, tmp2, extra,
-					    is_admin, only_pending, job_list))
+					    is_admin, only_pending, job_list,
+					    stream))
 		    != SLURM_SUCCESS)
 			error("Problem getting jobs for cluster %s",
 			      cluster_name);
+		/* A stream can't leave out a cluster without telling */
+		if (stream && (stream->rc == SLURM_SUCCESS))
+			stream->rc = rc;
+		/* Whoever is reading the stream has given up */
+		if (stream && (stream->rc != SLURM_SUCCESS))
+			break;
 	}
 	list_iterator_destroy(itr);
 
-	assoc_mgr_unlock(&locks);
+end_it:
+	if (copied_user) {
+		xfree(user.name);
+		FREE_NULL_LIST(user.coord_accts);
+	}
 
 	if (locked) {
 		FREE_NULL_LIST(use_cluster_list);
@@ -1847,5 +1974,52 @@ extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
 	xfree(tmp2);
 	xfree(extra);
 
+	return stream ? stream->rc : SLURM_SUCCESS;
+}
+
+extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
+					      uid_t uid,
+					      slurmdb_job_cond_t *job_cond)
+{
+	List job_list = list_create(slurmdb_destroy_job_rec);
+
+	if (_get_jobs(mysql_conn, uid, job_cond, job_list, NULL) !=
+	    SLURM_SUCCESS)
+		FREE_NULL_LIST(job_list);
+
 	return job_list;
 }
+
+extern int as_mysql_jobacct_process_get_jobs_stream(
+	mysql_conn_t *mysql_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_stream_cb_t callback, void *arg)
+{
+	local_job_stream_t stream;
+	int rc;
+
+	memset(&stream, 0, sizeof(local_job_stream_t));
+	stream.callback = callback;
+	stream.arg = arg;
+
+	/*
+	 * The job query is read off its own connection so the step and
+	 * suspend queries of each job can still use mysql_conn.
+	 */
+	stream.cursor_conn.conn = mysql_conn->conn;
+	/* Read from the same server as mysql_conn, a replica if it is one */
+	stream.cursor_conn.flags = mysql_conn->flags & DB_CONN_FLAG_REPLICA;
+	slurm_mutex_init(&stream.cursor_conn.lock);
+
+	if ((rc = check_connection(&stream.cursor_conn)) == SLURM_SUCCESS)
+		rc = _get_jobs(mysql_conn, uid, job_cond, NULL, &stream);
+
+	/*
+	 * Not mysql_db_close_db_connection(), this thread is still using
+	 * mysql_conn.
+	 */
+	if (stream.cursor_conn.db_conn)
+		mysql_close(stream.cursor_conn.db_conn);
+	slurm_mutex_destroy(&stream.cursor_conn.lock);
+
+	return rc;
+}
@@ -45,6 +45,134 @@
 
 #include "accounting_storage_mysql.h"
 
+/* Columns of job_req_inx, t1 is job_table */
+enum {
+	JOB_REQ_ACCOUNT1,
+	JOB_REQ_ADMIN_COMMENT,
+	JOB_REQ_ARRAY_MAX,
+	JOB_REQ_ARRAY_STR,
+	JOB_REQ_CONSTRAINTS,
+	JOB_REQ_CONTAINER,
+	JOB_REQ_REQ_CPUS,
+	JOB_REQ_DERIVED_EC,
+	JOB_REQ_DERIVED_ES,
+	JOB_REQ_EXIT_CODE,
+	JOB_REQ_EXTRA,
+	JOB_REQ_FAILED_NODE,
+	JOB_REQ_FLAGS,
+	JOB_REQ_ARRAYJOBID,
+	JOB_REQ_ARRAYTASKID,
+	JOB_REQ_ASSOCID,
+	JOB_REQ_BLOCKID,
+	JOB_REQ_GID,
+	JOB_REQ_JOBID,
+	JOB_REQ_HET_JOB_ID,
+	JOB_REQ_HET_JOB_OFFSET,
+	JOB_REQ_QOS,
+	JOB_REQ_RESVID,
+	JOB_REQ_RESV_NAME,
+	JOB_REQ_UID,
+	JOB_REQ_WCKEYID,
+	JOB_REQ_DB_INX,
+	JOB_REQ_NAME,
+	JOB_REQ_KILL_REQUID,
+	JOB_REQ_LICENSES,
+	JOB_REQ_REQ_MEM,
+	JOB_REQ_NODE_INX,
+	JOB_REQ_NODELIST,
+	JOB_REQ_ALLOC_NODES,
+	JOB_REQ_PARTITION,
+	JOB_REQ_PRIORITY,
+	JOB_REQ_STATE,
+	JOB_REQ_STATE_REASON,
+	JOB_REQ_SYSTEM_COMMENT,
+	JOB_REQ_ELIGIBLE,
+	JOB_REQ_END,
+	JOB_REQ_START,
+	JOB_REQ_SUBMIT,
+	JOB_REQ_SUSPENDED,
+	JOB_REQ_TIMELIMIT,
+	JOB_REQ_WCKEY,
+	JOB_REQ_GRES_USED,
+	JOB_REQ_TRESA,
+	JOB_REQ_TRESR,
+	JOB_REQ_WORK_DIR,
+	JOB_REQ_MCS_LABEL,
+	JOB_REQ_SCRIPT,
+	JOB_REQ_SUBMIT_LINE,
+	JOB_REQ_ENV,
+	JOB_REQ_ACCOUNT,
+	JOB_REQ_LFT,
+	JOB_REQ_USER_NAME,
+	JOB_REQ_COUNT
+};
+
+/* Columns of step_req_inx, t1 is step_table */
+enum {
+	STEP_REQ_STEPID,
+	STEP_REQ_STEP_HET_COMP,
+	STEP_REQ_START,
+	STEP_REQ_END,
+	STEP_REQ_SUSPENDED,
+	STEP_REQ_NAME,
+	STEP_REQ_NODELIST,
+	STEP_REQ_NODE_INX,
+	STEP_REQ_STATE,
+	STEP_REQ_KILL_REQUID,
+	STEP_REQ_EXIT_CODE,
+	STEP_REQ_NODES,
+	STEP_REQ_TASKS,
+	STEP_REQ_TASKDIST,
+	STEP_REQ_USER_SEC,
+	STEP_REQ_USER_USEC,
+	STEP_REQ_SYS_SEC,
+	STEP_REQ_SYS_USEC,
+	STEP_REQ_ACT_CPUFREQ,
+	STEP_REQ_CONSUMED_ENERGY,
+	STEP_REQ_CONTAINER,
+	STEP_REQ_REQ_CPUFREQ_MIN,
+	STEP_REQ_REQ_CPUFREQ_MAX,
+	STEP_REQ_REQ_CPUFREQ_GOV,
+	STEP_REQ_SUBMIT_LINE,
+	STEP_REQ_TRES,
+	STEP_REQ_TRES_USAGE_IN_MAX,
+	STEP_REQ_TRES_USAGE_IN_MAX_TASKID,
+	STEP_REQ_TRES_USAGE_IN_MAX_NODEID,
+	STEP_REQ_TRES_USAGE_IN_AVE,
+	STEP_REQ_TRES_USAGE_IN_MIN,
+	STEP_REQ_TRES_USAGE_IN_MIN_TASKID,
+	STEP_REQ_TRES_USAGE_IN_MIN_NODEID,
+	STEP_REQ_TRES_USAGE_IN_TOT,
+	STEP_REQ_TRES_USAGE_OUT_MAX,
+	STEP_REQ_TRES_USAGE_OUT_MAX_TASKID,
+	STEP_REQ_TRES_USAGE_OUT_MAX_NODEID,
+	STEP_REQ_TRES_USAGE_OUT_AVE,
+	STEP_REQ_TRES_USAGE_OUT_MIN,
+	STEP_REQ_TRES_USAGE_OUT_MIN_TASKID,
+	STEP_REQ_TRES_USAGE_OUT_MIN_NODEID,
+	STEP_REQ_TRES_USAGE_OUT_TOT,
+	STEP_REQ_COUNT
+};
+
+extern char *job_req_inx[];
+extern char *step_req_inx[];
+
+/*
+ * Comma separated job_req_inx columns to select, the batch script and
+ * environment are only read if job_cond asks for them.
+ */
+extern char *job_req_fields(slurmdb_job_cond_t *job_cond);
+
+/* Comma separated step_req_inx columns to select */
+extern char *step_req_fields(void);
+
+/*
+ * Select job_fields from the job table of cluster_name (t1) joined with the
+ * association (t2) and reservation (t3) of each job. Conditions are appended
+ * by the caller.
+ */
+extern char *job_req_query(char *job_fields, char *cluster_name);
+
 extern List setup_cluster_list_with_inx(mysql_conn_t *mysql_conn,
 					slurmdb_job_cond_t *job_cond,
 					void **curr_cluster);
@@ -60,4 +188,12 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
 					   slurmdb_job_cond_t *job_cond);
 
+/*
+ * Same as as_mysql_jobacct_process_get_jobs() but the jobs are handed to
+ * callback a chunk at a time as they are read from the database.
+ */
+extern int as_mysql_jobacct_process_get_jobs_stream(
+	mysql_conn_t *mysql_conn, uid_t uid, slurmdb_job_cond_t *job_cond,
+	slurmdb_job_stream_cb_t callback, void *arg);
+
 #endif
@@ -55,6 +55,17 @@ enum {
 	WCKEY_TABLES
 };
 
+/*
+ * Hours rolled up by one thread are never fewer than this, smaller ranges are
+ * not worth an extra database connection.
+ */
+#define ROLLUP_MIN_SLICE_HOURS 12
+
+/*
+ * TRES usage is kept in arrays with one local_tres_usage_t per TRES in the
+ * tres_table, at the position given by local_tres_index_t. An id of 0 means
+ * that TRES has not been set in the array.
+ */
 typedef struct {
 	uint64_t count;
 	uint32_t id;
@@ -67,15 +78,28 @@ typedef struct {
 	uint64_t total_time;
 } local_tres_usage_t;
 
+typedef struct {
+	uint32_t cnt;		/* TRES in the tres_table */
+	uint32_t max_id;	/* highest TRES id in the tres_table */
+	int *pos;		/* array position indexed by TRES id, -1 if none */
+} local_tres_index_t;
+
 typedef struct {
 	int id;
-	List loc_tres;
+	local_tres_usage_t *loc_tres;
 } local_id_usage_t;
 
+/* Associations or wckeys with usage in the current hour */
+typedef struct {
+	List list;			/* local_id_usage_t in order added */
+	uint32_t size;
+	local_id_usage_t **usage;	/* indexed by id */
+} local_id_index_t;
+
 typedef struct {
 	time_t end;
 	int id; /*only needed for reservations */
-	List loc_tres;
+	local_tres_usage_t *loc_tres;
 	time_t start;
 } local_cluster_usage_t;
 
@@ -86,25 +110,48 @@ typedef struct {
 	hostlist_t hl;
 	List local_assocs; /* list of assocs to spread unused time
 			      over of type local_id_usage_t */
-	List loc_tres;
+	local_tres_usage_t *loc_tres;
 	time_t orig_start;
+	int resv_seconds;
 	time_t start;
+	double unused_start; /* unused_wall before this hour */
 	double unused_wall;
+	double used_wall; /* wall seconds used by jobs, before clamping */
 } local_resv_usage_t;
 
-static void _destroy_local_tres_usage(void *object)
-{
-	local_tres_usage_t *a_usage = (local_tres_usage_t *)object;
-	if (a_usage) {
-		xfree(a_usage);
-	}
-}
+/*
+ * Unused wall time of a reservation in one hour. The unused_wall of an hour
+ * depends on the one of the hour before, so the slices only record this and
+ * it is added up in hour order once all slices are done.
+ */
+typedef struct {
+	int id;
+	time_t orig_start;
+	bool reset;		/* reservation started in this hour */
+	int resv_seconds;	/* seconds of the reservation in this hour */
+	double unused_wall;	/* unused_wall at the start of this hour */
+	double used_wall;	/* wall seconds used by jobs in this hour */
+} local_resv_unused_t;
+
+/* A range of hours rolled up on its own database connection */
+typedef struct {
+	char *cluster_name;
+	int conn;		/* conn number of the parent connection */
+	int dims;
+	time_t end;
+	time_t now;
+	int rc;
+	List resv_unused;	/* local_resv_unused_t in hour order */
+	time_t start;
+	local_tres_index_t *tres_idx;
+	uint16_t track_wckey;
+} local_hour_slice_t;
 
 static void _destroy_local_id_usage(void *object)
 {
 	local_id_usage_t *a_usage = (local_id_usage_t *)object;
 	if (a_usage) {
-		FREE_NULL_LIST(a_usage->loc_tres);
+		xfree(a_usage->loc_tres);
 		xfree(a_usage);
 	}
 }
@@ -113,7 +160,7 @@ static void _destroy_local_cluster_usage(void *object)
 {
 	local_cluster_usage_t *c_usage = (local_cluster_usage_t *)object;
 	if (c_usage) {
-		FREE_NULL_LIST(c_usage->loc_tres);
+		xfree(c_usage->loc_tres);
 		xfree(c_usage);
 	}
 }
@@ -124,59 +171,159 @@ static void _destroy_local_resv_usage(void *object)
 	if (r_usage) {
 		FREE_NULL_HOSTLIST(r_usage->hl);
 		FREE_NULL_LIST(r_usage->local_assocs);
-		FREE_NULL_LIST(r_usage->loc_tres);
+		xfree(r_usage->loc_tres);
 		xfree(r_usage);
 	}
 }
 
-static int _find_loc_tres(void *x, void *key)
+static int _find_resv_unused(void *x, void *key)
 {
-	local_tres_usage_t *loc_tres = (local_tres_usage_t *)x;
-	uint32_t tres_id = *(uint32_t *)key;
+	local_resv_unused_t *resv_unused = (local_resv_unused_t *)x;
+	local_resv_unused_t *key_unused = (local_resv_unused_t *)key;
 
-	if (loc_tres->id == tres_id)
+	if ((resv_unused->id == key_unused->id) &&
+	    (resv_unused->orig_start == key_unused->orig_start))
 		return 1;
 	return 0;
 }
 
-static int _find_id_usage(void *x, void *key)
+static int _setup_tres_index(mysql_conn_t *mysql_conn,
+			     local_tres_index_t *tres_idx)
 {
-	local_id_usage_t *loc = (local_id_usage_t *)x;
-	uint32_t id = *(uint32_t *)key;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	char *query;
+	uint32_t id;
 
-	if (loc->id == id)
-		return 1;
-	return 0;
+	memset(tres_idx, 0, sizeof(*tres_idx));
+
+	query = xstrdup_printf("select id from %s order by id", tres_table);
+	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		id = slurm_atoul(row[0]);
+		if (!tres_idx->pos || (id > tres_idx->max_id)) {
+			uint32_t old_cnt =
+				tres_idx->pos ? (tres_idx->max_id + 1) : 0;
+
+			xrecalloc(tres_idx->pos, id + 1, sizeof(int));
+			memset(tres_idx->pos + old_cnt, -1,
+			       (id + 1 - old_cnt) * sizeof(int));
+			tres_idx->max_id = id;
+		}
+		tres_idx->pos[id] = tres_idx->cnt++;
+	}
+	mysql_free_result(result);
+
+	if (!tres_idx->pos) {
+		tres_idx->pos = xcalloc(1, sizeof(int));
+		tres_idx->pos[0] = -1;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static local_tres_usage_t *_create_loc_tres(local_tres_index_t *tres_idx)
+{
+	return xcalloc(MAX(tres_idx->cnt, 1), sizeof(local_tres_usage_t));
+}
+
+static void _clear_loc_tres(local_tres_index_t *tres_idx,
+			    local_tres_usage_t *loc_tres)
+{
+	memset(loc_tres, 0, MAX(tres_idx->cnt, 1) * sizeof(local_tres_usage_t));
 }
 
-static void _remove_job_tres_time_from_cluster(List c_tres, List j_tres,
+/* Return the TRES with this id in the array, set it first if add is true */
+static local_tres_usage_t *_find_loc_tres(local_tres_index_t *tres_idx,
+					  local_tres_usage_t *loc_tres,
+					  uint32_t id, bool add)
+{
+	int pos;
+
+	if ((id > tres_idx->max_id) || ((pos = tres_idx->pos[id]) < 0)) {
+		if (add)
+			error("%s: TRES id %u is not in the %s",
+			      __func__, id, tres_table);
+		return NULL;
+	}
+
+	if (!loc_tres[pos].id) {
+		if (!add)
+			return NULL;
+		loc_tres[pos].id = id;
+	}
+
+	return &loc_tres[pos];
+}
+
+static local_id_usage_t *_find_id_usage(local_id_index_t *id_idx,
+					uint32_t id, bool add)
+{
+	local_id_usage_t *usage;
+
+	if (id >= id_idx->size) {
+		uint32_t new_size;
+
+		if (!add)
+			return NULL;
+
+		new_size = MAX(id + 1, id_idx->size * 2);
+		xrecalloc(id_idx->usage, new_size, sizeof(local_id_usage_t *));
+		id_idx->size = new_size;
+	}
+
+	if (!(usage = id_idx->usage[id]) && add) {
+		usage = xmalloc(sizeof(local_id_usage_t));
+		usage->id = id;
+		list_append(id_idx->list, usage);
+		id_idx->usage[id] = usage;
+	}
+
+	return usage;
+}
+
+static void _flush_id_index(local_id_index_t *id_idx)
+{
+	local_id_usage_t *usage;
+	ListIterator itr = list_iterator_create(id_idx->list);
+
+	while ((usage = list_next(itr)))
+		id_idx->usage[usage->id] = NULL;
+	list_iterator_destroy(itr);
+	list_flush(id_idx->list);
+}
+
+static void _remove_job_tres_time_from_cluster(local_tres_index_t *tres_idx,
+					       local_tres_usage_t *c_tres,
+					       local_tres_usage_t *j_tres,
 					       int seconds)
 {
-	ListIterator c_itr;
-	local_tres_usage_t *loc_c_tres, *loc_j_tres;
 	uint64_t time;
 
-	if ((seconds <= 0) || !c_tres || !j_tres ||
-	    !list_count(c_tres) || !list_count(j_tres))
+	if ((seconds <= 0) || !c_tres || !j_tres)
 		return;
 
-	c_itr = list_iterator_create(c_tres);
-	while ((loc_c_tres = list_next(c_itr))) {
-		if (!(loc_j_tres = list_find_first(
-			      j_tres, _find_loc_tres, &loc_c_tres->id)))
+	for (int i = 0; i < tres_idx->cnt; i++) {
+		if (!c_tres[i].id || !j_tres[i].id)
 			continue;
-		time = seconds * loc_j_tres->count;
+		time = seconds * j_tres[i].count;
 
-		if (time >= loc_c_tres->total_time)
-			loc_c_tres->total_time = 0;
+		if (time >= c_tres[i].total_time)
+			c_tres[i].total_time = 0;
 		else
-			loc_c_tres->total_time -= time;
+			c_tres[i].total_time -= time;
 	}
-	list_iterator_destroy(c_itr);
 }
 
 
-static local_tres_usage_t *_add_time_tres(List tres_list, int type, uint32_t id,
+static local_tres_usage_t *_add_time_tres(local_tres_index_t *tres_idx,
+					  local_tres_usage_t *tres_array,
+					  int type, uint32_t id,
 					  uint64_t time, bool times_count)
 {
 	local_tres_usage_t *loc_tres;
@@ -187,15 +334,9 @@ static local_tres_usage_t *_add_time_tres(List tres_list, int type, uint32_t id,
 	if (!time || (time == NO_VAL64))
 		return NULL;
 
-	loc_tres = list_find_first(tres_list, _find_loc_tres, &id);
-
-	if (!loc_tres) {
-		if (times_count)
-			return NULL;
-		loc_tres = xmalloc(sizeof(local_tres_usage_t));
-		loc_tres->id = id;
-		list_append(tres_list, loc_tres);
-	}
+	if (!(loc_tres = _find_loc_tres(tres_idx, tres_array, id,
+					!times_count)))
+		return NULL;
 
 	if (times_count) {
 		if (!loc_tres->count)
@@ -225,60 +366,52 @@ static local_tres_usage_t *_add_time_tres(List tres_list, int type, uint32_t id,
 	return loc_tres;
 }
 
-static void _add_time_tres_list(List tres_list_out, List tres_list_in, int type,
-				uint64_t time_in, bool times_count)
+static void _add_time_tres_loc(local_tres_index_t *tres_idx,
+			       local_tres_usage_t *tres_out,
+			       local_tres_usage_t *tres_in, int type,
+			       uint64_t time_in, bool times_count)
 {
-	ListIterator itr;
-	local_tres_usage_t *loc_tres;
+	xassert(tres_in);
+	xassert(tres_out);
 
-	xassert(tres_list_in);
-	xassert(tres_list_out);
-
-	itr = list_iterator_create(tres_list_in);
-	while ((loc_tres = list_next(itr)))
-		_add_time_tres(tres_list_out, type,
-			       loc_tres->id,
-			       time_in ? time_in : loc_tres->total_time,
+	for (int i = 0; i < tres_idx->cnt; i++) {
+		if (!tres_in[i].id)
+			continue;
+		_add_time_tres(tres_idx, tres_out, type, tres_in[i].id,
+			       time_in ? time_in : tres_in[i].total_time,
 			       times_count);
-	list_iterator_destroy(itr);
+	}
 }
 
 /*
  * Job usage is a ratio of its tres to the reservation's tres:
  * Unused wall = unused wall - job_seconds * job_tres / resv_tres
  */
-static int _update_unused_wall(local_resv_usage_t *r_usage, List job_tres,
+static int _update_unused_wall(local_tres_index_t *tres_idx,
+			       local_resv_usage_t *r_usage,
+			       local_tres_usage_t *job_tres,
 			       int job_seconds)
 {
-	ListIterator resv_itr;
-	local_tres_usage_t *loc_tres;
-	uint32_t resv_tres_id;
-	uint64_t resv_tres_count;
 	double tres_ratio = 0.0;
 
 	/* Get TRES counts. Make sure the TRES types match. */
-	resv_itr = list_iterator_create(r_usage->loc_tres);
-	while ((loc_tres = list_next(resv_itr))) {
+	for (int i = 0; i < tres_idx->cnt; i++) {
 		/* Avoid dividing by zero. */
-		if (!loc_tres->count)
+		if (!r_usage->loc_tres[i].id || !r_usage->loc_tres[i].count)
 			continue;
-		resv_tres_id = loc_tres->id;
-		resv_tres_count = loc_tres->count;
-		if ((loc_tres = list_find_first(job_tres,
-						_find_loc_tres,
-						&resv_tres_id))) {
-			tres_ratio = (double)loc_tres->count /
-				(double)resv_tres_count;
+		if (job_tres[i].id) {
+			tres_ratio = (double)job_tres[i].count /
+				(double)r_usage->loc_tres[i].count;
 			break;
 		}
 	}
-	list_iterator_destroy(resv_itr);
 
 	/*
 	 * Here we are converting TRES seconds to wall seconds.  This is needed
 	 * to determine how much time is actually idle in the reservation.
 	 */
 	r_usage->unused_wall -=	(double)job_seconds * tres_ratio;
+	r_usage->used_wall += (double)job_seconds * tres_ratio;
 
 	if (r_usage->unused_wall < 0) {
 		/*
@@ -292,43 +425,40 @@ static int _update_unused_wall(local_resv_usage_t *r_usage, List job_tres,
 	return SLURM_SUCCESS;
 }
 
-static void _add_job_alloc_time_to_cluster(List c_tres_list, List j_tres)
+static void _add_job_alloc_time_to_cluster(local_tres_index_t *tres_idx,
+					   local_tres_usage_t *c_tres,
+					   local_tres_usage_t *j_tres)
 {
-	ListIterator c_itr = list_iterator_create(c_tres_list);
-	local_tres_usage_t *loc_c_tres, *loc_j_tres;
-
-	while ((loc_c_tres = list_next(c_itr))) {
-		if (!(loc_j_tres = list_find_first(
-			      j_tres, _find_loc_tres, &loc_c_tres->id)))
+	for (int i = 0; i < tres_idx->cnt; i++) {
+		if (!c_tres[i].id || !j_tres[i].id)
 			continue;
-		loc_c_tres->time_alloc += loc_j_tres->time_alloc;
+		c_tres[i].time_alloc += j_tres[i].time_alloc;
 	}
-	list_iterator_destroy(c_itr);
 }
 
-static void _setup_cluster_tres(List tres_list, uint32_t id,
+static void _setup_cluster_tres(local_tres_index_t *tres_idx,
+				local_tres_usage_t *tres_array, uint32_t id,
 				uint64_t count, int seconds)
 {
 	local_tres_usage_t *loc_tres =
-		list_find_first(tres_list, _find_loc_tres, &id);
+		_find_loc_tres(tres_idx, tres_array, id, true);
 
-	if (!loc_tres) {
-		loc_tres = xmalloc(sizeof(local_tres_usage_t));
-		loc_tres->id = id;
-		list_append(tres_list, loc_tres);
-	}
+	if (!loc_tres)
+		return;
 
 	loc_tres->count = count;
 	loc_tres->total_time += seconds * loc_tres->count;
 }
 
-static void _add_tres_2_list(List tres_list, char *tres_str, int seconds)
+static void _add_tres_2_loc(local_tres_index_t *tres_idx,
+			    local_tres_usage_t *tres_array, char *tres_str,
+			    int seconds)
 {
 	char *tmp_str = tres_str;
 	int id;
 	uint64_t count;
 
-	xassert(tres_list);
+	xassert(tres_array);
 
 	if (!tres_str || !tres_str[0])
 		return;
@@ -336,7 +466,7 @@ static void _add_tres_2_list(List tres_list, char *tres_str, int seconds)
 	while (tmp_str) {
 		id = atoi(tmp_str);
 		if (id < 1) {
-			error("_add_tres_2_list: no id "
+			error("_add_tres_2_loc: no id "
 			      "found at %s instead", tmp_str);
 			break;
 		}
@@ -348,12 +478,13 @@ static void _add_tres_2_list(List tres_list, char *tres_str, int seconds)
 		 */
 		if (id != TRES_NODE) {
 			if (!(tmp_str = strchr(tmp_str, '='))) {
-				error("_add_tres_2_list: no value found");
+				error("_add_tres_2_loc: no value found");
 				xassert(0);
 				break;
 			}
 			count = slurm_atoull(++tmp_str);
-			_setup_cluster_tres(tres_list, id, count, seconds);
+			_setup_cluster_tres(tres_idx, tres_array, id, count,
+					    seconds);
 		}
 
 		if (!(tmp_str = strchr(tmp_str, ',')))
@@ -364,58 +495,43 @@ static void _add_tres_2_list(List tres_list, char *tres_str, int seconds)
 	return;
 }
 
-static void _add_job_alloc_time_to_assoc(List a_tres_list, List j_tres_list)
+/* Add the job's usage in loc_tres to the association or wckey */
+static void _transfer_loc_tres(local_tres_index_t *tres_idx,
+			       local_tres_usage_t *loc_tres,
+			       local_id_usage_t *usage)
 {
-	local_tres_usage_t *loc_a_tres, *loc_j_tres;
+	if (!usage || !loc_tres)
+		return;
 
-	/*
-	 * NOTE: You have to use slurm_list_pop here, since
-	 * mysql is exporting something of the same type as a
-	 * macro, which messes everything up
-	 * (my_list.h is the bad boy).
-	 */
-	while ((loc_j_tres = slurm_list_pop(j_tres_list))) {
-		if (!(loc_a_tres = list_find_first(
-			      a_tres_list, _find_loc_tres, &loc_j_tres->id))) {
+	if (!usage->loc_tres)
+		usage->loc_tres = _create_loc_tres(tres_idx);
+
+	for (int i = 0; i < tres_idx->cnt; i++) {
+		if (!loc_tres[i].id)
+			continue;
+		if (!usage->loc_tres[i].id) {
 			/*
 			 * New TRES we haven't seen before in this association
 			 * just transfer it over.
 			 */
-			list_append(a_tres_list, loc_j_tres);
+			usage->loc_tres[i] = loc_tres[i];
 			continue;
 		}
-		loc_a_tres->time_alloc += loc_j_tres->time_alloc;
-		_destroy_local_tres_usage(loc_j_tres);
+		usage->loc_tres[i].time_alloc += loc_tres[i].time_alloc;
 	}
 }
 
-/* This will destroy the *loc_tres given after it is transfered */
-static void _transfer_loc_tres(List *loc_tres, local_id_usage_t *usage)
-{
-	if (!usage || !*loc_tres) {
-		FREE_NULL_LIST(*loc_tres);
-		return;
-	}
-
-	if (!usage->loc_tres) {
-		usage->loc_tres = *loc_tres;
-		*loc_tres = NULL;
-	} else {
-		_add_job_alloc_time_to_assoc(usage->loc_tres, *loc_tres);
-		FREE_NULL_LIST(*loc_tres);
-	}
-}
-
-static void _add_tres_time_2_list(List tres_list, char *tres_str,
-				  int type, int seconds, int suspend_seconds,
-				  bool times_count)
+static void _add_tres_time_2_loc(local_tres_index_t *tres_idx,
+				 local_tres_usage_t *tres_array,
+				 char *tres_str, int type, int seconds,
+				 int suspend_seconds, bool times_count)
 {
 	char *tmp_str = tres_str;
 	int id;
 	uint64_t time, count;
 	local_tres_usage_t *loc_tres;
 
-	xassert(tres_list);
+	xassert(tres_array);
 
 	if (!tres_str || !tres_str[0])
 		return;
@@ -425,12 +541,12 @@ static void _add_tres_time_2_list(List tres_list, char *tres_str,
 
 		id = atoi(tmp_str);
 		if (id < 1) {
-			error("_add_tres_time_2_list: no id "
+			error("_add_tres_time_2_loc: no id "
 			      "found at %s", tmp_str);
 			break;
 		}
 		if (!(tmp_str = strchr(tmp_str, '='))) {
-			error("_add_tres_time_2_list: no value found for "
+			error("_add_tres_time_2_loc: no value found for "
 			      "id %d '%s'", id, tres_str);
 			xassert(0);
 			break;
@@ -452,7 +568,7 @@ static void _add_tres_time_2_list(List tres_list, char *tres_str,
 		if (id != TRES_ENERGY)
 			time *= loc_seconds;
 
-		loc_tres = _add_time_tres(tres_list, type, id,
+		loc_tres = _add_time_tres(tres_idx, tres_array, type, id,
 					  time, times_count);
 
 		if (loc_tres && !loc_tres->count)
@@ -685,27 +801,27 @@ static void _setup_cluster_tres_usage(mysql_conn_t *mysql_conn,
 }
 
 static int _process_cluster_usage(mysql_conn_t *mysql_conn,
+				  local_tres_index_t *tres_idx,
 				  char *cluster_name,
 				  time_t curr_start, time_t curr_end,
 				  time_t now, local_cluster_usage_t *c_usage)
 {
 	int rc = SLURM_SUCCESS;
 	char *query = NULL;
-	ListIterator itr;
-	local_tres_usage_t *loc_tres;
 
 	if (!c_usage)
 		return rc;
-	/* Now put the lists into the usage tables */
+	/* Now put the arrays into the usage tables */
 
 	xassert(c_usage->loc_tres);
-	itr = list_iterator_create(c_usage->loc_tres);
-	while ((loc_tres = list_next(itr))) {
+	for (int i = 0; i < tres_idx->cnt; i++) {
+		if (!c_usage->loc_tres[i].id)
+			continue;
 		_setup_cluster_tres_usage(mysql_conn, cluster_name,
 					  curr_start, curr_end, now,
-					  c_usage->start, loc_tres, &query);
+					  c_usage->start,
+					  &c_usage->loc_tres[i], &query);
 	}
-	list_iterator_destroy(itr);
 
 	if (!query)
 		return rc;
@@ -734,13 +850,13 @@ static int _process_cluster_usage(mysql_conn_t *mysql_conn,
 	return rc;
 }
 
-static void _create_id_usage_insert(char *cluster_name, int type,
+static void _create_id_usage_insert(local_tres_index_t *tres_idx,
+				    char *cluster_name, int type,
 				    time_t curr_start, time_t now,
 				    local_id_usage_t *id_usage,
 				    char **query)
 {
 	local_tres_usage_t *loc_tres;
-	ListIterator itr;
 	bool first;
 	char *table = NULL, *id_name = NULL;
 
@@ -761,14 +877,11 @@ static void _create_id_usage_insert(char *cluster_name, int type,
 		break;
 	}
 
-	if (!id_usage->loc_tres || !list_count(id_usage->loc_tres)) {
-		error("%s %d doesn't have any tres", id_name, id_usage->id);
-		return;
-	}
-
 	first = 1;
-	itr = list_iterator_create(id_usage->loc_tres);
-	while ((loc_tres = list_next(itr))) {
+	for (int i = 0; id_usage->loc_tres && (i < tres_idx->cnt); i++) {
+		loc_tres = &id_usage->loc_tres[i];
+		if (!loc_tres->id)
+			continue;
 		if (!first) {
 			xstrfmtcat(*query,
 				   ", (%ld, %ld, %u, %ld, %u, %"PRIu64")",
@@ -787,17 +900,21 @@ static void _create_id_usage_insert(char *cluster_name, int type,
 			first = 0;
 		}
 	}
-	list_iterator_destroy(itr);
+
+	if (first) {
+		error("%s %d doesn't have any tres", id_name, id_usage->id);
+		return;
+	}
+
 	xstrfmtcat(*query,
 		   " on duplicate key update mod_time=%ld, "
 		   "alloc_secs=VALUES(alloc_secs);", now);
 }
 
-static int _add_resv_usage_to_cluster(void *object, void *arg)
+static void _add_resv_usage_to_cluster(local_tres_index_t *tres_idx,
+				       local_resv_usage_t *r_usage,
+				       local_cluster_usage_t *c_usage)
 {
-	local_resv_usage_t *r_usage = (local_resv_usage_t *)object;
-	local_cluster_usage_t *c_usage = (local_cluster_usage_t *)arg;
-
 	xassert(c_usage);
 
 	/*
@@ -810,7 +927,7 @@ static int _add_resv_usage_to_cluster(void *object, void *arg)
 	 * but for cluster utilization we will just ignore them.
 	 */
 	if (r_usage->flags & RESERVE_FLAG_IGN_JOBS)
-		return SLURM_SUCCESS;
+		return;
 
 	/*
 	 * Since this reservation was added to the
@@ -821,10 +938,10 @@ static int _add_resv_usage_to_cluster(void *object, void *arg)
 	 * down time.
 	 */
 
-	_add_time_tres_list(c_usage->loc_tres,
-			    r_usage->loc_tres,
-			    (r_usage->flags & RESERVE_FLAG_MAINT) ?
-			    TIME_PDOWN : TIME_ALLOC, 0, 0);
+	_add_time_tres_loc(tres_idx, c_usage->loc_tres,
+			   r_usage->loc_tres,
+			   (r_usage->flags & RESERVE_FLAG_MAINT) ?
+			   TIME_PDOWN : TIME_ALLOC, 0, 0);
 
 	/* slurm_make_time_str(&r_usage->start, start_char, */
 	/* 		    sizeof(start_char)); */
@@ -835,11 +952,10 @@ static int _add_resv_usage_to_cluster(void *object, void *arg)
 	/*      r_usage->total_time, c_usage->name, */
 	/*      (row_flags & RESERVE_FLAG_MAINT),  */
 	/*      r_usage->id, start_char, end_char); */
-
-	return SLURM_SUCCESS;
 }
 
 static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
+						   local_tres_index_t *tres_idx,
 						   char *cluster_name,
 						   time_t curr_start,
 						   time_t curr_end,
@@ -856,6 +972,7 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 	ListIterator r_itr = NULL;
 	local_cluster_usage_t *loc_c_usage;
 	local_resv_usage_t *loc_r_usage;
+	local_tres_usage_t *loc_tres = NULL;
 
 	char *event_req_inx[] = {
 		"node_name",
@@ -901,6 +1018,7 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 
 	xfree(query);
 
+	loc_tres = _create_loc_tres(tres_idx);
 	d_itr = list_iterator_create(cluster_down_list);
 	r_itr = list_iterator_create(resv_usage_list);
 	while ((row = mysql_fetch_row(result))) {
@@ -939,7 +1057,7 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 					sizeof(local_cluster_usage_t));
 				loc_c_usage->start = row_start;
 				loc_c_usage->loc_tres =
-					list_create(_destroy_local_tres_usage);
+					_create_loc_tres(tres_idx);
 				/* If this has a state it
 				   means the slurmctld went
 				   down and we should put this
@@ -957,8 +1075,8 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 
 			loc_c_usage->end = row_end;
 
-			_add_tres_2_list(loc_c_usage->loc_tres,
-					 row[EVENT_REQ_TRES], seconds);
+			_add_tres_2_loc(tres_idx, loc_c_usage->loc_tres,
+					row[EVENT_REQ_TRES], seconds);
 
 			continue;
 		}
@@ -981,7 +1099,6 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 		while ((loc_r_usage = list_next(r_itr))) {
 			time_t temp_end = row_end;
 			time_t temp_start = row_start;
-			List loc_tres = NULL;
 
 			if (hostlist_find_dims(loc_r_usage->hl,
 					       row[EVENT_REQ_NAME], dims)
@@ -995,28 +1112,26 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 			if ((resv_seconds = (temp_end - temp_start)) < 1)
 				continue;
 
-			loc_tres = list_create(_destroy_local_tres_usage);
-
-			_add_tres_time_2_list(loc_tres,
-					      row[EVENT_REQ_TRES],
-					      loc_r_usage->flags &
-					      RESERVE_FLAG_MAINT ?
-					      TIME_PDOWN : TIME_DOWN,
-					      resv_seconds,
-					      0, 0);
-			_add_tres_time_2_list(c_usage->loc_tres,
-					      row[EVENT_REQ_TRES],
-					      loc_r_usage->flags &
-					      RESERVE_FLAG_MAINT ?
-					      TIME_PDOWN : TIME_DOWN,
-					      resv_seconds,
-					      0, 0);
+			_clear_loc_tres(tres_idx, loc_tres);
+
+			_add_tres_time_2_loc(tres_idx, loc_tres,
+					     row[EVENT_REQ_TRES],
+					     loc_r_usage->flags &
+					     RESERVE_FLAG_MAINT ?
+					     TIME_PDOWN : TIME_DOWN,
+					     resv_seconds,
+					     0, 0);
+			_add_tres_time_2_loc(tres_idx, c_usage->loc_tres,
+					     row[EVENT_REQ_TRES],
+					     loc_r_usage->flags &
+					     RESERVE_FLAG_MAINT ?
+					     TIME_PDOWN : TIME_DOWN,
+					     resv_seconds,
+					     0, 0);
 
 			_remove_job_tres_time_from_cluster(
-				loc_r_usage->loc_tres,
+				tres_idx, loc_r_usage->loc_tres,
 				loc_tres, resv_seconds);
-
-			FREE_NULL_LIST(loc_tres);
 		}
 
 		local_start = row_start;
@@ -1036,15 +1151,17 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 			if (((state & NODE_STATE_BASE) == NODE_STATE_FUTURE) ||
 			    ((state & NODE_STATE_CLOUD) &&
 			     (state & NODE_STATE_POWERED_DOWN)))
-				_add_tres_time_2_list(c_usage->loc_tres,
-						      row[EVENT_REQ_TRES],
-						      TIME_PDOWN,
-						      seconds, 0, 0);
+				_add_tres_time_2_loc(tres_idx,
+						     c_usage->loc_tres,
+						     row[EVENT_REQ_TRES],
+						     TIME_PDOWN,
+						     seconds, 0, 0);
 			else
-				_add_tres_time_2_list(c_usage->loc_tres,
-						      row[EVENT_REQ_TRES],
-						      TIME_DOWN,
-						      seconds, 0, 0);
+				_add_tres_time_2_loc(tres_idx,
+						     c_usage->loc_tres,
+						     row[EVENT_REQ_TRES],
+						     TIME_DOWN,
+						     seconds, 0, 0);
 		}
 
 		/*
@@ -1064,7 +1181,7 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 				continue;
 
 			_remove_job_tres_time_from_cluster(
-				loc_c_usage->loc_tres,
+				tres_idx, loc_c_usage->loc_tres,
 				c_usage->loc_tres, seconds);
 			/* info("Node %s was down for " */
 			/*      "%d seconds while " */
@@ -1077,15 +1194,21 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 	mysql_free_result(result);
 
 	list_iterator_destroy(d_itr);
+	xfree(loc_tres);
+
+	if (c_usage) {
+		list_iterator_reset(r_itr);
+		while ((loc_r_usage = list_next(r_itr)))
+			_add_resv_usage_to_cluster(tres_idx, loc_r_usage,
+						   c_usage);
+	}
+	list_iterator_destroy(r_itr);
 
-	if (c_usage)
-		(void)list_for_each(resv_usage_list,
-				    _add_resv_usage_to_cluster,
-				    c_usage);
 	return c_usage;
 }
 
 static int _setup_resv_usage(mysql_conn_t *mysql_conn,
+			     local_tres_index_t *tres_idx,
 			     char *cluster_name,
 			     time_t curr_start,
 			     time_t curr_end,
@@ -1198,11 +1321,10 @@ static int _setup_resv_usage(mysql_conn_t *mysql_conn,
 		r_usage->local_assocs = list_create(xfree_ptr);
 		slurm_addto_char_list(r_usage->local_assocs,
 				      row[RESV_REQ_ASSOCS]);
-		r_usage->loc_tres =
-			list_create(_destroy_local_tres_usage);
+		r_usage->loc_tres = _create_loc_tres(tres_idx);
 
-		_add_tres_2_list(r_usage->loc_tres,
-				 row[RESV_REQ_TRES], resv_seconds);
+		_add_tres_2_loc(tres_idx, r_usage->loc_tres,
+				row[RESV_REQ_TRES], resv_seconds);
 
 		/*
 		 * Original start is needed when updating the
@@ -1211,6 +1333,8 @@ static int _setup_resv_usage(mysql_conn_t *mysql_conn,
 		r_usage->orig_start = orig_start;
 		r_usage->start = row_start;
 		r_usage->end = row_end;
+		r_usage->resv_seconds = resv_seconds;
+		r_usage->unused_start = unused;
 		r_usage->unused_wall = unused + resv_seconds;
 		r_usage->hl = hostlist_create_dims(row[RESV_REQ_NODES], dims);
 		list_append(resv_usage_list, r_usage);
@@ -1220,7 +1344,8 @@ static int _setup_resv_usage(mysql_conn_t *mysql_conn,
 	return SLURM_SUCCESS;
 }
 
-static void _add_planned_time(local_cluster_usage_t *c_usage, time_t job_start,
+static void _add_planned_time(local_tres_index_t *tres_idx,
+			      local_cluster_usage_t *c_usage, time_t job_start,
 			      time_t job_eligible, uint32_t array_pending,
 			      uint32_t row_rcpu)
 {
@@ -1245,20 +1370,21 @@ static void _add_planned_time(local_cluster_usage_t *c_usage, time_t job_start,
 	if (array_pending)
 		loc_seconds *= array_pending;
 
-	_add_time_tres(c_usage->loc_tres, TIME_RESV, TRES_CPU,
+	_add_time_tres(tres_idx, c_usage->loc_tres, TIME_RESV, TRES_CPU,
 		       loc_seconds * (uint64_t) row_rcpu, 0);
 }
 
-extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
-				  char *cluster_name,
-				  time_t start, time_t end,
-				  uint16_t archive_data)
+/* Roll up the hours from slice->start to slice->end */
+static int _hourly_rollup_slice(mysql_conn_t *mysql_conn,
+				local_hour_slice_t *slice)
 {
 	int rc = SLURM_SUCCESS;
 	int add_sec = 3600;
-	int i=0, dims;
-	time_t now = time(NULL);
-	time_t curr_start = start;
+	int i=0;
+	char *cluster_name = slice->cluster_name;
+	int dims = slice->dims;
+	time_t now = slice->now;
+	time_t curr_start = slice->start;
 	time_t curr_end = curr_start + add_sec;
 	char *query = NULL;
 	MYSQL_RES *result = NULL;
@@ -1267,16 +1393,18 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	ListIterator c_itr = NULL;
 	ListIterator w_itr = NULL;
 	ListIterator r_itr = NULL;
-	List assoc_usage_list = list_create(_destroy_local_id_usage);
+	local_tres_index_t *tres_idx = slice->tres_idx;
+	local_id_index_t assoc_usage = { 0 };
+	local_id_index_t wckey_usage = { 0 };
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
-	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
-	uint16_t track_wckey = slurm_get_track_wckey();
+	uint16_t track_wckey = slice->track_wckey;
 	local_cluster_usage_t *loc_c_usage = NULL;
 	local_cluster_usage_t *c_usage = NULL;
 	local_resv_usage_t *r_usage = NULL;
 	local_id_usage_t *a_usage = NULL;
 	local_id_usage_t *w_usage = NULL;
+	local_tres_usage_t *loc_tres = _create_loc_tres(tres_idx);
 	/* char start_char[20], end_char[20]; */
 
 	char *job_req_inx[] = {
@@ -1333,37 +1461,14 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		xstrfmtcat(suspend_str, ", %s", suspend_req_inx[i]);
 	}
 
-	/* We need to figure out the dimensions of this cluster */
-	query = xstrdup_printf("select dimensions from %s where name='%s'",
-			       cluster_table, cluster_name);
-	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
-	result = mysql_db_query_ret(mysql_conn, query, 0);
-	xfree(query);
-
-	if (!result) {
-		error("%s: error querying cluster_table", __func__);
-		rc = SLURM_ERROR;
-		goto end_it;
-	}
-	row = mysql_fetch_row(result);
-
-	if (!row) {
-		error("%s: no cluster by name %s known",
-		      __func__, cluster_name);
-		rc = SLURM_ERROR;
-		goto end_it;
-	}
-
-	dims = atoi(row[0]);
-	mysql_free_result(result);
+	assoc_usage.list = list_create(_destroy_local_id_usage);
+	wckey_usage.list = list_create(_destroy_local_id_usage);
 
 /* 	info("begin start %s", slurm_ctime2(&curr_start)); */
 /* 	info("begin end %s", slurm_ctime2(&curr_end)); */
-	a_itr = list_iterator_create(assoc_usage_list);
 	c_itr = list_iterator_create(cluster_down_list);
-	w_itr = list_iterator_create(wckey_usage_list);
 	r_itr = list_iterator_create(resv_usage_list);
-	while (curr_start < end) {
+	while (curr_start < slice->end) {
 		int last_id = -1;
 		int last_wckeyid = -1;
 
@@ -1373,13 +1478,14 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 /* 		info("start %s", slurm_ctime2(&curr_start)); */
 /* 		info("end %s", slurm_ctime2(&curr_end)); */
 
-		if ((rc = _setup_resv_usage(mysql_conn, cluster_name,
+		if ((rc = _setup_resv_usage(mysql_conn, tres_idx, cluster_name,
 					    curr_start, curr_end,
 					    resv_usage_list, dims))
 		    != SLURM_SUCCESS)
 			goto end_it;
 
-		c_usage = _setup_cluster_usage(mysql_conn, cluster_name,
+		c_usage = _setup_cluster_usage(mysql_conn, tres_idx,
+					       cluster_name,
 					       curr_start, curr_end,
 					       resv_usage_list,
 					       cluster_down_list,
@@ -1419,7 +1525,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			time_t row_start = slurm_atoul(row[JOB_REQ_START]);
 			time_t row_end = slurm_atoul(row[JOB_REQ_END]);
 			uint32_t row_rcpu = slurm_atoul(row[JOB_REQ_RCPU]);
-			List loc_tres = NULL;
 			int loc_seconds = 0;
 			int seconds = 0, suspend_seconds = 0;
 
@@ -1485,9 +1590,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			}
 
 			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
+				a_usage = _find_id_usage(&assoc_usage,
+							 assoc_id, true);
 				last_id = assoc_id;
 				/* a_usage->loc_tres is made later,
 				   don't do it here.
@@ -1500,20 +1604,11 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			/* do the wckey calculation */
 			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
-
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
-					w_usage->loc_tres = list_create(
-						_destroy_local_tres_usage);
-				}
+				w_usage = _find_id_usage(&wckey_usage,
+							 wckey_id, true);
+				if (!w_usage->loc_tres)
+					w_usage->loc_tres =
+						_create_loc_tres(tres_idx);
 				last_wckeyid = wckey_id;
 			}
 
@@ -1524,16 +1619,18 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			 * We need to have this clean for each job
 			 * since we add the time to the cluster individually.
 			 */
-			loc_tres = list_create(_destroy_local_tres_usage);
+			_clear_loc_tres(tres_idx, loc_tres);
 
-			_add_tres_time_2_list(loc_tres, row[JOB_REQ_TRES],
-					      TIME_ALLOC, seconds,
-					      suspend_seconds, 0);
+			_add_tres_time_2_loc(tres_idx, loc_tres,
+					     row[JOB_REQ_TRES],
+					     TIME_ALLOC, seconds,
+					     suspend_seconds, 0);
 			if (w_usage)
-				_add_tres_time_2_list(w_usage->loc_tres,
-						      row[JOB_REQ_TRES],
-						      TIME_ALLOC, seconds,
-						      suspend_seconds, 0);
+				_add_tres_time_2_loc(tres_idx,
+						     w_usage->loc_tres,
+						     row[JOB_REQ_TRES],
+						     TIME_ALLOC, seconds,
+						     suspend_seconds, 0);
 
 			/*
 			 * Now figure out there was a disconnected
@@ -1552,6 +1649,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					continue;
 
 				_remove_job_tres_time_from_cluster(
+					tres_idx,
 					loc_c_usage->loc_tres,
 					loc_tres,
 					loc_seconds);
@@ -1593,6 +1691,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					if (r_usage->flags &
 					    RESERVE_FLAG_IGN_JOBS) {
 						_add_planned_time(
+							tres_idx,
 							c_usage,
 							MIN(row_start,
 							    r_usage->end),
@@ -1625,18 +1724,21 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 						 * account for it
 						 * individually here
 						 */
-						_add_tres_time_2_list(
+						_add_tres_time_2_loc(
+							tres_idx,
 							c_usage->loc_tres,
 							row[JOB_REQ_TRES],
 							TIME_ALLOC,
 							loc_seconds,
 							0, 0);
 
-					_add_time_tres_list(
+					_add_time_tres_loc(
+						tres_idx,
 						r_usage->loc_tres,
 						loc_tres, TIME_ALLOC,
 						loc_seconds, 1);
 					if ((rc = _update_unused_wall(
+						     tres_idx,
 						     r_usage,
 						     loc_tres,
 						     loc_seconds))
@@ -1644,7 +1746,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 						goto end_it;
 				}
 
-				_transfer_loc_tres(&loc_tres, a_usage);
+				_transfer_loc_tres(tres_idx, loc_tres, a_usage);
 				continue;
 			}
 
@@ -1661,6 +1763,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				/*      row_acpu); */
 
 				_add_job_alloc_time_to_cluster(
+					tres_idx,
 					c_usage->loc_tres,
 					loc_tres);
 			}
@@ -1669,39 +1772,46 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			 * The loc_tres isn't needed after this so transfer to
 			 * the association and go on our merry way.
 			 */
-			_transfer_loc_tres(&loc_tres, a_usage);
+			_transfer_loc_tres(tres_idx, loc_tres, a_usage);
 
-			_add_planned_time(c_usage, row_start, row_eligible,
-					  array_pending, row_rcpu);
+			_add_planned_time(tres_idx, c_usage, row_start,
+					  row_eligible, array_pending,
+					  row_rcpu);
 		}
 		mysql_free_result(result);
 
 		/* now figure out how much more to add to the
 		   associations that could had run in the reservation
 		*/
-		query = NULL;
 		list_iterator_reset(r_itr);
 		while ((r_usage = list_next(r_itr))) {
-			ListIterator t_itr;
-			local_tres_usage_t *loc_tres;
-
-			xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
-				   cluster_name, resv_table,
-				   r_usage->unused_wall, r_usage->id,
-				   r_usage->orig_start);
-
-			if (!r_usage->loc_tres ||
-			    !list_count(r_usage->loc_tres))
-				continue;
+			local_resv_unused_t *resv_unused =
+				xmalloc(sizeof(*resv_unused));
 
-			t_itr = list_iterator_create(r_usage->loc_tres);
-			while ((loc_tres = list_next(t_itr))) {
-				int64_t idle = loc_tres->total_time -
-					loc_tres->time_alloc;
+			/*
+			 * The unused_wall is written once all hours are
+			 * done, see _update_resv_unused().
+			 */
+			resv_unused->id = r_usage->id;
+			resv_unused->orig_start = r_usage->orig_start;
+			resv_unused->reset = (r_usage->orig_start >= curr_start);
+			resv_unused->resv_seconds = r_usage->resv_seconds;
+			resv_unused->unused_wall = r_usage->unused_start;
+			resv_unused->used_wall = r_usage->used_wall;
+			list_append(slice->resv_unused, resv_unused);
+
+			for (int t = 0; t < tres_idx->cnt; t++) {
+				local_tres_usage_t *resv_tres =
+					&r_usage->loc_tres[t];
+				int64_t idle = resv_tres->total_time -
+					resv_tres->time_alloc;
 				char *assoc = NULL;
 				ListIterator tmp_itr = NULL;
 				int assoc_cnt, resv_unused_secs;
 
+				if (!resv_tres->id)
+					continue;
+
 				if (idle <= 0)
 					break; /* since this will be
 						* the same for all TRES	*/
@@ -1716,76 +1826,63 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 				/* info("resv %d got %d seconds for TRES %u " */
 				/*      "for %d assocs", */
 				/*      r_usage->id, resv_unused_secs, */
-				/*      loc_tres->id, */
+				/*      resv_tres->id, */
 				/*      list_count(r_usage->local_assocs)); */
 				tmp_itr = list_iterator_create(
 					r_usage->local_assocs);
 				while ((assoc = list_next(tmp_itr))) {
 					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
-						a_usage->loc_tres = list_create(
-							_destroy_local_tres_usage);
-					}
+
+					a_usage = _find_id_usage(&assoc_usage,
+								 associd, true);
+					if (!a_usage->loc_tres)
+						a_usage->loc_tres =
+							_create_loc_tres(
+								tres_idx);
 					last_id = associd;
 
-					_add_time_tres(a_usage->loc_tres,
-						       TIME_ALLOC, loc_tres->id,
+					_add_time_tres(tres_idx,
+						       a_usage->loc_tres,
+						       TIME_ALLOC,
+						       resv_tres->id,
 						       resv_unused_secs, 0);
 				}
 				list_iterator_destroy(tmp_itr);
 			}
-			list_iterator_destroy(t_itr);
-		}
-
-		if (query) {
-			DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
-			         query);
-			rc = mysql_db_query(mysql_conn, query);
-			xfree(query);
-			if (rc != SLURM_SUCCESS) {
-				error("couldn't update reservations with unused time");
-				goto end_it;
-			}
 		}
 
 		/* now apply the down time from the slurmctld disconnects */
 		if (c_usage) {
 			list_iterator_reset(c_itr);
 			while ((loc_c_usage = list_next(c_itr))) {
-				local_tres_usage_t *loc_tres;
-				ListIterator tmp_itr = list_iterator_create(
-					loc_c_usage->loc_tres);
-				while ((loc_tres = list_next(tmp_itr)))
-					_add_time_tres(c_usage->loc_tres,
-						       TIME_DOWN,
-						       loc_tres->id,
-						       loc_tres->total_time,
-						       0);
-				list_iterator_destroy(tmp_itr);
+				for (int t = 0; t < tres_idx->cnt; t++) {
+					if (!loc_c_usage->loc_tres[t].id)
+						continue;
+					_add_time_tres(
+						tres_idx,
+						c_usage->loc_tres,
+						TIME_DOWN,
+						loc_c_usage->loc_tres[t].id,
+						loc_c_usage->loc_tres[t].
+						total_time,
+						0);
+				}
 			}
 
 			if ((rc = _process_cluster_usage(
-				     mysql_conn, cluster_name, curr_start,
-				     curr_end, now, c_usage))
+				     mysql_conn, tres_idx, cluster_name,
+				     curr_start, curr_end, now, c_usage))
 			    != SLURM_SUCCESS) {
 				goto end_it;
 			}
 		}
 
-		list_iterator_reset(a_itr);
+		a_itr = list_iterator_create(assoc_usage.list);
 		while ((a_usage = list_next(a_itr)))
-			_create_id_usage_insert(cluster_name, ASSOC_TABLES,
-						curr_start, now,
+			_create_id_usage_insert(tres_idx, cluster_name,
+						ASSOC_TABLES, curr_start, now,
 						a_usage, &query);
+		list_iterator_destroy(a_itr);
 		if (query) {
 			DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
 			         query);
@@ -1800,11 +1897,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		if (!track_wckey)
 			goto end_loop;
 
-		list_iterator_reset(w_itr);
+		w_itr = list_iterator_create(wckey_usage.list);
 		while ((w_usage = list_next(w_itr)))
-			_create_id_usage_insert(cluster_name, WCKEY_TABLES,
-						curr_start, now,
+			_create_id_usage_insert(tres_idx, cluster_name,
+						WCKEY_TABLES, curr_start, now,
 						w_usage, &query);
+		list_iterator_destroy(w_itr);
 		if (query) {
 			DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
 			         query);
@@ -1824,9 +1922,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		a_usage     = NULL;
 		w_usage     = NULL;
 
-		list_flush(assoc_usage_list);
+		_flush_id_index(&assoc_usage);
 		list_flush(cluster_down_list);
-		list_flush(wckey_usage_list);
+		_flush_id_index(&wckey_usage);
 		list_flush(resv_usage_list);
 		curr_start = curr_end;
 		curr_end = curr_start + add_sec;
@@ -1835,34 +1933,226 @@ end_it:
 	xfree(query);
 	xfree(suspend_str);
 	xfree(job_str);
+	xfree(loc_tres);
 	_destroy_local_cluster_usage(c_usage);
 
-	if (a_itr)
-		list_iterator_destroy(a_itr);
 	if (c_itr)
 		list_iterator_destroy(c_itr);
-	if (w_itr)
-		list_iterator_destroy(w_itr);
 	if (r_itr)
 		list_iterator_destroy(r_itr);
 
-	FREE_NULL_LIST(assoc_usage_list);
+	FREE_NULL_LIST(assoc_usage.list);
+	xfree(assoc_usage.usage);
 	FREE_NULL_LIST(cluster_down_list);
-	FREE_NULL_LIST(wckey_usage_list);
+	FREE_NULL_LIST(wckey_usage.list);
+	xfree(wckey_usage.usage);
 	FREE_NULL_LIST(resv_usage_list);
 
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
 
+	return rc;
+}
+
+static void *_hourly_rollup_slice_thread(void *arg)
+{
+	local_hour_slice_t *slice = (local_hour_slice_t *)arg;
+	mysql_conn_t mysql_conn;
+
+	memset(&mysql_conn, 0, sizeof(mysql_conn_t));
+	mysql_conn.flags |= DB_CONN_FLAG_ROLLBACK;
+	mysql_conn.conn = slice->conn;
+	slurm_mutex_init(&mysql_conn.lock);
+
+	/* Each thread needs it's own connection */
+	if ((slice->rc = check_connection(&mysql_conn)) == SLURM_SUCCESS)
+		slice->rc = _hourly_rollup_slice(&mysql_conn, slice);
+
+	if (slice->rc == SLURM_SUCCESS) {
+		if (mysql_db_commit(&mysql_conn)) {
+			error("Couldn't commit cluster (%s) hour rollup for %ld - %ld",
+			      slice->cluster_name, slice->start, slice->end);
+			slice->rc = SLURM_ERROR;
+		}
+	} else if (mysql_db_rollback(&mysql_conn))
+		error("rollback failed");
+
+	mysql_db_close_db_connection(&mysql_conn);
+	slurm_mutex_destroy(&mysql_conn.lock);
+
+	return NULL;
+}
+
+/*
+ * Add up the unused wall time of the reservations hour by hour over all the
+ * slices and write the final value of each reservation.
+ */
+static int _update_resv_unused(mysql_conn_t *mysql_conn, char *cluster_name,
+			       local_hour_slice_t *slices, int slice_cnt)
+{
+	List resv_list = list_create(NULL);
+	local_resv_unused_t *resv_unused, *last;
+	ListIterator itr;
+	char *query = NULL;
+	int rc = SLURM_SUCCESS;
+
+	for (int i = 0; i < slice_cnt; i++) {
+		itr = list_iterator_create(slices[i].resv_unused);
+		while ((resv_unused = list_next(itr))) {
+			double unused_wall = resv_unused->unused_wall;
+
+			last = list_find_first(resv_list, _find_resv_unused,
+					       resv_unused);
+			if (resv_unused->reset)
+				unused_wall = 0;
+			else if (last)
+				unused_wall = last->unused_wall;
+
+			/*
+			 * Jobs only take time away from it, so this is the
+			 * same as clamping to 0 after every job of the hour.
+			 */
+			unused_wall += resv_unused->resv_seconds -
+				resv_unused->used_wall;
+			resv_unused->unused_wall = MAX(unused_wall, 0);
+
+			if (last)
+				list_delete_ptr(resv_list, last);
+			list_append(resv_list, resv_unused);
+		}
+		list_iterator_destroy(itr);
+	}
+
+	itr = list_iterator_create(resv_list);
+	while ((resv_unused = list_next(itr)))
+		xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
+			   cluster_name, resv_table,
+			   resv_unused->unused_wall, resv_unused->id,
+			   resv_unused->orig_start);
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(resv_list);
+
+	if (query) {
+		DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+		if (rc != SLURM_SUCCESS)
+			error("couldn't update reservations with unused time");
+	}
+
+	return rc;
+}
+
+extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
+				  char *cluster_name,
+				  time_t start, time_t end,
+				  uint16_t archive_data)
+{
+	int rc = SLURM_SUCCESS;
+	int hours, slice_hours, slice_cnt = 1;
+	time_t now = time(NULL);
+	char *query = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	local_tres_index_t tres_idx = { 0 };
+	local_hour_slice_t *slices = NULL;
+	pthread_t *threads = NULL;
+
+	/* We need to figure out the dimensions of this cluster */
+	query = xstrdup_printf("select dimensions from %s where name='%s'",
+			       cluster_table, cluster_name);
+	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+
+	if (!result) {
+		error("%s: error querying cluster_table", __func__);
+		return SLURM_ERROR;
+	}
+	row = mysql_fetch_row(result);
+
+	if (!row) {
+		error("%s: no cluster by name %s known",
+		      __func__, cluster_name);
+		mysql_free_result(result);
+		return SLURM_ERROR;
+	}
+
+	if ((rc = _setup_tres_index(mysql_conn, &tres_idx)) != SLURM_SUCCESS) {
+		mysql_free_result(result);
+		return rc;
+	}
+
+	/*
+	 * Hours are independent of each other, other than the unused wall time
+	 * of reservations, so split a long range (like after the slurmdbd was
+	 * down for a while) in slices rolled up in parallel.
+	 */
+	hours = (end - start + 3599) / 3600;
+	if (slurmdbd_conf && (slurmdbd_conf->max_rollup_threads > 1))
+		slice_cnt = MIN(slurmdbd_conf->max_rollup_threads,
+				hours / ROLLUP_MIN_SLICE_HOURS);
+	slice_cnt = MAX(slice_cnt, 1);
+	slice_hours = (hours + slice_cnt - 1) / slice_cnt;
+
+	slices = xcalloc(slice_cnt, sizeof(local_hour_slice_t));
+	threads = xcalloc(slice_cnt, sizeof(pthread_t));
+	for (int i = 0; i < slice_cnt; i++) {
+		slices[i].cluster_name = cluster_name;
+		slices[i].conn = mysql_conn->conn;
+		slices[i].dims = atoi(row[0]);
+		slices[i].start = start + (i * slice_hours * 3600);
+		slices[i].end = MIN(end, slices[i].start + (slice_hours * 3600));
+		slices[i].now = now;
+		slices[i].resv_unused = list_create(xfree_ptr);
+		slices[i].tres_idx = &tres_idx;
+		slices[i].track_wckey = slurm_get_track_wckey();
+	}
+	mysql_free_result(result);
+
+	if (slice_cnt > 1)
+		debug("%s: rolling up %d hours of cluster %s in %d slices",
+		      __func__, hours, cluster_name, slice_cnt);
+
+	/*
+	 * The first slice is done here on the connection we were given.
+	 * The other slices commit on their own connection, so when one fails
+	 * the hours of the others stay committed. That is safe: last_ran is
+	 * only moved past the range once it all succeeded, so the whole range
+	 * is rolled up again next time. Usage rows are written with
+	 * "on duplicate key update" of the values of the hour, and unused_wall
+	 * is only written below once every slice succeeded, so redoing the
+	 * hours gives the same result.
+	 */
+	for (int i = 1; i < slice_cnt; i++)
+		slurm_thread_create(&threads[i], _hourly_rollup_slice_thread,
+				    &slices[i]);
+	rc = _hourly_rollup_slice(mysql_conn, &slices[0]);
+	for (int i = 1; i < slice_cnt; i++) {
+		pthread_join(threads[i], NULL);
+		if ((rc == SLURM_SUCCESS) && (slices[i].rc != SLURM_SUCCESS))
+			rc = slices[i].rc;
+	}
+
+	if (rc == SLURM_SUCCESS)
+		rc = _update_resv_unused(mysql_conn, cluster_name,
+					 slices, slice_cnt);
+
+	for (int i = 0; i < slice_cnt; i++)
+		FREE_NULL_LIST(slices[i].resv_unused);
+	xfree(slices);
+	xfree(threads);
+	xfree(tres_idx.pos);
+
 	/* go check to see if we archive and purge */
 
 	if (rc == SLURM_SUCCESS) {
 		if (mysql_db_commit(mysql_conn)) {
-			char start[25], end[25];
+			char start_str[25], end_str[25];
 			error("Couldn't commit cluster (%s) "
 			      "hour rollup for %s - %s",
-			      cluster_name, slurm_ctime2_r(&curr_start, start),
-			      slurm_ctime2_r(&curr_end, end));
+			      cluster_name, slurm_ctime2_r(&start, start_str),
+			      slurm_ctime2_r(&end, end_str));
 			rc = SLURM_ERROR;
 		} else
 			rc = _process_purge(mysql_conn, cluster_name,
@@ -42,10 +42,29 @@
 #include "src/common/macros.h"
 #include "src/common/slurm_time.h"
 
+#define USAGE_CACHE_MAX_ENTRIES 256
+#define USAGE_CACHE_MAX_ROWS 2000000
+
 time_t global_last_rollup = 0;
 pthread_mutex_t rollup_lock = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t usage_rollup_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/* The rows of a usage query, kept until a rollup changes them */
+typedef struct {
+	char *cluster_name;
+	time_t end;		/* end of the period queried */
+	time_t last_used;
+	char *query;
+	int row_cnt;
+	uint64_t *rows;		/* row_cnt rows of numbers */
+} usage_cache_t;
+
+static List usage_cache = NULL;
+static uint64_t usage_cache_gen = 0;	/* incremented on every clear */
+static time_t usage_cache_cleared = 0;
+static int usage_cache_rows = 0;
+static pthread_mutex_t usage_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 typedef struct {
 	uint16_t archive_data;
 	char *cluster_name;
@@ -59,6 +78,171 @@ typedef struct {
 	time_t sent_start;
 } local_rollup_t;
 
+static void _destroy_usage_cache(void *object)
+{
+	usage_cache_t *entry = object;
+
+	if (entry) {
+		xfree(entry->cluster_name);
+		xfree(entry->query);
+		xfree(entry->rows);
+		xfree(entry);
+	}
+}
+
+static int _find_usage_cache(void *x, void *key)
+{
+	usage_cache_t *entry = x;
+
+	return !xstrcmp(entry->query, key);
+}
+
+static int _find_usage_cache_lru(void *x, void *key)
+{
+	usage_cache_t *entry = x;
+	time_t *oldest = key;
+
+	return (entry->last_used == *oldest);
+}
+
+static int _usage_cache_oldest(void *x, void *arg)
+{
+	usage_cache_t *entry = x;
+	time_t *oldest = arg;
+
+	if (!*oldest || (entry->last_used < *oldest))
+		*oldest = entry->last_used;
+
+	return 0;
+}
+
+static int _find_usage_cache_stale(void *x, void *key)
+{
+	usage_cache_t *entry = x;
+	usage_cache_t *changed = key;
+
+	if (changed->cluster_name &&
+	    xstrcmp(entry->cluster_name, changed->cluster_name))
+		return 0;
+	if (entry->end <= changed->end)
+		return 0;
+
+	usage_cache_rows -= entry->row_cnt;
+	return 1;
+}
+
+/* usage_cache_lock must be locked */
+static void _usage_cache_evict(int rows)
+{
+	while (list_count(usage_cache) &&
+	       ((list_count(usage_cache) >= USAGE_CACHE_MAX_ENTRIES) ||
+		((usage_cache_rows + rows) > USAGE_CACHE_MAX_ROWS))) {
+		time_t oldest = 0;
+		usage_cache_t *entry;
+
+		(void) list_for_each(usage_cache, _usage_cache_oldest,
+				     &oldest);
+		entry = list_remove_first(usage_cache, _find_usage_cache_lru,
+					  &oldest);
+		usage_cache_rows -= entry->row_cnt;
+		_destroy_usage_cache(entry);
+	}
+}
+
+/*
+ * Get the rows of a usage query as width numbers each, from the cache if the
+ * same query was made since the last rollup of cluster_name.
+ * OUT rows - row_cnt rows of numbers, xfree() them
+ */
+static int _get_usage_rows(mysql_conn_t *mysql_conn, char *cluster_name,
+			   time_t end, char *query, int width,
+			   uint64_t **rows, int *row_cnt)
+{
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	usage_cache_t *entry;
+	uint64_t gen;
+	time_t now = time(NULL);
+	int i = 0;
+
+	slurm_mutex_lock(&usage_cache_lock);
+	if (usage_cache &&
+	    (entry = list_find_first(usage_cache, _find_usage_cache, query))) {
+		entry->last_used = now;
+		*row_cnt = entry->row_cnt;
+		*rows = xcalloc(entry->row_cnt * width, sizeof(uint64_t));
+		memcpy(*rows, entry->rows,
+		       entry->row_cnt * width * sizeof(uint64_t));
+		slurm_mutex_unlock(&usage_cache_lock);
+		DB_DEBUG(DB_USAGE, mysql_conn->conn, "cached query\n%s",
+			 query);
+		return SLURM_SUCCESS;
+	}
+	gen = usage_cache_gen;
+	slurm_mutex_unlock(&usage_cache_lock);
+
+	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+	if (!(result = mysql_db_query_ret(mysql_conn, query, 0)))
+		return SLURM_ERROR;
+
+	*row_cnt = mysql_num_rows(result);
+	*rows = xcalloc(*row_cnt * width, sizeof(uint64_t));
+	while ((row = mysql_fetch_row(result)) && (i < *row_cnt)) {
+		for (int j = 0; j < width; j++)
+			(*rows)[(i * width) + j] = slurm_atoull(row[j]);
+		i++;
+	}
+	mysql_free_result(result);
+
+	slurm_mutex_lock(&usage_cache_lock);
+	/*
+	 * Don't keep rows a rollup may have changed while we read them, or
+	 * that a replica may not have had yet since the last rollup.
+	 */
+	if ((gen != usage_cache_gen) ||
+	    ((mysql_conn->flags & DB_CONN_FLAG_REPLICA) &&
+	     (now <= (usage_cache_cleared + REPLICA_CHECK_SEC +
+		      slurmdbd_conf->storage_replica_max_lag))) ||
+	    (*row_cnt > (USAGE_CACHE_MAX_ROWS / 4))) {
+		slurm_mutex_unlock(&usage_cache_lock);
+		return SLURM_SUCCESS;
+	}
+
+	if (!usage_cache)
+		usage_cache = list_create(_destroy_usage_cache);
+	_usage_cache_evict(*row_cnt);
+
+	entry = xmalloc(sizeof(*entry));
+	entry->cluster_name = xstrdup(cluster_name);
+	entry->end = end;
+	entry->last_used = now;
+	entry->query = xstrdup(query);
+	entry->row_cnt = *row_cnt;
+	entry->rows = xcalloc(*row_cnt * width, sizeof(uint64_t));
+	memcpy(entry->rows, *rows, *row_cnt * width * sizeof(uint64_t));
+	list_append(usage_cache, entry);
+	usage_cache_rows += *row_cnt;
+	slurm_mutex_unlock(&usage_cache_lock);
+
+	return SLURM_SUCCESS;
+}
+
+extern void as_mysql_usage_cache_clear(char *cluster_name, time_t start)
+{
+	usage_cache_t changed = {
+		.cluster_name = cluster_name,
+		.end = start,
+	};
+
+	slurm_mutex_lock(&usage_cache_lock);
+	usage_cache_gen++;
+	usage_cache_cleared = time(NULL);
+	if (usage_cache)
+		(void) list_delete_all(usage_cache, _find_usage_cache_stale,
+				       &changed);
+	slurm_mutex_unlock(&usage_cache_lock);
+}
+
 static void *_cluster_rollup_usage(void *arg)
 {
 	local_rollup_t *local_rollup = (local_rollup_t *)arg;
@@ -81,6 +265,7 @@ static void *_cluster_rollup_usage(void *arg)
 	time_t day_end;
 	time_t month_start;
 	time_t month_end;
+	time_t changed_start = 0;	/* earliest usage rolled up */
 	DEF_TIMERS;
 
 	char *update_req_inx[] = {
@@ -294,6 +479,15 @@ static void *_cluster_rollup_usage(void *arg)
 /* 	info("month end %s", slurm_ctime2(&month_end)); */
 /* 	info("diff is %d", month_end-month_start); */
 
+	if ((hour_end - hour_start) > 0)
+		changed_start = hour_start;
+	if (((day_end - day_start) > 0) &&
+	    (!changed_start || (day_start < changed_start)))
+		changed_start = day_start;
+	if (((month_end - month_start) > 0) &&
+	    (!changed_start || (month_start < changed_start)))
+		changed_start = month_start;
+
 	if ((hour_end - hour_start) > 0) {
 		START_TIMER;
 		rc = as_mysql_hourly_rollup(&mysql_conn,
@@ -395,6 +589,11 @@ end_it:
 			error("rollback failed");
 	}
 
+	/* Each rollup commits on its own, even if a later one failed */
+	if (changed_start)
+		as_mysql_usage_cache_clear(local_rollup->cluster_name,
+					   changed_start);
+
 	mysql_db_close_db_connection(&mysql_conn);
 	slurm_mutex_destroy(&mysql_conn.lock);
 
@@ -417,9 +616,8 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 			     time_t start, time_t end, List *usage_list)
 {
 	char *tmp = NULL;
-	int i = 0;
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row;
+	int i = 0, row_cnt = 0;
+	uint64_t *rows = NULL, *row;
 	char *query = NULL;
 	assoc_mgr_lock_t locks = { NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 				   READ_LOCK, NO_LOCK, NO_LOCK };
@@ -474,23 +672,23 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 	}
 	xfree(tmp);
 
-	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
-	result = mysql_db_query_ret(mysql_conn, query, 0);
-	xfree(query);
-
-	if (!result)
+	if (_get_usage_rows(mysql_conn, cluster_name, end, query, USAGE_COUNT,
+			    &rows, &row_cnt) != SLURM_SUCCESS) {
+		xfree(query);
 		return SLURM_ERROR;
+	}
+	xfree(query);
 
 	if (!(*usage_list))
 		(*usage_list) = list_create(slurmdb_destroy_accounting_rec);
 
 	assoc_mgr_lock(&locks);
-	while ((row = mysql_fetch_row(result))) {
+	for (i = 0, row = rows; i < row_cnt; i++, row += USAGE_COUNT) {
 		slurmdb_tres_rec_t *tres_rec;
 		slurmdb_accounting_rec_t *accounting_rec =
 			xmalloc(sizeof(slurmdb_accounting_rec_t));
 
-		accounting_rec->tres_rec.id = slurm_atoul(row[USAGE_TRES]);
+		accounting_rec->tres_rec.id = row[USAGE_TRES];
 		if ((tres_rec = list_find_first(
 			     assoc_mgr_tres_list, slurmdb_find_tres_in_list,
 			     &accounting_rec->tres_rec.id))) {
@@ -500,15 +698,15 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 				xstrdup(tres_rec->type);
 		}
 
-		accounting_rec->id = slurm_atoul(row[USAGE_ID]);
-		accounting_rec->period_start = slurm_atoul(row[USAGE_START]);
-		accounting_rec->alloc_secs = slurm_atoull(row[USAGE_ALLOC]);
+		accounting_rec->id = row[USAGE_ID];
+		accounting_rec->period_start = row[USAGE_START];
+		accounting_rec->alloc_secs = row[USAGE_ALLOC];
 
 		list_append(*usage_list, accounting_rec);
 	}
 	assoc_mgr_unlock(&locks);
 
-	mysql_free_result(result);
+	xfree(rows);
 
 	return SLURM_SUCCESS;
 }
@@ -520,9 +718,8 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 			      time_t start, time_t end)
 {
 	int rc = SLURM_SUCCESS;
-	int i=0;
-	MYSQL_RES *result = NULL;
-	MYSQL_ROW row;
+	int i=0, row_cnt = 0;
+	uint64_t *rows = NULL, *row;
 	char *tmp = NULL;
 	char *my_usage_table = cluster_day_table;
 	char *query = NULL;
@@ -576,9 +773,9 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 		tmp, cluster_rec->name, my_usage_table, end, start);
 
 	xfree(tmp);
-	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
 
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
+	if (_get_usage_rows(mysql_conn, cluster_rec->name, end, query,
+			    CLUSTER_COUNT, &rows, &row_cnt) != SLURM_SUCCESS) {
 		xfree(query);
 		return SLURM_ERROR;
 	}
@@ -589,13 +786,13 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 			list_create(slurmdb_destroy_cluster_accounting_rec);
 
 	assoc_mgr_lock(&locks);
-	while ((row = mysql_fetch_row(result))) {
+	for (i = 0, row = rows; i < row_cnt; i++, row += CLUSTER_COUNT) {
 		slurmdb_tres_rec_t *tres_rec;
 		slurmdb_cluster_accounting_rec_t *accounting_rec =
 			xmalloc(sizeof(slurmdb_cluster_accounting_rec_t));
 
-		accounting_rec->tres_rec.id = slurm_atoul(row[CLUSTER_TRES]);
-		accounting_rec->tres_rec.count = slurm_atoul(row[CLUSTER_CNT]);
+		accounting_rec->tres_rec.id = row[CLUSTER_TRES];
+		accounting_rec->tres_rec.count = row[CLUSTER_CNT];
 		if ((tres_rec = list_find_first(
 			     assoc_mgr_tres_list, slurmdb_find_tres_in_list,
 			     &accounting_rec->tres_rec.id))) {
@@ -605,18 +802,18 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 				xstrdup(tres_rec->type);
 		}
 
-		accounting_rec->alloc_secs = slurm_atoull(row[CLUSTER_ACPU]);
-		accounting_rec->down_secs = slurm_atoull(row[CLUSTER_DCPU]);
-		accounting_rec->pdown_secs = slurm_atoull(row[CLUSTER_PDCPU]);
-		accounting_rec->idle_secs = slurm_atoull(row[CLUSTER_ICPU]);
-		accounting_rec->over_secs = slurm_atoull(row[CLUSTER_OCPU]);
-		accounting_rec->plan_secs = slurm_atoull(row[CLUSTER_PCPU]);
-		accounting_rec->period_start = slurm_atoul(row[CLUSTER_START]);
+		accounting_rec->alloc_secs = row[CLUSTER_ACPU];
+		accounting_rec->down_secs = row[CLUSTER_DCPU];
+		accounting_rec->pdown_secs = row[CLUSTER_PDCPU];
+		accounting_rec->idle_secs = row[CLUSTER_ICPU];
+		accounting_rec->over_secs = row[CLUSTER_OCPU];
+		accounting_rec->plan_secs = row[CLUSTER_PCPU];
+		accounting_rec->period_start = row[CLUSTER_START];
 		list_append(cluster_rec->accounting_list, accounting_rec);
 	}
 	assoc_mgr_unlock(&locks);
 
-	mysql_free_result(result);
+	xfree(rows);
 	return rc;
 }
 
@@ -972,6 +1169,7 @@ extern bool trigger_reroll(mysql_conn_t *mysql_conn, time_t event_time)
 {
 	slurm_mutex_lock(&rollup_lock);
 	if (event_time < global_last_rollup) {
+		mysql_conn_t *shared_conn;
 		char *query;
 		global_last_rollup = event_time;
 		slurm_mutex_unlock(&rollup_lock);
@@ -983,7 +1181,10 @@ extern bool trigger_reroll(mysql_conn_t *mysql_conn, time_t event_time)
 				       last_ran_table, event_time,
 				       event_time, event_time);
 		DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
-		(void) mysql_db_query(mysql_conn, query);
+		shared_conn = get_shared_conn(mysql_conn);
+		(void) release_shared_conn(
+			mysql_conn, shared_conn,
+			(mysql_db_query(shared_conn, query) == SLURM_SUCCESS));
 		xfree(query);
 		return true;
 	}
@@ -62,4 +62,10 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn,
  */
 extern bool trigger_reroll(mysql_conn_t *mysql_conn, time_t event_time);
 
+/*
+ * Forget the cached usage queries of cluster_name (all clusters if NULL)
+ * ending after start, as the usage from start on was just changed.
+ */
+extern void as_mysql_usage_cache_clear(char *cluster_name, time_t start);
+
 #endif
@@ -95,6 +95,11 @@ extern int acct_storage_p_close_connection(void **db_conn)
 	return SLURM_SUCCESS;
 }
 
+extern void *acct_storage_p_get_read_connection(void *db_conn)
+{
+	return db_conn;
+}
+
 extern int acct_storage_p_commit(void *db_conn, bool commit)
 {
 	return SLURM_SUCCESS;
@@ -512,6 +517,17 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	return NULL;
 }
 
+/*
+ * get info from the storage a chunk at a time
+ */
+extern int jobacct_storage_p_get_jobs_stream(void *db_conn, uid_t uid,
+					     void *job_cond,
+					     slurmdb_job_stream_cb_t callback,
+					     void *arg)
+{
+	return SLURM_SUCCESS;
+}
+
 /*
  * expire old info from the storage
  */
@@ -671,6 +671,11 @@ extern int acct_storage_p_close_connection(void **db_conn)
 	return SLURM_SUCCESS;
 }
 
+extern void *acct_storage_p_get_read_connection(void *db_conn)
+{
+	return db_conn;
+}
+
 extern int acct_storage_p_commit(void *db_conn, bool commit)
 {
 	persist_msg_t req = {0};
@@ -3221,6 +3226,93 @@ extern List jobacct_storage_p_get_jobs_cond(void *db_conn, uid_t uid,
 	return my_job_list;
 }
 
+/*
+ * get info from the storage a chunk at a time
+ */
+extern int jobacct_storage_p_get_jobs_stream(void *db_conn, uid_t uid,
+					     slurmdb_job_cond_t *job_cond,
+					     slurmdb_job_stream_cb_t callback,
+					     void *arg)
+{
+	persist_msg_t req = {0}, resp = {0};
+	dbd_cond_msg_t get_msg;
+	dbd_list_msg_t *got_msg;
+	uint32_t flags = job_cond->flags;
+	int rc, cb_rc = SLURM_SUCCESS;
+	bool done = false;
+
+	/* The agent only hands back one message per request */
+	if (running_in_slurmctld()) {
+		List job_list;
+
+		if (!(job_list = jobacct_storage_p_get_jobs_cond(db_conn, uid,
+								 job_cond)))
+			return errno ? errno : SLURM_ERROR;
+		if (list_count(job_list))
+			cb_rc = (callback)(job_list, arg);
+		FREE_NULL_LIST(job_list);
+		return cb_rc;
+	}
+
+	memset(&get_msg, 0, sizeof(dbd_cond_msg_t));
+
+	job_cond->flags |= JOBCOND_FLAG_STREAM;
+	get_msg.cond = job_cond;
+
+	req.msg_type = DBD_GET_JOBS_COND;
+	req.conn = db_conn;
+	req.data = &get_msg;
+	rc = dbd_conn_send_recv_direct(SLURM_PROTOCOL_VERSION, &req, &resp);
+	job_cond->flags = flags;
+
+	/*
+	 * An older slurmdbd answers with one DBD_GOT_JOBS, a newer one sends
+	 * any number of DBD_GOT_JOBS_CHUNK first. Every message has to be read
+	 * off the connection even after the callback fails.
+	 */
+	while ((rc == SLURM_SUCCESS) && !done) {
+		if (resp.msg_type == PERSIST_RC) {
+			persist_rc_msg_t *msg = resp.data;
+			if (msg->rc == SLURM_SUCCESS) {
+				info("%s", msg->comment);
+			} else {
+				rc = msg->rc;
+				error("%s", msg->comment);
+			}
+			slurm_persist_free_rc_msg(msg);
+			break;
+		} else if ((resp.msg_type != DBD_GOT_JOBS) &&
+			   (resp.msg_type != DBD_GOT_JOBS_CHUNK)) {
+			error("response type not DBD_GOT_JOBS: %u",
+			      resp.msg_type);
+			slurmdbd_free_msg(&resp);
+			rc = SLURM_ERROR;
+			break;
+		}
+
+		done = (resp.msg_type == DBD_GOT_JOBS);
+		got_msg = (dbd_list_msg_t *) resp.data;
+		if (!got_msg->my_list) {
+			rc = got_msg->return_code;
+			error("%s", slurm_strerror(rc));
+		} else if ((cb_rc == SLURM_SUCCESS) &&
+			   list_count(got_msg->my_list))
+			cb_rc = (callback)(got_msg->my_list, arg);
+		slurmdbd_free_list_msg(got_msg);
+
+		if (!done && (rc == SLURM_SUCCESS))
+			rc = dbd_conn_recv_direct(SLURM_PROTOCOL_VERSION,
+						  db_conn, &resp);
+	}
+
+	if (rc != SLURM_SUCCESS)
+		error("DBD_GET_JOBS_COND failure: %s", slurm_strerror(rc));
+	else
+		rc = cb_rc;
+
+	return rc;
+}
+
 /*
  * Expire old info from the storage
  * Not applicable for any database
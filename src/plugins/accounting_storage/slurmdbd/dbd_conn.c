@@ -243,6 +243,30 @@ extern void dbd_conn_close(slurm_persist_conn_t **pc)
 	*pc = NULL;
 }
 
+/*
+ * Wait for another message from the SlurmDBD on a connection an RPC has
+ * already been sent over, for replies that come in more than one message.
+ * The "resp" message must be freed by the caller.
+ * Returns SLURM_SUCCESS or an error code
+ */
+extern int dbd_conn_recv_direct(uint16_t rpc_version, slurm_persist_conn_t *pc,
+				persist_msg_t *resp)
+{
+	buf_t *buffer;
+	int rc;
+
+	xassert(pc);
+	xassert(resp);
+
+	if (!(buffer = slurm_persist_recv_msg(pc)))
+		return SLURM_ERROR;
+
+	rc = unpack_slurmdbd_msg(resp, rpc_version, buffer);
+	FREE_NULL_BUFFER(buffer);
+
+	return rc;
+}
+
 /*
  * Send an RPC to the SlurmDBD and wait for an arbitrary reply message.
  * The RPC will not be queued if an error occurs.
@@ -285,20 +309,16 @@ extern int dbd_conn_send_recv_direct(uint16_t rpc_version,
 		goto end_it;
 	}
 
-	buffer = slurm_persist_recv_msg(use_conn);
-	if (buffer == NULL) {
+	if ((rc = dbd_conn_recv_direct(rpc_version, use_conn, resp))) {
 		error("Getting response to message type: %s",
 		      slurmdbd_msg_type_2_str(req->msg_type, 1));
-		rc = SLURM_ERROR;
 		goto end_it;
 	}
 
-	rc = unpack_slurmdbd_msg(resp, rpc_version, buffer);
 	/* check for the rc of the start job message */
-	if (rc == SLURM_SUCCESS && resp->msg_type == DBD_ID_RC)
+	if (resp->msg_type == DBD_ID_RC)
 		rc = ((dbd_id_rc_msg_t *)resp->data)->return_code;
 
-	FREE_NULL_BUFFER(buffer);
 end_it:
 
 	log_flag(PROTOCOL, "msg_type:%s protocol_version:%hu return_code:%d response_msg_type:%s",
@@ -75,6 +75,16 @@ extern int dbd_conn_send_recv_direct(uint16_t rpc_version,
 				     persist_msg_t *req,
 				     persist_msg_t *resp);
 
+/*
+ * Wait for another message from the SlurmDBD after an RPC sent with
+ * dbd_conn_send_recv_direct() that is answered with more than one message.
+ *
+ * The "resp" message must be freed by the caller.
+ * Returns SLURM_SUCCESS or an error code
+ */
+extern int dbd_conn_recv_direct(uint16_t rpc_version, slurm_persist_conn_t *pc,
+				persist_msg_t *resp);
+
 
 /*
  * Send an RPC to the SlurmDBD and wait for the return code reply.
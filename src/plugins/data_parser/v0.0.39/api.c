@@ -93,6 +93,26 @@ extern int data_parser_p_dump(args_t *args, data_parser_type_t type, void *src,
 	return dump(src, src_bytes, parser, dst, args);
 }
 
+extern int data_parser_p_dump_stream(args_t *args, data_parser_type_t type,
+				     void *src, ssize_t src_bytes,
+				     const char *key,
+				     serializer_stream_t *stream)
+{
+	const parser_t *const parser = find_parser_by_type(type);
+
+	xassert(type > DATA_PARSER_TYPE_INVALID);
+	xassert(type < DATA_PARSER_TYPE_MAX);
+	xassert(args->magic == MAGIC_ARGS);
+	xassert(src);
+	xassert(src_bytes > 0);
+	xassert(stream);
+
+	if (!parser)
+		fatal("%s: invalid data parser type:0x%x", __func__, type);
+
+	return dump_stream(src, src_bytes, parser, key, stream, args);
+}
+
 extern int data_parser_p_parse(args_t *args, data_parser_type_t type, void *dst,
 			       ssize_t dst_bytes, data_t *src,
 			       data_t *parent_path)
@@ -150,6 +170,7 @@ extern void data_parser_p_free(args_t *args)
 	FREE_NULL_LIST(args->tres_list);
 	FREE_NULL_LIST(args->qos_list);
 	FREE_NULL_LIST(args->assoc_list);
+	xfree(args->fields);
 	if (args->close_db_conn)
 		slurmdb_connection_close(&args->db_conn);
 
@@ -188,6 +209,8 @@ extern int data_parser_p_assign(args_t *args, data_parser_attr_type_t type,
 		log_flag(DATA, "assigned QOS List at 0x%" PRIxPTR" to parser 0x%"PRIxPTR,
 			 (uintptr_t) obj, (uintptr_t) args);
 		return SLURM_SUCCESS;
+	case DATA_PARSER_ATTR_FIELDS:
+		return set_dump_fields(args, obj);
 	default :
 		return EINVAL;
 	}
@@ -62,6 +62,8 @@ typedef struct {
 	List tres_list;
 	List qos_list;
 	List assoc_list;
+	data_parser_type_t fields_type; /* type of record to mask */
+	bool *fields; /* dump field at index of fields_type parser or NULL */
 } args_t;
 
 extern args_t *data_parser_p_new(data_parser_on_error_t on_parse_error,
@@ -79,6 +81,10 @@ extern int data_parser_p_assign(args_t *args, data_parser_attr_type_t type,
 
 extern int data_parser_p_dump(args_t *args, data_parser_type_t type, void *src,
 			      ssize_t src_bytes, data_t *dst);
+extern int data_parser_p_dump_stream(args_t *args, data_parser_type_t type,
+				     void *src, ssize_t src_bytes,
+				     const char *key,
+				     serializer_stream_t *stream);
 extern int data_parser_p_parse(args_t *args, data_parser_type_t type, void *dst,
 			       ssize_t dst_bytes, data_t *src,
 			       data_t *parent_path);
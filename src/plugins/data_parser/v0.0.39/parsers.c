@@ -78,12 +78,14 @@
 #define MAGIC_FOREACH_STRING_ARRAY 0xaea1be2b
 #define MAGIC_FOREACH_HOSTLIST 0xae71b92b
 #define MAGIC_LIST_PER_TRES_TYPE_NCT 0xb1d8acd2
+#define MAGIC_FOREACH_DUMP_ENTRY 0xa2ea1b2c
 
 #define PARSER_ARRAY(type) _parser_array_##type
 #define PARSER_FLAG_ARRAY(type) _parser_flag_array_##type
 #define PARSE_FUNC(type) _parse_##type
 #define DUMP_FUNC(type) _dump_##type
 #define SPEC_FUNC(type) _openapi_spec_##type
+#define FOREACH_FUNC(type) _foreach_##type
 #define PARSE_DISABLED(type)                                                 \
 	static int PARSE_FUNC(type)(const parser_t *const parser, void *src, \
 				    data_t *dst, args_t *args,               \
@@ -159,6 +161,12 @@ typedef struct {
 	data_t *parent_path;
 } foreach_hostlist_parse_t;
 
+typedef struct {
+	int magic; /* MAGIC_FOREACH_DUMP_ENTRY */
+	args_t *args;
+	data_t *dst;
+} foreach_dump_entry_t;
+
 static int PARSE_FUNC(UINT64_NO_VAL)(const parser_t *const parser, void *obj,
 				     data_t *str, args_t *args,
 				     data_t *parent_path);
@@ -3380,16 +3388,14 @@ void SPEC_FUNC(JOB_RES_NODES)(const parser_t *const parser, args_t *args,
 
 PARSE_DISABLED(JOB_INFO_MSG)
 
-static int DUMP_FUNC(JOB_INFO_MSG)(const parser_t *const parser, void *obj,
-				   data_t *dst, args_t *args)
+static int FOREACH_FUNC(JOB_INFO_MSG)(const parser_t *const parser, void *obj,
+				      parser_foreach_entry_t func, void *arg,
+				      args_t *args)
 {
 	int rc = SLURM_SUCCESS;
 	job_info_msg_t *msg = obj;
 
 	xassert(args->magic == MAGIC_ARGS);
-	xassert(data_get_type(dst) == DATA_TYPE_NULL);
-
-	data_set_list(dst);
 
 	if (!msg || !msg->record_count) {
 		on_warn(DUMPING, parser->type, args, NULL, __func__,
@@ -3398,12 +3404,39 @@ static int DUMP_FUNC(JOB_INFO_MSG)(const parser_t *const parser, void *obj,
 	}
 
 	for (size_t i = 0; !rc && (i < msg->record_count); ++i)
-		rc = DUMP(JOB_INFO, msg->job_array[i], data_list_append(dst),
-			  args);
+		rc = func(&msg->job_array[i], arg);
 
 	return rc;
 }
 
+static int _dump_job_info_entry(void *obj, void *arg)
+{
+	foreach_dump_entry_t *fargs = arg;
+	slurm_job_info_t *job = obj;
+
+	xassert(fargs->magic == MAGIC_FOREACH_DUMP_ENTRY);
+
+	return DUMP(JOB_INFO, *job, data_list_append(fargs->dst), fargs->args);
+}
+
+static int DUMP_FUNC(JOB_INFO_MSG)(const parser_t *const parser, void *obj,
+				   data_t *dst, args_t *args)
+{
+	foreach_dump_entry_t fargs = {
+		.magic = MAGIC_FOREACH_DUMP_ENTRY,
+		.args = args,
+		.dst = dst,
+	};
+
+	xassert(args->magic == MAGIC_ARGS);
+	xassert(data_get_type(dst) == DATA_TYPE_NULL);
+
+	data_set_list(dst);
+
+	return FOREACH_FUNC(JOB_INFO_MSG)(parser, obj, _dump_job_info_entry,
+					  &fargs, args);
+}
+
 PARSE_DISABLED(CONTROLLER_PING_MODE)
 
 static int DUMP_FUNC(CONTROLLER_PING_MODE)(const parser_t *const parser,
@@ -5986,6 +6019,24 @@ static const parser_t PARSER_ARRAY(UPDATE_NODE_MSG)[] = {
 		.dump = DUMP_FUNC(typev),                                      \
 		.ptr_offset = NO_VAL,                                          \
 	}
+/* add parser for simple type which creates an array of walkable entries */
+#define addpsaw(typev, typea, stype, need, desc)                               \
+	{                                                                      \
+		.magic = MAGIC_PARSER,                                         \
+		.type = DATA_PARSER_##typev,                                   \
+		.array_type = DATA_PARSER_##typea,                             \
+		.model = PARSER_MODEL_SIMPLE,                                  \
+		.type_string = XSTRINGIFY(DATA_PARSER_ ## typev),              \
+		.obj_desc = desc,                                              \
+		.obj_type_string = XSTRINGIFY(stype),                          \
+		.obj_openapi = OPENAPI_FORMAT_ARRAY,                           \
+		.size = sizeof(stype),                                         \
+		.needs = need,                                                 \
+		.parse = PARSE_FUNC(typev),                                    \
+		.dump = DUMP_FUNC(typev),                                      \
+		.foreach_entry = FOREACH_FUNC(typev),                          \
+		.ptr_offset = NO_VAL,                                          \
+	}
 /* add parser for simple type which becomes another type */
 #define addpsp(typev, typea, stype, need, desc)                                \
 	{                                                                      \
@@ -6148,7 +6199,7 @@ static const parser_t parsers[] = {
 	addpsa(HOSTLIST_STRING, STRING, char *, NEED_NONE, NULL),
 	addps(CPU_FREQ_FLAGS, uint32_t, NEED_NONE, STRING, NULL),
 	addps(ERROR, int, NEED_NONE, STRING, NULL),
-	addpsa(JOB_INFO_MSG, JOB_INFO, job_info_msg_t, NEED_NONE, NULL),
+	addpsaw(JOB_INFO_MSG, JOB_INFO, job_info_msg_t, NEED_NONE, NULL),
 	addpsa(STRING_ARRAY, STRING, char **, NEED_NONE, NULL),
 	addps(SIGNAL, uint16_t, NEED_NONE, STRING, NULL),
 	addps(BITSTR, bitstr_t, NEED_NONE, STRING, NULL),
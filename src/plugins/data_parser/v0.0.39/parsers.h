@@ -93,6 +93,14 @@ typedef enum {
 
 #define MAGIC_PARSER 0xa3bafa05
 
+/*
+ * Callback for each entry of an object that dumps as an array
+ * IN obj - ptr to entry
+ * IN arg - arbitrary ptr handed to foreach_entry()
+ * RET SLURM_SUCCESS or error to stop walking the entries
+ */
+typedef int (*parser_foreach_entry_t)(void *obj, void *arg);
+
 typedef struct parser_s {
 	int magic; /* MAGIC_PARSER */
 	parser_model_t model;
@@ -135,6 +143,21 @@ typedef struct parser_s {
 	int (*parse)(const parser_t *const parser, void *dst, data_t *src,
 		     args_t *args, data_t *parent_path);
 	need_t needs;
+	/*
+	 * Walk each entry of a Simple model array object (optional).
+	 * 	Allows the array to be dumped one entry at a time using the
+	 * 	parser for array_type instead of requiring the entire array be
+	 * 	dumped into a single data_t.
+	 * IN parser - parser of array object
+	 * IN src - ptr to array object
+	 * IN func - function to call with ptr to each entry
+	 * IN arg - arbitrary ptr to hand to func
+	 * IN args - parser args
+	 * RET SLURM_SUCCESS or error from func
+	 */
+	int (*foreach_entry)(const parser_t *const parser, void *src,
+			     parser_foreach_entry_t func, void *arg,
+			     args_t *args);
 	/*
 	 * Populates OpenAPI specification.
 	 * 	For parsers where the normal OpenAPI specification generation is
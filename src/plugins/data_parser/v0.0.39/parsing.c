@@ -51,6 +51,8 @@
 #define MAGIC_FOREACH_LIST_FLAG 0xa1d4acd2
 #define MAGIC_FOREACH_LIST 0xaefa2af3
 #define MAGIC_FOREACH_NT_ARRAY 0xaba1be2b
+#define MAGIC_FOREACH_DUMP_NT_ARRAY 0xaba1be2c
+#define MAGIC_FOREACH_STREAM 0xa1ba3e2d
 
 typedef struct {
 	int magic;
@@ -82,6 +84,21 @@ typedef struct {
 	data_t *parent_path;
 } foreach_nt_array_t;
 
+typedef struct {
+	int magic; /* MAGIC_FOREACH_DUMP_NT_ARRAY */
+	const parser_t *parser;
+	args_t *args;
+	data_t *dst;
+} foreach_dump_nt_array_t;
+
+typedef struct {
+	int magic; /* MAGIC_FOREACH_STREAM */
+	type_t type; /* type of each entry */
+	args_t *args;
+	serializer_stream_t *stream;
+	int rc;
+} foreach_stream_t;
+
 static void _set_flag_bit(const parser_t *const parser, void *dst,
 			  const flag_bit_t *bit, bool matched, const char *path,
 			  data_t *src)
@@ -986,13 +1003,11 @@ static int _dump_pointer(const parser_t *const parser, void *src, data_t *dst,
 	return dump(*ptr, NO_VAL, pt, dst, args);
 }
 
-static int _dump_nt_array(const parser_t *const parser, void *src, data_t *dst,
-			  args_t *args)
+static int _foreach_nt_array(const parser_t *const parser, void *src,
+			     parser_foreach_entry_t func, void *arg)
 {
 	int rc = SLURM_SUCCESS;
 
-	data_set_list(dst);
-
 	if (parser->model == PARSER_MODEL_NT_PTR_ARRAY) {
 		void ***array_ptr = src;
 		void **array;
@@ -1000,11 +1015,8 @@ static int _dump_nt_array(const parser_t *const parser, void *src, data_t *dst,
 		if (!(array = *array_ptr))
 			return SLURM_SUCCESS;
 
-		for (int i = 0; !rc && array[i]; i++) {
-			rc = data_parser_p_dump(args, parser->array_type,
-						array[i], NO_VAL,
-						data_list_append(dst));
-		}
+		for (int i = 0; !rc && array[i]; i++)
+			rc = func(array[i], arg);
 	} else if (parser->model == PARSER_MODEL_NT_ARRAY) {
 		const parser_t *const ap =
 			find_parser_by_type(parser->array_type);
@@ -1025,8 +1037,7 @@ static int _dump_nt_array(const parser_t *const parser, void *src, data_t *dst,
 			if (done)
 				break;
 
-			rc = data_parser_p_dump(args, parser->array_type, ptr,
-						NO_VAL, data_list_append(dst));
+			rc = func(ptr, arg);
 		}
 	} else {
 		fatal_abort("invalid model");
@@ -1035,6 +1046,31 @@ static int _dump_nt_array(const parser_t *const parser, void *src, data_t *dst,
 	return rc;
 }
 
+static int _foreach_dump_nt_array(void *obj, void *arg)
+{
+	foreach_dump_nt_array_t *fargs = arg;
+
+	xassert(fargs->magic == MAGIC_FOREACH_DUMP_NT_ARRAY);
+
+	return data_parser_p_dump(fargs->args, fargs->parser->array_type, obj,
+				  NO_VAL, data_list_append(fargs->dst));
+}
+
+static int _dump_nt_array(const parser_t *const parser, void *src, data_t *dst,
+			  args_t *args)
+{
+	foreach_dump_nt_array_t fargs = {
+		.magic = MAGIC_FOREACH_DUMP_NT_ARRAY,
+		.parser = parser,
+		.args = args,
+		.dst = dst,
+	};
+
+	data_set_list(dst);
+
+	return _foreach_nt_array(parser, src, _foreach_dump_nt_array, &fargs);
+}
+
 static int _dump_linked(args_t *args, const parser_t *const array,
 			const parser_t *const parser, void *src, data_t *dst)
 {
@@ -1150,9 +1186,15 @@ extern int dump(void *src, ssize_t src_bytes, const parser_t *const parser,
 		xassert((data_get_type(dst) == DATA_TYPE_NULL) ||
 			(data_get_type(dst) == DATA_TYPE_DICT));
 		/* recursively run linked parsers for each struct field */
-		for (int i = 0; !rc && (i < parser->field_count); i++)
+		for (int i = 0; !rc && (i < parser->field_count); i++) {
+			/* skip fields not requested before any conversion */
+			if (args->fields && (parser->type == args->fields_type)
+			    && !args->fields[i])
+				continue;
+
 			rc = _dump_linked(args, parser, &parser->fields[i], src,
 					  dst);
+		}
 		break;
 	case PARSER_MODEL_LIST:
 		xassert(parser->list_type > DATA_PARSER_TYPE_INVALID);
@@ -1215,3 +1257,198 @@ done:
 
 	return rc;
 }
+
+/* Check if field path matches key or any of its parents */
+static bool _match_field(const char *key, const char *field)
+{
+	size_t klen = strlen(key), flen = strlen(field);
+
+	/* field is parent of key */
+	if ((flen <= klen) && !strncmp(key, field, flen) &&
+	    ((key[flen] == '\0') || (key[flen] == OPENAPI_PATH_SEP[0])))
+		return true;
+
+	/* key is parent of field */
+	if ((klen < flen) && !strncmp(key, field, klen) &&
+	    (field[klen] == OPENAPI_PATH_SEP[0]))
+		return true;
+
+	return false;
+}
+
+extern int set_dump_fields(args_t *args, const data_parser_fields_t *fields)
+{
+	int rc = SLURM_SUCCESS;
+	const parser_t *parser;
+	char *buffer, *token, *save_ptr = NULL;
+	bool *mask;
+
+	xassert(args->magic == MAGIC_ARGS);
+
+	xfree(args->fields);
+	args->fields_type = DATA_PARSER_TYPE_INVALID;
+
+	if (!fields || !fields->fields)
+		return SLURM_SUCCESS;
+
+	if (!(parser = find_parser_by_type(fields->type)) ||
+	    (parser->model != PARSER_MODEL_ARRAY))
+		return EINVAL;
+
+	mask = xcalloc(parser->field_count, sizeof(*mask));
+
+	/* fields without a key are part of the record itself */
+	for (int i = 0; i < parser->field_count; i++)
+		if (!parser->fields[i].key)
+			mask[i] = true;
+
+	buffer = xstrdup(fields->fields);
+	token = strtok_r(buffer, ",", &save_ptr);
+	while (!rc && token) {
+		bool found = false;
+
+		xstrtrim(token);
+
+		for (int i = 0; token[0] && (i < parser->field_count); i++) {
+			const parser_t *const field = &parser->fields[i];
+
+			if ((field->model == PARSER_MODEL_ARRAY_SKIP_FIELD) ||
+			    !field->key || !_match_field(field->key, token))
+				continue;
+
+			mask[i] = true;
+			found = true;
+		}
+
+		if (token[0] && !found)
+			rc = on_error(QUERYING, parser->type, args,
+				      ESLURM_REST_INVALID_QUERY, "fields",
+				      __func__, "Unknown field %s for %s",
+				      token, parser->obj_type_string);
+
+		token = strtok_r(NULL, ",", &save_ptr);
+	}
+	xfree(buffer);
+
+	if (rc) {
+		xfree(mask);
+		return rc;
+	}
+
+	log_flag(DATA, "assigned fields %s of %s to parser 0x%" PRIxPTR,
+		 fields->fields, parser->type_string, (uintptr_t) args);
+
+	args->fields_type = parser->type;
+	args->fields = mask;
+	return SLURM_SUCCESS;
+}
+
+static int _foreach_stream_entry(void *obj, void *arg)
+{
+	int rc;
+	foreach_stream_t *fargs = arg;
+	data_t *item = data_new_arena();
+
+	xassert(fargs->magic == MAGIC_FOREACH_STREAM);
+	xassert(fargs->args->magic == MAGIC_ARGS);
+
+	/* entry is only held as a data_t long enough to be serialized */
+	if (!(rc = data_parser_p_dump(fargs->args, fargs->type, obj, NO_VAL,
+				      item)))
+		rc = serialize_g_stream_data(fargs->stream, NULL, item);
+
+	FREE_NULL_DATA(item);
+	return rc;
+}
+
+static int _foreach_stream_list(void *obj, void *arg)
+{
+	foreach_stream_t *fargs = arg;
+
+	if ((fargs->rc = _foreach_stream_entry(obj, arg)))
+		return -1;
+
+	return 0;
+}
+
+static int _dump_stream_whole(void *src, ssize_t src_bytes,
+			      const parser_t *const parser, const char *key,
+			      serializer_stream_t *stream, args_t *args)
+{
+	int rc;
+	data_t *dst = data_new_arena();
+
+	if (!(rc = dump(src, src_bytes, parser, dst, args)))
+		rc = serialize_g_stream_data(stream, key, dst);
+
+	FREE_NULL_DATA(dst);
+	return rc;
+}
+
+extern int dump_stream(void *src, ssize_t src_bytes,
+		       const parser_t *const parser, const char *key,
+		       serializer_stream_t *stream, args_t *args)
+{
+	int rc;
+	foreach_stream_t fargs = {
+		.magic = MAGIC_FOREACH_STREAM,
+		.args = args,
+		.stream = stream,
+	};
+
+	check_parser(parser);
+	xassert(args->magic == MAGIC_ARGS);
+	xassert((src_bytes == NO_VAL) || (src_bytes == parser->size));
+	xassert(src);
+
+	if (parser->model == PARSER_MODEL_PTR) {
+		void **ptr = src;
+
+		if (*ptr)
+			return dump_stream(*ptr, NO_VAL,
+					   find_parser_by_type(
+						   parser->pointer_type),
+					   key, stream, args);
+	}
+
+	if ((parser->model != PARSER_MODEL_LIST) &&
+	    (parser->model != PARSER_MODEL_NT_ARRAY) &&
+	    (parser->model != PARSER_MODEL_NT_PTR_ARRAY) &&
+	    !parser->foreach_entry)
+		return _dump_stream_whole(src, src_bytes, parser, key, stream,
+					  args);
+
+	log_flag(DATA, "streaming %zd byte %s object at 0x%" PRIxPTR " with parser %s(0x%" PRIxPTR ")",
+		 (src_bytes == NO_VAL ? -1 : src_bytes),
+		 parser->obj_type_string, (uintptr_t) src, parser->type_string,
+		 (uintptr_t) parser);
+
+	if ((rc = load_prereqs(DUMPING, parser, args)))
+		return rc;
+
+	if ((rc = serialize_g_stream_begin(stream, key, DATA_TYPE_LIST)))
+		return rc;
+
+	if (parser->model == PARSER_MODEL_LIST) {
+		List *list_ptr = src;
+
+		fargs.type = parser->list_type;
+
+		if (*list_ptr &&
+		    (list_for_each(*list_ptr, _foreach_stream_list, &fargs) < 0))
+			rc = fargs.rc;
+	} else if (parser->model == PARSER_MODEL_SIMPLE) {
+		fargs.type = parser->array_type;
+		rc = parser->foreach_entry(parser, src, _foreach_stream_entry,
+					   &fargs, args);
+	} else {
+		fargs.type = parser->array_type;
+		rc = _foreach_nt_array(parser, src, _foreach_stream_entry,
+				       &fargs);
+	}
+
+	if (!rc)
+		rc = serialize_g_stream_end(stream);
+
+	return rc;
+}
@@ -65,6 +65,22 @@ extern int dump(void *src, ssize_t src_bytes, const parser_t *const parser,
 	dump(&src, sizeof(src), find_parser_by_type(DATA_PARSER_##type), dst, \
 	     args)
 
+/*
+ * Dump src into stream under key
+ * Lists and arrays are dumped one entry at a time to avoid building the
+ * entire dump as a single data_t.
+ */
+extern int dump_stream(void *src, ssize_t src_bytes,
+		       const parser_t *const parser, const char *key,
+		       serializer_stream_t *stream, args_t *args);
+
+/*
+ * Compile fields mask to only dump requested fields of records
+ * IN fields - fields to dump or NULL to dump all fields
+ * RET SLURM_SUCCESS or error
+ */
+extern int set_dump_fields(args_t *args, const data_parser_fields_t *fields);
+
 extern int parse(void *dst, ssize_t dst_bytes, const parser_t *const parser,
 		 data_t *src, args_t *args, data_t *parent_path);
 #define PARSE(type, dst, src, parent_path, args)                               \
@@ -0,0 +1,356 @@
+/*****************************************************************************\
+ *  binary_jobcomp_process.c - functions for reading and indexing the binary
+ *  job completion segments.
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+
+#include "src/common/parse_time.h"
+#include "src/common/uid.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "binary_jobcomp_process.h"
+
+#define BINARY_JOBCOMP_DATA_SUFFIX ".bin"
+#define BINARY_JOBCOMP_INDEX_SUFFIX ".idx"
+
+extern char *binary_jobcomp_segment_path(const char *dir, uint32_t seq,
+					 bool index)
+{
+	return xstrdup_printf("%s/%s%08u%s", dir, BINARY_JOBCOMP_PREFIX, seq,
+			      (index ? BINARY_JOBCOMP_INDEX_SUFFIX :
+			       BINARY_JOBCOMP_DATA_SUFFIX));
+}
+
+static int _cmp_seq(const void *a, const void *b)
+{
+	uint32_t x = *(uint32_t *) a, y = *(uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+extern int binary_jobcomp_segment_list(const char *dir, uint32_t **seqs)
+{
+	DIR *dp;
+	struct dirent *ent;
+	int cnt = 0, size = 0;
+
+	*seqs = NULL;
+	if (!(dp = opendir(dir))) {
+		error("%s: opendir(%s): %m", __func__, dir);
+		return -1;
+	}
+
+	while ((ent = readdir(dp))) {
+		char *end = NULL;
+		unsigned long seq;
+
+		if (xstrncmp(ent->d_name, BINARY_JOBCOMP_PREFIX,
+			     strlen(BINARY_JOBCOMP_PREFIX)))
+			continue;
+		seq = strtoul(ent->d_name + strlen(BINARY_JOBCOMP_PREFIX),
+			      &end, 10);
+		if ((end == ent->d_name + strlen(BINARY_JOBCOMP_PREFIX)) ||
+		    xstrcmp(end, BINARY_JOBCOMP_DATA_SUFFIX) ||
+		    (seq > UINT32_MAX))
+			continue;
+
+		if (cnt >= size) {
+			size = size ? (size * 2) : 16;
+			xrecalloc(*seqs, size, sizeof(**seqs));
+		}
+		(*seqs)[cnt++] = seq;
+	}
+	closedir(dp);
+
+	if (cnt)
+		qsort(*seqs, cnt, sizeof(**seqs), _cmp_seq);
+
+	return cnt;
+}
+
+extern void binary_jobcomp_pack_header(uint32_t magic, buf_t *buffer)
+{
+	pack32(magic, buffer);
+	pack16(BINARY_JOBCOMP_VERSION, buffer);
+}
+
+extern int binary_jobcomp_unpack_header(uint32_t magic, buf_t *buffer)
+{
+	uint32_t file_magic;
+	uint16_t version;
+
+	safe_unpack32(&file_magic, buffer);
+	safe_unpack16(&version, buffer);
+
+	if (file_magic != magic) {
+		error("%s: bad magic 0x%x", __func__, file_magic);
+		return SLURM_ERROR;
+	}
+	if (version != BINARY_JOBCOMP_VERSION) {
+		error("%s: unsupported format version %hu", __func__, version);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+extern void binary_jobcomp_pack_index(binary_jobcomp_index_t *index,
+				      buf_t *buffer)
+{
+	pack32(index->job_id, buffer);
+	pack32(index->length, buffer);
+	pack64(index->offset, buffer);
+}
+
+extern int binary_jobcomp_unpack_index(binary_jobcomp_index_t *index,
+				       buf_t *buffer)
+{
+	safe_unpack32(&index->job_id, buffer);
+	safe_unpack32(&index->length, buffer);
+	safe_unpack64(&index->offset, buffer);
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/* This is a variation of slurm_make_time_str() in src/common/parse_time.h
+ * This version uses ISO8601 format by default. */
+static char *_make_time_str(time_t time)
+{
+	char string[32];
+	struct tm time_tm;
+
+	if (!time)
+		return xstrdup("Unknown");
+
+	/* Format YYYY-MM-DDTHH:MM:SS, ISO8601 standard format */
+	localtime_r(&time, &time_tm);
+	strftime(string, sizeof(string), "%FT%T", &time_tm);
+
+	return xstrdup(string);
+}
+
+static char *_make_exit_code_str(uint32_t exit_code)
+{
+	int tmp_int = 0, tmp_int2 = 0;
+
+	if (exit_code == NO_VAL)
+		;
+	else if (WIFSIGNALED(exit_code))
+		tmp_int2 = WTERMSIG(exit_code);
+	else if (WIFEXITED(exit_code))
+		tmp_int = WEXITSTATUS(exit_code);
+
+	return xstrdup_printf("%d:%d", tmp_int, tmp_int2);
+}
+
+static bool _match_job_id(slurmdb_job_cond_t *job_cond, uint32_t job_id)
+{
+	slurm_selected_step_t *selected_step;
+	ListIterator itr;
+	bool match = false;
+
+	if (!job_cond->step_list || !list_count(job_cond->step_list))
+		return true;
+
+	itr = list_iterator_create(job_cond->step_list);
+	while ((selected_step = list_next(itr))) {
+		if (selected_step->step_id.job_id == job_id) {
+			match = true;
+			break;
+		}
+	}
+	list_iterator_destroy(itr);
+
+	return match;
+}
+
+static bool _match_partition(slurmdb_job_cond_t *job_cond, char *partition)
+{
+	if (!job_cond->partition_list || !list_count(job_cond->partition_list))
+		return true;
+	if (!partition)
+		return false;
+
+	return list_find_first(job_cond->partition_list,
+			       slurm_find_char_in_list, partition);
+}
+
+/* Unpack the record the index entry points to, NULL if filtered out */
+static jobcomp_job_rec_t *_unpack_record(binary_jobcomp_index_t *index,
+					 buf_t *buffer,
+					 slurmdb_job_cond_t *job_cond)
+{
+	jobcomp_job_rec_t *job = xmalloc(sizeof(*job));
+	uint32_t length, job_state, time_limit, exit_code, tmp32;
+	time_t start_time, end_time, tmp_time;
+	char *name = NULL;
+
+	set_buf_offset(buffer, index->offset);
+	safe_unpack32(&length, buffer);
+	if ((length != index->length) ||
+	    (length > remaining_buf(buffer)))
+		goto unpack_error;
+
+	safe_unpack32(&job->jobid, buffer);
+	if (job->jobid != index->job_id)
+		goto unpack_error;
+	safe_unpack_time(&end_time, buffer);
+	safe_unpack_time(&start_time, buffer);
+
+	safe_unpackstr(&job->partition, buffer);
+	if (!_match_partition(job_cond, job->partition)) {
+		jobcomp_destroy_job(job);
+		return NULL;
+	}
+
+	safe_unpack32(&job->uid, buffer);
+	safe_unpack32(&job->gid, buffer);
+	safe_unpackstr(&job->jobname, buffer);
+	safe_unpack32(&job_state, buffer);
+	safe_unpack32(&time_limit, buffer);
+	safe_unpackstr(&job->nodelist, buffer);
+	safe_unpack32(&job->node_cnt, buffer);
+	safe_unpack32(&job->proc_cnt, buffer);
+	safe_unpackstr(&job->work_dir, buffer);
+	safe_unpackstr(&job->resv_name, buffer);
+	safe_unpackstr(&job->tres_fmt_req_str, buffer);
+	safe_unpackstr(&job->account, buffer);
+	safe_unpackstr(&job->qos_name, buffer);
+	safe_unpackstr(&job->wckey, buffer);
+	safe_unpackstr(&job->cluster, buffer);
+	safe_unpack_time(&tmp_time, buffer);
+	job->submit_time = _make_time_str(tmp_time);
+	safe_unpack_time(&tmp_time, buffer);
+	job->eligible_time = _make_time_str(tmp_time);
+	safe_unpack32(&tmp32, buffer);
+	job->derived_ec = _make_exit_code_str(tmp32);
+	safe_unpack32(&exit_code, buffer);
+	job->exit_code = _make_exit_code_str(exit_code);
+
+	job->start_time = _make_time_str(start_time);
+	job->end_time = _make_time_str(end_time);
+	if (start_time)
+		job->elapsed_time = end_time - start_time;
+	job->state = xstrdup(job_state_string(job_state));
+	if (time_limit == INFINITE)
+		job->timelimit = xstrdup("UNLIMITED");
+	else
+		job->timelimit = xstrdup_printf("%u", time_limit);
+
+	/* Names are resolved here so the writer never blocks on NSS */
+	name = uid_to_string_or_null(job->uid);
+	job->uid_name = xstrdup_printf("%s(%u)", name, job->uid);
+	xfree(name);
+	name = gid_to_string_or_null(job->gid);
+	job->gid_name = xstrdup_printf("%s(%u)", name, job->gid);
+	xfree(name);
+
+	return job;
+
+unpack_error:
+	error("%s: corrupt record for JobId=%u at offset %"PRIu64,
+	      __func__, index->job_id, index->offset);
+	jobcomp_destroy_job(job);
+	return NULL;
+}
+
+static void _process_segment(const char *dir, uint32_t seq,
+			     slurmdb_job_cond_t *job_cond, List job_list)
+{
+	char *data_path = binary_jobcomp_segment_path(dir, seq, false);
+	char *index_path = binary_jobcomp_segment_path(dir, seq, true);
+	buf_t *data = NULL, *index = NULL;
+	binary_jobcomp_index_t entry;
+	jobcomp_job_rec_t *job;
+
+	if (!(index = create_mmap_buf(index_path)) ||
+	    !(data = create_mmap_buf(data_path))) {
+		error("%s: unable to map segment %s", __func__, data_path);
+		goto end;
+	}
+
+	if (binary_jobcomp_unpack_header(BINARY_JOBCOMP_INDEX_MAGIC, index) ||
+	    binary_jobcomp_unpack_header(BINARY_JOBCOMP_DATA_MAGIC, data)) {
+		error("%s: invalid header in segment %s", __func__, data_path);
+		goto end;
+	}
+
+	while (remaining_buf(index) >= BINARY_JOBCOMP_INDEX_SIZE) {
+		if (binary_jobcomp_unpack_index(&entry, index))
+			break;
+		if (!_match_job_id(job_cond, entry.job_id))
+			continue;
+		/* The writer may still be appending to the last segment */
+		if ((entry.offset + sizeof(uint32_t) + entry.length) >
+		    size_buf(data))
+			break;
+		if ((job = _unpack_record(&entry, data, job_cond)))
+			list_append(job_list, job);
+	}
+
+end:
+	FREE_NULL_BUFFER(data);
+	FREE_NULL_BUFFER(index);
+	xfree(data_path);
+	xfree(index_path);
+}
+
+extern List binary_jobcomp_process_get_jobs(slurmdb_job_cond_t *job_cond)
+{
+	List job_list = list_create(jobcomp_destroy_job);
+	uint32_t *seqs = NULL;
+	int cnt;
+
+	if ((cnt = binary_jobcomp_segment_list(slurm_conf.job_comp_loc,
+					       &seqs)) < 0)
+		return job_list;
+
+	for (int i = 0; i < cnt; i++)
+		_process_segment(slurm_conf.job_comp_loc, seqs[i], job_cond,
+				 job_list);
+	xfree(seqs);
+
+	return job_list;
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************\
+ *  binary_jobcomp_process.h - functions shared by the writer and reader of
+ *  the jobcomp/binary plugin.
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _HAVE_BINARY_JOBCOMP_PROCESS_H
+#define _HAVE_BINARY_JOBCOMP_PROCESS_H
+
+#include "src/common/pack.h"
+#include "src/interfaces/jobcomp.h"
+
+/*
+ * JobCompLoc is a directory holding numbered segments. Each segment is a pair
+ * of files:
+ *
+ *	jobcomp.NNNNNNNN.bin - header followed by length prefixed records
+ *	jobcomp.NNNNNNNN.idx - header followed by fixed size index entries
+ *
+ * Both headers are a magic number and a format version. A record is a pack32
+ * length followed by the packed fields of one job, starting with its job id.
+ * The index holds one entry per record so a reader can seek straight to the
+ * records it wants and the writer can find the last complete record after a
+ * crash.
+ */
+#define BINARY_JOBCOMP_DATA_MAGIC	0x4a434244 /* "JCBD" */
+#define BINARY_JOBCOMP_INDEX_MAGIC	0x4a434249 /* "JCBI" */
+#define BINARY_JOBCOMP_VERSION		1
+#define BINARY_JOBCOMP_HEADER_SIZE	6	/* magic + version */
+#define BINARY_JOBCOMP_INDEX_SIZE	16	/* job_id + length + offset */
+#define BINARY_JOBCOMP_PREFIX		"jobcomp."
+
+typedef struct {
+	uint32_t job_id;
+	uint32_t length;	/* of the record, without its length prefix */
+	uint64_t offset;	/* of the length prefix in the .bin file */
+} binary_jobcomp_index_t;
+
+/* Return xmalloc'ed path of segment seq, the .idx file if index is set */
+extern char *binary_jobcomp_segment_path(const char *dir, uint32_t seq,
+					 bool index);
+
+/*
+ * Get the sequence numbers of all segments in dir, sorted ascending.
+ * OUT seqs - xmalloc'ed array, to be xfree'd by the caller
+ * RET number of segments found or -1 on error
+ */
+extern int binary_jobcomp_segment_list(const char *dir, uint32_t **seqs);
+
+extern void binary_jobcomp_pack_header(uint32_t magic, buf_t *buffer);
+extern int binary_jobcomp_unpack_header(uint32_t magic, buf_t *buffer);
+
+extern void binary_jobcomp_pack_index(binary_jobcomp_index_t *index,
+				      buf_t *buffer);
+extern int binary_jobcomp_unpack_index(binary_jobcomp_index_t *index,
+				       buf_t *buffer);
+
+extern List binary_jobcomp_process_get_jobs(slurmdb_job_cond_t *job_cond);
+
+#endif
@@ -0,0 +1,513 @@
+/*****************************************************************************\
+ *  jobcomp_binary.c - binary file slurm job completion logging plugin.
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/slurm_xlator.h"
+#include "src/common/fd.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/interfaces/jobcomp.h"
+#include "binary_jobcomp_process.h"
+
+/*
+ * These variables are required by the generic plugin interface.  If they
+ * are not found in the plugin, the plugin loader will ignore it.
+ *
+ * plugin_name - a string giving a human-readable description of the
+ * plugin.  There is no maximum length, but the symbol must refer to
+ * a valid string.
+ *
+ * plugin_type - a string suggesting the type of the plugin or its
+ * applicability to a particular form of data or method of data handling.
+ * If the low-level plugin API is used, the contents of this string are
+ * unimportant and may be anything.  Slurm uses the higher-level plugin
+ * interface which requires this string to be of the form
+ *
+ *	<application>/<method>
+ *
+ * where <application> is a description of the intended application of
+ * the plugin (e.g., "jobcomp" for Slurm job completion logging) and <method>
+ * is a description of how this plugin satisfies that application.  Slurm will
+ * only load job completion logging plugins if the plugin_type string has a
+ * prefix of "jobcomp/".
+ *
+ * plugin_version - an unsigned 32-bit integer containing the Slurm version
+ * (major.minor.micro combined into a single number).
+ */
+const char plugin_name[]       	= "Job completion binary file logging plugin";
+const char plugin_type[]       	= "jobcomp/binary";
+const uint32_t plugin_version	= SLURM_VERSION_NUMBER;
+
+const char default_job_comp_loc[] = "/var/log/slurm_jobcomp";
+
+#define DEFAULT_SEGMENT_SIZE	64	/* MB */
+#define MAX_SEGMENT_SIZE	2048	/* MB, a segment must fit in a buf_t */
+
+static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *log_dir = NULL;
+static int data_fd = -1;
+static int index_fd = -1;
+static uint32_t segment_seq = 0;
+static uint64_t segment_size = 0;	/* bytes of complete records + header */
+static uint64_t max_segment_size = DEFAULT_SEGMENT_SIZE * 1024 * 1024;
+
+/* Reused for every record so logging a job does not allocate */
+static buf_t *record_buf = NULL;
+static buf_t *index_buf = NULL;
+
+/*
+ * init() is called when the plugin is loaded, before any other functions
+ * are called.  Put global initialization here.
+ */
+int init(void)
+{
+	record_buf = init_buf(BUF_SIZE);
+	index_buf = init_buf(BINARY_JOBCOMP_INDEX_SIZE);
+	return SLURM_SUCCESS;
+}
+
+static void _close_segment(void)
+{
+	if (data_fd >= 0)
+		close(data_fd);
+	if (index_fd >= 0)
+		close(index_fd);
+	data_fd = index_fd = -1;
+}
+
+int fini(void)
+{
+	_close_segment();
+	xfree(log_dir);
+	FREE_NULL_BUFFER(record_buf);
+	FREE_NULL_BUFFER(index_buf);
+	return SLURM_SUCCESS;
+}
+
+static void _parse_params(void)
+{
+	static char *segment_size_key = "segment_size=";
+	char *begin;
+	unsigned long size;
+
+	max_segment_size = DEFAULT_SEGMENT_SIZE;
+	if ((begin = xstrcasestr(slurm_conf.job_comp_params,
+				 segment_size_key))) {
+		size = strtoul(begin + strlen(segment_size_key), NULL, 10);
+		if (!size || (size > MAX_SEGMENT_SIZE))
+			error("Invalid JobCompParams %s%s, using %u",
+			      segment_size_key,
+			      begin + strlen(segment_size_key),
+			      DEFAULT_SEGMENT_SIZE);
+		else
+			max_segment_size = size;
+	}
+	max_segment_size *= 1024 * 1024;
+}
+
+static int _write_header(int fd, uint32_t magic)
+{
+	char data[BINARY_JOBCOMP_HEADER_SIZE];
+	buf_t *buffer = create_buf(data, sizeof(data));
+	int rc = SLURM_SUCCESS;
+
+	binary_jobcomp_pack_header(magic, buffer);
+	/* free buffer, but not the memory to which it points */
+	buffer->head = NULL;
+	FREE_NULL_BUFFER(buffer);
+
+	if (ftruncate(fd, 0) < 0)
+		return SLURM_ERROR;
+	safe_write(fd, data, sizeof(data));
+	return rc;
+
+rwfail:
+	return SLURM_ERROR;
+}
+
+static int _check_header(int fd, uint32_t magic)
+{
+	char data[BINARY_JOBCOMP_HEADER_SIZE];
+	buf_t *buffer;
+	int rc;
+
+	if (pread(fd, data, sizeof(data), 0) != sizeof(data))
+		return SLURM_ERROR;
+
+	buffer = create_buf(data, sizeof(data));
+	rc = binary_jobcomp_unpack_header(magic, buffer);
+	/* free buffer, but not the memory to which it points */
+	buffer->head = NULL;
+	FREE_NULL_BUFFER(buffer);
+
+	return rc;
+}
+
+/*
+ * Bring the open segment back to a consistent state after a crash or a failed
+ * write. Index entries pointing past the end of the data are dropped, complete
+ * records without an index entry are indexed again and a torn record at the
+ * end of the data is cut off.
+ */
+static int _recover_segment(void)
+{
+	char data[BINARY_JOBCOMP_INDEX_SIZE];
+	binary_jobcomp_index_t entry = { 0 };
+	struct stat data_st, index_st;
+	uint64_t entries, data_end = BINARY_JOBCOMP_HEADER_SIZE;
+	buf_t *buffer;
+	int rc = SLURM_SUCCESS;
+
+	if (fstat(data_fd, &data_st) || fstat(index_fd, &index_st))
+		return SLURM_ERROR;
+
+	buffer = create_buf(data, sizeof(data));
+
+	if (index_st.st_size < BINARY_JOBCOMP_HEADER_SIZE)
+		entries = 0;
+	else
+		entries = (index_st.st_size - BINARY_JOBCOMP_HEADER_SIZE) /
+			  BINARY_JOBCOMP_INDEX_SIZE;
+	while (entries) {
+		off_t offset = BINARY_JOBCOMP_HEADER_SIZE +
+			       ((entries - 1) * BINARY_JOBCOMP_INDEX_SIZE);
+
+		if (pread(index_fd, data, sizeof(data), offset) !=
+		    sizeof(data)) {
+			rc = SLURM_ERROR;
+			goto end;
+		}
+		set_buf_offset(buffer, 0);
+		if (binary_jobcomp_unpack_index(&entry, buffer)) {
+			rc = SLURM_ERROR;
+			goto end;
+		}
+		data_end = entry.offset + sizeof(uint32_t) + entry.length;
+		if (data_end <= data_st.st_size)
+			break;
+		data_end = BINARY_JOBCOMP_HEADER_SIZE;
+		entries--;
+	}
+
+	if (ftruncate(index_fd, BINARY_JOBCOMP_HEADER_SIZE +
+				(entries * BINARY_JOBCOMP_INDEX_SIZE)) < 0) {
+		rc = SLURM_ERROR;
+		goto end;
+	}
+
+	/* Index the records written after the last index entry */
+	while ((data_end + (2 * sizeof(uint32_t))) <= data_st.st_size) {
+		if (pread(data_fd, data, 2 * sizeof(uint32_t), data_end) !=
+		    (2 * sizeof(uint32_t))) {
+			rc = SLURM_ERROR;
+			goto end;
+		}
+		set_buf_offset(buffer, 0);
+		entry.offset = data_end;
+		if (unpack32(&entry.length, buffer) ||
+		    unpack32(&entry.job_id, buffer) ||
+		    ((data_end + sizeof(uint32_t) + entry.length) >
+		     data_st.st_size))
+			break;
+
+		set_buf_offset(index_buf, 0);
+		binary_jobcomp_pack_index(&entry, index_buf);
+		safe_write(index_fd, get_buf_data(index_buf),
+			   get_buf_offset(index_buf));
+		data_end += sizeof(uint32_t) + entry.length;
+		info("%s: recovered index entry for JobId=%u",
+		     plugin_type, entry.job_id);
+	}
+
+	if (data_end < data_st.st_size) {
+		info("%s: discarding %"PRIu64" bytes of incomplete record",
+		     plugin_type, (uint64_t) (data_st.st_size - data_end));
+		if (ftruncate(data_fd, data_end) < 0) {
+			rc = SLURM_ERROR;
+			goto end;
+		}
+	}
+
+	segment_size = data_end;
+
+end:
+	/* free buffer, but not the memory to which it points */
+	buffer->head = NULL;
+	FREE_NULL_BUFFER(buffer);
+	return rc;
+
+rwfail:
+	rc = SLURM_ERROR;
+	goto end;
+}
+
+static int _open_segment(uint32_t seq)
+{
+	char *data_path = binary_jobcomp_segment_path(log_dir, seq, false);
+	char *index_path = binary_jobcomp_segment_path(log_dir, seq, true);
+	struct stat st;
+	int rc = SLURM_ERROR;
+
+	_close_segment();
+
+	if ((data_fd = open(data_path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+			    0644)) < 0) {
+		error("open %s: %m", data_path);
+		goto end;
+	}
+	if ((index_fd = open(index_path,
+			     O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC,
+			     0644)) < 0) {
+		error("open %s: %m", index_path);
+		goto end;
+	}
+
+	if (fstat(data_fd, &st) < 0) {
+		error("fstat %s: %m", data_path);
+		goto end;
+	}
+	if (!st.st_size) {
+		if (_write_header(data_fd, BINARY_JOBCOMP_DATA_MAGIC) ||
+		    _write_header(index_fd, BINARY_JOBCOMP_INDEX_MAGIC)) {
+			error("unable to initialize %s: %m", data_path);
+			goto end;
+		}
+	} else if (_check_header(data_fd, BINARY_JOBCOMP_DATA_MAGIC)) {
+		error("%s is not a job completion segment", data_path);
+		goto end;
+	} else if (_check_header(index_fd, BINARY_JOBCOMP_INDEX_MAGIC)) {
+		/* The index can always be rebuilt from the data */
+		info("%s: rebuilding index %s", plugin_type, index_path);
+		if (_write_header(index_fd, BINARY_JOBCOMP_INDEX_MAGIC)) {
+			error("unable to initialize %s: %m", index_path);
+			goto end;
+		}
+	}
+
+	if (_recover_segment()) {
+		error("unable to recover %s: %m", data_path);
+		goto end;
+	}
+
+	segment_seq = seq;
+	rc = SLURM_SUCCESS;
+
+end:
+	if (rc != SLURM_SUCCESS)
+		_close_segment();
+	xfree(data_path);
+	xfree(index_path);
+	return rc;
+}
+
+/*
+ * The remainder of this file implements the standard Slurm job completion
+ * logging API.
+ */
+
+extern int jobcomp_p_set_location(void)
+{
+	uint32_t *seqs = NULL, seq = 0;
+	int cnt, rc = SLURM_SUCCESS;
+
+	if (!slurm_conf.job_comp_loc)
+		slurm_conf.job_comp_loc = xstrdup(default_job_comp_loc);
+
+	_parse_params();
+
+	slurm_mutex_lock(&file_lock);
+	xfree(log_dir);
+	log_dir = xstrdup(slurm_conf.job_comp_loc);
+
+	if (mkdirpath(log_dir, 0755, true))
+		fatal("mkdir %s: %m", log_dir);
+	if ((cnt = binary_jobcomp_segment_list(log_dir, &seqs)) > 0)
+		seq = seqs[cnt - 1];
+	xfree(seqs);
+
+	/* Never append to a segment we cannot make sense of */
+	if (_open_segment(seq) && _open_segment(seq + 1)) {
+		fatal("unable to open a job completion segment in %s",
+		      log_dir);
+		rc = SLURM_ERROR;
+	}
+	slurm_mutex_unlock(&file_lock);
+
+	return rc;
+}
+
+static void _pack_record(job_record_t *job_ptr, buf_t *buffer)
+{
+	time_t start_time, end_time;
+	uint32_t job_state, time_limit;
+	char *work_dir = "unknown", *qos = NULL, *cluster = "unknown";
+	uint32_t length_offset = get_buf_offset(buffer), end_offset;
+
+	if ((job_ptr->time_limit == NO_VAL) && job_ptr->part_ptr)
+		time_limit = job_ptr->part_ptr->max_time;
+	else
+		time_limit = job_ptr->time_limit;
+
+	if (job_ptr->job_state & JOB_RESIZING) {
+		job_state = job_ptr->job_state;
+		start_time = job_ptr->resize_time ?
+			job_ptr->resize_time : job_ptr->start_time;
+		end_time = time(NULL);
+	} else {
+		/* Job state will typically have JOB_COMPLETING or JOB_RESIZING
+		 * flag set when called. We remove the flags to get the eventual
+		 * completion state: JOB_FAILED, JOB_TIMEOUT, etc. */
+		job_state = job_ptr->job_state & JOB_STATE_BASE;
+		if (job_ptr->resize_time)
+			start_time = job_ptr->resize_time;
+		else if (job_ptr->start_time > job_ptr->end_time)
+			start_time = 0;	/* cancelled while pending */
+		else
+			start_time = job_ptr->start_time;
+		end_time = job_ptr->end_time;
+	}
+
+	if (job_ptr->details && job_ptr->details->work_dir)
+		work_dir = job_ptr->details->work_dir;
+	if (job_ptr->qos_ptr)
+		qos = job_ptr->qos_ptr->name;
+	if (job_ptr->assoc_ptr)
+		cluster = job_ptr->assoc_ptr->cluster;
+
+	pack32(0, buffer);	/* length, filled in below */
+
+	/* Recovery and the index rely on the job id being first */
+	pack32(job_ptr->job_id, buffer);
+	pack_time(end_time, buffer);
+	pack_time(start_time, buffer);
+	packstr(job_ptr->partition, buffer);
+	pack32(job_ptr->user_id, buffer);
+	pack32(job_ptr->group_id, buffer);
+	packstr(job_ptr->name, buffer);
+	pack32(job_state, buffer);
+	pack32(time_limit, buffer);
+	packstr(job_ptr->nodes, buffer);
+	pack32(job_ptr->node_cnt, buffer);
+	pack32(job_ptr->total_cpus, buffer);
+	packstr(work_dir, buffer);
+	packstr(job_ptr->resv_name, buffer);
+	packstr(job_ptr->tres_fmt_req_str, buffer);
+	packstr(job_ptr->account, buffer);
+	packstr(qos, buffer);
+	packstr(job_ptr->wckey, buffer);
+	packstr(cluster, buffer);
+	pack_time(job_ptr->details ? job_ptr->details->submit_time : 0,
+		  buffer);
+	pack_time(job_ptr->details ? job_ptr->details->begin_time : 0,
+		  buffer);
+	pack32(job_ptr->derived_ec, buffer);
+	pack32(job_ptr->exit_code, buffer);
+
+	/* Not shown by sacct, records are free to grow at the end */
+	pack32(job_ptr->array_job_id, buffer);
+	pack32(job_ptr->array_task_id, buffer);
+	pack32(job_ptr->het_job_id, buffer);
+	pack32(job_ptr->het_job_offset, buffer);
+
+	end_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, length_offset);
+	pack32(end_offset - length_offset - sizeof(uint32_t), buffer);
+	set_buf_offset(buffer, end_offset);
+}
+
+extern int jobcomp_p_log_record(job_record_t *job_ptr)
+{
+	binary_jobcomp_index_t entry;
+	uint32_t size;
+	int rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&file_lock);
+	if ((log_dir == NULL) || (data_fd < 0)) {
+		error("JobCompLoc directory %s not open", log_dir);
+		slurm_mutex_unlock(&file_lock);
+		return SLURM_ERROR;
+	}
+
+	set_buf_offset(record_buf, 0);
+	_pack_record(job_ptr, record_buf);
+	size = get_buf_offset(record_buf);
+
+	if ((segment_size > BINARY_JOBCOMP_HEADER_SIZE) &&
+	    ((segment_size + size) > max_segment_size) &&
+	    _open_segment(segment_seq + 1)) {
+		error("%s: unable to rotate to a new segment, JobId=%u not logged",
+		      plugin_type, job_ptr->job_id);
+		slurm_mutex_unlock(&file_lock);
+		return SLURM_ERROR;
+	}
+
+	entry.job_id = job_ptr->job_id;
+	entry.length = size - sizeof(uint32_t);
+	entry.offset = segment_size;
+	set_buf_offset(index_buf, 0);
+	binary_jobcomp_pack_index(&entry, index_buf);
+
+	safe_write(data_fd, get_buf_data(record_buf), size);
+	safe_write(index_fd, get_buf_data(index_buf),
+		   get_buf_offset(index_buf));
+	segment_size += size;
+
+	slurm_mutex_unlock(&file_lock);
+	return rc;
+
+rwfail:
+	error("%s: unable to log JobId=%u: %m", plugin_type, job_ptr->job_id);
+	/* Cut off whatever part of the record made it to disk */
+	if (_recover_segment())
+		_close_segment();
+	slurm_mutex_unlock(&file_lock);
+	return SLURM_ERROR;
+}
+
+/*
+ * get info from the segments
+ * in/out job_list List of job_rec_t *
+ * note List needs to be freed when called
+ */
+extern List jobcomp_p_get_jobs(slurmdb_job_cond_t *job_cond)
+{
+	return binary_jobcomp_process_get_jobs(job_cond);
+}
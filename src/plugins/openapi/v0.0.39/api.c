@@ -320,6 +320,31 @@ extern int get_date_param(data_t *query, const char *param, time_t *time)
 	return SLURM_SUCCESS;
 }
 
+extern int set_fields_param(ctxt_t *ctxt, data_parser_type_t type)
+{
+	int rc;
+	data_t *dfields = data_key_get(ctxt->query, "fields");
+	data_parser_fields_t fields = {
+		.type = type,
+	};
+
+	if (!dfields)
+		return SLURM_SUCCESS;
+
+	if (data_convert_type(dfields, DATA_TYPE_STRING) != DATA_TYPE_STRING)
+		return resp_error(ctxt, ESLURM_REST_INVALID_QUERY, __func__,
+				  "Unable to parse \"fields\" parameter");
+
+	fields.fields = data_get_string_const(dfields);
+
+	if ((rc = data_parser_g_assign(ctxt->parser, DATA_PARSER_ATTR_FIELDS,
+				       &fields)) && !ctxt->rc)
+		resp_error(ctxt, rc, __func__,
+			   "Unable to use \"fields\" parameter");
+
+	return ctxt->rc;
+}
+
 extern data_t *slurm_openapi_p_get_specification(openapi_spec_flags_t *flags)
 {
 	static data_parser_t *parser;
@@ -110,6 +110,14 @@ extern char *get_str_param_funcname(const char *path, ctxt_t *ctxt,
 
 extern int get_date_param(data_t *query, const char *param, time_t *time);
 
+/*
+ * Only dump fields of each record requested by "fields" query parameter
+ * IN ctxt - connection context
+ * IN type - type of each record
+ * RET SLURM_SUCCESS or error
+ */
+extern int set_fields_param(ctxt_t *ctxt, data_parser_type_t type);
+
 /* ------------ declarations for each operation --------------- */
 
 extern void init_op_diag(void);
@@ -48,6 +48,33 @@
 
 #include "src/plugins/openapi/v0.0.39/api.h"
 
+typedef struct {
+	ctxt_t *ctxt;
+	job_info_msg_t *job_info_ptr;
+} dump_jobs_args_t;
+
+static int _dump_jobs(void *arg, const char *key, data_t *dst,
+		      serializer_stream_t *stream)
+{
+	dump_jobs_args_t *args = arg;
+
+	if (stream)
+		return DATA_DUMP_STREAM(args->ctxt->parser, JOB_INFO_MSG,
+					*args->job_info_ptr, key, stream);
+
+	return DATA_DUMP(args->ctxt->parser, JOB_INFO_MSG, *args->job_info_ptr,
+			 dst);
+}
+
+static void _free_dump_jobs(void *arg)
+{
+	dump_jobs_args_t *args = arg;
+
+	slurm_free_job_info_msg(args->job_info_ptr);
+	(void) fini_connection(args->ctxt);
+	xfree(args);
+}
+
 static int _op_handler_jobs(const char *context_id,
 			    http_request_method_t method, data_t *parameters,
 			    data_t *query, int tag, data_t *resp, void *auth)
@@ -56,6 +83,7 @@ static int _op_handler_jobs(const char *context_id,
 				       tag, resp, auth);
 	time_t update_time = 0; /* default to unix epoch */
 	job_info_msg_t *job_info_ptr = NULL;
+	dump_jobs_args_t *args;
 	int rc;
 
 	debug4("%s: jobs handler called by %s", __func__, ctxt->id);
@@ -73,6 +101,9 @@ static int _op_handler_jobs(const char *context_id,
 		goto cleanup;
 	}
 
+	if ((rc = set_fields_param(ctxt, DATA_PARSER_JOB_INFO)))
+		goto cleanup;
+
 	rc = slurm_load_jobs(update_time, &job_info_ptr,
 			     SHOW_ALL | SHOW_DETAIL);
 
@@ -86,8 +117,19 @@ static int _op_handler_jobs(const char *context_id,
 		goto cleanup;
 	}
 
-	DATA_DUMP(ctxt->parser, JOB_INFO_MSG, *job_info_ptr,
-		  data_key_set(resp, "jobs"));
+	if ((rc = ctxt->rc))
+		goto cleanup;
+
+	/*
+	 * Jobs are dumped directly to the client after returning to avoid
+	 * holding every job as a data_t at once.
+	 */
+	args = xmalloc(sizeof(*args));
+	args->ctxt = ctxt;
+	args->job_info_ptr = job_info_ptr;
+	openapi_stream_resp_key("jobs", _dump_jobs, args, _free_dump_jobs);
+
+	return rc;
 
 cleanup:
 	slurm_free_job_info_msg(job_info_ptr);
@@ -111,6 +153,9 @@ static void _handle_job_get(ctxt_t *ctxt, slurm_selected_step_t *job_id)
 		resp_warn(ctxt, __func__,
 			  "Job steps are not supported for job searches. Showing whole job instead.");
 
+	if (set_fields_param(ctxt, DATA_PARSER_JOB_INFO))
+		return;
+
 	if ((rc = slurm_load_job(&job_info_ptr, id, SHOW_ALL | SHOW_DETAIL))) {
 		char *id = NULL;
 
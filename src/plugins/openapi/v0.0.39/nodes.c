@@ -101,6 +101,9 @@ static void _dump_nodes(ctxt_t *ctxt, char *name)
 	node_info_msg_t *node_info_ptr = NULL;
 	data_t *dnodes = data_key_set(ctxt->resp, "nodes");
 
+	if (set_fields_param(ctxt, DATA_PARSER_NODE))
+		goto done;
+
 	if (!name) {
 		if (get_date_param(ctxt->query, "update_time", &update_time))
 			goto done;
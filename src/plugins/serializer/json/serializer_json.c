@@ -36,11 +36,9 @@
 
 #include "config.h"
 
-#if HAVE_JSON_C_INC
-#include <json-c/json.h>
-#else
-#include <json/json.h>
-#endif
+#include <inttypes.h>
+#include <math.h>
+#include <strings.h>
 
 #include "slurm/slurm.h"
 #include "src/common/slurm_xlator.h"
@@ -49,9 +47,18 @@
 #include "src/common/log.h"
 #include "src/common/read_config.h"
 #include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/interfaces/serializer.h"
 
+#define WRITER_MAGIC 0x1a8aa0be
+#define WRITER_BUFFER_SIZE (64 * 1024)
+#define WRITER_INDENT 2
+#define READER_MAGIC 0x1a8ab0cd
+#define READER_BUFFER_SIZE 1024
+/* same maximum nesting as json-c tokener */
+#define READER_MAX_DEPTH 32
+
 /*
  * These variables are required by the generic plugin interface.  If they
  * are not found in the plugin, the plugin loader will ignore it.
@@ -86,7 +93,46 @@ const char *mime_types[] = {
 	NULL
 };
 
-static json_object *_data_to_json(const data_t *d);
+/*
+ * Write JSON text directly instead of building a json-c object tree first.
+ * Output matches json_object_to_json_string_ext() for the same flags.
+ */
+typedef struct {
+	data_type_t type; /* DATA_TYPE_DICT or DATA_TYPE_LIST */
+	bool had_children;
+} writer_level_t;
+
+typedef struct {
+	int magic; /* WRITER_MAGIC */
+	bool pretty;
+	int rc; /* first error from write_func */
+	serializer_write_t write_func;
+	void *write_arg;
+	char *buffer;
+	size_t used; /* bytes pending in buffer */
+	writer_level_t *levels;
+	int depth; /* number of open containers */
+	int levels_size;
+} writer_t;
+
+/*
+ * Parse JSON text directly into data_t in a single pass instead of building a
+ * json-c object tree first. Accepts the same extensions to JSON as json-c does
+ * when not in strict mode: comments, single quoted strings, trailing
+ * separators, case insensitive literals, NaN and Infinity.
+ */
+typedef struct {
+	int magic; /* READER_MAGIC */
+	const char *src;
+	const char *pos; /* next character to read */
+	const char *end; /* end of src */
+	int depth; /* number of open containers */
+	const char *error; /* reason of first parsing error */
+	const char *error_pos; /* position of first parsing error */
+	char *buffer; /* decoded string or number */
+	size_t used; /* bytes used in buffer */
+	size_t size; /* bytes allocated for buffer */
+} reader_t;
 
 extern int serializer_p_init(void)
 {
@@ -103,196 +149,898 @@ extern int serializer_p_fini(void)
 }
 
 
-static json_object *_try_parse(const char *src, size_t stringlen,
-			       struct json_tokener *tok)
+/* Reader helpers all return SLURM_SUCCESS or ESLURM_DATA_CONV_FAILED */
+static int _fail(reader_t *r, const char *reason)
 {
-	json_object *jobj = json_tokener_parse_ex(tok, src, stringlen);
+	xassert(r->magic == READER_MAGIC);
 
-	if (jobj == NULL) {
-		enum json_tokener_error jerr = json_tokener_get_error(tok);
-		error("%s: JSON parsing error %zu bytes: %s",
-		      __func__, stringlen, json_tokener_error_desc(jerr));
-		return NULL;
+	if (!r->error) {
+		r->error = reason;
+		r->error_pos = r->pos;
 	}
-	if (tok->char_offset < stringlen)
-		log_flag(DATA, "%s: Extra %zu characters after JSON string detected",
-		     __func__, (stringlen - tok->char_offset));
 
-	return jobj;
+	return ESLURM_DATA_CONV_FAILED;
+}
+
+static void _buffer_append(reader_t *r, const char *str, size_t len)
+{
+	if ((r->used + len + 1) > r->size) {
+		while ((r->used + len + 1) > r->size)
+			r->size *= 2;
+		xrealloc_nz(r->buffer, r->size);
+	}
+
+	memcpy(r->buffer + r->used, str, len);
+	r->used += len;
+}
+
+/* Skip whitespace and comments (which json-c accepts in non-strict mode) */
+static int _skip_space(reader_t *r)
+{
+	while (r->pos < r->end) {
+		switch (*r->pos) {
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+			r->pos++;
+			break;
+		case '/':
+			if (((r->pos + 1) < r->end) && (r->pos[1] == '/')) {
+				while ((r->pos < r->end) && (*r->pos != '\n'))
+					r->pos++;
+			} else if (((r->pos + 1) < r->end) &&
+				   (r->pos[1] == '*')) {
+				const char *end = NULL;
+
+				for (const char *i = (r->pos + 2);
+				     (i + 1) < r->end; i++) {
+					if ((i[0] == '*') && (i[1] == '/')) {
+						end = i + 2;
+						break;
+					}
+				}
+
+				if (!end)
+					return _fail(r, "unterminated comment");
+
+				r->pos = end;
+			} else {
+				return _fail(r, "unexpected character");
+			}
+			break;
+		default:
+			return SLURM_SUCCESS;
+		}
+	}
+
+	return SLURM_SUCCESS;
 }
 
-static data_t *_json_to_data(json_object *jobj, data_t *d)
+static int _read_hex4(reader_t *r, uint32_t *codepoint)
 {
-	size_t arraylen = 0;
+	uint32_t cp = 0;
+
+	if ((r->end - r->pos) < 4)
+		return _fail(r, "truncated unicode escape");
+
+	for (int i = 0; i < 4; i++) {
+		const char c = *r->pos;
+
+		cp <<= 4;
+
+		if ((c >= '0') && (c <= '9'))
+			cp |= c - '0';
+		else if ((c >= 'a') && (c <= 'f'))
+			cp |= c - 'a' + 10;
+		else if ((c >= 'A') && (c <= 'F'))
+			cp |= c - 'A' + 10;
+		else
+			return _fail(r, "invalid unicode escape");
+
+		r->pos++;
+	}
+
+	*codepoint = cp;
+	return SLURM_SUCCESS;
+}
+
+/* Decode \uXXXX (after the "\u") to UTF-8 */
+static int _read_unicode(reader_t *r)
+{
+	uint32_t cp, low;
+	char utf8[4];
+	size_t len;
+	int rc;
+
+	if ((rc = _read_hex4(r, &cp)))
+		return rc;
+
+	if ((cp >= 0xD800) && (cp <= 0xDBFF)) {
+		const char *pos = r->pos;
+
+		/* high surrogate must be followed by escaped low surrogate */
+		if (((r->end - r->pos) >= 6) && (r->pos[0] == '\\') &&
+		    (r->pos[1] == 'u')) {
+			r->pos += 2;
+
+			if ((rc = _read_hex4(r, &low)))
+				return rc;
+
+			if ((low >= 0xDC00) && (low <= 0xDFFF)) {
+				cp = 0x10000 + ((cp - 0xD800) << 10) +
+				     (low - 0xDC00);
+			} else {
+				/* decode following escape on its own */
+				r->pos = pos;
+				cp = 0xFFFD;
+			}
+		} else {
+			cp = 0xFFFD;
+		}
+	} else if ((cp >= 0xDC00) && (cp <= 0xDFFF)) {
+		/* unpaired low surrogate */
+		cp = 0xFFFD;
+	}
+
+	if (cp < 0x80) {
+		utf8[0] = cp;
+		len = 1;
+	} else if (cp < 0x800) {
+		utf8[0] = 0xC0 | (cp >> 6);
+		utf8[1] = 0x80 | (cp & 0x3F);
+		len = 2;
+	} else if (cp < 0x10000) {
+		utf8[0] = 0xE0 | (cp >> 12);
+		utf8[1] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[2] = 0x80 | (cp & 0x3F);
+		len = 3;
+	} else {
+		utf8[0] = 0xF0 | (cp >> 18);
+		utf8[1] = 0x80 | ((cp >> 12) & 0x3F);
+		utf8[2] = 0x80 | ((cp >> 6) & 0x3F);
+		utf8[3] = 0x80 | (cp & 0x3F);
+		len = 4;
+	}
+
+	_buffer_append(r, utf8, len);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Decode quoted string into r->buffer.
+ * json-c accepts single quoted strings in non-strict mode.
+ */
+static int _read_string(reader_t *r)
+{
+	const char quote = *r->pos;
+	int rc;
+
+	xassert((quote == '"') || (quote == '\''));
+
+	r->pos++;
+	r->used = 0;
+
+	while (true) {
+		const char *run = r->pos;
+		char c;
+
+		/* copy runs of unescaped characters at once */
+		while ((r->pos < r->end) && (*r->pos != quote) &&
+		       (*r->pos != '\\'))
+			r->pos++;
+
+		if (r->pos > run)
+			_buffer_append(r, run, (r->pos - run));
+
+		if (r->pos >= r->end)
+			return _fail(r, "unterminated string");
+
+		if (*r->pos == quote) {
+			r->pos++;
+			break;
+		}
+
+		/* skip backslash */
+		r->pos++;
+
+		if (r->pos >= r->end)
+			return _fail(r, "unterminated string");
+
+		switch (*r->pos++) {
+		case '"':
+			c = '"';
+			break;
+		case '\\':
+			c = '\\';
+			break;
+		case '/':
+			c = '/';
+			break;
+		case 'b':
+			c = '\b';
+			break;
+		case 'f':
+			c = '\f';
+			break;
+		case 'n':
+			c = '\n';
+			break;
+		case 'r':
+			c = '\r';
+			break;
+		case 't':
+			c = '\t';
+			break;
+		case 'u':
+			if ((rc = _read_unicode(r)))
+				return rc;
+			continue;
+		default:
+			r->pos--;
+			return _fail(r, "invalid escape sequence");
+		}
+
+		_buffer_append(r, &c, 1);
+	}
+
+	r->buffer[r->used] = '\0';
+	return SLURM_SUCCESS;
+}
+
+static int _read_number(reader_t *r, data_t *d)
+{
+	const char *start = r->pos;
+	bool is_float = false;
+	char *end = NULL;
+
+	for (; r->pos < r->end; r->pos++) {
+		const char c = *r->pos;
+
+		if (((c >= '0') && (c <= '9')) || (c == '-') || (c == '+'))
+			continue;
+		else if ((c == '.') || (c == 'e') || (c == 'E'))
+			is_float = true;
+		else
+			break;
+	}
+
+	/* strtod() and strtoll() require a terminated string */
+	r->used = 0;
+	_buffer_append(r, start, (r->pos - start));
+	r->buffer[r->used] = '\0';
 
-	if (!d)
-		d = data_new();
+	if (is_float) {
+		double value = strtod(r->buffer, &end);
 
-	switch (json_object_get_type(jobj)) {
-	case json_type_null:
+		if ((end == r->buffer) || *end) {
+			r->pos = start;
+			return _fail(r, "invalid number");
+		}
+
+		data_set_float(d, value);
+	} else {
+		/* out of range values are clamped the same as json-c */
+		int64_t value = strtoll(r->buffer, &end, 10);
+
+		if ((end == r->buffer) || *end) {
+			r->pos = start;
+			return _fail(r, "invalid number");
+		}
+
+		data_set_int(d, value);
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static bool _match_literal(reader_t *r, const char *literal)
+{
+	const size_t len = strlen(literal);
+
+	if (((r->end - r->pos) < len) || strncasecmp(r->pos, literal, len))
+		return false;
+
+	r->pos += len;
+	return true;
+}
+
+/* json-c matches literals case insensitively in non-strict mode */
+static int _read_literal(reader_t *r, data_t *d)
+{
+	if (_match_literal(r, "true"))
+		data_set_bool(d, true);
+	else if (_match_literal(r, "false"))
+		data_set_bool(d, false);
+	else if (_match_literal(r, "null"))
 		data_set_null(d);
-		break;
-	case json_type_boolean:
-		data_set_bool(d, json_object_get_boolean(jobj));
-		break;
-	case json_type_double:
-		data_set_float(d, json_object_get_double(jobj));
-		break;
-	case json_type_int:
-		data_set_int(d, json_object_get_int64(jobj));
-		break;
-	case json_type_object:
-		data_set_dict(d);
-		/* warning: json_object_object_foreach is an evil macro */
-		json_object_object_foreach(jobj, key, val) {
-			_json_to_data(val, data_key_set(d, key));
+	else if (_match_literal(r, "NaN"))
+		data_set_float(d, NAN);
+	else if (_match_literal(r, "Infinity"))
+		data_set_float(d, INFINITY);
+	else if (_match_literal(r, "-Infinity"))
+		data_set_float(d, -INFINITY);
+	else
+		return _fail(r, "unexpected character");
+
+	return SLURM_SUCCESS;
+}
+
+static int _read_value(reader_t *r, data_t *d);
+
+/* Read separator after container entry and check for end of container */
+static int _read_next(reader_t *r, char close, bool *done)
+{
+	int rc;
+
+	if ((rc = _skip_space(r)))
+		return rc;
+
+	if (r->pos >= r->end)
+		return _fail(r, "unexpected end of input");
+
+	if (*r->pos == close) {
+		r->pos++;
+		*done = true;
+		return SLURM_SUCCESS;
+	}
+
+	if (*r->pos != ',')
+		return _fail(r, "expected separator");
+
+	r->pos++;
+
+	if ((rc = _skip_space(r)))
+		return rc;
+
+	/* json-c allows trailing separator in non-strict mode */
+	if ((r->pos < r->end) && (*r->pos == close)) {
+		r->pos++;
+		*done = true;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _read_list(reader_t *r, data_t *d)
+{
+	bool done = false;
+	int rc;
+
+	data_set_list(d);
+	r->pos++;
+
+	if ((rc = _skip_space(r)))
+		return rc;
+
+	if ((r->pos < r->end) && (*r->pos == ']')) {
+		r->pos++;
+		return SLURM_SUCCESS;
+	}
+
+	while (!done) {
+		if ((rc = _read_value(r, data_list_append(d))))
+			return rc;
+
+		if ((rc = _read_next(r, ']', &done)))
+			return rc;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _read_dict(reader_t *r, data_t *d)
+{
+	bool done = false;
+	int rc;
+
+	data_set_dict(d);
+	r->pos++;
+
+	if ((rc = _skip_space(r)))
+		return rc;
+
+	if ((r->pos < r->end) && (*r->pos == '}')) {
+		r->pos++;
+		return SLURM_SUCCESS;
+	}
+
+	while (!done) {
+		if ((r->pos >= r->end) ||
+		    ((*r->pos != '"') && (*r->pos != '\'')))
+			return _fail(r, "expected quoted key");
+
+		if ((rc = _read_string(r)))
+			return rc;
+
+		if ((rc = _skip_space(r)))
+			return rc;
+
+		if ((r->pos >= r->end) || (*r->pos != ':'))
+			return _fail(r, "expected ':' after key");
+
+		r->pos++;
+
+		if (!r->buffer[0]) {
+			/* data_t does not allow empty keys */
+			data_t *ignored = data_new();
+
+			log_flag(DATA, "%s: ignoring value of empty key at byte %zu",
+				 __func__, (size_t) (r->pos - r->src));
+
+			rc = _read_value(r, ignored);
+			FREE_NULL_DATA(ignored);
+		} else {
+			/* key is copied before buffer is reused */
+			rc = _read_value(r, data_key_set(d, r->buffer));
 		}
-		break;
-	case json_type_array:
-		arraylen = json_object_array_length(jobj);
-		data_set_list(d);
-		for (size_t i = 0; i < arraylen; i++)
-			_json_to_data(json_object_array_get_idx(jobj, i),
-				      data_list_append(d));
-		break;
-	case json_type_string:
-		data_set_string(d, json_object_get_string(jobj));
-		break;
+
+		if (rc)
+			return rc;
+
+		if ((rc = _read_next(r, '}', &done)))
+			return rc;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _read_value(reader_t *r, data_t *d)
+{
+	int rc;
+
+	if ((rc = _skip_space(r)))
+		return rc;
+
+	if (r->pos >= r->end)
+		return _fail(r, "unexpected end of input");
+
+	switch (*r->pos) {
+	case '{':
+	case '[':
+		if (r->depth >= READER_MAX_DEPTH)
+			return _fail(r, "nesting too deep");
+
+		r->depth++;
+		if (*r->pos == '{')
+			rc = _read_dict(r, d);
+		else
+			rc = _read_list(r, d);
+		r->depth--;
+
+		return rc;
+	case '"':
+	case '\'':
+		if ((rc = _read_string(r)))
+			return rc;
+
+		data_set_string(d, r->buffer);
+		return SLURM_SUCCESS;
+	case '-':
+		if (((r->pos + 1) < r->end) &&
+		    ((r->pos[1] == 'I') || (r->pos[1] == 'i')))
+			return _read_literal(r, d);
+		/* fall through */
+	case '0':
+	case '1':
+	case '2':
+	case '3':
+	case '4':
+	case '5':
+	case '6':
+	case '7':
+	case '8':
+	case '9':
+		return _read_number(r, d);
 	default:
-		fatal_abort("%s: unknown JSON type", __func__);
-	};
+		return _read_literal(r, d);
+	}
+}
+
+static int _flush(writer_t *w)
+{
+	if (!w->rc && w->used)
+		w->rc = w->write_func(w->buffer, w->used, w->write_arg);
+
+	w->used = 0;
+	return w->rc;
+}
+
+static void _write(writer_t *w, const char *str, size_t len)
+{
+	if (w->rc)
+		return;
+
+	if ((w->used + len) > WRITER_BUFFER_SIZE) {
+		if (_flush(w))
+			return;
+
+		if (len > WRITER_BUFFER_SIZE) {
+			w->rc = w->write_func(str, len, w->write_arg);
+			return;
+		}
+	}
 
-	return d;
+	memcpy(w->buffer + w->used, str, len);
+	w->used += len;
 }
 
-static data_for_each_cmd_t _convert_dict_json(const char *key,
-					      const data_t *data,
-					      void *arg)
+#define _write_str(w, str) _write(w, str, strlen(str))
+
+static void _write_indent(writer_t *w, int level)
 {
-	json_object *jobj = arg;
-	json_object *jobject = _data_to_json(data);
+	static const char spaces[] = "                                ";
+
+	if (!w->pretty)
+		return;
+
+	for (int i = level * WRITER_INDENT; i > 0;) {
+		int len = MIN(i, (sizeof(spaces) - 1));
 
-	json_object_object_add(jobj, key, jobject);
-	return DATA_FOR_EACH_CONT;
+		_write(w, spaces, len);
+		i -= len;
+	}
 }
 
-static data_for_each_cmd_t _convert_list_json(const data_t *data, void *arg)
+static void _write_escaped(writer_t *w, const char *str)
 {
-	json_object *jobj = arg;
-	json_object *jarray = _data_to_json(data);
+	static const char hex[] = "0123456789abcdef";
+	const char *start = str;
+
+	_write(w, "\"", 1);
+
+	for (; *str; str++) {
+		const unsigned char c = *str;
+		const char *esc = NULL;
+		char uesc[7];
+
+		switch (c) {
+		case '\b':
+			esc = "\\b";
+			break;
+		case '\n':
+			esc = "\\n";
+			break;
+		case '\r':
+			esc = "\\r";
+			break;
+		case '\t':
+			esc = "\\t";
+			break;
+		case '\f':
+			esc = "\\f";
+			break;
+		case '"':
+			esc = "\\\"";
+			break;
+		case '\\':
+			esc = "\\\\";
+			break;
+		case '/':
+			esc = "\\/";
+			break;
+		default:
+			if (c < ' ') {
+				uesc[0] = '\\';
+				uesc[1] = 'u';
+				uesc[2] = '0';
+				uesc[3] = '0';
+				uesc[4] = hex[c >> 4];
+				uesc[5] = hex[c & 0xf];
+				uesc[6] = '\0';
+				esc = uesc;
+			}
+		}
+
+		if (esc) {
+			_write(w, start, (str - start));
+			_write_str(w, esc);
+			start = str + 1;
+		}
+	}
+
+	_write(w, start, (str - start));
+	_write(w, "\"", 1);
+}
+
+static void _write_float(writer_t *w, double value)
+{
+	char buf[64];
+	int len;
+
+	if (isnan(value)) {
+		_write_str(w, "NaN");
+		return;
+	} else if (isinf(value)) {
+		_write_str(w, ((value > 0) ? "Infinity" : "-Infinity"));
+		return;
+	}
+
+	len = snprintf(buf, sizeof(buf), "%.17g", value);
+
+	/* always make it obvious that this is a float */
+	if (!strpbrk(buf, ".e"))
+		len += snprintf(buf + len, sizeof(buf) - len, ".0");
+
+	_write(w, buf, len);
+}
+
+/* Write separator, indent and key before the next value in open container */
+static void _write_prefix(writer_t *w, const char *key)
+{
+	writer_level_t *level;
+
+	if (!w->depth) {
+		xassert(!key);
+		return;
+	}
+
+	level = &w->levels[w->depth - 1];
+
+	if (level->had_children)
+		_write_str(w, (w->pretty ? ",\n" : ","));
+	level->had_children = true;
+
+	_write_indent(w, w->depth);
+
+	if (level->type == DATA_TYPE_DICT) {
+		xassert(key);
+		_write_escaped(w, key);
+		_write_str(w, (w->pretty ? ": " : ":"));
+	} else {
+		xassert(!key);
+	}
+}
+
+static void _writer_begin(writer_t *w, const char *key, data_type_t type)
+{
+	_write_prefix(w, key);
+
+	if (w->depth >= w->levels_size) {
+		w->levels_size = MAX(8, (w->levels_size * 2));
+		xrecalloc(w->levels, w->levels_size, sizeof(*w->levels));
+	}
+
+	w->levels[w->depth].type = type;
+	w->levels[w->depth].had_children = false;
+	w->depth++;
+
+	_write_str(w, ((type == DATA_TYPE_DICT) ? "{" : "["));
+	if (w->pretty)
+		_write(w, "\n", 1);
+}
+
+static void _writer_end(writer_t *w)
+{
+	writer_level_t *level;
+
+	xassert(w->depth > 0);
+	level = &w->levels[--w->depth];
+
+	if (w->pretty) {
+		if (level->had_children)
+			_write(w, "\n", 1);
+		_write_indent(w, w->depth);
+	}
+
+	_write_str(w, ((level->type == DATA_TYPE_DICT) ? "}" : "]"));
+}
+
+static void _write_data(writer_t *w, const char *key, const data_t *d);
+
+static data_for_each_cmd_t _write_dict(const char *key, const data_t *data,
+				       void *arg)
+{
+	writer_t *w = arg;
+
+	_write_data(w, key, data);
+
+	return (w->rc ? DATA_FOR_EACH_FAIL : DATA_FOR_EACH_CONT);
+}
+
+static data_for_each_cmd_t _write_list(const data_t *data, void *arg)
+{
+	writer_t *w = arg;
+
+	_write_data(w, NULL, data);
 
-	json_object_array_add(jobj, jarray);
-	return DATA_FOR_EACH_CONT;
+	return (w->rc ? DATA_FOR_EACH_FAIL : DATA_FOR_EACH_CONT);
 }
 
-static json_object *_data_to_json(const data_t *d)
+static void _write_data(writer_t *w, const char *key, const data_t *d)
 {
-	if (!d)
-		return NULL;
+	const data_type_t type = (d ? data_get_type(d) : DATA_TYPE_NULL);
 
-	switch (data_get_type(d)) {
+	if ((type == DATA_TYPE_DICT) || (type == DATA_TYPE_LIST)) {
+		_writer_begin(w, key, type);
+
+		if (type == DATA_TYPE_DICT)
+			(void) data_dict_for_each_const(d, _write_dict, w);
+		else
+			(void) data_list_for_each_const(d, _write_list, w);
+
+		_writer_end(w);
+		return;
+	}
+
+	_write_prefix(w, key);
+
+	switch (type) {
 	case DATA_TYPE_NULL:
-		return NULL;
+		_write_str(w, "null");
 		break;
 	case DATA_TYPE_BOOL:
-		return json_object_new_boolean(data_get_bool(d));
+		_write_str(w, (data_get_bool(d) ? "true" : "false"));
 		break;
 	case DATA_TYPE_FLOAT:
-		return json_object_new_double(data_get_float(d));
+		_write_float(w, data_get_float(d));
 		break;
 	case DATA_TYPE_INT_64:
-		return json_object_new_int64(data_get_int(d));
-		break;
-	case DATA_TYPE_DICT:
 	{
-		json_object *jobj = json_object_new_object();
-		if (data_dict_for_each_const(d, _convert_dict_json, jobj) < 0)
-			error("%s: unexpected error calling _convert_dict_json()",
-			      __func__);
-		return jobj;
-	}
-	case DATA_TYPE_LIST:
-	{
-		json_object *jobj = json_object_new_array();
-		if (data_list_for_each_const(d, _convert_list_json, jobj) < 0)
-			error("%s: unexpected error calling _convert_list_json()",
-			      __func__);
-		return jobj;
+		char buf[32];
+		int len = snprintf(buf, sizeof(buf), "%"PRId64, data_get_int(d));
+
+		_write(w, buf, len);
+		break;
 	}
 	case DATA_TYPE_STRING:
 	{
 		const char *str = data_get_string_const(d);
-		if (str)
-			return json_object_new_string(str);
-		else
-			return json_object_new_string("");
+
+		_write_escaped(w, (str ? str : ""));
 		break;
 	}
 	default:
 		fatal_abort("%s: unknown type", __func__);
-	};
+	}
 }
 
-extern int serialize_p_data_to_string(char **dest, size_t *length,
-				      const data_t *src,
-				      serializer_flags_t flags)
+static writer_t *_writer_new(serializer_flags_t flags,
+			     serializer_write_t write_func, void *write_arg)
 {
-	struct json_object *jobj = _data_to_json(src);
-	int jflags = 0;
+	writer_t *w = xmalloc(sizeof(*w));
 
 	/* can't be pretty and compact at the same time! */
 	xassert((flags & (SER_FLAGS_PRETTY | SER_FLAGS_COMPACT)) !=
 		(SER_FLAGS_PRETTY | SER_FLAGS_COMPACT));
 
-	switch (flags) {
-	case SER_FLAGS_PRETTY:
-		jflags = JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY;
-		break;
-	case SER_FLAGS_COMPACT: /* fallthrough */
-	default:
-		jflags = JSON_C_TO_STRING_PLAIN;
-	}
+	w->magic = WRITER_MAGIC;
+	w->pretty = (flags == SER_FLAGS_PRETTY);
+	w->write_func = write_func;
+	w->write_arg = write_arg;
+	w->buffer = xmalloc_nz(WRITER_BUFFER_SIZE);
+
+	return w;
+}
+
+static int _writer_free(writer_t *w)
+{
+	int rc;
+
+	xassert(w->magic == WRITER_MAGIC);
+
+	rc = _flush(w);
+
+	w->magic = ~WRITER_MAGIC;
+	xfree(w->buffer);
+	xfree(w->levels);
+	xfree(w);
+
+	return rc;
+}
+
+static int _append_string(const char *data, size_t length, void *arg)
+{
+	char **str = arg;
+
+	xstrncat(*str, data, length);
+
+	return SLURM_SUCCESS;
+}
+
+extern int serialize_p_data_to_string(char **dest, size_t *length,
+				      const data_t *src,
+				      serializer_flags_t flags)
+{
+	char *str = NULL;
+	writer_t *w = _writer_new(flags, _append_string, &str);
+
+	_write_data(w, NULL, src);
+	(void) _writer_free(w);
 
-	/* string will die with jobj */
-	*dest = xstrdup(json_object_to_json_string_ext(jobj, jflags));
+	*dest = str;
 	if (length) {
 		/* add 1 for \0 */
 		*length = strlen(*dest) + 1;
 	}
 
-	/* put is equiv to free() */
-	json_object_put(jobj);
+	return SLURM_SUCCESS;
+}
+
+extern int serialize_p_stream_new(void **state_ptr, serializer_flags_t flags,
+				  serializer_write_t write_func,
+				  void *write_arg)
+{
+	*state_ptr = _writer_new(flags, write_func, write_arg);
 
 	return SLURM_SUCCESS;
 }
 
+extern int serialize_p_stream_begin(void *state, const char *key,
+				    data_type_t type)
+{
+	writer_t *w = state;
+
+	xassert(w->magic == WRITER_MAGIC);
+
+	_writer_begin(w, key, type);
+
+	return w->rc;
+}
+
+extern int serialize_p_stream_end(void *state)
+{
+	writer_t *w = state;
+
+	xassert(w->magic == WRITER_MAGIC);
+
+	_writer_end(w);
+
+	return w->rc;
+}
+
+extern int serialize_p_stream_data(void *state, const char *key,
+				   const data_t *src)
+{
+	writer_t *w = state;
+
+	xassert(w->magic == WRITER_MAGIC);
+
+	_write_data(w, key, src);
+
+	return w->rc;
+}
+
+extern int serialize_p_stream_fini(void *state)
+{
+	writer_t *w = state;
+
+	xassert(!w->depth);
+
+	return _writer_free(w);
+}
+
 extern int serialize_p_string_to_data(data_t **dest, const char *src,
 				      size_t length)
 {
-	json_object *jobj = NULL;
-	data_t *data = NULL;
-	struct json_tokener *tok = json_tokener_new();
-
-	if (!tok)
-		return ENOMEM;
+	data_t *data;
+	reader_t r = {
+		.magic = READER_MAGIC,
+		.src = src,
+		.pos = src,
+	};
 
 	if (!src)
 		return ESLURM_DATA_PTR_NULL;
 
-	/* json-c has hard limit of 32 bits */
-	if (length >= INT32_MAX) {
-		error("%s: unable to parse JSON: too large",
-		      __func__);
-		return ESLURM_DATA_TOO_LARGE;
-	}
+	/* stop at terminator the same as json-c */
+	r.end = src + strnlen(src, length);
+	r.size = READER_BUFFER_SIZE;
+	r.buffer = xmalloc_nz(r.size);
 
-	jobj = _try_parse(src, length, tok);
-	if (jobj) {
-		data = _json_to_data(jobj, NULL);
-		json_object_put(jobj);
+	data = data_new_arena();
+
+	if (_read_value(&r, data)) {
+		error("%s: JSON parsing error at byte %zu of %zu bytes: %s",
+		      __func__, (size_t) (r.error_pos - src), length, r.error);
+		FREE_NULL_DATA(data);
+	} else if (!_skip_space(&r) && (r.pos < r.end)) {
+		log_flag(DATA, "%s: Extra %zu characters after JSON string detected",
+			 __func__, (size_t) (r.end - r.pos));
 	}
 
-	json_tokener_free(tok);
+	r.magic = ~READER_MAGIC;
+	xfree(r.buffer);
 
 	*dest = data;
 	return SLURM_SUCCESS;
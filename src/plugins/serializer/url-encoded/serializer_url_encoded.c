@@ -96,6 +96,35 @@ extern int serialize_p_data_to_string(char **dest, size_t *length,
 	return ESLURM_NOT_SUPPORTED;
 }
 
+extern int serialize_p_stream_new(void **state_ptr, serializer_flags_t flags,
+				  serializer_write_t write_func,
+				  void *write_arg)
+{
+	return ESLURM_NOT_SUPPORTED;
+}
+
+extern int serialize_p_stream_begin(void *state, const char *key,
+				    data_type_t type)
+{
+	return ESLURM_NOT_SUPPORTED;
+}
+
+extern int serialize_p_stream_end(void *state)
+{
+	return ESLURM_NOT_SUPPORTED;
+}
+
+extern int serialize_p_stream_data(void *state, const char *key,
+				   const data_t *src)
+{
+	return ESLURM_NOT_SUPPORTED;
+}
+
+extern int serialize_p_stream_fini(void *state)
+{
+	return ESLURM_NOT_SUPPORTED;
+}
+
 static int _handle_new_key_char(data_t *d, char **key, char **buffer,
 				bool convert_types)
 {
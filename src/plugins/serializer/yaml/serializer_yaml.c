@@ -110,6 +110,19 @@ typedef struct {
 	char *suffix;
 } yaml_tag_types_t;
 
+#define STREAM_MAGIC 0x1a3aa0bf
+
+typedef struct {
+	int magic; /* STREAM_MAGIC */
+	yaml_emitter_t emitter;
+	serializer_write_t write_func;
+	void *write_arg;
+	int rc; /* first error from write_func */
+	data_type_t *levels; /* type of each open container */
+	int depth; /* number of open containers */
+	int levels_size;
+} stream_t;
+
 /* Map of suffix to local data_t type */
 static const yaml_tag_types_t tags[] = {
 	{ .type = DATA_TYPE_NULL, .suffix = "null" },
@@ -859,7 +872,21 @@ static int _yaml_write_handler(void *data, unsigned char *buffer, size_t size)
 	return 1;
 }
 
-static int _dump_yaml(const data_t *data, yaml_emitter_t *emitter, buf_t *buf)
+static int _yaml_stream_write_handler(void *data, unsigned char *buffer,
+				      size_t size)
+{
+	stream_t *stream = data;
+	xassert(stream->magic == STREAM_MAGIC);
+
+	if (!stream->rc)
+		stream->rc = stream->write_func((const char *) buffer, size,
+						stream->write_arg);
+
+	return (stream->rc ? 0 : 1);
+}
+
+static int _start_yaml(yaml_emitter_t *emitter,
+		       yaml_write_handler_t *handler, void *arg)
 {
 	yaml_event_t event;
 
@@ -872,7 +899,7 @@ static int _dump_yaml(const data_t *data, yaml_emitter_t *emitter, buf_t *buf)
 	if (!yaml_emitter_initialize(emitter))
 		_yaml_emitter_error;
 
-	yaml_emitter_set_output(emitter, _yaml_write_handler, buf);
+	yaml_emitter_set_output(emitter, handler, arg);
 
 	//TODO defaulted to UTF8 but maybe this should be a flag?
 	if (!yaml_stream_start_event_initialize(&event, YAML_UTF8_ENCODING))
@@ -887,8 +914,15 @@ static int _dump_yaml(const data_t *data, yaml_emitter_t *emitter, buf_t *buf)
 	if (!yaml_emitter_emit(emitter, &event))
 		_yaml_emitter_error;
 
-	if (_data_to_yaml(data, emitter))
-		goto yaml_fail;
+	return SLURM_SUCCESS;
+
+yaml_fail:
+	return SLURM_ERROR;
+}
+
+static int _end_yaml(yaml_emitter_t *emitter)
+{
+	yaml_event_t event;
 
 	if (!yaml_document_end_event_initialize(&event, 0))
 		_yaml_emitter_error;
@@ -908,6 +942,153 @@ yaml_fail:
 	return SLURM_ERROR;
 }
 
+static int _dump_yaml(const data_t *data, yaml_emitter_t *emitter, buf_t *buf)
+{
+	if (_start_yaml(emitter, _yaml_write_handler, buf))
+		return SLURM_ERROR;
+
+	if (_data_to_yaml(data, emitter))
+		return SLURM_ERROR;
+
+	return _end_yaml(emitter);
+}
+
+static int _stream_error(stream_t *stream)
+{
+	if (stream->rc)
+		return stream->rc;
+
+	return ESLURM_DATA_CONV_FAILED;
+}
+
+extern int serialize_p_stream_new(void **state_ptr, serializer_flags_t flags,
+				  serializer_write_t write_func,
+				  void *write_arg)
+{
+	stream_t *stream = xmalloc(sizeof(*stream));
+
+	stream->magic = STREAM_MAGIC;
+	stream->write_func = write_func;
+	stream->write_arg = write_arg;
+
+	if (_start_yaml(&stream->emitter, _yaml_stream_write_handler,
+			stream)) {
+		int rc = _stream_error(stream);
+
+		yaml_emitter_delete(&stream->emitter);
+		stream->magic = ~STREAM_MAGIC;
+		xfree(stream);
+		return rc;
+	}
+
+	*state_ptr = stream;
+	return SLURM_SUCCESS;
+}
+
+extern int serialize_p_stream_begin(void *state, const char *key,
+				    data_type_t type)
+{
+	stream_t *stream = state;
+	yaml_emitter_t *emitter = &stream->emitter;
+	yaml_event_t event;
+
+	xassert(stream->magic == STREAM_MAGIC);
+
+	if (key && _emit_string(key, emitter))
+		return _stream_error(stream);
+
+	if (type == DATA_TYPE_DICT) {
+		if (!yaml_mapping_start_event_initialize(
+			    &event, NULL, (yaml_char_t *)YAML_MAP_TAG, 0,
+			    YAML_ANY_MAPPING_STYLE))
+			_yaml_emitter_error;
+	} else {
+		if (!yaml_sequence_start_event_initialize(
+			    &event, NULL, (yaml_char_t *)YAML_SEQ_TAG, 0,
+			    YAML_ANY_SEQUENCE_STYLE))
+			_yaml_emitter_error;
+	}
+
+	if (!yaml_emitter_emit(emitter, &event))
+		_yaml_emitter_error;
+
+	if (stream->depth >= stream->levels_size) {
+		stream->levels_size = MAX(8, (stream->levels_size * 2));
+		xrecalloc(stream->levels, stream->levels_size,
+			  sizeof(*stream->levels));
+	}
+	stream->levels[stream->depth++] = type;
+
+	return SLURM_SUCCESS;
+
+yaml_fail:
+	return _stream_error(stream);
+}
+
+extern int serialize_p_stream_end(void *state)
+{
+	stream_t *stream = state;
+	yaml_emitter_t *emitter = &stream->emitter;
+	yaml_event_t event;
+
+	xassert(stream->magic == STREAM_MAGIC);
+	xassert(stream->depth > 0);
+
+	if (stream->levels[--stream->depth] == DATA_TYPE_DICT) {
+		if (!yaml_mapping_end_event_initialize(&event))
+			_yaml_emitter_error;
+	} else {
+		if (!yaml_sequence_end_event_initialize(&event))
+			_yaml_emitter_error;
+	}
+
+	if (!yaml_emitter_emit(emitter, &event))
+		_yaml_emitter_error;
+
+	return SLURM_SUCCESS;
+
+yaml_fail:
+	return _stream_error(stream);
+}
+
+extern int serialize_p_stream_data(void *state, const char *key,
+				   const data_t *src)
+{
+	stream_t *stream = state;
+
+	xassert(stream->magic == STREAM_MAGIC);
+
+	if (key && _emit_string(key, &stream->emitter))
+		return _stream_error(stream);
+
+	if (_data_to_yaml(src, &stream->emitter))
+		return _stream_error(stream);
+
+	return SLURM_SUCCESS;
+}
+
+extern int serialize_p_stream_fini(void *state)
+{
+	stream_t *stream = state;
+	int rc = SLURM_SUCCESS;
+
+	xassert(stream->magic == STREAM_MAGIC);
+	xassert(!stream->depth);
+
+	if (!stream->rc && (_end_yaml(&stream->emitter) ||
+			    !yaml_emitter_flush(&stream->emitter)))
+		rc = _stream_error(stream);
+	else
+		rc = stream->rc;
+
+	yaml_emitter_delete(&stream->emitter);
+	stream->magic = ~STREAM_MAGIC;
+	xfree(stream->levels);
+	xfree(stream);
+
+	return rc;
+}
+
 #undef _yaml_emitter_error
 
 extern int serialize_p_data_to_string(char **dest, size_t *length,
@@ -940,7 +1121,7 @@ extern int serialize_p_data_to_string(char **dest, size_t *length,
 extern int serialize_p_string_to_data(data_t **dest, const char *src,
 				      size_t length)
 {
-	data_t *data = data_new();
+	data_t *data = data_new_arena();
 	yaml_parser_t parser;
 
 	xassert(length < strlen(src));
@@ -63,12 +63,14 @@
 #define OPT_LONG_YAML      0x110
 #define OPT_LONG_AUTOCOMP  0x111
 #define OPT_LONG_ARRAY     0x112
+#define OPT_LONG_STREAM    0x113
 
 #define JOB_HASH_SIZE 1000
 
 static void _help_fields_msg(void);
 static void _help_msg(void);
 static void _init_params(void);
+static void _print_job(slurmdb_job_rec_t *job);
 static void _usage(void);
 
 List selected_parts = NULL;
@@ -336,6 +338,9 @@ sacct [<OPTION>]                                                            \n \
                    Select jobs eligible after this time.  Default is        \n\
                    00:00:00 of the current day, unless '-s' is set then     \n\
                    the default is 'now'.                                    \n\
+     --stream:                                                              \n\
+                   Print jobs as they are read from the database, in job id \n\
+                   order instead of by submit time.                         \n\
      -T, --truncate:                                                        \n\
                    Truncate time.  So if a job started before --starttime   \n\
                    the start time would be truncated to --starttime.        \n\
@@ -503,18 +508,68 @@ static void _remove_duplicate_fed_jobs(List jobs)
 	xfree(hash_job);
 }
 
+/* Add the cpu time of the job's completed steps to the job */
+static void _aggregate_job_steps(slurmdb_job_rec_t *job)
+{
+	slurmdb_step_rec_t *step = NULL;
+	ListIterator itr_step = NULL;
+
+	if (!job->steps || !list_count(job->steps))
+		return;
+
+	itr_step = list_iterator_create(job->steps);
+	while ((step = list_next(itr_step))) {
+		/* now aggregate the aggregatable */
+
+		if (step->state < JOB_COMPLETE)
+			continue;
+		job->tot_cpu_sec += step->tot_cpu_sec;
+		job->tot_cpu_usec += step->tot_cpu_usec;
+		job->user_cpu_sec +=
+			step->user_cpu_sec;
+		job->user_cpu_usec +=
+			step->user_cpu_usec;
+		job->sys_cpu_sec +=
+			step->sys_cpu_sec;
+		job->sys_cpu_usec +=
+			step->sys_cpu_usec;
+	}
+	list_iterator_destroy(itr_step);
+}
+
+/* Print the jobs of each chunk handed back with --stream */
+static int _print_job_chunk(List job_list, void *arg)
+{
+	slurmdb_job_rec_t *job = NULL;
+	ListIterator itr = list_iterator_create(job_list);
+
+	while ((job = list_next(itr))) {
+		_aggregate_job_steps(job);
+		_print_job(job);
+	}
+	list_iterator_destroy(itr);
+
+	return SLURM_SUCCESS;
+}
+
 extern int get_data(void)
 {
 	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
 	ListIterator itr = NULL;
-	ListIterator itr_step = NULL;
 	slurmdb_job_cond_t *job_cond = params.job_cond;
-	int cnt;
+	int rc;
 
 	if (params.opt_completion) {
 		jobs = slurmdb_jobcomp_jobs_get(job_cond);
 		return SLURM_SUCCESS;
+	} else if (params.opt_stream) {
+		/* The jobs are printed as they come in, jobs stays empty */
+		if ((rc = slurmdb_jobs_get_stream(acct_db_conn, job_cond,
+						  _print_job_chunk, NULL))) {
+			errno = rc;
+			return SLURM_ERROR;
+		}
+		return SLURM_SUCCESS;
 	} else {
 		jobs = slurmdb_jobs_get(acct_db_conn, job_cond);
 	}
@@ -536,30 +591,8 @@ extern int get_data(void)
 		list_sort(jobs, _sort_desc_submit_time);
 
 	itr = list_iterator_create(jobs);
-	while ((job = list_next(itr))) {
-
-		if (!job->steps || !(cnt = list_count(job->steps)))
-			continue;
-
-		itr_step = list_iterator_create(job->steps);
-		while ((step = list_next(itr_step))) {
-			/* now aggregate the aggregatable */
-
-			if (step->state < JOB_COMPLETE)
-				continue;
-			job->tot_cpu_sec += step->tot_cpu_sec;
-			job->tot_cpu_usec += step->tot_cpu_usec;
-			job->user_cpu_sec +=
-				step->user_cpu_sec;
-			job->user_cpu_usec +=
-				step->user_cpu_usec;
-			job->sys_cpu_sec +=
-				step->sys_cpu_sec;
-			job->sys_cpu_usec +=
-				step->sys_cpu_usec;
-		}
-		list_iterator_destroy(itr_step);
-	}
+	while ((job = list_next(itr)))
+		_aggregate_job_steps(job);
 	list_iterator_destroy(itr);
 
 	return SLURM_SUCCESS;
@@ -630,6 +663,7 @@ extern void parse_command_line(int argc, char **argv)
                 {"reason",         required_argument, 0,    'R'},
                 {"state",          required_argument, 0,    's'},
                 {"starttime",      required_argument, 0,    'S'},
+                {"stream",         no_argument,       0,    OPT_LONG_STREAM},
                 {"truncate",       no_argument,       0,    'T'},
                 {"uid",            required_argument, 0,    'u'},
 		{"use-local-uid",  no_argument,       0,    OPT_LONG_LOCAL_UID},
@@ -812,6 +846,9 @@ extern void parse_command_line(int argc, char **argv)
 			params.opt_local = true;
 			all_clusters = false;
 			break;
+		case OPT_LONG_STREAM:
+			params.opt_stream = true;
+			break;
 		case OPT_LONG_NOCONVERT:
 			params.convert_flags |= CONVERT_NUM_UNIT_NO;
 			break;
@@ -971,6 +1008,9 @@ extern void parse_command_line(int argc, char **argv)
 	    (job_cond->flags & JOBCOND_FLAG_ENV))
 		fatal("Options --batch-script and --env-vars are mutually exclusive");
 
+	if (params.opt_stream && (params.opt_completion || params.mimetype))
+		fatal("Option --stream can not be used with --completion, --json or --yaml");
+
 
 	if (long_output && params.opt_field_list)
 		fatal("Options -o(--format) and -l(--long) are mutually exclusive. Please remove one and retry.");
@@ -1392,6 +1432,39 @@ static void _print_env(slurmdb_job_rec_t *job)
 	return;
 }
 
+static void _print_job(slurmdb_job_rec_t *job)
+{
+	ListIterator itr_step = NULL;
+	slurmdb_step_rec_t *step = NULL;
+	slurmdb_job_cond_t *job_cond = params.job_cond;
+
+	if ((params.cluster_name) &&
+	    _test_local_job(job->jobid) &&
+	    xstrcmp(params.cluster_name, job->cluster))
+		return;
+
+	if (job_cond->flags & JOBCOND_FLAG_SCRIPT) {
+		_print_script(job);
+		return;
+	} else if (job_cond->flags & JOBCOND_FLAG_ENV) {
+		_print_env(job);
+		return;
+	}
+
+	if (job->show_full)
+		print_fields(JOB, job);
+
+	if (!(job_cond->flags & JOBCOND_FLAG_NO_STEP)) {
+		itr_step = list_iterator_create(job->steps);
+		while ((step = list_next(itr_step))) {
+			if (step->end == 0)
+				step->end = job->end;
+			print_fields(JOBSTEP, step);
+		}
+		list_iterator_destroy(itr_step);
+	}
+}
+
 /* do_list() -- List the assembled data
  *
  * In:	Nothing explicit.
@@ -1403,10 +1476,7 @@ static void _print_env(slurmdb_job_rec_t *job)
 extern void do_list(int argc, char **argv)
 {
 	ListIterator itr = NULL;
-	ListIterator itr_step = NULL;
 	slurmdb_job_rec_t *job = NULL;
-	slurmdb_step_rec_t *step = NULL;
-	slurmdb_job_cond_t *job_cond = params.job_cond;
 
 	if (params.mimetype) {
 		errno = DATA_DUMP_CLI(JOB_LIST, jobs, "jobs", argc, argv,
@@ -1418,33 +1488,8 @@ extern void do_list(int argc, char **argv)
 		return;
 
 	itr = list_iterator_create(jobs);
-	while ((job = list_next(itr))) {
-		if ((params.cluster_name) &&
-		    _test_local_job(job->jobid) &&
-		    xstrcmp(params.cluster_name, job->cluster))
-			continue;
-
-		if (job_cond->flags & JOBCOND_FLAG_SCRIPT) {
-			_print_script(job);
-			continue;
-		} else if (job_cond->flags & JOBCOND_FLAG_ENV) {
-			_print_env(job);
-			continue;
-		}
-
-		if (job->show_full)
-			print_fields(JOB, job);
-
-		if (!(job_cond->flags & JOBCOND_FLAG_NO_STEP)) {
-			itr_step = list_iterator_create(job->steps);
-			while ((step = list_next(itr_step))) {
-				if (step->end == 0)
-					step->end = job->end;
-				print_fields(JOBSTEP, step);
-			}
-			list_iterator_destroy(itr_step);
-		}
-	}
+	while ((job = list_next(itr)))
+		_print_job(job);
 	list_iterator_destroy(itr);
 }
 
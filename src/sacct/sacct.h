@@ -212,6 +212,7 @@ typedef struct {
 	int opt_help;		/* --help */
 	bool opt_local;		/* --local */
 	int opt_noheader;	/* can only be cleared */
+	bool opt_stream;	/* --stream */
 	uid_t opt_uid;		/* running persons uid */
 	int units;		/* --units*/
 	bool use_local_uid;	/* --use-local-uid */
@@ -42,6 +42,7 @@
 
 #include "src/sacctmgr/sacctmgr.h"
 #include <sys/param.h>		/* MAXPATHLEN */
+#include "src/common/archive_file.h"
 #include "src/common/proc_args.h"
 #include "src/common/util-net.h"
 
@@ -531,3 +532,191 @@ extern int sacctmgr_archive_load(int argc, char **argv)
 
 	return rc;
 }
+
+/* Find a column by name, ignoring the quotes around reserved words */
+static int _find_archive_column(archive_file_t *af, char *name, int len)
+{
+	for (int i = 0; i < af->col_cnt; i++) {
+		char *col = af->columns[i];
+		int col_len;
+
+		if (col[0] == '`')
+			col++;
+		col_len = strlen(col);
+		if (col_len && (col[col_len - 1] == '`'))
+			col_len--;
+		if ((col_len == len) && !xstrncasecmp(col, name, len))
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Print the records of a columnar archive file without loading them into the
+ * database. The file is read locally so no slurmdbd is needed.
+ */
+extern int sacctmgr_archive_read(int argc, char **argv)
+{
+	archive_file_t *af = NULL;
+	archive_chunk_t *chunk = NULL;
+	char *file = NULL, *object, **filter = NULL;
+	int i, rc, command_len = 0, field_count;
+	List format_list = list_create(xfree_ptr);
+	List print_fields_list = NULL;
+	ListIterator itr = NULL;
+	print_field_t *field;
+
+	for (i = 0; i < argc; i++) {
+		int end = parse_option_end(argv[i]);
+		if (!end)
+			command_len = strlen(argv[i]);
+		else {
+			command_len = end - 1;
+			if (argv[i][end] == '=')
+				end++;
+		}
+
+		if (!xstrncasecmp(argv[i], "Where", MAX(command_len, 5)))
+			continue;
+		if (!end
+		   || !xstrncasecmp(argv[i], "File", MAX(command_len, 1))) {
+			xfree(file);
+			file = strip_quotes(argv[i]+end, NULL, 0);
+		} else if (!xstrncasecmp(argv[i], "Format",
+					 MAX(command_len, 2))) {
+			slurm_addto_char_list(format_list, argv[i]+end);
+		}
+	}
+
+	if (!file) {
+		exit_code = 1;
+		fprintf(stderr, " No archive file given\n");
+		FREE_NULL_LIST(format_list);
+		return SLURM_ERROR;
+	}
+
+	if (!archive_file_is_columnar(file)) {
+		exit_code = 1;
+		fprintf(stderr, " %s is not an archive file that can be read\n",
+			file);
+		FREE_NULL_LIST(format_list);
+		xfree(file);
+		return SLURM_ERROR;
+	}
+
+	if ((rc = archive_file_open(file, &af))) {
+		exit_code = 1;
+		fprintf(stderr, " Problem reading archive file: %s\n",
+			slurm_strerror(rc));
+		FREE_NULL_LIST(format_list);
+		xfree(file);
+		return SLURM_ERROR;
+	}
+	xfree(file);
+
+	/* Anything else is a column to match */
+	filter = xcalloc(af->col_cnt, sizeof(char *));
+	for (i = 0; i < argc; i++) {
+		int end = parse_option_end(argv[i]), col;
+
+		if (!end)
+			continue;
+		command_len = end - 1;
+		if (!xstrncasecmp(argv[i], "File", MAX(command_len, 1)) ||
+		    !xstrncasecmp(argv[i], "Format", MAX(command_len, 2)))
+			continue;
+		if ((col = _find_archive_column(af, argv[i],
+						command_len)) < 0) {
+			exit_code = 1;
+			fprintf(stderr, " Unknown option: %s\n", argv[i]);
+			continue;
+		}
+		if (argv[i][end] == '=')
+			end++;
+		xfree(filter[col]);
+		filter[col] = xstrdup(argv[i]+end);
+	}
+
+	if (!list_count(format_list)) {
+		for (i = 0; i < af->col_cnt; i++) {
+			char *col = xstrdup(af->columns[i]);
+			xstrsubstituteall(col, "`", "");
+			list_append(format_list, col);
+		}
+	}
+
+	print_fields_list = list_create(destroy_print_field);
+	itr = list_iterator_create(format_list);
+	while ((object = list_next(itr))) {
+		char *tmp = strchr(object, '%');
+		int col, len = tmp ? (tmp - object) : strlen(object);
+
+		if ((col = _find_archive_column(af, object, len)) < 0) {
+			exit_code = 1;
+			fprintf(stderr, " Unknown field '%s'\n", object);
+			continue;
+		}
+		field = xmalloc(sizeof(print_field_t));
+		field->type = col;
+		field->name = xstrndup(object, len);
+		field->len = tmp ? atoi(tmp + 1) : 20;
+		field->print_routine = print_fields_str;
+		list_append(print_fields_list, field);
+	}
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(format_list);
+
+	if (exit_code) {
+		rc = SLURM_ERROR;
+		goto end_it;
+	}
+
+	print_fields_header(print_fields_list);
+	field_count = list_count(print_fields_list);
+	itr = list_iterator_create(print_fields_list);
+
+	while (!(rc = archive_file_read_chunk(af, &chunk)) && chunk) {
+		if ((rc = archive_chunk_unpack(af, chunk)))
+			break;
+
+		for (int r = 0; r < chunk->row_cnt; r++) {
+			char **row = &chunk->values[r * af->col_cnt];
+			int curr_inx = 1;
+
+			for (i = 0; i < af->col_cnt; i++) {
+				if (filter[i] && xstrcmp(filter[i], row[i]))
+					break;
+			}
+			if (i < af->col_cnt)
+				continue;
+
+			while ((field = list_next(itr))) {
+				field->print_routine(field, row[field->type],
+						     (curr_inx == field_count));
+				curr_inx++;
+			}
+			list_iterator_reset(itr);
+			printf("\n");
+		}
+		archive_chunk_free(chunk);
+		chunk = NULL;
+	}
+	list_iterator_destroy(itr);
+
+	if (rc) {
+		exit_code = 1;
+		fprintf(stderr, " Problem reading archive file: %s\n",
+			slurm_strerror(rc));
+	}
+
+end_it:
+	archive_chunk_free(chunk);
+	for (i = 0; i < af->col_cnt; i++)
+		xfree(filter[i]);
+	xfree(filter);
+	archive_file_free(af);
+	FREE_NULL_LIST(print_fields_list);
+
+	return rc ? SLURM_ERROR : SLURM_SUCCESS;
+}
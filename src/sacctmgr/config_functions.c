@@ -221,6 +221,31 @@ static int _print_rpc_obj(void *x, void *arg)
 	return 0;
 }
 
+static int _sum_stmt_stats(void *x, void *arg)
+{
+	slurmdb_stmt_stats_t *stmt_stats = x;
+	slurmdb_stmt_stats_t *total = arg;
+
+	total->cnt += stmt_stats->cnt;
+	total->prepare_cnt += stmt_stats->prepare_cnt;
+
+	return 0;
+}
+
+static int _print_stmt_stats(void *x, void *arg)
+{
+	slurmdb_stmt_stats_t *stmt_stats = x;
+
+	printf("\t%-25s count:%-8"PRIu64" prepares:%-6"PRIu64
+	       " ave_time:%-6"PRIu64" max_time:%-6"PRIu64
+	       " total_time:%"PRIu64"\n",
+	       stmt_stats->name, stmt_stats->cnt, stmt_stats->prepare_cnt,
+	       stmt_stats->cnt ? (stmt_stats->time / stmt_stats->cnt) : 0,
+	       stmt_stats->time_max, stmt_stats->time);
+
+	return 0;
+}
+
 extern int sacctmgr_list_config(void)
 {
 	_load_slurm_config();
@@ -291,6 +316,32 @@ extern int sacctmgr_list_stats(int argc, char **argv)
 		list_iterator_destroy(itr);
 	}
 
+	if (stats_rec->batch_cnt) {
+		printf("\nBatched DBD_SEND_MULT_MSG statistics\n");
+		printf("\ttransactions:%-6"PRIu64" records:%-8"PRIu64
+		       " ave_records:%-6"PRIu64" total_time:%"PRIu64
+		       " records/sec:%"PRIu64"\n",
+		       stats_rec->batch_cnt, stats_rec->batch_records,
+		       stats_rec->batch_records / stats_rec->batch_cnt,
+		       stats_rec->batch_time,
+		       stats_rec->batch_time ?
+		       ((stats_rec->batch_records * USEC_IN_SEC) /
+			stats_rec->batch_time) : 0);
+	}
+
+	if (stats_rec->stmt_stats && list_count(stats_rec->stmt_stats)) {
+		slurmdb_stmt_stats_t total = { 0 };
+
+		list_for_each(stats_rec->stmt_stats, _sum_stmt_stats, &total);
+		printf("\nPrepared statement statistics\n");
+		printf("\texecutions:%-8"PRIu64" prepares:%-6"PRIu64
+		       " cache_hit_rate:%.2f%%\n",
+		       total.cnt, total.prepare_cnt,
+		       total.cnt ? (100.0 * (total.cnt - total.prepare_cnt) /
+				    total.cnt) : 0.0);
+		list_for_each(stats_rec->stmt_stats, _print_stmt_stats, NULL);
+	}
+
 	if (argc) {
 		if (!xstrncasecmp(argv[0], "ave_time", 2))
 			sort_by_ave_time = true;
@@ -624,6 +624,18 @@ static void _archive_it(int argc, char **argv)
 	int error_code = SLURM_SUCCESS;
 	int command_len = 0;
 
+	if (!argv[0])
+		goto helpme;
+
+	command_len = strlen(argv[0]);
+
+	/* Reading a file does not need the database */
+	if (xstrncasecmp(argv[0], "read", MAX(command_len, 1)) == 0) {
+		if (sacctmgr_archive_read((argc - 1), &argv[1]))
+			exit_code = 1;
+		return;
+	}
+
 	if (!have_db_conn) {
 		exit_code = 1;
 		return;
@@ -635,10 +647,6 @@ static void _archive_it(int argc, char **argv)
 		return;
 	}
 
-	if (!argv[0])
-		goto helpme;
-
-	command_len = strlen(argv[0]);
 	/* reset the connection to get the most recent stuff */
 	slurmdb_connection_commit(db_conn, 0);
 
@@ -652,7 +660,7 @@ static void _archive_it(int argc, char **argv)
 		exit_code = 1;
 		fprintf(stderr, "No valid entity in archive command\n");
 		fprintf(stderr, "Input line must include, ");
-		fprintf(stderr, "\"Dump\", or \"load\"\n");
+		fprintf(stderr, "\"Dump\", \"load\" or \"read\"\n");
 	}
 
 	if (error_code != SLURM_SUCCESS) {
@@ -60,6 +60,7 @@
 #define OPT_LONG_USAGE     0x102
 #define OPT_LONG_SEND_LIBS 0x103
 #define OPT_LONG_AUTOCOMP  0x104
+#define OPT_LONG_PIPELINE  0x105
 
 
 /* getopt_long options, integers but not characters */
@@ -85,6 +86,7 @@ extern void parse_command_line(int argc, char **argv)
 		{"fanout",    required_argument, 0, 'F'},
 		{"force",     no_argument,       0, 'f'},
 		{"jobid",     required_argument, 0, 'j'},
+		{"pipeline",  required_argument, 0, OPT_LONG_PIPELINE},
 		{"send-libs", optional_argument, 0, OPT_LONG_SEND_LIBS},
 		{"preserve",  no_argument,       0, 'p'},
 		{"size",      required_argument, 0, 's'},
@@ -106,6 +108,11 @@ extern void parse_command_line(int argc, char **argv)
 			sep[0] = ',';
 	}
 
+	if (bcast_conf_pipeline(&params.pipeline)) {
+		error("Invalid BcastParameters Pipeline value");
+		exit(1);
+	}
+
 	if (slurm_conf.bcast_exclude)
 		params.exclude = xstrdup(slurm_conf.bcast_exclude);
 
@@ -119,6 +126,11 @@ extern void parse_command_line(int argc, char **argv)
 		params.fanout = atoi(env_val);
 	if (getenv("SBCAST_FORCE"))
 		params.flags |= BCAST_FLAG_FORCE;
+	if ((env_val = getenv("SBCAST_PIPELINE")) &&
+	    bcast_parse_pipeline(env_val, &params.pipeline)) {
+		error("Invalid SBCAST_PIPELINE value '%s'", env_val);
+		exit(1);
+	}
 
 	if (getenv("SBCAST_PRESERVE"))
 		params.flags |= BCAST_FLAG_PRESERVE;
@@ -172,6 +184,12 @@ extern void parse_command_line(int argc, char **argv)
 		case (int)'p':
 			params.flags |= BCAST_FLAG_PRESERVE;
 			break;
+		case (int) OPT_LONG_PIPELINE:
+			if (bcast_parse_pipeline(optarg, &params.pipeline)) {
+				error("Invalid --pipeline value '%s'", optarg);
+				exit(1);
+			}
+			break;
 		case (int) OPT_LONG_SEND_LIBS:
 			ret = parse_send_libs(optarg);
 			if (ret == -1)
@@ -292,6 +310,7 @@ static void _print_options( void )
 	info("force      = %s",
 	     (params.flags & BCAST_FLAG_FORCE) ? "true" : "false");
 	info("fanout     = %d", params.fanout);
+	info("pipeline   = %d", params.pipeline);
 	info("preserve   = %s",
 	     (params.flags & BCAST_FLAG_PRESERVE) ? "true" : "false");
 	info("send_libs  = %s",
@@ -306,7 +325,7 @@ static void _print_options( void )
 
 static void _usage( void )
 {
-	printf("Usage: sbcast [--exclude] [-CfFjpvV] [--send-libs] SOURCE DEST\n");
+	printf("Usage: sbcast [--exclude] [-CfFjpvV] [--pipeline] [--send-libs] SOURCE DEST\n");
 }
 
 static void _help( void )
@@ -318,6 +337,7 @@ Usage: sbcast [OPTIONS] SOURCE DEST\n\
   -f, --force           replace destination file as required\n\
   -F, --fanout=num      specify message fanout\n\
   -j, --jobid=#[+#][.#] specify job ID with optional hetjob offset and/or step ID\n\
+  --pipeline=num        number of blocks to have in flight at one time\n\
   -p, --preserve        preserve modes and times of source file\n\
   --send-libs[=yes|no]  autodetect and broadcast executable's shared objects\n\
   -s, --size=num        block size in bytes (rounded off)\n\
@@ -2759,6 +2759,27 @@ static void _split_node_config(node_record_t *node_ptr,
 	config_ptr->tot_sockets = reg_msg->sockets;
 }
 
+/*
+ * valid_node_reg_epoch - test if a registration flagged as unchanged refers
+ *	to the last registration of the node that passed full validation
+ * IN reg_msg - node registration message
+ * RET true if the registration can be accepted without revalidation
+ */
+extern bool valid_node_reg_epoch(slurm_node_registration_status_msg_t *reg_msg)
+{
+	node_record_t *node_ptr;
+
+	if (!(reg_msg->flags & SLURMD_REG_FLAG_UNCHANGED))
+		return false;
+
+	if (!(node_ptr = find_node_record(reg_msg->node_name)))
+		return false;
+
+	return (node_ptr->reg_epoch &&
+		(node_ptr->reg_epoch == reg_msg->reg_epoch) &&
+		!IS_NODE_INVALID_REG(node_ptr));
+}
+
 /*
  * validate_node_specs - validate the node's specifications as valid,
  *	if not set state to down, in any case update last_response
@@ -2784,6 +2805,7 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 	int threads1, threads2;	/* total threads on node */
 	static time_t sched_update = 0;
 	static double conf_node_reg_mem_percent = -1;
+	bool unchanged;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 
@@ -2827,6 +2849,18 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 		return SLURM_SUCCESS;
 	bit_clear(booting_node_bitmap, node_ptr->index);
 
+	/*
+	 * The slurmd reports nothing changed since the last registration we
+	 * fully validated (e.g. after a reconfigure), so the features, GRES
+	 * and hardware checks below would give the same result again.
+	 */
+	if ((unchanged = valid_node_reg_epoch(reg_msg))) {
+		debug2("%s: node %s unchanged since registration at %ld",
+		       __func__, reg_msg->node_name,
+		       (long) reg_msg->reg_epoch);
+		goto validated;
+	}
+
 	if (cr_flag == NO_VAL) {
 		cr_flag = 0;  /* call is no-op for select/linear and others */
 		if (select_g_get_info_from_plugin(SELECT_CR_PLUGIN,
@@ -3027,6 +3061,7 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 	node_ptr->os = reg_msg->os;
 	reg_msg->os = NULL;	/* Nothing left to free */
 
+validated:
 	if (node_ptr->cpu_load != reg_msg->cpu_load) {
 		node_ptr->cpu_load = reg_msg->cpu_load;
 		node_ptr->cpu_load_time = now;
@@ -3263,6 +3298,11 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 		memcpy(node_ptr->energy, reg_msg->energy,
 		       sizeof(acct_gather_energy_t));
 
+	if (error_code)
+		node_ptr->reg_epoch = 0;
+	else if (!unchanged)
+		node_ptr->reg_epoch = reg_msg->timestamp;
+
 	node_ptr->last_response = now;
 	node_ptr->boot_req_time = (time_t) 0;
 	node_ptr->power_save_req_time = (time_t) 0;
@@ -2004,6 +2004,69 @@ static void _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 	/* NOTE: RPC has no response */
 }
 
+/*
+ * Process the epilog completion of many nodes of a job, as aggregated by
+ * the slurmd reverse tree, with a single job write lock.
+ */
+static void _slurm_rpc_epilog_complete_batch(slurm_msg_t *msg)
+{
+	static int active_rpc_cnt = 0;
+	DEF_TIMERS;
+	/* Locks: Read configuration, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+	epilog_complete_batch_msg_t *batch_msg = msg->data;
+	job_record_t *job_ptr;
+	bool run_scheduler = false;
+
+	START_TIMER;
+	if (!validate_slurm_user(msg->auth_uid)) {
+		error("Security violation, EPILOG_COMPLETE_BATCH RPC from uid=%u",
+		      msg->auth_uid);
+		return;
+	}
+
+	_throttle_start(&active_rpc_cnt);
+	lock_slurmctld(job_write_lock);
+
+	log_flag(ROUTE, "%s: JobId=%u node_cnt=%u",
+		 __func__, batch_msg->job_id, batch_msg->node_cnt);
+
+	for (int i = 0; i < batch_msg->node_cnt; i++) {
+		if (job_epilog_complete(batch_msg->job_id,
+					batch_msg->node_names[i],
+					batch_msg->return_codes[i]))
+			run_scheduler = true;
+	}
+
+	job_ptr = find_job_record(batch_msg->job_id);
+	for (int i = 0; i < batch_msg->node_cnt; i++) {
+		if (batch_msg->return_codes[i])
+			error("%s: epilog error %pJ Node=%s Err=%s",
+			      __func__, job_ptr, batch_msg->node_names[i],
+			      slurm_strerror(batch_msg->return_codes[i]));
+	}
+
+	unlock_slurmctld(job_write_lock);
+	_throttle_fini(&active_rpc_cnt);
+	END_TIMER2(__func__);
+	debug2("%s: %pJ NodeCnt=%u %s",
+	       __func__, job_ptr, batch_msg->node_cnt, TIME_STR);
+
+	/* Functions below provide their own locking */
+	if (run_scheduler) {
+		if (!LOTS_OF_AGENTS &&
+		    !xstrcasestr(slurm_conf.sched_params, "defer"))
+			schedule(false);	/* Has own locking */
+		else
+			queue_job_scheduler();
+		schedule_node_save();		/* Has own locking */
+		schedule_job_save();		/* Has own locking */
+	}
+
+	/* NOTE: RPC has no response */
+}
+
 /* _slurm_rpc_job_step_kill - process RPC to cancel an entire job or
  * an individual job step */
 static void _slurm_rpc_job_step_kill(slurm_msg_t *msg)
@@ -2855,8 +2918,17 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 							  msg->protocol_version,
 							  &newly_up);
 #else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(msg, &newly_up);
+		if ((node_reg_stat_msg->flags & SLURMD_REG_FLAG_UNCHANGED) &&
+		    !valid_node_reg_epoch(node_reg_stat_msg)) {
+			/*
+			 * Nothing to validate against, ask the slurmd to
+			 * send its full registration instead.
+			 */
+			error_code = ESLURM_NODE_REG_STALE;
+		} else {
+			validate_jobs_on_node(node_reg_stat_msg);
+			error_code = validate_node_specs(msg, &newly_up);
+		}
 #endif
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(job_write_lock);
@@ -2870,7 +2942,12 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 send_resp:
 
 	/* return result */
-	if (error_code) {
+	if (error_code == ESLURM_NODE_REG_STALE) {
+		debug("%s node=%s: %s",
+		      __func__, node_reg_stat_msg->node_name,
+		      slurm_strerror(error_code));
+		slurm_send_rc_msg(msg, error_code);
+	} else if (error_code) {
 		error("%s node=%s: %s",
 		      __func__, node_reg_stat_msg->node_name,
 		      slurm_strerror(error_code));
@@ -6567,6 +6644,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_EPILOG_COMPLETE,
 		.func = _slurm_rpc_epilog_complete,
+	},{
+		.msg_type = MESSAGE_EPILOG_COMPLETE_BATCH,
+		.func = _slurm_rpc_epilog_complete_batch,
 	},{
 		.msg_type = REQUEST_CANCEL_JOB_STEP,
 		.func = _slurm_rpc_job_step_kill,
@@ -2486,6 +2486,33 @@ static void _set_features(node_record_t **old_node_table_ptr,
 		}
 	}
 }
+/*
+ * Return true if the configured resources of a node are the same in both
+ * config records, so a registration validated against the old record is
+ * still valid against the new one.
+ */
+static bool _same_node_config(config_record_t *old_config_ptr,
+			      config_record_t *config_ptr)
+{
+	if (!old_config_ptr || !config_ptr)
+		return false;
+
+	return ((old_config_ptr->boards == config_ptr->boards) &&
+		(old_config_ptr->core_spec_cnt == config_ptr->core_spec_cnt) &&
+		(old_config_ptr->cores == config_ptr->cores) &&
+		(old_config_ptr->cpus == config_ptr->cpus) &&
+		(old_config_ptr->mem_spec_limit ==
+		 config_ptr->mem_spec_limit) &&
+		(old_config_ptr->real_memory == config_ptr->real_memory) &&
+		(old_config_ptr->threads == config_ptr->threads) &&
+		(old_config_ptr->tmp_disk == config_ptr->tmp_disk) &&
+		(old_config_ptr->tot_sockets == config_ptr->tot_sockets) &&
+		!xstrcmp(old_config_ptr->cpu_spec_list,
+			 config_ptr->cpu_spec_list) &&
+		!xstrcmp(old_config_ptr->feature, config_ptr->feature) &&
+		!xstrcmp(old_config_ptr->gres, config_ptr->gres));
+}
+
 /* Restore node state and size information from saved records which match
  * the node registration message. If a node was re-configured to be down or
  * drained, we set those states. We only recover a node's Features if
@@ -2573,6 +2600,14 @@ static int _restore_node_state(int recover,
 		node_ptr->protocol_version = old_node_ptr->protocol_version;
 		node_ptr->cpu_load = old_node_ptr->cpu_load;
 
+		/*
+		 * The node may skip the full registration after this reconfig
+		 * only if its configured resources did not change.
+		 */
+		if (_same_node_config(old_node_ptr->config_ptr,
+				      node_ptr->config_ptr))
+			node_ptr->reg_epoch = old_node_ptr->reg_epoch;
+
 		/* make sure we get the old state from the select
 		 * plugin, just swap it out to avoid possible memory leak */
 		tmp_select_nodeinfo = node_ptr->select_nodeinfo;
@@ -2656,6 +2656,15 @@ extern int validate_job_create_req(job_desc_msg_t *job_desc, uid_t submit_uid,
  */
 extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg);
 
+/*
+ * valid_node_reg_epoch - test if a registration flagged as unchanged refers
+ *	to the last registration of the node that passed full validation
+ * IN reg_msg - node registration message
+ * RET true if the registration can be accepted without revalidation
+ * NOTE: READ lock_slurmctld node before entry
+ */
+extern bool valid_node_reg_epoch(slurm_node_registration_status_msg_t *reg_msg);
+
 /*
  * validate_node_specs - validate the node's specifications as valid,
  *	if not set state to down, in any case update last_response
@@ -0,0 +1,335 @@
+/*****************************************************************************\
+ *  bcast_cache.c - content addressed cache of file broadcast blocks
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/bcast/file_bcast.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/interfaces/hash.h"
+
+#include "src/slurmd/slurmd/bcast_cache.h"
+#include "src/slurmd/slurmd/slurmd.h"
+
+#define CACHE_DIR "bcast_cache"
+#define CACHE_LIFETIME (24 * 60 * 60)	/* purge blocks unused for a day */
+#define CACHE_PURGE_INTERVAL (60 * 60)	/* scan the cache at most hourly */
+#define DEFAULT_CACHE_SIZE 1024		/* MB */
+
+typedef struct {
+	char *path;
+	time_t mtime;
+	off_t size;
+} cache_entry_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static time_t last_purge = 0;
+/* bytes used by the cache or NO_VAL64 until it is scanned */
+static uint64_t cache_bytes = NO_VAL64;
+
+static char *_cache_dir(void)
+{
+	return xstrdup_printf("%s/%s", conf->spooldir, CACHE_DIR);
+}
+
+static char *_cache_path(slurm_hash_t *hash)
+{
+	char *path = _cache_dir();
+
+	xstrcatchar(path, '/');
+	for (int i = 0; i < sizeof(hash->hash); i++)
+		xstrfmtcat(path, "%02x", hash->hash[i]);
+
+	return path;
+}
+
+/* Size limit of the cache from BcastParameters=CacheSize=<MB> */
+static uint64_t _cache_limit(void)
+{
+	char *tmp;
+	uint64_t size_mb = DEFAULT_CACHE_SIZE;
+
+	if ((tmp = xstrcasestr(slurm_conf.bcast_parameters, "CacheSize=")))
+		size_mb = strtoull(tmp + 10, NULL, 10);
+
+	return size_mb * 1024 * 1024;
+}
+
+static int _cmp_entry_mtime(const void *x, const void *y)
+{
+	const cache_entry_t *a = x, *b = y;
+
+	if (a->mtime < b->mtime)
+		return -1;
+	if (a->mtime > b->mtime)
+		return 1;
+	return 0;
+}
+
+/*
+ * Remove blocks unused for CACHE_LIFETIME and then the least recently used
+ * blocks until the cache holds at most target bytes. Updates cache_bytes.
+ * Caller must hold cache_mutex.
+ */
+static void _purge_locked(uint64_t target)
+{
+	DIR *dp;
+	struct dirent *ent;
+	struct stat stat_buf;
+	char *dir, *path = NULL;
+	cache_entry_t *entries = NULL;
+	int count = 0;
+	uint64_t bytes = 0;
+	time_t now = time(NULL);
+
+	dir = _cache_dir();
+	if (!(dp = opendir(dir))) {
+		if (errno == ENOENT)
+			cache_bytes = 0;
+		xfree(dir);
+		return;
+	}
+
+	while ((ent = readdir(dp))) {
+		if (ent->d_name[0] == '.')
+			continue;
+		xstrfmtcat(path, "%s/%s", dir, ent->d_name);
+		if (stat(path, &stat_buf)) {
+			xfree(path);
+			continue;
+		}
+		if ((stat_buf.st_mtime + CACHE_LIFETIME) < now) {
+			debug("%s: removing %s", __func__, path);
+			(void) unlink(path);
+			xfree(path);
+			continue;
+		}
+
+		xrecalloc(entries, (count + 1), sizeof(*entries));
+		entries[count].path = path;
+		entries[count].mtime = stat_buf.st_mtime;
+		entries[count].size = stat_buf.st_size;
+		bytes += stat_buf.st_size;
+		count++;
+		path = NULL;
+	}
+	closedir(dp);
+
+	if (bytes > target) {
+		qsort(entries, count, sizeof(*entries), _cmp_entry_mtime);
+		for (int i = 0; (i < count) && (bytes > target); i++) {
+			debug("%s: evicting %s", __func__, entries[i].path);
+			if (!unlink(entries[i].path))
+				bytes -= entries[i].size;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+		xfree(entries[i].path);
+	xfree(entries);
+	xfree(dir);
+
+	cache_bytes = bytes;
+}
+
+/*
+ * Account for len more bytes in the cache, evicting least recently used
+ * blocks as needed.
+ * RET true if the block fits within the cache size limit
+ */
+static bool _reserve_space(uint32_t len)
+{
+	uint64_t limit = _cache_limit();
+	bool fits = false;
+
+	if (len > limit)
+		return false;
+
+	slurm_mutex_lock(&cache_mutex);
+	if (cache_bytes == NO_VAL64)
+		_purge_locked(NO_VAL64);
+	if ((cache_bytes == NO_VAL64) || ((cache_bytes + len) > limit)) {
+		/* evict down to 90% to avoid scanning for every block */
+		uint64_t low_water = (limit / 10) * 9;
+
+		_purge_locked((low_water > len) ? (low_water - len) : 0);
+	}
+	if ((cache_bytes != NO_VAL64) && ((cache_bytes + len) <= limit)) {
+		cache_bytes += len;
+		fits = true;
+	}
+	slurm_mutex_unlock(&cache_mutex);
+
+	return fits;
+}
+
+static void _release_space(uint32_t len)
+{
+	slurm_mutex_lock(&cache_mutex);
+	if (cache_bytes != NO_VAL64)
+		cache_bytes -= MIN(cache_bytes, len);
+	slurm_mutex_unlock(&cache_mutex);
+}
+
+extern int bcast_cache_fetch(slurm_hash_t *hash, uint32_t len, char **data)
+{
+	char *path;
+	struct stat stat_buf;
+	int fd, rc = ESLURMD_BCAST_CACHE_MISS;
+
+	if (!bcast_cache_enabled() || (hash->type != HASH_PLUGIN_K12))
+		return rc;
+
+	path = _cache_path(hash);
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+		if (errno != ENOENT)
+			error("%s: can't open %s: %m", __func__, path);
+		goto fini;
+	}
+	if (fstat(fd, &stat_buf) || (stat_buf.st_size != len)) {
+		error("%s: ignoring invalid cache entry %s", __func__, path);
+		goto fini;
+	}
+
+	*data = xmalloc(len);
+	safe_read(fd, *data, len);
+
+	/* Record the use so the purge keeps blocks that are still needed */
+	(void) futimens(fd, NULL);
+	rc = SLURM_SUCCESS;
+	debug2("%s: block cache hit for %s", __func__, path);
+	goto fini;
+
+rwfail:
+	error("%s: can't read %s: %m", __func__, path);
+	xfree(*data);
+fini:
+	if (fd >= 0)
+		close(fd);
+	xfree(path);
+	return rc;
+}
+
+extern void bcast_cache_store(slurm_hash_t *hash, char *data, uint32_t len)
+{
+	slurm_hash_t check = { .type = HASH_PLUGIN_K12 };
+	char *dir = NULL, *path = NULL, *tmp_path = NULL;
+	int fd;
+
+	if (!bcast_cache_enabled() || (hash->type != HASH_PLUGIN_K12))
+		return;
+
+	/*
+	 * Cached blocks may be handed to other users, so never trust the
+	 * hash the sender computed.
+	 */
+	if ((hash_g_compute(data, len, NULL, 0, &check) < 0) ||
+	    memcmp(check.hash, hash->hash, sizeof(check.hash))) {
+		error("%s: block hash mismatch, not caching", __func__);
+		return;
+	}
+
+	path = _cache_path(hash);
+	if (!access(path, F_OK))
+		goto fini;
+
+	dir = _cache_dir();
+	if (mkdir(dir, 0700) && (errno != EEXIST)) {
+		error("%s: can't create %s: %m", __func__, dir);
+		goto fini;
+	}
+
+	if (!_reserve_space(len)) {
+		debug("%s: cache full, not caching %u bytes", __func__, len);
+		goto fini;
+	}
+
+	/* Write to a private name first so readers never see partial data */
+	tmp_path = xstrdup_printf("%s.XXXXXX", path);
+	if ((fd = mkstemp(tmp_path)) < 0) {
+		error("%s: can't create %s: %m", __func__, tmp_path);
+		_release_space(len);
+		goto fini;
+	}
+	safe_write(fd, data, len);
+	close(fd);
+
+	if (rename(tmp_path, path)) {
+		error("%s: can't rename %s: %m", __func__, tmp_path);
+		(void) unlink(tmp_path);
+		_release_space(len);
+	}
+	goto fini;
+
+rwfail:
+	error("%s: can't write %s: %m", __func__, tmp_path);
+	close(fd);
+	(void) unlink(tmp_path);
+	_release_space(len);
+fini:
+	xfree(dir);
+	xfree(path);
+	xfree(tmp_path);
+}
+
+extern void bcast_cache_purge(void)
+{
+	time_t now = time(NULL);
+
+	if (!bcast_cache_enabled())
+		return;
+
+	slurm_mutex_lock(&cache_mutex);
+	if ((now - last_purge) >= CACHE_PURGE_INTERVAL) {
+		last_purge = now;
+		_purge_locked(_cache_limit());
+	}
+	slurm_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,63 @@
+/*****************************************************************************\
+ *  bcast_cache.h - content addressed cache of file broadcast blocks
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _BCAST_CACHE_H
+#define _BCAST_CACHE_H
+
+#include "slurm/slurm.h"
+
+/*
+ * Load a cached block.
+ * IN hash - hash of the uncompressed block data
+ * IN len - expected length of the block
+ * OUT data - xmalloc'ed block data on success
+ * RET SLURM_SUCCESS or ESLURMD_BCAST_CACHE_MISS
+ */
+extern int bcast_cache_fetch(slurm_hash_t *hash, uint32_t len, char **data);
+
+/*
+ * Add a block to the cache. The block is only stored if its content matches
+ * the hash supplied by the sender and it fits within the cache size limit
+ * after evicting the least recently used blocks.
+ */
+extern void bcast_cache_store(slurm_hash_t *hash, char *data, uint32_t len);
+
+/*
+ * Remove cached blocks which have not been used recently and enforce the
+ * cache size limit
+ */
+extern void bcast_cache_purge(void);
+
+#endif
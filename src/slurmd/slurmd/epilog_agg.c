@@ -0,0 +1,428 @@
+/*****************************************************************************\
+ *  epilog_agg.c - aggregate epilog completion messages through a tree
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * When a large job ends every node used to send its own
+ * MESSAGE_EPILOG_COMPLETE to slurmctld, each one taking the job write lock.
+ * Instead, the nodes of the job form the same reverse tree used for step
+ * completion. Each node collects the completions of its subtree and relays
+ * them to its parent in one MESSAGE_EPILOG_COMPLETE_BATCH, so slurmctld only
+ * receives a few batches which it processes under a single lock.
+ *
+ * A node never waits more than AGG_WAIT seconds for its subtree, so a slow
+ * epilog can not keep the other nodes of the job from being released. Any
+ * later completions are relayed in a separate batch. If the parent can not
+ * be reached, the batch is sent directly to slurmctld.
+ */
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/reverse_tree.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmd/slurmd/epilog_agg.h"
+#include "src/slurmd/slurmd/slurmd.h"
+
+#define AGG_WAIT 2		/* seconds to wait for the rest of a subtree */
+#define AGG_EXPIRE 300		/* seconds to remember a job's parent */
+#define AGG_PARAM "batch_epilog_complete"
+
+typedef struct {
+	time_t deadline;	/* send pending entries at this time */
+	int expected;		/* entries from this subtree, 0 if unknown */
+	time_t expire;		/* forget the record after this time */
+	uint32_t job_id;
+	char *parent;		/* parent node, NULL to send to slurmctld */
+	int pending_cnt;	/* entries not yet relayed */
+	char **pending_names;
+	uint32_t *pending_rcs;
+	int reported;		/* entries already relayed */
+} agg_rec_t;
+
+static List agg_list = NULL;
+static pthread_mutex_t agg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t agg_cond = PTHREAD_COND_INITIALIZER;
+static bool agent_running = false;
+static bool agg_shutdown = false;
+
+static void _free_agg_rec(void *x)
+{
+	agg_rec_t *rec = x;
+
+	if (!rec)
+		return;
+
+	for (int i = 0; i < rec->pending_cnt; i++)
+		xfree(rec->pending_names[i]);
+	xfree(rec->pending_names);
+	xfree(rec->pending_rcs);
+	xfree(rec->parent);
+	xfree(rec);
+}
+
+static int _find_agg_rec(void *x, void *key)
+{
+	agg_rec_t *rec = x;
+
+	return (rec->job_id == *(uint32_t *) key);
+}
+
+/* agg_mutex must be locked */
+static agg_rec_t *_get_agg_rec(uint32_t job_id)
+{
+	agg_rec_t *rec;
+
+	if (!agg_list)
+		agg_list = list_create(_free_agg_rec);
+
+	if (!(rec = list_find_first(agg_list, _find_agg_rec, &job_id))) {
+		rec = xmalloc(sizeof(*rec));
+		rec->job_id = job_id;
+		list_append(agg_list, rec);
+	}
+	rec->expire = time(NULL) + AGG_EXPIRE;
+
+	return rec;
+}
+
+/* agg_mutex must be locked */
+static void _add_entry(agg_rec_t *rec, char *node_name, uint32_t rc)
+{
+	xrecalloc(rec->pending_names, rec->pending_cnt + 1, sizeof(char *));
+	xrecalloc(rec->pending_rcs, rec->pending_cnt + 1, sizeof(uint32_t));
+	rec->pending_names[rec->pending_cnt] = xstrdup(node_name);
+	rec->pending_rcs[rec->pending_cnt] = rc;
+	rec->pending_cnt++;
+
+	if (!rec->deadline)
+		rec->deadline = time(NULL) + AGG_WAIT;
+}
+
+/*
+ * Move a record's pending entries into a new batch message.
+ * agg_mutex must be locked.
+ * OUT parent - xstrdup'ed parent name, NULL if sending to slurmctld
+ */
+static epilog_complete_batch_msg_t *_take_pending(agg_rec_t *rec,
+						  char **parent)
+{
+	epilog_complete_batch_msg_t *batch = xmalloc(sizeof(*batch));
+
+	batch->job_id = rec->job_id;
+	batch->node_cnt = rec->pending_cnt;
+	batch->node_names = rec->pending_names;
+	batch->return_codes = rec->pending_rcs;
+	*parent = xstrdup(rec->parent);
+
+	rec->reported += rec->pending_cnt;
+	rec->pending_cnt = 0;
+	rec->pending_names = NULL;
+	rec->pending_rcs = NULL;
+	rec->deadline = 0;
+
+	return batch;
+}
+
+static void _send_to_ctld(epilog_complete_batch_msg_t *batch)
+{
+	slurm_msg_t msg;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = MESSAGE_EPILOG_COMPLETE_BATCH;
+	msg.data = batch;
+
+	/*
+	 * Note: No return code from message, slurmctld will resend
+	 * TERMINATE_JOB request if message send fails.
+	 */
+	if (slurm_send_only_controller_msg(&msg, working_cluster_rec) < 0)
+		error("JobId=%u: Unable to send epilog complete batch message: %m",
+		      batch->job_id);
+	else
+		debug("JobId=%u: sent epilog complete batch msg for %u nodes",
+		      batch->job_id, batch->node_cnt);
+}
+
+static void _send_batch(epilog_complete_batch_msg_t *batch, char *parent)
+{
+	slurm_msg_t msg;
+	int rc = SLURM_ERROR;
+
+	if (!parent) {
+		_send_to_ctld(batch);
+		goto fini;
+	}
+
+	slurm_msg_t_init(&msg);
+	slurm_msg_set_r_uid(&msg, slurm_conf.slurmd_user_id);
+	msg.msg_type = MESSAGE_EPILOG_COMPLETE_BATCH;
+	msg.data = batch;
+
+	if (slurm_conf_get_addr(parent, &msg.address, msg.flags))
+		error("%s: failed getting address for parent NodeName %s",
+		      __func__, parent);
+	else if (slurm_send_recv_rc_msg_only_one(&msg, &rc, 0))
+		rc = SLURM_ERROR;
+
+	if (rc) {
+		debug("JobId=%u: relaying epilog completion to %s failed, sending to slurmctld",
+		      batch->job_id, parent);
+		_send_to_ctld(batch);
+	} else {
+		debug2("JobId=%u: relayed epilog completion of %u nodes to %s",
+		       batch->job_id, batch->node_cnt, parent);
+	}
+
+fini:
+	slurm_free_epilog_complete_batch_msg(batch);
+}
+
+/* agg_mutex must be locked */
+static bool _subtree_done(agg_rec_t *rec)
+{
+	return (rec->expected &&
+		((rec->reported + rec->pending_cnt) >= rec->expected));
+}
+
+typedef struct {
+	List batches;
+	time_t now;
+} foreach_due_t;
+
+typedef struct {
+	epilog_complete_batch_msg_t *batch;
+	char *parent;
+} due_batch_t;
+
+static int _collect_due(void *x, void *arg)
+{
+	agg_rec_t *rec = x;
+	foreach_due_t *args = arg;
+
+	if (rec->pending_cnt &&
+	    (agg_shutdown || _subtree_done(rec) ||
+	     (rec->deadline <= args->now))) {
+		due_batch_t *due = xmalloc(sizeof(*due));
+		due->batch = _take_pending(rec, &due->parent);
+		list_append(args->batches, due);
+	}
+
+	/* Remove records which are complete or stale */
+	if (!rec->pending_cnt &&
+	    (agg_shutdown || _subtree_done(rec) || (rec->expire <= args->now)))
+		return 1;
+
+	return 0;
+}
+
+static void _send_due(bool all)
+{
+	foreach_due_t args = {
+		.now = time(NULL),
+	};
+	due_batch_t *due;
+
+	args.batches = list_create(NULL);
+
+	slurm_mutex_lock(&agg_mutex);
+	if (all)
+		agg_shutdown = true;
+	if (agg_list)
+		list_delete_all(agg_list, _collect_due, &args);
+	slurm_mutex_unlock(&agg_mutex);
+
+	while ((due = list_pop(args.batches))) {
+		_send_batch(due->batch, due->parent);
+		xfree(due->parent);
+		xfree(due);
+	}
+	FREE_NULL_LIST(args.batches);
+}
+
+static void *_agent(void *arg)
+{
+	struct timespec ts = {0, 0};
+
+	while (true) {
+		_send_due(false);
+
+		slurm_mutex_lock(&agg_mutex);
+		if (agg_shutdown || !agg_list || !list_count(agg_list)) {
+			agent_running = false;
+			slurm_mutex_unlock(&agg_mutex);
+			break;
+		}
+		ts.tv_sec = time(NULL) + 1;
+		slurm_cond_timedwait(&agg_cond, &agg_mutex, &ts);
+		slurm_mutex_unlock(&agg_mutex);
+	}
+
+	return NULL;
+}
+
+/* agg_mutex must be locked */
+static void _start_agent(void)
+{
+	if (agent_running) {
+		slurm_cond_signal(&agg_cond);
+		return;
+	}
+	agent_running = true;
+	slurm_thread_create_detached(NULL, _agent, NULL);
+}
+
+extern bool epilog_agg_enabled(void)
+{
+#ifdef HAVE_FRONT_END
+	return false;
+#else
+	return (xstrcasestr(slurm_conf.slurmd_params, AGG_PARAM) != NULL);
+#endif
+}
+
+/* Width of the tree, REVERSE_TREE_WIDTH unless batch_epilog_complete=# */
+static int _tree_width(void)
+{
+	char *tmp, *end = NULL;
+	long width;
+
+	if (!(tmp = xstrcasestr(slurm_conf.slurmd_params, AGG_PARAM "=")))
+		return REVERSE_TREE_WIDTH;
+
+	tmp += strlen(AGG_PARAM "=");
+	width = strtol(tmp, &end, 10);
+	if ((end == tmp) || ((*end != '\0') && (*end != ',')) ||
+	    (width < 1) || (width > UINT16_MAX)) {
+		error("Invalid SlurmdParameters=%s=%s, using width %d",
+		      AGG_PARAM, tmp, REVERSE_TREE_WIDTH);
+		return REVERSE_TREE_WIDTH;
+	}
+
+	return width;
+}
+
+extern int epilog_agg_complete(uint32_t job_id, char *nodes, uint32_t rc)
+{
+	hostlist_t hl;
+	agg_rec_t *rec;
+	char *parent = NULL;
+	int rank, node_cnt, parent_rank, children, depth, max_depth;
+
+	if (!nodes || !(hl = hostlist_create(nodes)))
+		return SLURM_ERROR;
+
+	node_cnt = hostlist_count(hl);
+	rank = hostlist_find(hl, conf->node_name);
+	if ((node_cnt < 2) || (rank < 0)) {
+		hostlist_destroy(hl);
+		return SLURM_ERROR;
+	}
+
+	reverse_tree_info(rank, node_cnt, _tree_width(), &parent_rank,
+			  &children, &depth, &max_depth);
+	if (children == -1) {
+		hostlist_destroy(hl);
+		return SLURM_ERROR;
+	}
+	/* rank 0 always talks directly to the slurmctld */
+	if ((rank > 0) && (parent_rank != -1))
+		parent = hostlist_nth(hl, parent_rank);
+	hostlist_destroy(hl);
+
+	slurm_mutex_lock(&agg_mutex);
+	if (agg_shutdown) {
+		slurm_mutex_unlock(&agg_mutex);
+		free(parent);
+		return SLURM_ERROR;
+	}
+	rec = _get_agg_rec(job_id);
+	xfree(rec->parent);
+	rec->parent = xstrdup(parent);
+	rec->expected = children + 1;
+	_add_entry(rec, conf->node_name, rc);
+	_start_agent();
+	slurm_mutex_unlock(&agg_mutex);
+	free(parent);
+
+	/* Send right away if the subtree (e.g. a leaf) is already complete */
+	_send_due(false);
+
+	return SLURM_SUCCESS;
+}
+
+extern void epilog_agg_add(epilog_complete_batch_msg_t *msg)
+{
+	agg_rec_t *rec;
+	bool sent_direct = false;
+
+	slurm_mutex_lock(&agg_mutex);
+	if (agg_shutdown) {
+		sent_direct = true;
+	} else {
+		rec = _get_agg_rec(msg->job_id);
+		for (int i = 0; i < msg->node_cnt; i++)
+			_add_entry(rec, msg->node_names[i],
+				   msg->return_codes[i]);
+		_start_agent();
+	}
+	slurm_mutex_unlock(&agg_mutex);
+
+	if (sent_direct)
+		_send_to_ctld(msg);
+	else
+		_send_due(false);
+}
+
+extern void epilog_agg_fini(void)
+{
+	_send_due(true);
+
+	slurm_mutex_lock(&agg_mutex);
+	FREE_NULL_LIST(agg_list);
+	slurm_mutex_unlock(&agg_mutex);
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************\
+ *  epilog_agg.h - aggregate epilog completion messages through a tree
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _EPILOG_AGG_H
+#define _EPILOG_AGG_H
+
+#include "src/common/slurm_protocol_defs.h"
+
+/* Return true if SlurmdParameters enables batched epilog completion */
+extern bool epilog_agg_enabled(void);
+
+/*
+ * Report this node's epilog completion for a job.
+ * IN job_id - job whose epilog completed
+ * IN nodes - node list of the job, used to build the reporting tree
+ * IN rc - epilog return code
+ * RET SLURM_SUCCESS if the completion was queued, SLURM_ERROR if the caller
+ *     should send MESSAGE_EPILOG_COMPLETE itself
+ */
+extern int epilog_agg_complete(uint32_t job_id, char *nodes, uint32_t rc);
+
+/* Queue completions relayed from this node's children in the tree */
+extern void epilog_agg_add(epilog_complete_batch_msg_t *msg);
+
+/* Send any queued completions straight to slurmctld */
+extern void epilog_agg_fini(void);
+
+#endif
@@ -105,6 +105,8 @@
 
 #include "src/bcast/file_bcast.h"
 
+#include "src/slurmd/slurmd/bcast_cache.h"
+#include "src/slurmd/slurmd/epilog_agg.h"
 #include "src/slurmd/slurmd/get_mach_stat.h"
 #include "src/slurmd/slurmd/slurmd.h"
 
@@ -186,6 +188,7 @@ static void _rpc_reconfig(slurm_msg_t *msg);
 static void _rpc_reconfig_with_config(slurm_msg_t *msg);
 static void _rpc_reboot(slurm_msg_t *msg);
 static void _rpc_pid2jid(slurm_msg_t *msg);
+static void _rpc_epilog_complete_batch(slurm_msg_t *msg);
 static void _rpc_file_bcast(slurm_msg_t *msg);
 static void _file_bcast_cleanup(void);
 static int  _file_bcast_register_file(slurm_msg_t *msg,
@@ -394,6 +397,9 @@ slurmd_req(slurm_msg_t *msg)
 	case REQUEST_STEP_COMPLETE:
 		_rpc_step_complete(msg);
 		break;
+	case MESSAGE_EPILOG_COMPLETE_BATCH:
+		_rpc_epilog_complete_batch(msg);
+		break;
 	case REQUEST_JOB_STEP_STAT:
 		_rpc_stat_jobacct(msg);
 		break;
@@ -4177,6 +4183,8 @@ static void _file_bcast_cleanup(void)
 	list_delete_all(file_bcast_list, _bcast_find_in_list_to_remove, &now);
 	list_delete_all(bcast_libdir_list, _libdir_find_in_list_to_remove, &now);
 	_fb_wrunlock();
+
+	bcast_cache_purge();
 }
 
 static int _bcast_find_by_job(void *x, void *y)
@@ -4261,6 +4269,22 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 #endif
 	key.step_id = cred_arg->step_id;
 
+	/*
+	 * Look up cached data before touching any file state, so that a miss
+	 * has no side effects and the sender can retry with the data. The
+	 * credential is checked first so that callers can not learn which
+	 * blocks are cached.
+	 */
+	if (req->flags & FILE_BCAST_CACHE_PROBE) {
+		if ((rc = bcast_cache_fetch(&req->block_hash, req->uncomp_len,
+					    &req->block))) {
+			sbcast_cred_arg_free(cred_arg);
+			goto done;
+		}
+		req->block_len = req->uncomp_len;
+		req->compress = COMPRESS_OFF;
+	}
+
 #if 0
 	info("last_block=%u force=%u modes=%o",
 	     req->last_block, req->force, req->modes);
@@ -4347,10 +4371,15 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		goto done;
 	}
 
+	/*
+	 * Blocks may arrive out of order when the sender pipelines the
+	 * transfer, so always write at the block's own offset.
+	 */
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(file_info->fd, &req->block[offset],
-			    (req->block_len - offset));
+		inx = pwrite(file_info->fd, &req->block[offset],
+			     (req->block_len - offset),
+			     (req->block_offset + offset));
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
@@ -4363,6 +4392,10 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		offset += inx;
 	}
 
+	if ((req->flags & FILE_BCAST_CACHE) &&
+	    !(req->flags & FILE_BCAST_CACHE_PROBE))
+		bcast_cache_store(&req->block_hash, req->block, req->block_len);
+
 	file_info->last_update = time(NULL);
 
 	if ((req->flags & FILE_BCAST_LAST_BLOCK) &&
@@ -4912,6 +4945,22 @@ static int _epilog_complete(uint32_t jobid, int rc)
 	return SLURM_SUCCESS;
 }
 
+/* Queue epilog completions relayed by this node's children in the tree */
+static void _rpc_epilog_complete_batch(slurm_msg_t *msg)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!_slurm_authorized_user(msg->auth_uid)) {
+		error("Security violation: epilog complete batch RPC from uid %u",
+		      msg->auth_uid);
+		rc = ESLURM_USER_ID_MISSING;
+	} else {
+		epilog_agg_add(msg->data);
+	}
+
+	slurm_send_rc_msg(msg, rc);
+}
+
 /* if a lock is granted to the job then return 1; else return 0 if
  * the lock for the job is already taken or there's no more locks */
 static int
@@ -5547,9 +5596,12 @@ _rpc_terminate_job(slurm_msg_t *msg)
 done:
 	_wait_state_completed(req->step_id.job_id, 5);
 	_waiter_complete(req->step_id.job_id);
-	_sync_messages_kill(req);
 
-	_epilog_complete(req->step_id.job_id, rc);
+	if (!epilog_agg_enabled() ||
+	    epilog_agg_complete(req->step_id.job_id, req->nodes, rc)) {
+		_sync_messages_kill(req);
+		_epilog_complete(req->step_id.job_id, rc);
+	}
 }
 
 /* On a parallel job, every slurmd may send the EPILOG_COMPLETE
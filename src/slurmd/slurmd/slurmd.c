@@ -119,6 +119,7 @@
 #include "src/interfaces/task.h"
 #include "src/slurmd/common/xcpuinfo.h"
 
+#include "src/slurmd/slurmd/epilog_agg.h"
 #include "src/slurmd/slurmd/get_mach_stat.h"
 #include "src/slurmd/slurmd/req.h"
 #include "src/slurmd/slurmd/slurmd.h"
@@ -177,6 +178,14 @@ static sig_atomic_t _update_log = 0;
 static pthread_t msg_pthread = (pthread_t) 0;
 static time_t sent_reg_time = (time_t) 0;
 
+/*
+ * last registration accepted by the slurmctld, so a registration after a
+ * reconfigure can be reduced to "unchanged since reg_epoch"
+ */
+static time_t reg_epoch = (time_t) 0;
+static buf_t *reg_fingerprint = NULL;
+static pthread_mutex_t reg_epoch_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * cached features
  */
@@ -212,6 +221,7 @@ static void      _process_cmdline(int ac, char **av);
 static void      _read_config(void);
 static void      _reconfigure(void);
 static void     *_registration_engine(void *arg);
+static int       _send_registration_msg(uint32_t status, bool reconfig);
 static void      _resource_spec_fini(void);
 static int       _resource_spec_init(void);
 static int       _restore_cred_state(slurm_cred_ctx_t *ctx);
@@ -423,6 +433,7 @@ main (int argc, char **argv)
 	 * failure.
 	 */
 	run_command_shutdown();
+	epilog_agg_fini();
 	_slurmd_fini();
 	_destroy_conf();
 	slurm_cred_fini();	/* must be after _destroy_conf() */
@@ -744,13 +755,90 @@ static void _handle_node_reg_resp(slurm_msg_t *resp_msg)
 	}
 }
 
+/*
+ * Pack everything the slurmctld validates in a registration, so we can tell
+ * if any of it changed since the last registration that was accepted.
+ */
+static buf_t *_pack_reg_fingerprint(slurm_node_registration_status_msg_t *msg)
+{
+	buf_t *buffer = init_buf(1024);
+	uint32_t gres_info_size = 0;
+
+	packstr(msg->arch, buffer);
+	pack16(msg->boards, buffer);
+	pack16(msg->cores, buffer);
+	packstr(msg->cpu_spec_list, buffer);
+	pack16(msg->cpus, buffer);
+	packstr(msg->features_active, buffer);
+	packstr(msg->features_avail, buffer);
+	if (msg->gres_info)
+		gres_info_size = get_buf_offset(msg->gres_info);
+	pack32(gres_info_size, buffer);
+	if (gres_info_size)
+		packmem(get_buf_data(msg->gres_info), gres_info_size, buffer);
+	pack32(msg->hash_val, buffer);
+	packstr(msg->node_name, buffer);
+	packstr(msg->os, buffer);
+	pack64(msg->real_memory, buffer);
+	pack16(msg->sockets, buffer);
+	pack16(msg->threads, buffer);
+	pack32(msg->tmp_disk, buffer);
+	packstr(msg->version, buffer);
+
+	return buffer;
+}
+
+static bool _reg_unchanged(buf_t *fingerprint, uint32_t status, bool reconfig)
+{
+#ifdef HAVE_FRONT_END
+	return false;
+#else
+	if (!reconfig || !reg_epoch || !reg_fingerprint ||
+	    (status != SLURM_SUCCESS) || (conf->dynamic_type != DYN_NODE_NONE))
+		return false;
+
+	return ((get_buf_offset(fingerprint) ==
+		 get_buf_offset(reg_fingerprint)) &&
+		!memcmp(get_buf_data(fingerprint), get_buf_data(reg_fingerprint),
+			get_buf_offset(fingerprint)));
+#endif
+}
+
+/*
+ * Drop what the slurmctld already has from the last accepted registration.
+ */
+static void _strip_registration_msg(slurm_node_registration_status_msg_t *msg)
+{
+	xfree(msg->arch);
+	xfree(msg->cpu_spec_list);
+	xfree(msg->features_active);
+	xfree(msg->features_avail);
+	FREE_NULL_BUFFER(msg->gres_info);
+	xfree(msg->os);
+}
+
 extern int send_registration_msg(uint32_t status)
+{
+	return _send_registration_msg(status, false);
+}
+
+/*
+ * IN reconfig - true if sent after a reconfigure, in which case only a
+ *	compact "unchanged" registration is sent if nothing the slurmctld
+ *	validates has changed since the last accepted registration
+ */
+static int _send_registration_msg(uint32_t status, bool reconfig)
 {
 	int ret_val = SLURM_SUCCESS;
 	slurm_msg_t req, resp_msg;
-	slurm_node_registration_status_msg_t *msg =
-		xmalloc(sizeof(slurm_node_registration_status_msg_t));
-
+	slurm_node_registration_status_msg_t *msg;
+	buf_t *fingerprint = NULL;
+	bool unchanged;
+	time_t timestamp;
+
+	slurm_mutex_lock(&reg_epoch_mutex);
+again:
+	msg = xmalloc(sizeof(slurm_node_registration_status_msg_t));
 	slurm_msg_t_init(&req);
 	slurm_msg_t_init(&resp_msg);
 
@@ -759,6 +847,16 @@ extern int send_registration_msg(uint32_t status)
 
 	_fill_registration_msg(msg);
 	msg->status = status;
+	timestamp = msg->timestamp;
+
+	fingerprint = _pack_reg_fingerprint(msg);
+	if ((unchanged = _reg_unchanged(fingerprint, status, reconfig))) {
+		debug("%s: registration unchanged since %ld",
+		      __func__, (long) reg_epoch);
+		msg->flags |= SLURMD_REG_FLAG_UNCHANGED;
+		msg->reg_epoch = reg_epoch;
+		_strip_registration_msg(msg);
+	}
 
 	req.msg_type = MESSAGE_NODE_REGISTRATION_STATUS;
 	req.data = msg;
@@ -781,9 +879,25 @@ extern int send_registration_msg(uint32_t status)
 		errno = 0;
 	}
 
-	if (ret_val == SLURM_SUCCESS)
+	if (unchanged && (ret_val == ESLURM_NODE_REG_STALE)) {
+		debug("%s: slurmctld requested a full registration", __func__);
+		reg_epoch = 0;
+		FREE_NULL_BUFFER(fingerprint);
+		goto again;
+	}
+
+	if (ret_val == SLURM_SUCCESS) {
 		sent_reg_time = time(NULL);
+		if (!unchanged) {
+			reg_epoch = timestamp;
+			FREE_NULL_BUFFER(reg_fingerprint);
+			reg_fingerprint = fingerprint;
+			fingerprint = NULL;
+		}
+	}
 fail:
+	FREE_NULL_BUFFER(fingerprint);
+	slurm_mutex_unlock(&reg_epoch_mutex);
 	return ret_val;
 }
 
@@ -938,6 +1052,8 @@ _read_config(void)
 {
 	char *bcast_address;
 	char *path_pubkey = NULL;
+	char *hw_params;
+	static char *last_hw_params = NULL;
 	slurm_conf_t *cf = NULL;
 	int cc;
 	bool cgroup_mem_confinement = false;
@@ -1016,10 +1132,6 @@ _read_config(void)
 	conf->cpu_spec_list = xstrdup(node_ptr->cpu_spec_list);
 	conf->mem_spec_limit = node_ptr->mem_spec_limit;
 
-	/* store hardware properties in slurmd_config */
-	xfree(conf->block_map);
-	xfree(conf->block_map_inv);
-
 	/*
 	 * This must be reset before update_slurmd_logging(), otherwise the
 	 * slurmstepd processes will not get the reconfigure request, and logs
@@ -1041,8 +1153,6 @@ _read_config(void)
 	update_slurmd_logging(LOG_LEVEL_END);
 	_update_nice();
 
-	conf->actual_cpus = 0;
-
 	if (!conf->conf_cache && xstrcasestr(cf->slurmctld_params,
 					     "enable_configless"))
 		warning("Running with local config file despite slurmctld having been setup for configless operation");
@@ -1052,13 +1162,34 @@ _read_config(void)
 	 * it will work properly.  This is the earliest we can unset def_config.
 	 */
 	conf->def_config = false;
-	xcpuinfo_hwloc_topo_get(&conf->actual_cpus,
-				&conf->actual_boards,
-				&conf->actual_sockets,
-				&conf->actual_cores,
-				&conf->actual_threads,
-				&conf->block_map_size,
-				&conf->block_map, &conf->block_map_inv);
+
+	/*
+	 * The hardware does not change under a running slurmd, so only probe
+	 * it again if a parameter affecting how the topology is interpreted
+	 * changed with this reconfigure.
+	 */
+	hw_params = xstrdup_printf("%s:%s:%s", conf->spooldir,
+				   slurm_conf.sched_params,
+				   slurm_conf.slurmd_params);
+	if (conf->actual_cpus && !xstrcmp(hw_params, last_hw_params)) {
+		debug("%s: hardware topology unchanged, not probing it again",
+		      __func__);
+		xfree(hw_params);
+	} else {
+		/* store hardware properties in slurmd_config */
+		xfree(conf->block_map);
+		xfree(conf->block_map_inv);
+		conf->actual_cpus = 0;
+
+		xcpuinfo_hwloc_topo_get(&conf->actual_cpus,
+					&conf->actual_boards,
+					&conf->actual_sockets,
+					&conf->actual_cores,
+					&conf->actual_threads,
+					&conf->block_map_size,
+					&conf->block_map, &conf->block_map_inv);
+		_free_and_set(last_hw_params, hw_params);
+	}
 #ifdef HAVE_FRONT_END
 	/*
 	 * When running with multiple frontends, the slurmd S:C:T values are not
@@ -1275,7 +1406,7 @@ _reconfigure(void)
 	slurm_mutex_lock(&cached_features_mutex);
 	refresh_cached_features = true;
 	slurm_mutex_unlock(&cached_features_mutex);
-	send_registration_msg(SLURM_SUCCESS);
+	_send_registration_msg(SLURM_SUCCESS, true);
 
 	acct_gather_reconfig();
 
@@ -2231,6 +2362,10 @@ _slurmd_fini(void)
 	xfree(cached_features_active);
 	refresh_cached_features = true;
 	slurm_mutex_unlock(&cached_features_mutex);
+	slurm_mutex_lock(&reg_epoch_mutex);
+	FREE_NULL_BUFFER(reg_fingerprint);
+	reg_epoch = 0;
+	slurm_mutex_unlock(&reg_epoch_mutex);
 	slurm_mutex_lock(&fini_job_mutex);
 	xfree(fini_job_id);
 	fini_job_cnt = 0;
@@ -118,6 +118,12 @@ struct client_io_info {
 
 	/* true if writing to a file, false if writing to a socket */
 	bool is_local_file;
+
+	/* SLURM_IO_FLAG_* negotiated with the client */
+	uint16_t io_flags;
+	/* frame and scratch space used to coalesce queued messages */
+	struct io_buf *batch_msg;
+	char *batch_raw;
 };
 
 
@@ -193,8 +199,9 @@ static void *_window_manager(void *arg);
  * General declarations
  **********************************************************************/
 static void *_io_thr(void *);
+static uint16_t _get_io_flags(srun_info_t *srun, stepd_step_rec_t *step);
 static int _send_io_init_msg(int sock, srun_info_t *srun, stepd_step_rec_t *step,
-			     bool init);
+			     bool init, uint16_t io_flags);
 static void _send_eof_msg(struct task_read_info *out);
 static struct io_buf *_task_build_message(struct task_read_info *out,
 					  stepd_step_rec_t *step, cbuf_t *cbuf);
@@ -207,6 +214,7 @@ static bool _incoming_buf_free(stepd_step_rec_t *step);
 static bool _outgoing_buf_free(stepd_step_rec_t *step);
 static int  _send_connection_okay_response(stepd_step_rec_t *step);
 static struct io_buf *_build_connection_okay_message(stepd_step_rec_t *step);
+static struct io_buf *_build_batch_message(struct client_io_info *client);
 
 /**********************************************************************
  * IO client socket functions
@@ -443,7 +451,11 @@ _client_write(eio_obj_t *obj, List objs)
 	 * next message from the queue.
 	 */
 	if (client->out_msg == NULL) {
-		client->out_msg = list_dequeue(client->msg_queue);
+		if ((client->io_flags & SLURM_IO_FLAG_COALESCE) &&
+		    (list_count(client->msg_queue) > 1))
+			client->out_msg = _build_batch_message(client);
+		else
+			client->out_msg = list_dequeue(client->msg_queue);
 		if (client->out_msg == NULL) {
 			debug5("_client_write: nothing in the queue");
 			return SLURM_SUCCESS;
@@ -483,12 +495,56 @@ again:
 	if (client->out_remaining > 0)
 		return SLURM_SUCCESS;
 
-	_free_outgoing_msg(client->out_msg, client->step);
+	/* The batch frame is reused, its messages were already released */
+	if (client->out_msg != client->batch_msg)
+		_free_outgoing_msg(client->out_msg, client->step);
 	client->out_msg = NULL;
 
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Coalesce the messages queued for a client into one SLURM_IO_BATCH frame.
+ * Queued messages are copied into the frame and released right away, so
+ * their buffers can be refilled by the tasks while the frame is written.
+ */
+static struct io_buf *_build_batch_message(struct client_io_info *client)
+{
+	stepd_step_rec_t *step = client->step;
+	struct io_buf *msg;
+	uint32_t raw_len = 0;
+	int count = 0;
+
+	if (!client->batch_msg) {
+		client->batch_msg = xmalloc(sizeof(*client->batch_msg));
+		client->batch_msg->data = xmalloc(io_batch_frame_size());
+		client->batch_raw = xmalloc(io_batch_raw_size());
+	}
+
+	while ((count < SLURM_IO_BATCH_MAX_MSGS) &&
+	       (msg = list_dequeue(client->msg_queue))) {
+		memcpy(client->batch_raw + raw_len, msg->data, msg->length);
+		raw_len += msg->length;
+		count++;
+		_free_outgoing_msg(msg, step);
+	}
+
+	client->batch_msg->length = io_batch_frame_pack(client->batch_msg->data,
+							client->batch_raw,
+							raw_len,
+							client->io_flags);
+	client->batch_msg->ref_count = 1;
+
+	step->io_batch_cnt++;
+	step->io_batch_raw += raw_len;
+	step->io_batch_sent += client->batch_msg->length;
+
+	debug5("%s: coalesced %d messages, %u bytes into %u",
+	       __func__, count, raw_len, client->batch_msg->length);
+
+	return client->batch_msg;
+}
+
 
 static bool
 _local_file_writable(eio_obj_t *obj)
@@ -1482,6 +1538,10 @@ _io_thr(void *arg)
 	debug("IO handler started pid=%lu", (unsigned long) getpid());
 	rc = eio_handle_mainloop(step->eio);
 	debug("IO handler exited, rc=%d", rc);
+	if (step->io_batch_cnt)
+		debug("%ps: coalesced %"PRIu64" bytes of stdio into %u frames of %"PRIu64" bytes",
+		      &step->step_id, step->io_batch_raw, step->io_batch_cnt,
+		      step->io_batch_sent);
 	return (void *)1;
 }
 
@@ -1548,6 +1608,7 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *step,
 	int sock = -1;
 	struct client_io_info *client;
 	eio_obj_t *obj;
+	uint16_t io_flags;
 
 	debug4 ("adding IO connection (logical node rank %d)", step->nodeid);
 
@@ -1568,7 +1629,8 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *step,
 	}
 
 	fd_set_blocking(sock);  /* just in case... */
-	_send_io_init_msg(sock, srun, step, true);
+	io_flags = _get_io_flags(srun, step);
+	_send_io_init_msg(sock, srun, step, true, io_flags);
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1584,6 +1646,7 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *step,
 	client->labelio = false;
 	client->taskid_width = 0;
 	client->is_local_file = false;
+	client->io_flags = io_flags;
 
 	obj = eio_obj_create(sock, &client_ops, (void *)client);
 	list_append(step->clients, (void *)obj);
@@ -1622,7 +1685,7 @@ io_client_connect(srun_info_t *srun, stepd_step_rec_t *step)
 	}
 
 	fd_set_blocking(sock);  /* just in case... */
-	_send_io_init_msg(sock, srun, step, false);
+	_send_io_init_msg(sock, srun, step, false, 0);
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1649,8 +1712,33 @@ io_client_connect(srun_info_t *srun, stepd_step_rec_t *step)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Only the stdio modes requested at launch, understood by the client and
+ * supported by this slurmstepd are used on a connection.
+ */
+static uint16_t _get_io_flags(srun_info_t *srun, stepd_step_rec_t *step)
+{
+	uint16_t io_flags = SLURM_IO_FLAG_COALESCE;
+
+	if (!(step->flags & LAUNCH_IO_COALESCE) ||
+	    (srun->protocol_version < SLURM_23_11_PROTOCOL_VERSION))
+		return 0;
+
+	if (step->flags & LAUNCH_IO_LZ4) {
+#if HAVE_LZ4
+		io_flags |= SLURM_IO_FLAG_LZ4;
+#else
+		info("%ps: lz4 compression not supported, coalescing stdio uncompressed",
+		     &step->step_id);
+#endif
+	}
+
+	return io_flags;
+}
+
 static int
-_send_io_init_msg(int sock, srun_info_t *srun, stepd_step_rec_t *step, bool init)
+_send_io_init_msg(int sock, srun_info_t *srun, stepd_step_rec_t *step,
+		  bool init, uint16_t io_flags)
 {
 	io_init_msg_t msg;
 
@@ -1659,6 +1747,7 @@ _send_io_init_msg(int sock, srun_info_t *srun, stepd_step_rec_t *step, bool init
 	memcpy(msg.io_key, srun->key->data, srun->key->len);
 	msg.nodeid = step->nodeid;
 	msg.version = srun->protocol_version;
+	msg.io_flags = io_flags;
 
 	/*
 	 * The initial message does not need the node_offset it is needed for
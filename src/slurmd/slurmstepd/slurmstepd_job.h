@@ -228,6 +228,9 @@ typedef struct {
 	List outgoing_cache;  /* cache of outgoing stdio messages
 			       * used when a new client attaches
 			       */
+	uint32_t io_batch_cnt;  /* count of coalesced stdio frames sent */
+	uint64_t io_batch_raw;  /* stdio bytes carried by coalesced frames */
+	uint64_t io_batch_sent; /* bytes of coalesced frames on the wire */
 
 	pthread_t      ioid;  /* pthread id of IO thread                    */
 	pthread_t      msgid; /* pthread id of message thread               */
@@ -63,6 +63,27 @@
 #include "src/slurmdbd/slurmdbd.h"
 #include "src/slurmctld/slurmctld.h"
 
+/* Fewest records of a DBD_SEND_MULT_MSG worth a connection of their own */
+#define MULT_MSG_MIN_SLICE_RECORDS 50
+
+typedef struct {
+#ifndef NDEBUG
+	bool drop_priv;
+#endif
+	int first;		/* first record to process */
+	uint32_t *job_ids;	/* job of each record */
+	int last;		/* record after the last one to process */
+	persist_msg_t *msgs;	/* records of the message */
+	buf_t **ret_bufs;	/* response to each record */
+	int slice;		/* process the records of job_id % slice_cnt */
+	int slice_cnt;
+	slurmdbd_conn_t slurmdbd_conn; /* with the db_conn of the slice */
+	int *stop;		/* first record that failed */
+	int *stop_rc;		/* error of the first record that failed */
+	pthread_mutex_t *stop_lock;
+	uint32_t *uid;
+} mult_msg_slice_t;
+
 /* Local functions */
 static bool  _validate_slurm_user(uint32_t uid);
 static bool  _validate_super_user(uint32_t uid, slurmdbd_conn_t *slurmdbd_conn);
@@ -135,6 +156,17 @@ static bool _validate_operator(uint32_t uid, slurmdbd_conn_t *dbd_conn)
 	return false;
 }
 
+/*
+ * Reporting queries (jobs, usage, events, reservations and transactions) may
+ * go to the StorageReplicaHost so they do not compete with the controllers.
+ * Everything a controller or sacctmgr reads back right after changing it
+ * stays on the primary connection.
+ */
+static void *_read_conn(slurmdbd_conn_t *slurmdbd_conn)
+{
+	return acct_storage_g_get_read_connection(slurmdbd_conn->db_conn);
+}
+
 static void _add_registered_cluster(slurmdbd_conn_t *db_conn)
 {
 	ListIterator itr;
@@ -928,7 +960,7 @@ static int _get_events(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	debug2("DBD_GET_EVENTS: called in CONN %d", slurmdbd_conn->conn->fd);
 
 	list_msg.my_list = acct_storage_g_get_events(
-		slurmdbd_conn->db_conn, *uid, get_msg->cond);
+		_read_conn(slurmdbd_conn), *uid, get_msg->cond);
 
 	if (!errno) {
 		if (!list_msg.my_list)
@@ -951,6 +983,26 @@ static int _get_events(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
+/* Send one chunk of a streamed DBD_GET_JOBS_COND response */
+static int _send_jobs_chunk(List job_list, void *arg)
+{
+	slurmdbd_conn_t *slurmdbd_conn = arg;
+	dbd_list_msg_t list_msg = { NULL };
+	buf_t *buffer = init_buf(1024);
+	int rc;
+
+	list_msg.my_list = job_list;
+	pack16((uint16_t) DBD_GOT_JOBS_CHUNK, buffer);
+	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
+			       DBD_GOT_JOBS_CHUNK, buffer);
+	if ((rc = slurm_persist_send_msg(slurmdbd_conn->conn, buffer)))
+		error("Problem sending DBD_GOT_JOBS_CHUNK to CONN %d: %s",
+		      slurmdbd_conn->conn->fd, slurm_strerror(rc));
+	FREE_NULL_BUFFER(buffer);
+
+	return rc;
+}
+
 static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			  buf_t **out_buffer, uint32_t *uid)
 {
@@ -995,8 +1047,21 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 		}
 	}
 
-	list_msg.my_list = jobacct_storage_g_get_jobs_cond(
-		slurmdbd_conn->db_conn, *uid, job_cond);
+	if ((job_cond->flags & JOBCOND_FLAG_STREAM) &&
+	    (slurmdbd_conn->conn->version >= SLURM_23_11_PROTOCOL_VERSION)) {
+		/*
+		 * The jobs are sent as they are read, the DBD_GOT_JOBS below
+		 * only marks the end.
+		 */
+		if ((rc = jobacct_storage_g_get_jobs_stream(
+			     _read_conn(slurmdbd_conn), *uid, job_cond,
+			     _send_jobs_chunk, slurmdbd_conn)))
+			errno = rc;
+		else
+			errno = 0;
+	} else
+		list_msg.my_list = jobacct_storage_g_get_jobs_cond(
+			_read_conn(slurmdbd_conn), *uid, job_cond);
 
 	if (!errno) {
 		if (!list_msg.my_list)
@@ -1126,8 +1191,8 @@ static int _get_txn(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 
 	debug2("DBD_GET_TXN: called in CONN %d", slurmdbd_conn->conn->fd);
 
-	list_msg.my_list = acct_storage_g_get_txn(slurmdbd_conn->db_conn, *uid,
-						  cond_msg->cond);
+	list_msg.my_list = acct_storage_g_get_txn(_read_conn(slurmdbd_conn),
+						  *uid, cond_msg->cond);
 
 	if (!errno) {
 		if (!list_msg.my_list)
@@ -1181,7 +1246,7 @@ static int _get_usage(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 		return SLURM_ERROR;
 	}
 
-	rc = acct_storage_g_get_usage(slurmdbd_conn->db_conn,
+	rc = acct_storage_g_get_usage(_read_conn(slurmdbd_conn),
 				      *uid, get_msg->rec, msg->msg_type,
 				      get_msg->start, get_msg->end);
 
@@ -1311,7 +1376,7 @@ static int _get_reservations(slurmdbd_conn_t *slurmdbd_conn,
 	debug2("DBD_GET_RESVS: called in CONN %d", slurmdbd_conn->conn->fd);
 
 	list_msg.my_list = acct_storage_g_get_reservations(
-		slurmdbd_conn->db_conn, *uid, get_msg->cond);
+		_read_conn(slurmdbd_conn), *uid, get_msg->cond);
 
 	if (!errno) {
 		if (!list_msg.my_list)
@@ -2948,6 +3013,179 @@ static int _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Return the job a record of a DBD_SEND_MULT_MSG is about, or 0 if the record
+ * has to be processed in order with every other record of the message.
+ */
+static uint32_t _mult_msg_job_id(persist_msg_t *msg)
+{
+	switch (msg->msg_type) {
+	case DBD_JOB_COMPLETE:
+		return ((dbd_job_comp_msg_t *) msg->data)->job_id;
+	case DBD_JOB_START:
+		return ((dbd_job_start_msg_t *) msg->data)->job_id;
+	case DBD_JOB_SUSPEND:
+		return ((dbd_job_suspend_msg_t *) msg->data)->job_id;
+	case DBD_STEP_COMPLETE:
+		return ((dbd_step_comp_msg_t *) msg->data)->step_id.job_id;
+	case DBD_STEP_START:
+		return ((dbd_step_start_msg_t *) msg->data)->step_id.job_id;
+	default:
+		return 0;
+	}
+}
+
+/* Get the database connection of a slice of a DBD_SEND_MULT_MSG */
+static void *_mult_msg_db_conn(slurmdbd_conn_t *slurmdbd_conn, int slice)
+{
+	if (!slice)
+		return slurmdbd_conn->db_conn;
+
+	if (slice > slurmdbd_conn->mult_db_conn_cnt) {
+		xrecalloc(slurmdbd_conn->mult_db_conns, slice, sizeof(void *));
+		slurmdbd_conn->mult_db_conn_cnt = slice;
+	}
+	if (!slurmdbd_conn->mult_db_conns[slice - 1])
+		slurmdbd_conn->mult_db_conns[slice - 1] =
+			acct_storage_g_get_connection(
+				slurmdbd_conn->conn->fd, NULL, true,
+				slurmdbd_conn->conn->cluster_name);
+
+	return slurmdbd_conn->mult_db_conns[slice - 1];
+}
+
+static void _mult_msg_slice(mult_msg_slice_t *slice)
+{
+	for (int i = slice->first; i < slice->last; i++) {
+		int rc;
+
+		if ((slice->job_ids[i] % slice->slice_cnt) != slice->slice)
+			continue;
+
+		/*
+		 * Nothing of the run is committed once any record failed, so
+		 * don't bother writing more.
+		 */
+		slurm_mutex_lock(slice->stop_lock);
+		if (*slice->stop < slice->last) {
+			slurm_mutex_unlock(slice->stop_lock);
+			break;
+		}
+		slurm_mutex_unlock(slice->stop_lock);
+
+		rc = proc_req(&slice->slurmdbd_conn, &slice->msgs[i],
+			      &slice->ret_bufs[i], slice->uid);
+		if (rc != SLURM_SUCCESS) {
+			slurm_mutex_lock(slice->stop_lock);
+			if (i < *slice->stop) {
+				*slice->stop = i;
+				*slice->stop_rc = rc;
+			}
+			slurm_mutex_unlock(slice->stop_lock);
+			break;
+		}
+	}
+}
+
+static void *_mult_msg_slice_thread(void *arg)
+{
+	mult_msg_slice_t *slice = arg;
+
+#ifndef NDEBUG
+	drop_priv = slice->drop_priv;
+#endif
+	_mult_msg_slice(slice);
+
+	return NULL;
+}
+
+/*
+ * Process the records first to last of a DBD_SEND_MULT_MSG, which are all
+ * about jobs, in slices each with its own database connection. All the records
+ * of a job are in the same slice so they are still written in order.
+ *
+ * Every slice is committed before the run returns, as the next run may write
+ * the same job on another connection which would then wait for the row locks
+ * of this one. If a record fails the whole run is rolled back, other slices
+ * may have written records past it.
+ * OUT rc - error of the first record not stored
+ * RET index of the first record not stored, last if all were
+ */
+static int _mult_msg_parallel(slurmdbd_conn_t *slurmdbd_conn,
+			      persist_msg_t *msgs, uint32_t *job_ids,
+			      buf_t **ret_bufs, int first, int last,
+			      int slice_cnt, uint32_t *uid, int *rc)
+{
+	mult_msg_slice_t *args = xcalloc(slice_cnt, sizeof(*args));
+	pthread_t *threads = xcalloc(slice_cnt, sizeof(pthread_t));
+	pthread_mutex_t stop_lock = PTHREAD_MUTEX_INITIALIZER;
+	int stop = last, stop_rc = SLURM_SUCCESS, done = last;
+
+	debug2("DBD_SEND_MULT_MSG: writing %d job records in %d slices",
+	       (last - first), slice_cnt);
+
+	for (int i = 0; i < slice_cnt; i++) {
+		args[i].first = first;
+		args[i].job_ids = job_ids;
+		args[i].last = last;
+		args[i].msgs = msgs;
+		args[i].ret_bufs = ret_bufs;
+		args[i].slice = i;
+		args[i].slice_cnt = slice_cnt;
+		args[i].slurmdbd_conn = *slurmdbd_conn;
+		args[i].slurmdbd_conn.db_conn =
+			_mult_msg_db_conn(slurmdbd_conn, i);
+		args[i].stop = &stop;
+		args[i].stop_rc = &stop_rc;
+		args[i].stop_lock = &stop_lock;
+		args[i].uid = uid;
+#ifndef NDEBUG
+		args[i].drop_priv = drop_priv;
+#endif
+	}
+
+	/* The first slice is done here on the connection of the message */
+	for (int i = 1; i < slice_cnt; i++)
+		slurm_thread_create(&threads[i], _mult_msg_slice_thread,
+				    &args[i]);
+	_mult_msg_slice(&args[0]);
+	for (int i = 1; i < slice_cnt; i++)
+		pthread_join(threads[i], NULL);
+
+	if (stop < last) {
+		for (int i = 0; i < slice_cnt; i++)
+			acct_storage_g_commit(args[i].slurmdbd_conn.db_conn, 0);
+		*rc = stop_rc;
+		done = first;
+	}
+
+	for (int i = 0; (stop == last) && (i < slice_cnt); i++) {
+		int commit_rc;
+
+		if (!(commit_rc = acct_storage_g_commit(
+			      args[i].slurmdbd_conn.db_conn, 1)))
+			continue;
+
+		/*
+		 * Nothing of this slice made it to the database, tell the
+		 * slurmctld to send everything from its first record again.
+		 */
+		for (int j = first; j < done; j++) {
+			if ((job_ids[j] % slice_cnt) == i) {
+				done = j;
+				*rc = commit_rc;
+				break;
+			}
+		}
+	}
+
+	slurm_mutex_destroy(&stop_lock);
+	xfree(args);
+	xfree(threads);
+
+	return done;
+}
+
 static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			  buf_t **out_buffer, uint32_t *uid)
 {
@@ -2955,9 +3193,12 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	dbd_list_msg_t list_msg = { NULL };
 	char *comment = NULL;
 	ListIterator itr = NULL;
-	buf_t *req_buf = NULL, *ret_buf = NULL;
-	int rc = SLURM_SUCCESS;
-	/* DEF_TIMERS; */
+	buf_t *req_buf = NULL, **ret_bufs;
+	persist_msg_t *msgs;
+	uint32_t *job_ids;
+	int rc = SLURM_SUCCESS, cnt = 0, msg_cnt, unpacked = 0, stop;
+	int max_slices = 1, serial_first = -1;
+	DEF_TIMERS;
 
 	if (!_validate_slurm_user(*uid)) {
 		comment = "DBD_SEND_MULT_MSG message from invalid uid";
@@ -2970,31 +3211,133 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	}
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
-	/* START_TIMER; */
-	itr = list_iterator_create(get_msg->my_list);
-	while ((req_buf = list_next(itr))) {
-		persist_msg_t sub_msg;
+	START_TIMER;
+	/*
+	 * Commit the whole message once instead of after every record so the
+	 * storage plugin can batch the records into multi-row statements.
+	 */
+	slurmdbd_conn->mult_msg = (slurmdbd_conf->max_batch_records > 1);
 
-		ret_buf = NULL;
+	/*
+	 * The records of different jobs can be written in parallel on their
+	 * own connections, as long as each is committed by this function and
+	 * not by the commit handler, so a failed run can be rolled back.
+	 */
+	if (slurmdbd_conn->mult_msg && slurmdbd_conn->conn->rem_port &&
+	    !slurmdbd_conf->commit_delay &&
+	    (slurmdbd_conf->max_batch_threads > 1))
+		max_slices = slurmdbd_conf->max_batch_threads;
 
+	msg_cnt = list_count(get_msg->my_list);
+	msgs = xcalloc(msg_cnt, sizeof(*msgs));
+	ret_bufs = xcalloc(msg_cnt, sizeof(*ret_bufs));
+	job_ids = xcalloc(msg_cnt, sizeof(*job_ids));
+
+	itr = list_iterator_create(get_msg->my_list);
+	while ((req_buf = list_next(itr))) {
 		rc = slurm_persist_conn_process_msg(
-			slurmdbd_conn->conn, &sub_msg,
+			slurmdbd_conn->conn, &msgs[unpacked],
 			get_buf_data(req_buf),
-			size_buf(req_buf), &ret_buf, 0);
+			size_buf(req_buf), &ret_bufs[unpacked], 0);
+		if (rc != SLURM_SUCCESS)
+			break;
+		if (max_slices > 1)
+			job_ids[unpacked] = _mult_msg_job_id(&msgs[unpacked]);
+		unpacked++;
+	}
+	list_iterator_destroy(itr);
+	stop = unpacked;
+
+	for (int i = 0; i < unpacked; ) {
+		int last = i, slice_cnt;
+
+		while ((last < unpacked) && job_ids[last])
+			last++;
+		slice_cnt = MIN(max_slices,
+				(last - i) / MULT_MSG_MIN_SLICE_RECORDS);
+
+		if (slice_cnt > 1) {
+			int done;
 
-		if (rc == SLURM_SUCCESS) {
-			rc = proc_req(slurmdbd_conn, &sub_msg, &ret_buf, uid);
-			slurmdbd_free_msg(&sub_msg);
+			/*
+			 * Commit the records written in order so far first, a
+			 * slice may write the same jobs on another connection.
+			 */
+			if ((serial_first >= 0) &&
+			    (rc = acct_storage_g_commit(slurmdbd_conn->db_conn,
+							1))) {
+				stop = serial_first;
+				comment = "DBD_SEND_MULT_MSG commit failed";
+				break;
+			}
+			serial_first = -1;
+
+			done = _mult_msg_parallel(slurmdbd_conn, msgs, job_ids,
+						  ret_bufs, i, last, slice_cnt,
+						  uid, &rc);
+			if (done < last) {
+				stop = done;
+				comment = "DBD_SEND_MULT_MSG job records not stored";
+				break;
+			}
+			i = last;
+			continue;
 		}
 
-		if (ret_buf)
-			list_append(list_msg.my_list, ret_buf);
-		if (rc != SLURM_SUCCESS)
+		if (serial_first < 0)
+			serial_first = i;
+		if (proc_req(slurmdbd_conn, &msgs[i], &ret_bufs[i], uid) !=
+		    SLURM_SUCCESS) {
+			stop = i;
 			break;
+		}
+		i++;
 	}
-	list_iterator_destroy(itr);
-	/* END_TIMER; */
-	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
+
+	if (slurmdbd_conn->mult_msg) {
+		slurmdbd_conn->mult_msg = false;
+		if (!comment && (serial_first >= 0) &&
+		    slurmdbd_conn->conn->rem_port &&
+		    !slurmdbd_conf->commit_delay &&
+		    (rc = acct_storage_g_commit(slurmdbd_conn->db_conn, 1))) {
+			/*
+			 * Nothing since the last commit made it to the
+			 * database, tell the slurmctld to send it again.
+			 */
+			stop = serial_first;
+			comment = "DBD_SEND_MULT_MSG commit failed";
+		}
+	}
+
+	cnt = stop;
+	if (comment)
+		error("%s: %s", comment, slurm_strerror(rc));
+
+	for (int i = 0; i < msg_cnt; i++) {
+		if (ret_bufs[i] && ((i < cnt) || ((i == cnt) && !comment)))
+			list_append(list_msg.my_list, ret_bufs[i]);
+		else
+			FREE_NULL_BUFFER(ret_bufs[i]);
+		if (i < unpacked)
+			slurmdbd_free_msg(&msgs[i]);
+	}
+	if (comment)
+		list_append(list_msg.my_list,
+			    slurm_persist_make_rc_msg(slurmdbd_conn->conn,
+						      rc, comment,
+						      DBD_SEND_MULT_MSG));
+	xfree(msgs);
+	xfree(ret_bufs);
+	xfree(job_ids);
+	END_TIMER;
+	debug3("DBD_SEND_MULT_MSG: %d of %d records took %s",
+	       cnt, msg_cnt, TIME_STR);
+
+	slurm_mutex_lock(&rpc_mutex);
+	rpc_stats.batch_cnt++;
+	rpc_stats.batch_records += cnt;
+	rpc_stats.batch_time += DELTA_TIMER;
+	slurm_mutex_unlock(&rpc_mutex);
 
 	*out_buffer = init_buf(1024);
 	pack16((uint16_t) DBD_GOT_MULT_MSG, *out_buffer);
@@ -3165,6 +3508,7 @@ static int _get_stats(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 {
 	int rc = SLURM_SUCCESS;
 	char *comment = NULL;
+	slurmdb_stats_rec_t *stats_ptr;
 
 	if (!_validate_super_user(*uid, slurmdbd_conn)) {
 		comment = "Your user doesn't have privilege to perform this action";
@@ -3180,6 +3524,9 @@ static int _get_stats(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	*out_buffer = init_buf(32 * 1024);
 	pack16((uint16_t) DBD_GOT_STATS, *out_buffer);
 	slurm_mutex_lock(&rpc_mutex);
+	/* Let the storage plugin add its own statistics */
+	stats_ptr = &rpc_stats;
+	acct_storage_g_get_stats(slurmdbd_conn->db_conn, &stats_ptr);
 	slurmdb_pack_stats_msg(&rpc_stats, slurmdbd_conn->conn->version,
 			       *out_buffer);
 	slurm_mutex_unlock(&rpc_mutex);
@@ -3207,6 +3554,7 @@ static int _clear_stats(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	info("Clear stats request received from UID %u", *uid);
 
 	init_dbd_stats();
+	acct_storage_g_clear_stats(slurmdbd_conn->db_conn);
 
 	*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
 						rc, comment, DBD_CLEAR_STATS);
@@ -3495,7 +3843,8 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->mult_msg) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
@@ -47,6 +47,10 @@ typedef struct {
 	slurm_persist_conn_t *conn;
 	slurm_persist_conn_t *conn_send;
 	void *db_conn; /* database connection */
+	bool mult_msg; /* processing a DBD_SEND_MULT_MSG in one transaction */
+	void **mult_db_conns; /* more database connections to write the
+			       * records of a DBD_SEND_MULT_MSG in parallel */
+	int mult_db_conn_cnt;
 	char *tres_str;
 } slurmdbd_conn_t;
 
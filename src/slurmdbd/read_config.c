@@ -110,6 +110,7 @@ static void _clear_slurmdbd_conf(void)
 		slurmdbd_conf->purge_txn = 0;
 		slurmdbd_conf->purge_usage = 0;
 		xfree(slurmdbd_conf->storage_loc);
+		xfree(slurmdbd_conf->storage_replica_host);
 		slurmdbd_conf->track_wckey = 0;
 		slurmdbd_conf->track_ctld = 0;
 	}
@@ -149,10 +150,14 @@ extern int read_slurmdbd_conf(void)
 		{"DebugLevel", S_P_STRING},
 		{"DebugLevelSyslog", S_P_STRING},
 		{"DefaultQOS", S_P_STRING},
+		{"JobCacheWindow", S_P_UINT16},
 		{"JobPurge", S_P_UINT32},
 		{"LogFile", S_P_STRING},
 		{"LogTimeFormat", S_P_STRING},
+		{"MaxBatchRecords", S_P_UINT32},
+		{"MaxBatchThreads", S_P_UINT16},
 		{"MaxQueryTimeRange", S_P_STRING},
+		{"MaxRollupThreads", S_P_UINT16},
 		{"MessageTimeout", S_P_UINT16},
 		{"Parameters", S_P_STRING},
 		{"PidFile", S_P_STRING},
@@ -179,6 +184,9 @@ extern int read_slurmdbd_conf(void)
 		{"StorageParameters", S_P_STRING},
 		{"StoragePass", S_P_STRING},
 		{"StoragePort", S_P_UINT16},
+		{"StorageReplicaHost", S_P_STRING},
+		{"StorageReplicaMaxLag", S_P_UINT32},
+		{"StorageReplicaPort", S_P_UINT16},
 		{"StorageType", S_P_STRING},
 		{"StorageUser", S_P_STRING},
 		{"TCPTimeout", S_P_UINT16},
@@ -329,6 +337,8 @@ extern int read_slurmdbd_conf(void)
 		}
 
 		s_p_get_string(&slurmdbd_conf->default_qos, "DefaultQOS", tbl);
+		s_p_get_uint16(&slurmdbd_conf->job_cache_window,
+			       "JobCacheWindow", tbl);
 		if (s_p_get_uint32(&slurmdbd_conf->purge_job,
 				   "JobPurge", tbl)) {
 			if (!slurmdbd_conf->purge_job)
@@ -368,6 +378,16 @@ extern int read_slurmdbd_conf(void)
 		} else
 			slurm_conf.log_fmt = LOG_FMT_ISO8601_MS;
 
+		if (!s_p_get_uint32(&slurmdbd_conf->max_batch_records,
+				    "MaxBatchRecords", tbl))
+			slurmdbd_conf->max_batch_records =
+				DEFAULT_SLURMDBD_MAX_BATCH_RECORDS;
+
+		if (!s_p_get_uint16(&slurmdbd_conf->max_batch_threads,
+				    "MaxBatchThreads", tbl))
+			slurmdbd_conf->max_batch_threads =
+				DEFAULT_SLURMDBD_MAX_BATCH_THREADS;
+
 		if (s_p_get_string(&temp_str, "MaxQueryTimeRange", tbl)) {
 			slurmdbd_conf->max_time_range = time_str2secs(temp_str);
 			xfree(temp_str);
@@ -375,6 +395,11 @@ extern int read_slurmdbd_conf(void)
 			slurmdbd_conf->max_time_range = INFINITE;
 		}
 
+		if (!s_p_get_uint16(&slurmdbd_conf->max_rollup_threads,
+				    "MaxRollupThreads", tbl))
+			slurmdbd_conf->max_rollup_threads =
+				DEFAULT_SLURMDBD_MAX_ROLLUP_THREADS;
+
 		if (!s_p_get_uint16(&slurm_conf.msg_timeout, "MessageTimeout",
 		                    tbl))
 			slurm_conf.msg_timeout = DEFAULT_MSG_TIMEOUT;
@@ -576,6 +601,14 @@ extern int read_slurmdbd_conf(void)
 			       "StoragePass", tbl);
 		s_p_get_uint16(&slurm_conf.accounting_storage_port,
 		               "StoragePort", tbl);
+		s_p_get_string(&slurmdbd_conf->storage_replica_host,
+			       "StorageReplicaHost", tbl);
+		if (!s_p_get_uint32(&slurmdbd_conf->storage_replica_max_lag,
+				    "StorageReplicaMaxLag", tbl))
+			slurmdbd_conf->storage_replica_max_lag =
+				DEFAULT_SLURMDBD_REPLICA_MAX_LAG;
+		s_p_get_uint16(&slurmdbd_conf->storage_replica_port,
+			       "StorageReplicaPort", tbl);
 		s_p_get_string(&slurm_conf.accounting_storage_type,
 		               "StorageType", tbl);
 		s_p_get_string(&slurm_conf.accounting_storage_user,
@@ -668,6 +701,10 @@ extern int read_slurmdbd_conf(void)
 				xstrdup(DEFAULT_STORAGE_LOC);
 	}
 
+	if (!slurmdbd_conf->storage_replica_port)
+		slurmdbd_conf->storage_replica_port =
+			slurm_conf.accounting_storage_port;
+
 	if (slurmdbd_conf->archive_dir) {
 		if (stat(slurmdbd_conf->archive_dir, &buf) < 0)
 			fatal("Failed to stat the archive directory %s: %m",
@@ -887,11 +924,29 @@ extern List dump_config(void)
 	key_pair->value = xstrdup(slurmdbd_conf->default_qos);
 	list_append(my_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("JobCacheWindow");
+	key_pair->value = xstrdup_printf("%u hours",
+					 slurmdbd_conf->job_cache_window);
+	list_append(my_list, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("LogFile");
 	key_pair->value = xstrdup(slurmdbd_conf->log_file);
 	list_append(my_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("MaxBatchRecords");
+	key_pair->value = xstrdup_printf("%u",
+					 slurmdbd_conf->max_batch_records);
+	list_append(my_list, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("MaxBatchThreads");
+	key_pair->value = xstrdup_printf("%u",
+					 slurmdbd_conf->max_batch_threads);
+	list_append(my_list, key_pair);
+
 	secs2time_str(slurmdbd_conf->max_time_range, time_str,
 		      sizeof(time_str));
 	key_pair = xmalloc(sizeof(config_key_pair_t));
@@ -899,6 +954,12 @@ extern List dump_config(void)
 	key_pair->value = xstrdup_printf("%s", time_str);
 	list_append(my_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("MaxRollupThreads");
+	key_pair->value = xstrdup_printf("%u",
+					 slurmdbd_conf->max_rollup_threads);
+	list_append(my_list, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("MessageTimeout");
 	key_pair->value = xstrdup_printf("%u secs", slurm_conf.msg_timeout);
@@ -1040,6 +1101,23 @@ extern List dump_config(void)
 	                                 slurm_conf.accounting_storage_port);
 	list_append(my_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("StorageReplicaHost");
+	key_pair->value = xstrdup(slurmdbd_conf->storage_replica_host);
+	list_append(my_list, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("StorageReplicaMaxLag");
+	key_pair->value = xstrdup_printf(
+		"%u secs", slurmdbd_conf->storage_replica_max_lag);
+	list_append(my_list, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("StorageReplicaPort");
+	key_pair->value = xstrdup_printf(
+		"%u", slurmdbd_conf->storage_replica_port);
+	list_append(my_list, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("StorageType");
 	key_pair->value = xstrdup(slurm_conf.accounting_storage_type);
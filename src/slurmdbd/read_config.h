@@ -53,6 +53,10 @@
 #define DEFAULT_SLURMDBD_KEEPALIVE_INTERVAL 30
 #define DEFAULT_SLURMDBD_KEEPALIVE_PROBES 3
 #define DEFAULT_SLURMDBD_KEEPALIVE_TIME 30
+#define DEFAULT_SLURMDBD_MAX_BATCH_RECORDS 100
+#define DEFAULT_SLURMDBD_MAX_BATCH_THREADS 4
+#define DEFAULT_SLURMDBD_MAX_ROLLUP_THREADS 4
+#define DEFAULT_SLURMDBD_REPLICA_MAX_LAG 30
 //#define DEFAULT_SLURMDBD_STEP_PURGE	1
 
 /* Define slurmdbd_conf_t flags */
@@ -75,7 +79,15 @@ typedef struct {
 	char *	 	default_qos;	/* default qos setting when
 					 * adding clusters              */
 	uint32_t flags;			/* Various flags see DBD_CONF_FLAG_* */
+	uint16_t	job_cache_window; /* hours of recent jobs kept in
+					   * memory, 0 to disable */
 	char *		log_file;	/* Log file			*/
+	uint32_t	max_batch_records; /* max job/step records written
+					    * in one batch */
+	uint16_t	max_batch_threads; /* max connections writing the
+					    * jobs of one batch */
+	uint16_t	max_rollup_threads; /* max threads per cluster for
+					     * the hourly rollup */
 	uint32_t	max_time_range;	/* max time range for user queries */
 	char *		parameters;	/* parameters to change behavior with
 					 * the slurmdbd directly	*/
@@ -97,6 +109,11 @@ typedef struct {
 	uint32_t        purge_usage;    /* purge usage data older
 					 * than this in months or days	*/
 	char *		storage_loc;	/* database name		*/
+	char *		storage_replica_host; /* read replica of the
+					       * database */
+	uint32_t	storage_replica_max_lag; /* max seconds the replica
+						  * may be behind */
+	uint16_t	storage_replica_port; /* port of the read replica */
 	uint16_t	syslog_debug;	/* output to both logfile and syslog*/
 	uint16_t        track_wckey;    /* Whether or not to track wckey*/
 	uint16_t        track_ctld;     /* Whether or not track when a
@@ -173,6 +173,9 @@ static void _connection_fini_callback(void *arg)
 	}
 
 	acct_storage_g_close_connection(&conn->db_conn);
+	for (int i = 0; i < conn->mult_db_conn_cnt; i++)
+		acct_storage_g_close_connection(&conn->mult_db_conns[i]);
+	xfree(conn->mult_db_conns);
 
 	if (stay_locked)
 		slurm_mutex_unlock(&registered_lock);
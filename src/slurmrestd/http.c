@@ -63,6 +63,8 @@
 #define HTTP_PARSER_RETURN_ERROR 1
 
 #define MAGIC_REQUEST_T 0xdbadaaaf
+/* largest body buffer to keep for the next request on a connection */
+#define MAX_KEEP_BODY_BYTES 65536
 /* Data to handed around by http_parser to call backs */
 typedef struct {
 	int magic;
@@ -128,6 +130,33 @@ static void _free_request_t(request_t *request)
 	xfree(request);
 }
 
+/*
+ * Clear request to parse the next request on a persistent connection while
+ * keeping the header list and body buffer allocations for reuse
+ */
+static void _reset_request_t(request_t *request)
+{
+	xassert(request->magic == MAGIC_REQUEST_T);
+
+	list_flush(request->headers);
+	xfree(request->path);
+	xfree(request->query);
+	xfree(request->last_header);
+	xfree(request->content_type);
+	xfree(request->accept);
+	xfree(request->body_encoding);
+	request->keep_alive = 0;
+	request->connection_close = false;
+	request->expect = 0;
+	request->expected_body_length = 0;
+	request->body_length = 0;
+
+	if (request->body && (xsize(request->body) > MAX_KEEP_BODY_BYTES))
+		xfree(request->body);
+	else if (request->body)
+		request->body[0] = '\0';
+}
+
 static void _http_parser_url_init(struct http_parser_url *url)
 {
 #if (HTTP_PARSER_VERSION_MAJOR == 2 && HTTP_PARSER_VERSION_MINOR >= 6) || \
@@ -368,43 +397,31 @@ static int _on_headers_complete(http_parser *parser)
 static int _on_body(http_parser *parser, const char *at, size_t length)
 {
 	request_t *request = parser->data;
+	size_t nlength;
 	xassert(request->magic == MAGIC_REQUEST_T);
 
 	log_flag_hex(NET_RAW, at, length, "%s: [%s] received HTTP body",
 	       __func__, request->context->con->name);
 
-	if (request->body) {
-		size_t nlength = length + request->body_length;
+	nlength = length + request->body_length;
 
-		xassert(request->body_length > 0);
-		xassert(request->body_length <= MAX_BODY_BYTES);
-		xassert((request->body_length + 1) == xsize(request->body));
+	if (nlength >= MAX_BODY_BYTES)
+		goto no_mem;
 
-		if (nlength > MAX_BODY_BYTES)
-			goto no_mem;
-
-		if (request->expected_body_length &&
-		    (nlength > request->expected_body_length))
-			goto no_mem;
+	if (request->expected_body_length &&
+	    (nlength > request->expected_body_length))
+		goto no_mem;
 
+	/* body buffer may be left over from a prior request */
+	if (!request->body || (xsize(request->body) < (nlength + 1))) {
 		if (!try_xrealloc(request->body, (nlength + 1)))
 			goto no_mem;
-
-		memmove((request->body + request->body_length), at, length);
-		request->body_length += length;
-	} else {
-		if ((length >= MAX_BODY_BYTES) ||
-		    (request->expected_body_length &&
-		     (length > request->expected_body_length)) ||
-		    !(request->body = try_xmalloc(length + 1)))
-			goto no_mem;
-
-		request->body_length = length;
-		memmove(request->body, at, length);
 	}
 
+	memmove((request->body + request->body_length), at, length);
+	request->body_length = nlength;
+
 	/* final byte must in body must always be NULL terminated */
-	xassert(!request->body[request->body_length]);
 	request->body[request->body_length] = '\0';
 
 	log_flag(NET, "%s: [%s] received %zu bytes for HTTP body length %zu/%zu bytes",
@@ -419,15 +436,20 @@ no_mem:
 }
 
 /*
- * Create rfc2616 formatted header
+ * Append rfc2616 formatted header
  * TODO: add more sanity checks
+ * IN/OUT buffer buffer to append header
+ * IN/OUT at end of buffer
  * IN name header name
  * IN value header value
- * RET formatted string (must xfree)
  * */
-static char *_fmt_header(const char *name, const char *value)
+static void _fmt_header(char **buffer, char **at, const char *name,
+			const char *value)
 {
-	return xstrdup_printf("%s: %s"CRLF, name, value);
+	xstrcatat(*buffer, at, name);
+	xstrcatat(*buffer, at, ": ");
+	xstrcatat(*buffer, at, value);
+	xstrcatat(*buffer, at, CRLF);
 }
 
 /*
@@ -435,27 +457,35 @@ static char *_fmt_header(const char *name, const char *value)
  * IN request HTTP request
  * IN name header name
  * IN value header value
- * RET formatted string (must xfree)
+ * RET SLURM_SUCCESS or error
  * */
 static int _write_fmt_header(con_mgr_fd_t *con, const char *name,
 			     const char *value)
 {
-	const char *buffer = _fmt_header(name, value);
-	int rc = con_mgr_queue_write_fd(con, buffer, strlen(buffer));
+	char *buffer = NULL, *at = NULL;
+	int rc;
+
+	_fmt_header(&buffer, &at, name, value);
+	rc = con_mgr_queue_write_fd(con, buffer, (at - buffer));
 	xfree(buffer);
 	return rc;
 }
 
 /*
- * Create rfc2616 formatted numerical header
+ * Append rfc2616 formatted numerical header
  * TODO: add sanity checks
+ * IN/OUT buffer buffer to append header
+ * IN/OUT at end of buffer
  * IN name header name
  * IN value header value
- * RET formatted string (must xfree)
  * */
-static char *_fmt_header_num(const char *name, size_t value)
+static void _fmt_header_num(char **buffer, char **at, const char *name,
+			    size_t value)
 {
-	return xstrdup_printf("%s: %zu" CRLF, name, value);
+	char num[24];
+
+	(void) snprintf(num, sizeof(num), "%zu", value);
+	_fmt_header(buffer, at, name, num);
 }
 
 extern int send_http_connection_close(http_context_t *ctxt)
@@ -463,26 +493,26 @@ extern int send_http_connection_close(http_context_t *ctxt)
 	return _write_fmt_header(ctxt->con, "Connection", "Close");
 }
 
-/*
- * Create and write formatted numerical header
- * IN request HTTP request
- * IN name header name
- * IN value header value
- * RET formatted string (must xfree)
- * */
-static int _write_fmt_num_header(con_mgr_fd_t *con, const char *name,
-				 size_t value)
+/* Check if client requested connection close for the current request */
+static bool _is_connection_close(con_mgr_fd_t *con)
 {
-	const char *buffer = _fmt_header_num(name, value);
-	int rc = con_mgr_queue_write_fd(con, buffer, strlen(buffer));
-	xfree(buffer);
-	return rc;
+	http_context_t *context = con->arg;
+	request_t *request;
+
+	if (!context || (context->magic != MAGIC) ||
+	    !(request = context->request))
+		return false;
+
+	xassert(request->magic == MAGIC_REQUEST_T);
+	return request->connection_close;
 }
 
 extern int send_http_response(const send_http_response_args_t *args)
 {
-	char *buffer = NULL;
+	char *buffer = NULL, *at = NULL;
+	char status[64];
 	int rc = SLURM_SUCCESS;
+	bool close_header = false, send_body = false;
 	xassert(args->status_code != HTTP_STATUS_NONE);
 	xassert(args->body_length == 0 || (args->body_length && args->body));
 
@@ -491,60 +521,44 @@ extern int send_http_response(const send_http_response_args_t *args)
 	       args->status_code,
 	       get_http_status_code_string(args->status_code));
 
-	/* send rfc2616 response */
-	xstrfmtcat(buffer, "HTTP/%d.%d %d %s"CRLF,
-		   args->http_major, args->http_minor, args->status_code,
-		   get_http_status_code_string(args->status_code));
-
-	rc = con_mgr_queue_write_fd(args->con, buffer, strlen(buffer));
-	xfree(buffer);
+	/*
+	 * Assemble status line and all headers to queue them as a single
+	 * write instead of formatting and queuing each header separately.
+	 */
 
-	if (rc)
-		return rc;
+	/* send rfc2616 response */
+	(void) snprintf(status, sizeof(status), "HTTP/%d.%d %d ",
+			args->http_major, args->http_minor, args->status_code);
+	xstrcatat(buffer, &at, status);
+	xstrcatat(buffer, &at, get_http_status_code_string(args->status_code));
+	xstrcatat(buffer, &at, CRLF);
 
 	/* send along any requested headers */
 	if (args->headers) {
 		ListIterator itr = list_iterator_create(args->headers);
 		http_header_entry_t *header = NULL;
 		while ((header = list_next(itr))) {
-			if ((rc = _write_fmt_header(args->con, header->name,
-						    header->value)))
-				break;
+			_fmt_header(&buffer, &at, header->name, header->value);
+
+			if (!xstrcasecmp(header->name, "Connection"))
+				close_header = true;
 		}
 		list_iterator_destroy(itr);
-
-		if (rc)
-			return rc;
 	}
 
-	if (args->body && args->body_length) {
-		/* RFC7230-3.3.2 limits response of Content-Length */
-		if ((args->status_code < 100) ||
-		    ((args->status_code >= 200) &&
-		     (args->status_code != 204))) {
-			if ((rc = _write_fmt_num_header(args->con,
-				"Content-Length", args->body_length))) {
-				return rc;
-			}
-		}
-
-		if (args->body_encoding &&
-		    (rc = _write_fmt_header(
-			     args->con, "Content-Type", args->body_encoding)))
-			return rc;
+	/* RFC7230-6.6 warn client before the connection is closed */
+	if (!close_header && (args->status_code >= 200) &&
+	    _is_connection_close(args->con))
+		_fmt_header(&buffer, &at, "Connection", "Close");
 
-		if ((rc = con_mgr_queue_write_fd(args->con, CRLF,
-						 strlen(CRLF))))
-			return rc;
+	if (args->chunked) {
+		xassert(!args->body_length);
 
-		log_flag(NET, "%s: [%s] rc=%s(%u) sending body:\n%s",
-			 __func__, args->con->name,
-			 get_http_status_code_string(args->status_code),
-			 args->status_code, args->body);
+		_fmt_header(&buffer, &at, "Transfer-Encoding", "chunked");
 
-		if ((rc = con_mgr_queue_write_fd(args->con, args->body,
-						 args->body_length)))
-			return rc;
+		if (args->body_encoding)
+			_fmt_header(&buffer, &at, "Content-Type",
+				    args->body_encoding);
 	} else if (((args->status_code >= 100) && (args->status_code < 200)) ||
 		   (args->status_code == 204) ||
 		   (args->status_code == 304)) {
@@ -552,11 +566,61 @@ extern int send_http_response(const send_http_response_args_t *args)
 		 * RFC2616 requires empty line after headers for return code
 		 * that "MUST NOT" include a message body
 		 */
-		if ((rc = con_mgr_queue_write_fd(args->con, CRLF,
-						 strlen(CRLF))))
-			return rc;
+	} else if (args->body && args->body_length) {
+		send_body = true;
+
+		/* RFC7230-3.3.2 limits response of Content-Length */
+		_fmt_header_num(&buffer, &at, "Content-Length",
+				args->body_length);
+
+		if (args->body_encoding)
+			_fmt_header(&buffer, &at, "Content-Type",
+				    args->body_encoding);
+	} else {
+		/*
+		 * RFC7230-3.3.3 explicit empty body to allow client to find
+		 * the next pipelined response without waiting for close
+		 */
+		_fmt_header_num(&buffer, &at, "Content-Length", 0);
 	}
 
+	xstrcatat(buffer, &at, CRLF);
+
+	rc = con_mgr_queue_write_fd(args->con, buffer, (at - buffer));
+	xfree(buffer);
+
+	if (rc || !send_body)
+		return rc;
+
+	log_flag(NET, "%s: [%s] rc=%s(%u) sending body:\n%s",
+		 __func__, args->con->name,
+		 get_http_status_code_string(args->status_code),
+		 args->status_code, args->body);
+
+	return con_mgr_queue_write_fd(args->con, args->body, args->body_length);
+}
+
+extern int send_http_chunk(con_mgr_fd_t *con, const char *data,
+			   size_t length)
+{
+	int rc;
+	char *buffer = NULL;
+
+	xassert(!length || data);
+
+	log_flag(NET, "%s: [%s] sending %zu byte chunk",
+		 __func__, con->name, length);
+
+	xstrfmtcat(buffer, "%zx"CRLF, length);
+	rc = con_mgr_queue_write_fd(con, buffer, strlen(buffer));
+	xfree(buffer);
+
+	if (!rc && length)
+		rc = con_mgr_queue_write_fd(con, data, length);
+
+	if (!rc)
+		rc = con_mgr_queue_write_fd(con, CRLF, strlen(CRLF));
+
 	return rc;
 }
 
@@ -572,21 +636,25 @@ static int _send_reject(const http_parser *parser,
 		.http_minor = parser->http_minor,
 		.status_code = status_code,
 		.body_length = 0,
-		.headers = list_create(_free_http_header),
+		.headers = list_create(NULL),
+	};
+	http_header_entry_t close = {
+		.name = "Connection",
+		.value = "Close",
 	};
 
 	/* If we don't have a requested client version, default to 0.9 */
 	if ((args.http_major == 0) && (args.http_minor == 0))
 		args.http_minor = 9;
 
-	/* Ignore response since this connection is already dead */
-	(void) send_http_response(&args);
-	FREE_NULL_LIST(args.headers);
-
 	if (request->connection_close ||
 	    ((parser->http_major == 1) && (parser->http_minor >= 1)) ||
 	     (parser->http_major > 1))
-		send_http_connection_close(request->context);
+		list_append(args.headers, &close);
+
+	/* Ignore response since this connection is already dead */
+	(void) send_http_response(&args);
+	FREE_NULL_LIST(args.headers);
 
 	/* ensure connection gets closed */
 	(void) con_mgr_queue_close_fd(request->context->con);
@@ -609,7 +677,7 @@ static int _on_message_complete_request(http_parser *parser,
 		.http_minor = parser->http_minor,
 		.content_type = request->content_type,
 		.accept = request->accept,
-		.body = request->body,
+		.body = (request->body_length ? request->body : NULL),
 		.body_length = request->body_length,
 		.body_encoding = request->body_encoding
 	};
@@ -699,26 +767,21 @@ static int _on_message_complete(http_parser *parser)
 
 	if (!request->connection_close) {
 		/*
-		 * Create a new HTTP request to allow persistent connections to
-		 * continue but without inheirting previous requests.
+		 * Reuse the HTTP request to allow persistent connections to
+		 * continue but without inheriting previous requests. Any
+		 * pipelined request already in the buffer will be parsed next.
 		 */
-		request_t *nrequest = xmalloc(sizeof(*request));
-		nrequest->magic = MAGIC_REQUEST_T;
-		nrequest->headers = list_create(_free_http_header);
-		nrequest->context = request->context;
-		request->context->request = nrequest;
-		parser->data = nrequest;
-		_free_request_t(request);
+		_reset_request_t(request);
 	} else {
-		/* Notify client that this connection will be closed now */
-		if (request->connection_close)
-			send_http_connection_close(request->context);
-
+		/* Response already included "Connection: Close" */
 		con_mgr_queue_close_fd(request->context->con);
 
 		request->context->request = NULL;
 		_free_request_t(request);
 		parser->data = NULL;
+
+		/* Ignore anything pipelined after the connection close */
+		http_parser_pause(parser, 1);
 	}
 
 	return 0;
@@ -788,7 +851,10 @@ extern int parse_http(con_mgr_fd_t *con, void *x)
 	log_flag(NET, "%s: [%s] parsed %zu/%u bytes",
 		 __func__, con->name, bytes_parsed, size_buf(buffer));
 
-	if (bytes_parsed > 0)
+	if (HTTP_PARSER_ERRNO(parser) == HPE_PAUSED)
+		/* connection is closing so discard any remaining requests */
+		set_buf_offset(buffer, size_buf(buffer));
+	else if (bytes_parsed > 0)
 		set_buf_offset(buffer, bytes_parsed);
 	else if (parser->http_errno) {
 		error("%s: [%s] unexpected HTTP error %s: %s",
@@ -125,6 +125,7 @@ typedef struct {
 	const char *body; /* body to send or NULL */
 	size_t body_length; /* bytes in body to send or 0 */
 	const char *body_encoding; /* body encoding type or NULL */
+	bool chunked; /* body will follow via send_http_chunk() */
 } send_http_response_args_t;
 
 /*
@@ -142,6 +143,17 @@ extern int send_http_connection_close(http_context_t *ctxt);
  */
 extern int send_http_response(const send_http_response_args_t *args);
 
+/*
+ * Send chunk of body using chunked transfer encoding (RFC7230-4.1)
+ * 	Response must have been sent with chunked set.
+ * IN con - assigned connection
+ * IN data - bytes of body to send
+ * IN length - number of bytes in data or 0 to send last chunk
+ * RET SLURM_SUCCESS or error
+ */
+extern int send_http_chunk(con_mgr_fd_t *con, const char *data,
+			   size_t length);
+
 /*
  * setup http context against a given new socket
  * IN fd file descriptor of socket (must be connected!)
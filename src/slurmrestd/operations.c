@@ -54,8 +54,15 @@ openapi_t *openapi_state = NULL;
 static pthread_rwlock_t paths_lock = PTHREAD_RWLOCK_INITIALIZER;
 static List paths = NULL;
 
+/* seconds to cache GET responses or -1 for never and 0 to only coalesce */
+static int cache_ttl = -1;
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static List cache = NULL; /* list of cache_entry_t */
+
 #define MAGIC 0xDFFEAAAE
 #define MAGIC_HEADER_ACCEPT 0xDF9EAABE
+#define MAGIC_STREAM_RESP 0xDF9EAAFE
+#define MAGIC_CACHE_ENTRY 0xDF9EABFE
 
 typedef struct {
 	int magic;
@@ -67,12 +74,52 @@ typedef struct {
 	int callback_tag;
 } path_t;
 
+/* paths indexed by path tag */
+static path_t **path_tags = NULL;
+static int path_tags_count = 0;
+
 typedef struct {
 	int magic; /* MAGIC_HEADER_ACCEPT */
 	char *type; /* mime type and sub type unchanged */
 	float q; /* quality factor (priority) */
 } http_header_accept_t;
 
+typedef struct {
+	int magic; /* MAGIC_STREAM_RESP */
+	char *key;
+	openapi_stream_func_t func;
+	void *arg;
+	void (*free_arg)(void *arg);
+	serializer_stream_t *stream;
+	con_mgr_fd_t *con; /* send chunks to connection */
+	char **body; /* append to body instead of sending chunks */
+	int rc;
+} stream_resp_t;
+
+/* streamed key registered by current handler */
+static __thread stream_resp_t *stream_resp = NULL;
+/* serialized response registered by current handler */
+static __thread openapi_serialized_func_t serialized_func = NULL;
+static __thread void *serialized_arg = NULL;
+
+/*
+ * Response to a GET request shared by every identical request while the
+ * handler is running and afterwards until it expires.
+ */
+typedef struct {
+	int magic; /* MAGIC_CACHE_ENTRY */
+	char *key; /* request and credentials of requester */
+	bool done; /* handler has completed */
+	bool removed; /* removed from cache and freed once refs drops to 0 */
+	time_t expires; /* when response is stale */
+	int refs; /* number of requests using entry */
+	pthread_cond_t cond; /* signaled once done */
+	int rc; /* handler return code */
+	char *body; /* serialized response */
+	const char *static_body; /* serialized response owned by handler */
+	char *etag; /* entity tag of body */
+} cache_entry_t;
+
 static void _check_path_magic(const path_t *path)
 {
 	xassert(path->magic == MAGIC);
@@ -93,7 +140,34 @@ static void _free_path(void *x)
 	xfree(path);
 }
 
-extern int init_operations(void)
+static void _free_cache_entry(cache_entry_t *entry)
+{
+	xassert(entry->magic == MAGIC_CACHE_ENTRY);
+	xassert(!entry->refs);
+
+	entry->magic = ~MAGIC_CACHE_ENTRY;
+	slurm_cond_destroy(&entry->cond);
+	xfree(entry->key);
+	xfree(entry->body);
+	xfree(entry->etag);
+	xfree(entry);
+}
+
+/* Remove entry from cache and free it once no request is using it */
+static void _remove_cache_entry(void *x)
+{
+	cache_entry_t *entry = x;
+
+	xassert(entry->magic == MAGIC_CACHE_ENTRY);
+	xassert(!entry->removed);
+
+	entry->removed = true;
+
+	if (!entry->refs)
+		_free_cache_entry(entry);
+}
+
+extern int init_operations(int response_cache_ttl)
 {
 	slurm_rwlock_wrlock(&paths_lock);
 
@@ -104,6 +178,12 @@ extern int init_operations(void)
 
 	slurm_rwlock_unlock(&paths_lock);
 
+	slurm_mutex_lock(&cache_lock);
+	cache_ttl = response_cache_ttl;
+	if (cache_ttl >= 0)
+		cache = list_create(_remove_cache_entry);
+	slurm_mutex_unlock(&cache_lock);
+
 	return SLURM_SUCCESS;
 }
 
@@ -112,21 +192,27 @@ extern void destroy_operations(void)
 	slurm_rwlock_wrlock(&paths_lock);
 
 	FREE_NULL_LIST(paths);
+	xfree(path_tags);
+	path_tags_count = 0;
 
 	slurm_rwlock_unlock(&paths_lock);
+
+	slurm_mutex_lock(&cache_lock);
+	FREE_NULL_LIST(cache);
+	slurm_mutex_unlock(&cache_lock);
 }
 
-static int _match_path_key(void *x, void *ptr)
+static path_t *_find_path_tag(int tag)
 {
-	path_t *path = (path_t *)x;
-	int tag = *(int *) ptr;
+	path_t *path;
 
-	_check_path_magic(path);
+	if ((tag < 0) || (tag >= path_tags_count))
+		return NULL;
+	if (!(path = path_tags[tag]))
+		return NULL;
 
-	if (path->tag == tag)
-		return 1;
-	else
-		return 0;
+	_check_path_magic(path);
+	return path;
 }
 
 extern int bind_operation_handler(const char *str_path,
@@ -145,7 +231,7 @@ extern int bind_operation_handler(const char *str_path,
 		fatal_abort("%s: failure registering OpenAPI for path: %s",
 			    __func__, str_path);
 
-	if ((path = list_find_first(paths, _match_path_key, &path_tag)))
+	if ((path = _find_path_tag(path_tag)))
 		goto exists;
 
 	/* add new path */
@@ -158,6 +244,12 @@ extern int bind_operation_handler(const char *str_path,
 	path->tag = path_tag;
 	list_append(paths, path);
 
+	if (path_tag >= path_tags_count) {
+		xrecalloc(path_tags, (path_tag + 1), sizeof(*path_tags));
+		path_tags_count = path_tag + 1;
+	}
+	path_tags[path_tag] = path;
+
 exists:
 	path->callback = callback;
 	path->callback_tag = callback_tag;
@@ -180,6 +272,7 @@ static int _rm_path_callback(void *x, void *ptr)
 	debug5("%s: removing tag %d for callback %"PRIxPTR,
 	       __func__, path->tag, (uintptr_t) callback);
 	unregister_path_tag(openapi_state, path->tag);
+	path_tags[path->tag] = NULL;
 
 	return 1;
 }
@@ -444,14 +537,168 @@ static int _resolve_mime(on_http_request_args_t *args, const char **read_mime,
 	return SLURM_SUCCESS;
 }
 
-static int _call_handler(on_http_request_args_t *args, data_t *params,
-			 data_t *query, openapi_handler_t callback,
-			 int callback_tag, const char *write_mime)
+extern void openapi_stream_resp_key(const char *key,
+				    openapi_stream_func_t func, void *arg,
+				    void (*free_arg)(void *arg))
+{
+	stream_resp_t *sr = xmalloc(sizeof(*sr));
+
+	xassert(!stream_resp);
+	xassert(key && func);
+
+	sr->magic = MAGIC_STREAM_RESP;
+	sr->key = xstrdup(key);
+	sr->func = func;
+	sr->arg = arg;
+	sr->free_arg = free_arg;
+
+	stream_resp = sr;
+}
+
+extern void openapi_resp_serialized(openapi_serialized_func_t func, void *arg)
+{
+	xassert(!serialized_func);
+	xassert(func);
+
+	serialized_func = func;
+	serialized_arg = arg;
+}
+
+static void _free_stream_resp(stream_resp_t *sr)
+{
+	if (!sr)
+		return;
+
+	xassert(sr->magic == MAGIC_STREAM_RESP);
+	xassert(!sr->stream);
+
+	if (sr->free_arg)
+		sr->free_arg(sr->arg);
+
+	sr->magic = ~MAGIC_STREAM_RESP;
+	xfree(sr->key);
+	xfree(sr);
+}
+
+static int _stream_write(const char *data, size_t length, void *arg)
+{
+	stream_resp_t *sr = arg;
+
+	xassert(sr->magic == MAGIC_STREAM_RESP);
+
+	if (sr->body) {
+		xstrncat(*sr->body, data, length);
+		return SLURM_SUCCESS;
+	}
+
+	return send_http_chunk(sr->con, data, length);
+}
+
+static data_for_each_cmd_t _stream_resp_key(const char *key,
+					    const data_t *data, void *arg)
+{
+	stream_resp_t *sr = arg;
+
+	xassert(sr->magic == MAGIC_STREAM_RESP);
+
+	/* skip any placeholder for the streamed key */
+	if (!xstrcmp(key, sr->key))
+		return DATA_FOR_EACH_CONT;
+
+	if ((sr->rc = serialize_g_stream_data(sr->stream, key, data)))
+		return DATA_FOR_EACH_FAIL;
+
+	return DATA_FOR_EACH_CONT;
+}
+
+/*
+ * Serialize response with the streamed key directly to the client using
+ * chunked transfer encoding or into body for clients older than HTTP/1.1.
+ * IN allow_chunked - false to always serialize into body
+ * IN/OUT sent_ptr - set to true if response headers were sent
+ * RET SLURM_SUCCESS or error
+ */
+static int _stream_response(on_http_request_args_t *args, data_t *resp,
+			    stream_resp_t *sr, const char *write_mime,
+			    bool allow_chunked, char **body_ptr,
+			    bool *sent_ptr)
 {
 	int rc;
-	data_t *resp = data_new();
-	char *body = NULL;
-	http_status_code_t e;
+	/* RFC7230-3.3.1: chunked transfer encoding requires HTTP/1.1 */
+	const bool chunked = (allow_chunked &&
+			      ((args->http_major > 1) ||
+			       ((args->http_major == 1) &&
+				(args->http_minor >= 1))));
+
+	xassert(sr->magic == MAGIC_STREAM_RESP);
+	xassert(!*body_ptr);
+
+	sr->con = args->context->con;
+	if (!chunked)
+		sr->body = body_ptr;
+
+	if ((rc = serialize_g_stream_new(&sr->stream, write_mime,
+					 SER_FLAGS_PRETTY, _stream_write, sr)))
+		return rc;
+
+	if (chunked) {
+		send_http_response_args_t send_args = {
+			.con = args->context->con,
+			.http_major = args->http_major,
+			.http_minor = args->http_minor,
+			.status_code = HTTP_STATUS_CODE_SUCCESS_OK,
+			.body_encoding = write_mime,
+			.chunked = true,
+		};
+
+		if ((rc = send_http_response(&send_args)))
+			goto cleanup;
+
+		*sent_ptr = true;
+	}
+
+	if ((rc = serialize_g_stream_begin(sr->stream, NULL, DATA_TYPE_DICT)))
+		goto cleanup;
+
+	if ((rc = sr->func(sr->arg, sr->key, NULL, sr->stream)))
+		goto cleanup;
+
+	(void) data_dict_for_each_const(resp, _stream_resp_key, sr);
+	if ((rc = sr->rc))
+		goto cleanup;
+
+	rc = serialize_g_stream_end(sr->stream);
+
+cleanup:
+	if (!rc)
+		rc = serialize_g_stream_fini(&sr->stream);
+	else
+		(void) serialize_g_stream_fini(&sr->stream);
+
+	if (!rc && chunked)
+		rc = send_http_chunk(args->context->con, NULL, 0);
+
+	return rc;
+}
+
+/*
+ * Call handler and serialize its response
+ * IN allow_chunked - allow streaming response directly to client
+ * OUT body_ptr - serialized response or NULL
+ * OUT static_body_ptr - serialized response owned by handler or NULL
+ * OUT sent_ptr - set to true if response was already sent to client
+ * RET SLURM_SUCCESS or error
+ */
+static int _run_handler(on_http_request_args_t *args, data_t *params,
+			data_t *query, openapi_handler_t callback,
+			int callback_tag, const char *write_mime,
+			bool allow_chunked, char **body_ptr,
+			const char **static_body_ptr, bool *sent_ptr)
+{
+	int rc;
+	data_t *resp = data_new_arena();
+	stream_resp_t *sr;
+	openapi_serialized_func_t sfunc;
 
 	debug3("%s: [%s] BEGIN: calling handler: 0x%"PRIXPTR"[%d] for path: %s",
 	       __func__, args->context->con->name, (uintptr_t) callback,
@@ -460,37 +707,102 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 	rc = callback(args->context->con->name, args->method, params, query,
 		      callback_tag, resp, args->context->auth);
 
-	/*
-	 * Clear auth context after callback is complete. Client has to provide
-	 * full auth for every request already.
-	 */
-	FREE_NULL_REST_AUTH(args->context->auth);
+	sr = stream_resp;
+	stream_resp = NULL;
+	sfunc = serialized_func;
+	serialized_func = NULL;
+
+	if (sfunc) {
+		xassert(!sr);
+
+		if (!rc)
+			rc = sfunc(serialized_arg, write_mime, static_body_ptr);
+
+		serialized_arg = NULL;
+		goto done;
+	}
+
+	if (sr && !rc && (data_get_type(resp) == DATA_TYPE_DICT)) {
+		rc = _stream_response(args, resp, sr, write_mime, allow_chunked,
+				      body_ptr, sent_ptr);
+
+		if (*sent_ptr) {
+			/* too late to send an error to the client */
+			if (rc)
+				con_mgr_queue_close_fd(args->context->con);
+
+			goto done;
+		} else if (rc == ESLURM_NOT_SUPPORTED) {
+			/* serializer can't stream: dump into resp instead */
+			xfree(*body_ptr);
+			rc = sr->func(sr->arg, sr->key,
+				      data_key_set(resp, sr->key), NULL);
+		} else if (rc) {
+			xfree(*body_ptr);
+		}
+	}
 
-	if (data_get_type(resp) != DATA_TYPE_NULL) {
+	if (!*body_ptr && (data_get_type(resp) != DATA_TYPE_NULL)) {
 		int rc2 = serialize_g_data_to_string(
-			&body, NULL, resp, write_mime, SER_FLAGS_PRETTY);
+			body_ptr, NULL, resp, write_mime, SER_FLAGS_PRETTY);
 
 		if (!rc)
 			rc = rc2;
 	}
 
-	if (rc == SLURM_NO_CHANGE_IN_DATA) {
+done:
+	_free_stream_resp(sr);
+	FREE_NULL_DATA(resp);
+
+	return rc;
+}
+
+/* Check If-None-Match header against entity tag of response */
+static bool _etag_match(on_http_request_args_t *args, const char *etag)
+{
+	const char *match = find_http_header(args->headers, "If-None-Match");
+
+	if (!match || !etag)
+		return false;
+
+	/* RFC7232-3.2: weak comparison allows for W/ prefix */
+	return (!xstrcmp(match, "*") || xstrstr(match, etag));
+}
+
+/*
+ * Send response of handler to client
+ * IN rc - return code of handler
+ * IN body - serialized response or NULL
+ * IN etag - entity tag of body or NULL
+ * OUT status_ptr - HTTP status sent
+ * RET SLURM_SUCCESS or error
+ */
+static int _send_response(on_http_request_args_t *args, int rc,
+			  const char *body, const char *write_mime,
+			  const char *etag, http_status_code_t *status_ptr)
+{
+	send_http_response_args_t send_args = {
+		.con = args->context->con,
+		.http_major = args->http_major,
+		.http_minor = args->http_minor,
+		.status_code = HTTP_STATUS_CODE_SUCCESS_OK,
+	};
+	http_header_entry_t etag_header = {
+		.name = "ETag",
+		.value = (char *) etag,
+	};
+
+	if ((rc == SLURM_NO_CHANGE_IN_DATA) ||
+	    (!rc && _etag_match(args, etag))) {
 		/*
 		 * RFC#7232 Section:4.1
 		 *
 		 * Send minimal response that nothing has changed
 		 *
 		 */
-		send_http_response_args_t send_args = {
-			.con = args->context->con,
-			.http_major = args->http_major,
-			.http_minor = args->http_minor,
-			.status_code = HTTP_STATUS_CODE_REDIRECT_NOT_MODIFIED,
-		};
-		e = send_args.status_code;
-		rc = send_http_response(&send_args);
+		send_args.status_code = HTTP_STATUS_CODE_REDIRECT_NOT_MODIFIED;
 	} else if (rc && (rc != ESLURM_REST_EMPTY_RESULT)) {
-		e = HTTP_STATUS_CODE_SRVERR_INTERNAL;
+		http_status_code_t e = HTTP_STATUS_CODE_SRVERR_INTERNAL;
 
 		if (rc == ESLURM_REST_INVALID_QUERY)
 			e = HTTP_STATUS_CODE_ERROR_UNPROCESSABLE_CONTENT;
@@ -501,34 +813,210 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 		else if (rc == ESLURM_DATA_UNKNOWN_MIME_TYPE)
 			e = HTTP_STATUS_CODE_ERROR_UNSUPPORTED_MEDIA_TYPE;
 
-		rc = _operations_router_reject(args, body, e, write_mime);
-	} else {
-		send_http_response_args_t send_args = {
-			.con = args->context->con,
-			.http_major = args->http_major,
-			.http_minor = args->http_minor,
-			.status_code = HTTP_STATUS_CODE_SUCCESS_OK,
-			.body = NULL,
-			.body_length = 0,
-		};
-
-		if (body) {
-			send_args.body = body;
-			send_args.body_length = strlen(body);
-			send_args.body_encoding = write_mime;
-		}
+		*status_ptr = e;
+		return _operations_router_reject(args, body, e, write_mime);
+	} else if (body) {
+		send_args.body = body;
+		send_args.body_length = strlen(body);
+		send_args.body_encoding = write_mime;
+	}
 
-		rc = send_http_response(&send_args);
-		e = send_args.status_code;
+	if (etag) {
+		send_args.headers = list_create(NULL);
+		list_append(send_args.headers, &etag_header);
 	}
 
+	*status_ptr = send_args.status_code;
+	rc = send_http_response(&send_args);
+
+	FREE_NULL_LIST(send_args.headers);
+
+	return rc;
+}
+
+static int _call_handler(on_http_request_args_t *args, data_t *params,
+			 data_t *query, openapi_handler_t callback,
+			 int callback_tag, const char *write_mime)
+{
+	int rc;
+	char *body = NULL;
+	const char *static_body = NULL;
+	http_status_code_t e = HTTP_STATUS_CODE_SUCCESS_OK;
+	bool sent = false;
+
+	rc = _run_handler(args, params, query, callback, callback_tag,
+			  write_mime, true, &body, &static_body, &sent);
+
+	if (!sent)
+		rc = _send_response(args, rc, (body ? body : static_body),
+				    write_mime, NULL, &e);
+
 	debug3("%s: [%s] END: calling handler: (0x%"PRIXPTR") callback_tag %d for path: %s rc[%d]=%s status[%d]=%s",
 	       __func__, args->context->con->name, (uintptr_t) callback,
 	       callback_tag, args->path, rc, slurm_strerror(rc), e,
 	       get_http_status_code_string(e));
 
+	/*
+	 * Clear auth context after response is complete. Client has to provide
+	 * full auth for every request already.
+	 */
+	FREE_NULL_REST_AUTH(args->context->auth);
+
 	xfree(body);
-	FREE_NULL_DATA(resp);
+
+	return rc;
+}
+
+/*
+ * Key of request in response cache.
+ * Only requests with identical credentials share a response as tokens are only
+ * verified by slurmctld and slurmdbd while the handler runs.
+ */
+static char *_cache_key(on_http_request_args_t *args, const char *write_mime)
+{
+	rest_auth_context_t *auth = args->context->auth;
+	const char *token = find_http_header(args->headers,
+					     HTTP_HEADER_USER_TOKEN);
+	const char *bearer = find_http_header(args->headers, HTTP_HEADER_AUTH);
+
+	return xstrdup_printf("%s\n%s\n%s\n%u\n%s\n%s\n%s", args->path,
+			      (args->query ? args->query : ""), write_mime,
+			      auth->plugin_id,
+			      (auth->user_name ? auth->user_name : ""),
+			      (token ? token : ""), (bearer ? bearer : ""));
+}
+
+static int _match_cache_key(void *x, void *key)
+{
+	cache_entry_t *entry = x;
+
+	xassert(entry->magic == MAGIC_CACHE_ENTRY);
+
+	return !xstrcmp(entry->key, key);
+}
+
+static int _match_cache_expired(void *x, void *arg)
+{
+	cache_entry_t *entry = x;
+	time_t *now = arg;
+
+	xassert(entry->magic == MAGIC_CACHE_ENTRY);
+
+	return (entry->done && (entry->expires <= *now));
+}
+
+/* Release reference to entry. Caller must hold cache_lock. */
+static void _cache_release(cache_entry_t *entry)
+{
+	xassert(entry->magic == MAGIC_CACHE_ENTRY);
+	xassert(entry->refs > 0);
+
+	entry->refs--;
+
+	if (!entry->refs && entry->removed)
+		_free_cache_entry(entry);
+}
+
+/* Entity tag of response from FNV-1a hash of body */
+static char *_make_etag(const char *body)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	for (const char *c = body; c && *c; c++) {
+		hash ^= (unsigned char) *c;
+		hash *= 1099511628211ULL;
+	}
+
+	return xstrdup_printf("\"%016"PRIx64"\"", hash);
+}
+
+/*
+ * Call handler of GET request once for all identical requests that arrive
+ * while it runs and then serve its response from the cache until it expires.
+ */
+static int _call_handler_cached(on_http_request_args_t *args, data_t *params,
+				data_t *query, openapi_handler_t callback,
+				int callback_tag, const char *write_mime)
+{
+	int rc;
+	char *key = _cache_key(args, write_mime);
+	http_status_code_t e = HTTP_STATUS_CODE_SUCCESS_OK;
+	cache_entry_t *entry;
+	bool run = false;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&cache_lock);
+
+	list_delete_all(cache, _match_cache_expired, &now);
+
+	if (!(entry = list_find_first(cache, _match_cache_key, key))) {
+		entry = xmalloc(sizeof(*entry));
+		entry->magic = MAGIC_CACHE_ENTRY;
+		entry->key = key;
+		key = NULL;
+		slurm_cond_init(&entry->cond, NULL);
+		list_append(cache, entry);
+		run = true;
+	} else if (!entry->done) {
+		debug3("%s: [%s] waiting on identical request for path: %s",
+		       __func__, args->context->con->name, args->path);
+	} else {
+		debug3("%s: [%s] using cached response for path: %s",
+		       __func__, args->context->con->name, args->path);
+	}
+
+	entry->refs++;
+
+	while (!run && !entry->done)
+		slurm_cond_wait(&entry->cond, &cache_lock);
+
+	slurm_mutex_unlock(&cache_lock);
+
+	if (run) {
+		char *body = NULL;
+		const char *static_body = NULL;
+		bool sent = false;
+
+		/* response must be kept so it can't be streamed */
+		rc = _run_handler(args, params, query, callback, callback_tag,
+				  write_mime, false, &body, &static_body,
+				  &sent);
+		xassert(!sent);
+
+		slurm_mutex_lock(&cache_lock);
+		entry->rc = rc;
+		entry->body = body;
+		entry->static_body = static_body;
+		if (!rc)
+			entry->etag = _make_etag(body ? body : static_body);
+		entry->expires = time(NULL) + cache_ttl;
+		entry->done = true;
+
+		/* only keep successful responses */
+		if (rc || !cache_ttl)
+			list_delete_ptr(cache, entry);
+
+		slurm_cond_broadcast(&entry->cond);
+		slurm_mutex_unlock(&cache_lock);
+	}
+
+	/* entry is not modified once done */
+	rc = _send_response(args, entry->rc,
+			    (entry->body ? entry->body : entry->static_body),
+			    write_mime, entry->etag, &e);
+
+	debug3("%s: [%s] END: %s handler: (0x%"PRIXPTR") callback_tag %d for path: %s rc[%d]=%s status[%d]=%s",
+	       __func__, args->context->con->name,
+	       (run ? "calling" : "shared response of"), (uintptr_t) callback,
+	       callback_tag, args->path, rc, slurm_strerror(rc), e,
+	       get_http_status_code_string(e));
+
+	slurm_mutex_lock(&cache_lock);
+	_cache_release(entry);
+	slurm_mutex_unlock(&cache_lock);
+
+	FREE_NULL_REST_AUTH(args->context->auth);
+	xfree(key);
 
 	return rc;
 }
@@ -569,7 +1057,7 @@ extern int operations_router(on_http_request_args_t *args)
 	 */
 	slurm_rwlock_rdlock(&paths_lock);
 
-	if (!(path = list_find_first(paths, _match_path_key, &path_tag)))
+	if (!(path = _find_path_tag(path_tag)))
 		fatal_abort("%s: found tag but missing path handler", __func__);
 	_check_path_magic(path);
 
@@ -588,8 +1076,12 @@ extern int operations_router(on_http_request_args_t *args)
 	if ((rc = _get_query(args, &query, read_mime)))
 		goto cleanup;
 
-	rc = _call_handler(args, params, query, callback, callback_tag,
-			   write_mime);
+	if (cache && (args->method == HTTP_REQUEST_GET))
+		rc = _call_handler_cached(args, params, query, callback,
+					  callback_tag, write_mime);
+	else
+		rc = _call_handler(args, params, query, callback,
+				   callback_tag, write_mime);
 
 cleanup:
 	FREE_NULL_DATA(query);
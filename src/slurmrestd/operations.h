@@ -39,6 +39,7 @@
 
 #include "src/common/data.h"
 #include "src/interfaces/openapi.h"
+#include "src/interfaces/serializer.h"
 #include "src/slurmrestd/http.h"
 #include "src/slurmrestd/rest_auth.h"
 
@@ -47,8 +48,11 @@ extern openapi_t *openapi_state;
 /*
  * setup locks.
  * only call once!
+ * IN response_cache_ttl - seconds to cache responses of GET requests, 0 to
+ *	only share the response between identical concurrent requests or -1 to
+ *	disable
  */
-extern int init_operations(void);
+extern int init_operations(int response_cache_ttl);
 extern void destroy_operations(void);
 
 /*
@@ -104,4 +108,52 @@ extern void *get_operation_db_conn(rest_auth_context_t *auth);
  */
 extern void *openapi_get_db_conn(void *ctxt);
 
+/*
+ * Dump the value of a streamed response key
+ * IN arg - arbitrary pointer handed to openapi_stream_resp_key()
+ * IN key - key to dump value under
+ * IN dst - data_t to dump into when stream is NULL
+ * IN stream - serializer stream to dump key and value directly into or NULL
+ * RET SLURM_SUCCESS or error
+ */
+typedef int (*openapi_stream_func_t)(void *arg, const char *key, data_t *dst,
+				     serializer_stream_t *stream);
+
+/*
+ * Register key in response to be dumped after openapi_handler_t() returns.
+ * 	Allows large responses to be serialized directly to the client without
+ * 	first building the entire response as data_t. The key will be written
+ * 	before the other keys in response to ensure any errors or warnings
+ * 	from dumping it are included.
+ * WARNING: Only valid inside of openapi_handler_t()
+ * IN key - key in response to dump
+ * IN func - function to dump value of key
+ * IN arg - arbitrary pointer to hand to func
+ * IN free_arg - function to release arg once response is sent or NULL
+ */
+extern void openapi_stream_resp_key(const char *key,
+				    openapi_stream_func_t func, void *arg,
+				    void (*free_arg)(void *arg));
+
+/*
+ * Get already serialized response
+ * IN arg - arbitrary pointer handed to openapi_resp_serialized()
+ * IN mime_type - MIME type requested by client
+ * OUT body_ptr - set to serialized response which is sent without copying
+ * 	first. Must remain valid and unchanged until slurmrestd shuts down.
+ * RET SLURM_SUCCESS or error
+ */
+typedef int (*openapi_serialized_func_t)(void *arg, const char *mime_type,
+					 const char **body_ptr);
+
+/*
+ * Register function to provide the serialized response after
+ * openapi_handler_t() returns instead of serializing the response data_t.
+ * 	Allows responses that never change to only be serialized once.
+ * WARNING: Only valid inside of openapi_handler_t()
+ * IN func - function to get serialized response
+ * IN arg - arbitrary pointer to hand to func
+ */
+extern void openapi_resp_serialized(openapi_serialized_func_t func, void *arg);
+
 #endif /* SLURMRESTD_OPERATIONS_H */
@@ -38,15 +38,20 @@
 
 #define _GNU_SOURCE
 
+#include <fcntl.h>
 #include <grp.h>
 #include <limits.h>
 #include <netdb.h>
 #include <sched.h>
+#include <poll.h>
 #include <signal.h>
 #include <sys/prctl.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "slurm/slurm.h"
@@ -76,6 +81,16 @@
 
 decl_static_data(usage_txt);
 
+#define MAX_WORKERS 256
+/* Seconds for replacement workers to start listening before giving up */
+#define WORKER_START_TIMEOUT 60
+
+typedef struct {
+	pid_t pid;
+	int ready_fd; /* readiness pipe until worker is listening or -1 */
+	bool ready; /* worker is listening */
+} worker_t;
+
 typedef struct {
 	bool stdin_tty; /* running with a TTY for stdin */
 	bool stdin_socket; /* running with a socket for stdin */
@@ -94,6 +109,12 @@ static List socket_listen = NULL;
 static char *slurm_conf_filename = NULL;
 /* Number of requested threads */
 static int thread_count = 20;
+/* Seconds to cache GET responses or -1 to disable */
+static int response_cache_ttl = -1;
+/* Number of worker processes to fork or 0 to serve from this process */
+static int worker_count = 0;
+/* Pipe to tell supervisor once this worker is listening or -1 */
+static int ready_fd = -1;
 /* User to become once loaded */
 static uid_t uid = 0;
 static gid_t gid = 0;
@@ -153,6 +174,28 @@ static void _parse_env(void)
 		oas_specs = xstrdup(buffer);
 	}
 
+	if ((buffer = getenv("SLURMRESTD_RESPONSE_CACHE_TTL"))) {
+		char *end = NULL;
+		long ttl = strtol(buffer, &end, 10);
+
+		if (!buffer[0] || *end || (ttl < 0) || (ttl > INT_MAX))
+			fatal("Invalid env SLURMRESTD_RESPONSE_CACHE_TTL: %s",
+			      buffer);
+
+		response_cache_ttl = ttl;
+	}
+
+	if ((buffer = getenv("SLURMRESTD_WORKERS"))) {
+		char *end = NULL;
+		long workers = strtol(buffer, &end, 10);
+
+		if (!buffer[0] || *end || (workers < 0) ||
+		    (workers > MAX_WORKERS))
+			fatal("Invalid env SLURMRESTD_WORKERS: %s", buffer);
+
+		worker_count = workers;
+	}
+
 	if ((buffer = getenv("SLURMRESTD_SECURITY"))) {
 		char *token = NULL, *save_ptr = NULL;
 		char *toklist = xstrdup(buffer);
@@ -347,6 +390,351 @@ static void _lock_down(void)
 		fatal("slurmrestd should not be run with SlurmUser's group.");
 }
 
+static int _is_unix_socket(void *x, void *arg)
+{
+	return (xstrstr(x, "unix:") != NULL);
+}
+
+/*
+ * Fork a new worker
+ * IN mask - signal mask to restore in worker
+ * IN worker - worker to populate in supervisor
+ * RET true in the worker process
+ */
+static bool _start_worker(const sigset_t *mask, worker_t *worker)
+{
+	pid_t supervisor = getpid();
+	int fds[2];
+	pid_t pid;
+
+	if (pipe2(fds, O_CLOEXEC))
+		fatal("%s: pipe2() failed: %m", __func__);
+
+	if ((pid = fork()) < 0)
+		fatal("%s: fork() failed: %m", __func__);
+
+	if (!pid) {
+		/* Stop gracefully when the supervisor goes away */
+		if (prctl(PR_SET_PDEATHSIG, SIGINT) == -1)
+			fatal("%s: unable to set parent death signal: %m",
+			      __func__);
+		if (getppid() != supervisor)
+			_exit(0);
+		if (sigprocmask(SIG_SETMASK, mask, NULL))
+			fatal("%s: unable to restore signal mask: %m",
+			      __func__);
+		close(fds[0]);
+		ready_fd = fds[1];
+		return true;
+	}
+
+	close(fds[1]);
+	debug("%s: started worker pid %d", __func__, pid);
+	worker->pid = pid;
+	worker->ready_fd = fds[0];
+	worker->ready = false;
+	return false;
+}
+
+static void _signal_workers(worker_t *workers, int sig)
+{
+	for (int i = 0; i < worker_count; i++)
+		if (workers[i].pid > 0)
+			kill(workers[i].pid, sig);
+}
+
+static void _close_ready_fds(worker_t *workers)
+{
+	for (int i = 0; workers && (i < worker_count); i++) {
+		if (workers[i].ready_fd >= 0)
+			close(workers[i].ready_fd);
+		workers[i].ready_fd = -1;
+	}
+}
+
+static worker_t *_find_worker(worker_t *workers, pid_t pid)
+{
+	for (int i = 0; workers && (i < worker_count); i++)
+		if (workers[i].pid == pid)
+			return &workers[i];
+
+	return NULL;
+}
+
+/*
+ * Abandon a reload and keep the current workers
+ * IN/OUT next_ptr - pointer to the replacement workers to stop
+ */
+static void _abort_reload(worker_t **next_ptr)
+{
+	worker_t *next = *next_ptr;
+
+	_signal_workers(next, SIGINT);
+	_close_ready_fds(next);
+	xfree(next);
+	*next_ptr = NULL;
+}
+
+/*
+ * Check if worker is ready
+ * IN worker - worker whose readiness pipe polled readable
+ * RET true if worker is ready or false if worker failed before listening
+ */
+static bool _check_ready(worker_t *worker)
+{
+	char c;
+	ssize_t rc;
+
+	while (((rc = read(worker->ready_fd, &c, 1)) < 0) && (errno == EINTR))
+		;
+
+	close(worker->ready_fd);
+	worker->ready_fd = -1;
+
+	if ((worker->ready = (rc == 1)))
+		debug("%s: worker pid %d is listening", __func__, worker->pid);
+
+	return worker->ready;
+}
+
+/* RET true once every worker is listening */
+static bool _all_ready(worker_t *workers)
+{
+	for (int i = 0; i < worker_count; i++)
+		if (!workers[i].ready)
+			return false;
+
+	return true;
+}
+
+/* Tell supervisor (if any) that this worker is accepting connections */
+static void _notify_ready(void)
+{
+	char c = 0;
+
+	if (ready_fd < 0)
+		return;
+
+	if (write(ready_fd, &c, 1) != 1)
+		fatal("%s: unable to notify supervisor: %m", __func__);
+
+	close(ready_fd);
+	ready_fd = -1;
+}
+
+/*
+ * Run as supervisor of worker_count worker processes. Each worker opens its
+ * own listening sockets with SO_REUSEPORT to let the kernel balance new
+ * connections between them and runs its own connection manager. Each worker
+ * writes to its readiness pipe once it is listening.
+ *
+ * SIGHUP starts a new set of workers. The old workers are only asked to finish
+ * their active connections and exit once every new worker is listening. If
+ * any new worker fails before then, the new workers are stopped and the old
+ * workers are kept. SIGINT and SIGTERM ask all workers to finish and exit.
+ *
+ * Only returns in the worker processes.
+ */
+static void _supervise_workers(void)
+{
+	sigset_t mask, old_mask;
+	worker_t *workers = xcalloc(worker_count, sizeof(*workers));
+	/* replacement workers during a reload */
+	worker_t *next = NULL;
+	struct pollfd *fds = xcalloc((worker_count * 2) + 1, sizeof(*fds));
+	int sig_fd, running = 0, rc = SLURM_SUCCESS;
+	time_t reload_start = 0;
+	bool stopping = false;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGCHLD);
+	sigaddset(&mask, SIGHUP);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	if (sigprocmask(SIG_BLOCK, &mask, &old_mask))
+		fatal("%s: unable to block signals: %m", __func__);
+	if ((sig_fd = signalfd(-1, &mask, SFD_CLOEXEC)) < 0)
+		fatal("%s: signalfd() failed: %m", __func__);
+
+	for (int i = 0; i < worker_count; i++)
+		workers[i].ready_fd = -1;
+
+	for (int i = 0; i < worker_count; i++, running++)
+		if (_start_worker(&old_mask, &workers[i]))
+			goto worker;
+
+	info("%s: supervising %d workers", __func__, worker_count);
+
+	while (running > 0) {
+		struct signalfd_siginfo siginfo;
+		int nfds = 0, status;
+		pid_t pid;
+
+		fds[nfds].fd = sig_fd;
+		fds[nfds++].events = POLLIN;
+		for (int i = 0; i < worker_count; i++) {
+			fds[nfds].fd = workers[i].ready_fd;
+			fds[nfds++].events = POLLIN;
+			fds[nfds].fd = (next ? next[i].ready_fd : -1);
+			fds[nfds++].events = POLLIN;
+		}
+
+		if (poll(fds, nfds, (next ? 1000 : -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			fatal("%s: poll() failed: %m", __func__);
+		}
+
+		if (next && !stopping &&
+		    ((time(NULL) - reload_start) >= WORKER_START_TIMEOUT)) {
+			error("%s: replacement workers not listening after %d seconds, keeping current workers",
+			      __func__, WORKER_START_TIMEOUT);
+			_abort_reload(&next);
+		}
+
+		for (int i = 0; i < worker_count; i++) {
+			worker_t *worker = &workers[i];
+
+			/* startup failures are handled once reaped */
+			if (fds[(i * 2) + 1].revents && (worker->ready_fd >= 0))
+				(void) _check_ready(worker);
+
+			if (!next || !fds[(i * 2) + 2].revents ||
+			    (next[i].ready_fd < 0))
+				continue;
+
+			if (!_check_ready(&next[i])) {
+				if (stopping)
+					continue;
+				error("%s: replacement worker pid %d failed during startup, keeping current workers",
+				      __func__, next[i].pid);
+				_abort_reload(&next);
+			} else if (_all_ready(next)) {
+				info("%s: replacement workers are listening, stopping old workers",
+				     __func__);
+				/* old workers finish their connections */
+				_signal_workers(workers, SIGINT);
+				_close_ready_fds(workers);
+				xfree(workers);
+				workers = next;
+				next = NULL;
+				break;
+			}
+		}
+
+		if (!fds[0].revents)
+			continue;
+
+		if (read(sig_fd, &siginfo, sizeof(siginfo)) != sizeof(siginfo))
+			continue;
+
+		switch (siginfo.ssi_signo) {
+		case SIGHUP:
+			if (stopping)
+				break;
+
+			if (next) {
+				info("%s: caught SIGHUP, reload already in progress",
+				     __func__);
+				break;
+			}
+
+			info("%s: caught SIGHUP, starting replacement workers",
+			     __func__);
+
+			reload_start = time(NULL);
+			next = xcalloc(worker_count, sizeof(*next));
+			for (int i = 0; i < worker_count; i++)
+				next[i].ready_fd = -1;
+
+			for (int i = 0; i < worker_count; i++, running++)
+				if (_start_worker(&old_mask, &next[i]))
+					goto worker;
+			break;
+		case SIGINT:
+		case SIGTERM:
+			info("%s: caught %s, stopping workers",
+			     __func__, strsignal(siginfo.ssi_signo));
+			stopping = true;
+			_signal_workers(workers, SIGINT);
+			if (next)
+				_signal_workers(next, SIGINT);
+			break;
+		case SIGCHLD:
+			while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+				worker_t *worker;
+
+				running--;
+
+				if (next && (worker = _find_worker(next, pid))) {
+					worker->pid = 0;
+					if (stopping)
+						continue;
+					error("%s: replacement worker pid %d exited, keeping current workers",
+					      __func__, pid);
+					_abort_reload(&next);
+					continue;
+				}
+
+				if (!(worker = _find_worker(workers, pid))) {
+					/* replaced or abandoned worker finished */
+					debug("%s: stopped worker pid %d exited",
+					      __func__, pid);
+					continue;
+				}
+
+				worker->pid = 0;
+				if (worker->ready_fd >= 0) {
+					close(worker->ready_fd);
+					worker->ready_fd = -1;
+				}
+
+				if (stopping) {
+					debug("%s: worker pid %d exited",
+					      __func__, pid);
+					continue;
+				}
+
+				if (WIFSIGNALED(status))
+					error("%s: worker pid %d killed by signal %s",
+					      __func__, pid,
+					      strsignal(WTERMSIG(status)));
+				else
+					error("%s: worker pid %d exited with %d",
+					      __func__, pid,
+					      WEXITSTATUS(status));
+
+				if (!worker->ready) {
+					/* restarting would fail the same way */
+					error("%s: worker pid %d failed during startup, not restarting",
+					      __func__, pid);
+					rc = SLURM_ERROR;
+					continue;
+				}
+
+				if (_start_worker(&old_mask, worker))
+					goto worker;
+				running++;
+			}
+			break;
+		}
+	}
+
+	close(sig_fd);
+	xfree(fds);
+	xfree(workers);
+	log_fini();
+	exit((stopping && !rc) ? 0 : 1);
+
+worker:
+	close(sig_fd);
+	xfree(fds);
+	_close_ready_fds(workers);
+	_close_ready_fds(next);
+	xfree(workers);
+	xfree(next);
+}
+
 /* simple wrapper to hand over operations router in http context */
 static void *_setup_http_context(con_mgr_fd_t *con, void *arg)
 {
@@ -376,11 +764,20 @@ static void _plugrack_foreach_list(const char *full_type, const char *fq_path,
 	info("%s", full_type);
 }
 
+static int _get_openapi_serialized(void *arg, const char *mime_type,
+				   const char **body_ptr)
+{
+	return get_openapi_specification_serialized(openapi_state, mime_type,
+						    body_ptr);
+}
+
 static int _op_handler_openapi(const char *context_id,
 			       http_request_method_t method, data_t *parameters,
 			       data_t *query, int tag, data_t *resp, void *auth)
 {
-	return get_openapi_specification(openapi_state, resp);
+	/* spec is only serialized once per MIME type */
+	openapi_resp_serialized(_get_openapi_serialized, NULL);
+	return SLURM_SUCCESS;
 }
 
 int main(int argc, char **argv)
@@ -415,6 +812,15 @@ int main(int argc, char **argv)
 
 	run_mode.listen = !list_is_empty(socket_listen);
 
+	if (worker_count && !run_mode.listen)
+		fatal("SLURMRESTD_WORKERS requires listening sockets");
+	if (worker_count &&
+	    list_find_first(socket_listen, _is_unix_socket, NULL))
+		fatal("SLURMRESTD_WORKERS does not support UNIX sockets");
+	if (worker_count && xstrcasecmp(rest_auth, "list") &&
+	    xstrcasecmp(oas_specs, "list"))
+		_supervise_workers();
+
 	slurm_init(slurm_conf_filename);
 
 	if (thread_count < 2)
@@ -432,7 +838,7 @@ int main(int argc, char **argv)
 				    callbacks)))
 		fatal("Unable to initialize connection manager");
 
-	if (init_operations())
+	if (init_operations(response_cache_ttl))
 		fatal("Unable to initialize operations structures");
 
 	auth_rack = plugrack_create("rest_auth");
@@ -522,11 +928,15 @@ int main(int argc, char **argv)
 	} else if (run_mode.listen) {
 		mode_t mask = umask(0);
 
+		/* Workers share the same addresses */
+		conmgr->reuse_port = (worker_count > 0);
+
 		if (con_mgr_create_sockets(conmgr, CON_TYPE_RAW, socket_listen,
 					   conmgr_events, operations_router))
 			fatal("Unable to create sockets");
 
 		umask(mask);
+		_notify_ready();
 
 		FREE_NULL_LIST(socket_listen);
 		debug("%s: server listen mode activated", __func__);
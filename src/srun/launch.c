@@ -1313,6 +1313,8 @@ extern int launch_g_step_launch(srun_job_t *job, slurm_step_io_fds_t *cio_fds,
 	launch_params.cwd = opt_local->chdir;
 	launch_params.slurmd_debug = srun_opt->slurmd_debug;
 	launch_params.buffered_stdio = !srun_opt->unbuffered;
+	launch_params.io_coalesce = srun_opt->io_coalesce;
+	launch_params.io_compress = srun_opt->io_compress;
 	launch_params.labelio = srun_opt->labelio ? true : false;
 	launch_params.remote_output_filename = fname_remote_string(job->ofname);
 	launch_params.remote_input_filename  = fname_remote_string(job->ifname);
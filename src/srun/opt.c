@@ -567,6 +567,7 @@ env_vars_t env_vars[] = {
   { "SLURM_GRES", LONG_OPT_GRES },
   { "SLURM_GRES_FLAGS", LONG_OPT_GRES_FLAGS },
   { "SLURM_HINT", LONG_OPT_HINT },
+  { "SLURM_IO_COALESCE", LONG_OPT_IO_COALESCE },
   { "SLURM_JOB_ID", LONG_OPT_JOBID },
   { "SLURM_JOB_NAME", 'J' },
   { "SLURM_JOB_NODELIST", LONG_OPT_ALLOC_NODELIST },
@@ -1513,6 +1514,7 @@ static void _usage(void)
 "            [--bb=burst_buffer_spec] [--bbf=burst_buffer_file]\n"
 "            [--bcast=<dest_path>] [--bcast-exclude=<NONE|path1,...,pathN>]\n"
 "            [--send-libs[=y|n]] [--compress[=library]]\n"
+"            [--io-coalesce[=library]]\n"
 "            [--acctg-freq=<datatype>=<interval>] [--delay-boot=mins]\n"
 "            [-w hosts...] [-x hosts...] [--use-min-nodes]\n"
 "            [--mpi-combine=yes|no] [--het-group=value]\n"
@@ -1563,6 +1565,7 @@ static void _help(void)
 "  -H, --hold                  submit job in held state\n"
 "  -i, --input=in              location of stdin redirection\n"
 "  -I, --immediate[=secs]      exit if resources not available in \"secs\"\n"
+"      --io-coalesce[=library] coalesce (and compress) stdout/err of tasks\n"
 "      --jobid=id              run under already allocated job\n"
 "  -J, --job-name=jobname      name of job\n"
 "  -k, --no-kill               do not kill job on node failure\n"
@@ -774,6 +774,8 @@ static void _file_bcast(slurm_opt_t *opt_local, srun_job_t *job)
 		if (sep)
 			sep[0] = ',';
 	}
+	if (bcast_conf_pipeline(&params->pipeline))
+		fatal("Invalid BcastParameters Pipeline value");
 	params->exclude = xstrdup(srun_opt->bcast_exclude);
 	if (srun_opt->bcast_file && (srun_opt->bcast_file[0] == '/')) {
 		params->dst_fname = xstrdup(srun_opt->bcast_file);
@@ -0,0 +1,40 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import pytest
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_accounting()
+    atf.require_nodes(1)
+    atf.require_slurm_running()
+
+
+def test_stream():
+    """Verify sacct --stream reports the same jobs and steps"""
+
+    job_ids = []
+    for i in range(5):
+        job_id = atf.submit_job("--wrap=\"srun true\"", fatal=True)
+        job_ids.append(job_id)
+    for job_id in job_ids:
+        atf.wait_for_job_state(job_id, "COMPLETED", fatal=True)
+
+    jobs = ",".join(str(job_id) for job_id in job_ids)
+    args = f"-n -P -o jobid,state -j {jobs}"
+    listed = atf.run_command_output(f"sacct {args}", fatal=True)
+    streamed = atf.run_command_output(f"sacct --stream {args}", fatal=True)
+
+    assert len(listed.splitlines()) >= len(job_ids)
+    assert sorted(streamed.splitlines()) == sorted(listed.splitlines())
+
+
+def test_stream_json():
+    """Verify sacct --stream can not be used with --json"""
+
+    result = atf.run_command("sacct --stream --json")
+    assert result['exit_code'] != 0
+    assert "--stream" in result['stderr']
@@ -0,0 +1,73 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import pytest
+
+job_count = 150
+wckey_count = 3
+wckey_prefix = "test_101_3_wckey"
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_auto_config("wants to pause slurmdbd")
+    atf.require_accounting(modify=True)
+    atf.require_config_parameter("TrackWCKey", "Yes")
+    atf.require_config_parameter_excludes("AccountingStorageEnforce",
+                                          "wckeys")
+    atf.require_config_parameter("TrackWCKey", "Yes", source="slurmdbd")
+    atf.require_config_parameter("MaxBatchRecords", "1000",
+                                 source="slurmdbd")
+    atf.require_config_parameter("MaxBatchThreads", "4", source="slurmdbd")
+    atf.require_nodes(1)
+    atf.require_slurm_running()
+
+
+def test_parallel_late_jobs_new_wckeys():
+    """Verify late job starts creating wckeys are stored by parallel batches"""
+
+    slurm_user = atf.properties['slurm-user']
+    slurmdbd = f"{atf.properties['slurm-sbin-dir']}/slurmdbd"
+    slurmdbd_pids = atf.pids_from_exe(slurmdbd)
+    assert slurmdbd_pids, "slurmdbd is not running"
+    pids = " ".join(str(pid) for pid in slurmdbd_pids)
+
+    # Every job now starts before the last rollup, so each resets it
+    atf.run_command("sacctmgr -i rollup now-1hours now+3hours",
+                    user=slurm_user, fatal=True)
+
+    # Queue the records in slurmctld so they are sent in DBD_SEND_MULT_MSG
+    # batches. Jobs of the same new wckey land on different connections.
+    atf.run_command(f"kill -STOP {pids}", user=slurm_user, fatal=True)
+    job_ids = []
+    try:
+        for i in range(job_count):
+            job_ids.append(atf.submit_job(
+                f"--wckey={wckey_prefix}{i % wckey_count} --wrap=\"true\"",
+                fatal=True))
+    finally:
+        atf.run_command(f"kill -CONT {pids}", user=slurm_user, fatal=True)
+
+    for job_id in job_ids:
+        atf.wait_for_job_state(job_id, "COMPLETED", timeout=120, fatal=True)
+
+    jobs = ",".join(str(job_id) for job_id in job_ids)
+    expected = sorted(f"{job_id}|{wckey_prefix}{i % wckey_count}"
+                      for i, job_id in enumerate(job_ids))
+    assert atf.repeat_until(
+        lambda: sorted(atf.run_command_output(
+            f"sacct -X -n -P -o jobid,wckey -j {jobs}").splitlines()),
+        lambda stored: stored == expected, timeout=120), \
+        "Not every job was stored with its wckey"
+
+    wckeys = atf.run_command_output(
+        "sacctmgr -n -P show wckey format=wckey", user=slurm_user,
+        fatal=True).split()
+    for i in range(wckey_count):
+        assert f"{wckey_prefix}{i}" in wckeys, \
+            f"WCKey {wckey_prefix}{i} was not created"
+
+    assert atf.pids_from_exe(slurmdbd) == slurmdbd_pids, \
+        "slurmdbd stopped while storing the batches"
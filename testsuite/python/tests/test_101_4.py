@@ -0,0 +1,136 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import pytest
+import time
+
+account1 = "test_101_4_acct1"
+account2 = "test_101_4_acct2"
+cache_window = "24"
+fields = "jobid,jobname,account,partition,user,state,exitcode,admincomment,submit,start,end"
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_auto_config("wants to toggle JobCacheWindow")
+    atf.require_accounting(modify=True)
+    atf.require_config_parameter("JobCacheWindow", cache_window,
+                                 source="slurmdbd")
+    atf.require_nodes(1)
+    atf.require_slurm_running()
+
+
+@pytest.fixture(scope="module")
+def jobs():
+    """Runs jobs of every state in two accounts and returns their ids"""
+
+    slurm_user = atf.properties['slurm-user']
+    user = atf.get_user_name()
+    cluster = atf.get_config_parameter("ClusterName")
+    for account in [account1, account2]:
+        atf.run_command(f"sacctmgr -i add account {account} cluster={cluster}",
+                        user=slurm_user, fatal=True)
+    atf.run_command(f"sacctmgr -i add user {user} cluster={cluster} account={account1},{account2}",
+                    user=slurm_user, fatal=True)
+
+    # Jobs submitted after this are inside the window of any query from it
+    time.sleep(1)
+    start = time.strftime("%Y-%m-%dT%H:%M:%S")
+    time.sleep(1)
+
+    job_ids = {}
+    job_ids['completed'] = atf.submit_job(
+        f"-A {account1} --wrap=\"true\"", fatal=True)
+    job_ids['failed'] = atf.submit_job(
+        f"-A {account2} --wrap=\"false\"", fatal=True)
+    job_ids['cancelled'] = atf.submit_job(
+        f"-A {account1} --begin=now+1hour --wrap=\"true\"", fatal=True)
+    job_ids['pending'] = atf.submit_job(
+        f"-A {account2} --begin=now+1hour --wrap=\"true\"", fatal=True)
+    job_ids['held'] = atf.submit_job(
+        f"-A {account2} --hold --wrap=\"sleep 5\"", fatal=True)
+
+    atf.wait_for_job_state(job_ids['completed'], "COMPLETED", fatal=True)
+    atf.wait_for_job_state(job_ids['failed'], "FAILED", fatal=True)
+    atf.cancel_jobs([job_ids['cancelled']], fatal=True)
+
+    # Let slurmdbd store the records
+    jobs = ",".join(str(job_id) for job_id in job_ids.values())
+    atf.repeat_until(
+        lambda: atf.run_command_output(f"sacct -X -n -P -o state -j {jobs}"),
+        lambda output: len(output.splitlines()) == len(job_ids),
+        timeout=60, fatal=True)
+    time.sleep(1)
+    middle = time.strftime("%Y-%m-%dT%H:%M:%S")
+
+    yield job_ids, start, middle
+
+    atf.cancel_jobs(list(job_ids.values()))
+
+
+def _queries(start, middle):
+    user = atf.get_user_name()
+    partition = atf.default_partition()
+
+    return [
+        "",
+        f"-S {start}",
+        f"-S {start} -E {middle}",
+        f"-S {middle}",
+        f"-S {start} -E {middle} -s CD",
+        f"-S {start} -s CD",
+        f"-S {start} -s F,CA",
+        f"-S {start} -s R,PD",
+        f"-S {middle} -s R",
+        f"-S {start} -E {middle} -s PD",
+        f"-S {start} -A {account1}",
+        f"-S {start} -A {account1},{account2}",
+        f"-S {start} -A {account2} -s CD,F",
+        f"-S {start} -r {partition}",
+        f"-S {start} -r {partition} -A {account2}",
+        f"-S {start} -u {user}",
+        f"-S {start} -u {user} -A {account1} -s R",
+        f"-S {start} -a",
+    ]
+
+
+def _run_queries(queries):
+    return {query: atf.run_command_output(
+        f"sacct -n -P -o {fields} {query}", fatal=True)
+        for query in queries}
+
+
+def test_cache_matches_database(jobs):
+    """Verify queries answered from the job cache match the database"""
+
+    job_ids, start, middle = jobs
+    queries = _queries(start, middle)
+
+    # Load the cache, then update jobs it holds from slurmctld and sacctmgr
+    _run_queries(queries)
+    atf.run_command(f"sacctmgr -i modify job where jobid={job_ids['completed']} set AdminComment=test_101_4_updated",
+                    user=atf.properties['slurm-user'], fatal=True)
+    atf.run_command(f"scontrol release {job_ids['held']}", fatal=True)
+    atf.wait_for_job_state(job_ids['held'], "RUNNING", fatal=True)
+    time.sleep(1)
+    running = time.strftime("%Y-%m-%dT%H:%M:%S")
+    queries += [f"-S {running} -E {running} -s R",
+                f"-S {running} -E {running}"]
+    atf.wait_for_job_state(job_ids['held'], "COMPLETED", fatal=True)
+    assert atf.repeat_until(
+        lambda: atf.run_command_output(
+            f"sacct -X -n -P -o state -j {job_ids['held']}"),
+        lambda output: output.strip() == "COMPLETED", timeout=60)
+
+    cached = _run_queries(queries)
+    assert "test_101_4_updated" in cached[f"-S {start}"], \
+        "Update of a cached job was not seen"
+
+    atf.set_config_parameter("JobCacheWindow", "0", source="slurmdbd")
+    uncached = _run_queries(queries)
+
+    for query in queries:
+        assert cached[query] == uncached[query], \
+            f"sacct {query} differs with JobCacheWindow={cache_window}"
@@ -0,0 +1,124 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import datetime
+import os
+import pytest
+import shutil
+
+# Three days long ago, so each of 4 threads rolls up 18 hours
+period_start = int(datetime.datetime(2008, 1, 1, 0, 0, 0).timestamp())
+period_end = period_start + (72 * 3600)
+period_start_string = datetime.datetime.fromtimestamp(period_start).strftime('%Y-%m-%dT%H:%M:%S')
+period_end_string = datetime.datetime.fromtimestamp(period_end).strftime('%Y-%m-%dT%H:%M:%S')
+cluster_cpus = 4
+
+# The reservation crosses the slices and so does one of its jobs
+resv_id = 65536
+resv_start = period_start + (6 * 3600)
+resv_end = period_start + (66 * 3600)
+jobs = [
+    # (id, start, end, in reservation)
+    (65536, period_start + (10 * 3600), period_start + (14 * 3600), True),
+    (65537, period_start + (16 * 3600), period_start + (44 * 3600), True),
+    (65538, period_start + (30 * 3600), period_start + (31 * 3600), False),
+    (65539, period_start + (50 * 3600), period_start + (70 * 3600), False),
+]
+
+usage_tables = {
+    "usage_hour_table": "id_tres, time_start, count, alloc_secs, down_secs, pdown_secs, idle_secs, over_secs, plan_secs",
+    "usage_day_table": "id_tres, time_start, count, alloc_secs, down_secs, pdown_secs, idle_secs, over_secs, plan_secs",
+    "assoc_usage_hour_table": "id, id_tres, time_start, alloc_secs",
+    "assoc_usage_day_table": "id, id_tres, time_start, alloc_secs",
+}
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_auto_config("wants to change MaxRollupThreads")
+    atf.require_accounting(modify=True)
+    if shutil.which('mysql') is None:
+        pytest.skip("This test needs the mysql client")
+    atf.require_slurm_running()
+
+
+def _mysql(statement):
+    """Runs a statement on the accounting database and returns its output"""
+
+    slurmdbd_dict = atf.get_config(live=False, source='slurmdbd', quiet=True)
+    host, port, name, user, password = (slurmdbd_dict.get(key) for key in ['StorageHost', 'StoragePort', 'StorageLoc', 'StorageUser', 'StoragePass'])
+
+    command = "mysql -N -B"
+    if host:
+        command += f" -h {host}"
+    if port:
+        command += f" -P {port}"
+    command += f" -u {user if user else atf.properties['slurm-user']}"
+    if password:
+        command += f" -p{password}"
+    command += f" {name if name else 'slurm_acct_db'}"
+
+    return atf.run_command_output(command, input=statement, fatal=True,
+                                  quiet=True)
+
+
+@pytest.fixture(scope="module")
+def usage_data():
+    """Inserts the events, reservation and jobs of the period"""
+
+    cluster = atf.get_config_parameter("ClusterName")
+    user = atf.get_user_name()
+    assoc_id = atf.run_command_output(
+        f"sacctmgr -n -P list assoc user={user} cluster={cluster} format=id",
+        fatal=True).split()[0]
+    uid = os.geteuid()
+    gid = os.getegid()
+
+    statement = f"insert into `{cluster}_event_table` (node_name, cluster_nodes, reason, tres, time_start, time_end) values ('', '', 'Cluster processor count', '1={cluster_cpus}', {period_start}, {period_end}), ('node_test_101_5', '', 'down', '1=1', {period_start + (20 * 3600)}, {period_start + (40 * 3600)});\n"
+    statement += f"insert into `{cluster}_resv_table` (id_resv, assoclist, resv_name, nodelist, tres, time_start, time_end) values ({resv_id}, ',{assoc_id},', 'test_101_5_resv', 'node_test_101_5', '1=2', {resv_start}, {resv_end});\n"
+    for job_id, start, end, in_resv in jobs:
+        statement += f"insert into `{cluster}_job_table` (id_job, id_assoc, id_resv, id_wckey, id_user, id_group, het_job_id, het_job_offset, state_reason_prev, job_name, account, `partition`, cpus_req, nodes_alloc, priority, state, time_submit, time_eligible, time_start, time_end, tres_alloc) values ({job_id}, {assoc_id}, {resv_id if in_resv else 0}, 0, {uid}, {gid}, 0, 4294967294, 0, 'test_101_5', '', 'test_101_5', 1, 1, 1, 3, {start}, {start}, {start}, {end}, '1=1');\n"
+    _mysql(statement)
+
+    return cluster
+
+
+def _rollup(cluster, threads):
+    """Rolls up the period with threads and returns the resulting usage"""
+
+    atf.set_config_parameter("MaxRollupThreads", threads, source="slurmdbd")
+
+    statement = ""
+    for table in usage_tables:
+        statement += f"delete from `{cluster}_{table}` where time_start >= {period_start} and time_start < {period_end};\n"
+    statement += f"update `{cluster}_resv_table` set unused_wall=0 where id_resv={resv_id};\n"
+    _mysql(statement)
+
+    atf.run_command(f"sacctmgr -i rollup {period_start_string} {period_end_string}",
+                    user=atf.properties['slurm-user'], fatal=True)
+
+    usage = {}
+    for table, columns in usage_tables.items():
+        usage[table] = _mysql(f"select {columns} from `{cluster}_{table}` where time_start >= {period_start} and time_start < {period_end} order by {columns};")
+    usage['unused_wall'] = _mysql(f"select unused_wall from `{cluster}_resv_table` where id_resv={resv_id};")
+
+    return usage
+
+
+def test_parallel_rollup(usage_data):
+    """Verify rolling up in slices gives the same usage as hour by hour"""
+
+    cluster = usage_data
+    serial = _rollup(cluster, 1)
+    parallel = _rollup(cluster, 4)
+
+    for table in usage_tables:
+        assert serial[table], f"Rollup wrote nothing into {table}"
+        assert parallel[table] == serial[table], \
+            f"{table} differs when rolled up with 4 threads"
+
+    assert float(serial['unused_wall']) > 0
+    assert parallel['unused_wall'] == serial['unused_wall'], \
+        "unused_wall differs when rolled up with 4 threads"
@@ -0,0 +1,139 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import os
+import pytest
+import struct
+
+header_size = 6         # magic + version
+index_entry_size = 16   # job_id + length + offset
+segment_size = 1        # megabytes
+padding_job_id = 4000000
+jobcomp_dir = None
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    global jobcomp_dir
+
+    atf.require_auto_config("wants to set the job completion plugin")
+    jobcomp_dir = str(atf.module_tmp_path / "jobcomp")
+    os.chmod(atf.module_tmp_path, 0o777)
+    atf.require_config_parameter("JobCompType", "jobcomp/binary")
+    atf.require_config_parameter("JobCompLoc", jobcomp_dir)
+    atf.require_config_parameter("JobCompParams",
+                                 f"segment_size={segment_size}")
+    atf.require_nodes(1)
+    atf.require_slurm_running()
+
+
+def _segment(seq, index=False):
+    return f"{jobcomp_dir}/jobcomp.{seq:08d}{'.idx' if index else ''}"
+
+
+def _read(path):
+    """Returns the content of a file only the SlurmUser may read"""
+
+    copy = str(atf.module_tmp_path / "copy")
+    atf.run_command(f"cp {path} {copy} && chmod 644 {copy}",
+                    user=atf.properties['slurm-user'], fatal=True)
+    with open(copy, 'rb') as f:
+        return f.read()
+
+
+def _write(path, data):
+    copy = str(atf.module_tmp_path / "copy")
+    with open(copy, 'wb') as f:
+        f.write(data)
+    os.chmod(copy, 0o644)
+    atf.run_command(f"cp {copy} {path}", user=atf.properties['slurm-user'],
+                    fatal=True)
+
+
+def _records(data):
+    """Splits the data of a segment in its records"""
+
+    records = []
+    offset = header_size
+    while offset + 4 <= len(data):
+        length, = struct.unpack('>I', data[offset:offset + 4])
+        records.append(data[offset:offset + 4 + length])
+        offset += 4 + length
+    return records
+
+
+def _completed_jobs():
+    output = atf.run_command_output(
+        "sacct --completion -n -P -o jobid -S 2000-01-01", fatal=True)
+    return sorted(int(job_id) for job_id in output.split())
+
+
+def _run_jobs(count):
+    job_ids = [atf.submit_job("--wrap=\"true\"", fatal=True)
+               for i in range(count)]
+    for job_id in job_ids:
+        atf.wait_for_job_state(job_id, "COMPLETED", fatal=True)
+    return job_ids
+
+
+def test_recover_torn_segment():
+    """Verify complete records survive a segment cut in the middle of one"""
+
+    logged = _completed_jobs()
+    job_ids = _run_jobs(3)
+    assert atf.repeat_until(_completed_jobs,
+                            lambda jobs: set(job_ids) <= set(jobs),
+                            timeout=10)
+
+    # Cut the last record and its index entry in half, as a crash would
+    atf.stop_slurmctld(quiet=True)
+    data = _read(_segment(0))
+    index = _read(_segment(0, index=True))
+    last = _records(data)[-1]
+    _write(_segment(0), data[:len(data) - (len(last) // 2)])
+    _write(_segment(0, index=True), index[:len(index) - (index_entry_size // 2)])
+    atf.start_slurmctld(quiet=True)
+
+    assert _completed_jobs() == sorted(logged + job_ids[:-1]), \
+        "Every complete record should be kept, without the torn one"
+
+    # New records are appended after the recovered ones
+    job_ids += _run_jobs(1)
+    assert atf.repeat_until(
+        _completed_jobs,
+        lambda jobs: jobs == sorted(logged + job_ids[:2] + job_ids[3:]),
+        timeout=10)
+
+
+def test_rotate_segment():
+    """Verify a full segment is rotated to a new one"""
+
+    # Fill the segment past its size with copies of a record
+    atf.stop_slurmctld(quiet=True)
+    data = _read(_segment(0))
+    record = _records(data)[0]
+    padding = b''
+    job_id = padding_job_id
+    while len(data) + len(padding) <= segment_size * 1024 * 1024:
+        padding += record[:4] + struct.pack('>I', job_id) + record[8:]
+        job_id += 1
+    _write(_segment(0), data + padding)
+    atf.start_slurmctld(quiet=True)
+
+    assert atf.run_command_exit(f"test -e {_segment(1)}",
+                                user=atf.properties['slurm-user']) != 0, \
+        "A new segment should only be created for a new record"
+    logged = _completed_jobs()
+    assert set(range(padding_job_id, job_id)) <= set(logged), \
+        "Records without an index entry should be indexed again"
+
+    job_ids = _run_jobs(1)
+    assert atf.repeat_until(_completed_jobs,
+                            lambda jobs: jobs == sorted(logged + job_ids),
+                            timeout=10)
+    assert atf.run_command_exit(f"test -e {_segment(1)}",
+                                user=atf.properties['slurm-user']) == 0, \
+        "The full segment was not rotated"
+    assert len(_records(_read(_segment(1)))) == 1
@@ -0,0 +1,95 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import hashlib
+import os
+import pytest
+import time
+
+file_size = 64 * 1024 * 1024
+block_size = "1m"
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_nodes(2)
+    atf.require_slurm_running()
+
+
+@pytest.fixture(scope="module")
+def src_file(tmp_path_factory):
+    """Build a file that is half random and half compressible"""
+
+    path = str(tmp_path_factory.mktemp("sbcast") / "src")
+    with open(path, "wb") as f:
+        chunk = 1024 * 1024
+        for i in range(file_size // chunk):
+            if i % 2:
+                f.write(os.urandom(chunk))
+            else:
+                f.write(bytes([i % 256]) * chunk)
+    with open(path, "rb") as f:
+        digest = hashlib.md5(f.read()).hexdigest()
+    return path, digest
+
+
+@pytest.fixture(scope="module")
+def job_id():
+    job_id = atf.submit_job("-N2 --wrap=\"sleep 600\"", fatal=True)
+    atf.wait_for_job_state(job_id, "RUNNING", fatal=True)
+    return job_id
+
+
+def _bcast(job_id, src, dest, args):
+    start = time.time()
+    atf.run_command(f"sbcast -j {job_id} -f -s {block_size} {args} {src} {dest}",
+                    fatal=True)
+    return time.time() - start
+
+
+def _verify(job_id, dest, digest):
+    output = atf.run_command_output(
+        f"srun --jobid={job_id} -N2 --ntasks-per-node=1 md5sum {dest}",
+        fatal=True)
+    sums = [line.split()[0] for line in output.splitlines() if dest in line]
+    assert len(sums) == 2
+    for node_sum in sums:
+        assert node_sum == digest
+
+
+@pytest.mark.parametrize("compress", ["none", "lz4", "zstd"])
+def test_pipeline(job_id, src_file, tmp_path, compress):
+    """Verify pipelined sbcast writes the same file and compare throughput"""
+
+    src, digest = src_file
+    dest = str(tmp_path / f"dest_{compress}")
+
+    serial = _bcast(job_id, src, dest, f"--compress={compress} --pipeline=1")
+    _verify(job_id, dest, digest)
+
+    pipelined = _bcast(job_id, src, dest,
+                       f"--compress={compress} --pipeline=8")
+    _verify(job_id, dest, digest)
+
+    atf.log_debug(f"sbcast compress={compress}: serial {serial:.3f}s "
+                  f"({file_size / serial / 1e6:.1f} MB/s), "
+                  f"pipeline=8 {pipelined:.3f}s "
+                  f"({file_size / pipelined / 1e6:.1f} MB/s)")
+
+
+@pytest.mark.parametrize("pipeline", ["0", "-1", "4x", ""])
+def test_invalid_pipeline(job_id, src_file, tmp_path, pipeline):
+    """Verify invalid --pipeline and SBCAST_PIPELINE values are rejected"""
+
+    src, digest = src_file
+    dest = str(tmp_path / "dest")
+
+    result = atf.run_command(f"sbcast -j {job_id} -f --pipeline={pipeline} {src} {dest}")
+    assert result['exit_code'] != 0
+    assert "Invalid --pipeline value" in result['stderr']
+
+    result = atf.run_command(f"SBCAST_PIPELINE={pipeline} sbcast -j {job_id} -f {src} {dest}")
+    assert result['exit_code'] != 0
+    assert "Invalid SBCAST_PIPELINE value" in result['stderr']
@@ -0,0 +1,39 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import pytest
+import re
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_config_parameter_includes("BcastParameters", "Cache")
+    atf.require_nodes(1)
+    atf.require_slurm_running()
+
+
+def test_send_libs_cache(tmp_path):
+    """Verify a repeated sbcast --send-libs is served from the block cache"""
+
+    job_id = atf.submit_job("-N1 --wrap=\"sleep 300\"", fatal=True)
+    atf.wait_for_job_state(job_id, "RUNNING", fatal=True)
+
+    src = atf.run_command_output("which sleep", fatal=True).strip()
+    dest = str(tmp_path / "sleep_copy")
+
+    # The first transfer may or may not find the blocks cached
+    atf.run_command(f"sbcast -j {job_id} -f --send-libs {src} {dest}",
+                    fatal=True)
+
+    # Every block of the second transfer must come from the cache
+    error = atf.run_command_error(
+        f"sbcast -v -j {job_id} -f --send-libs {src} {dest}", fatal=True)
+    match = re.search(r'(\d+) of (\d+) blocks were already cached', error)
+    assert match is not None
+    assert match.group(1) == match.group(2)
+
+    output = atf.run_command_output(
+        f"srun --jobid={job_id} -N1 cmp {src} {dest}")
+    assert output == ""
@@ -0,0 +1,110 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import os
+import pytest
+import re
+import subprocess
+
+jobs_path = "/slurm/v0.0.39/jobs/"
+
+
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_slurm_running()
+
+
+def test_invalid_ttl():
+    """Verify invalid SLURMRESTD_RESPONSE_CACHE_TTL is rejected"""
+
+    assert atf.run_command_exit("SLURMRESTD_RESPONSE_CACHE_TTL=invalid slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n") != 0
+    assert atf.run_command_exit("SLURMRESTD_RESPONSE_CACHE_TTL=-1 slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n") != 0
+
+
+def test_cached_response():
+    """Verify identical GET requests share a cached response and ETag"""
+
+    request = "GET /openapi HTTP/1.1\r\n\r\n"
+    output = atf.run_command_output("SLURMRESTD_RESPONSE_CACHE_TTL=60 slurmrestd -a rest_auth/local", input=request + request.replace("\r\n\r\n", "\r\nConnection: Close\r\n\r\n"), fatal=True)
+
+    assert len(re.findall(r'HTTP/1.1 200 OK', output)) == 2
+    etags = re.findall(r'ETag: (\S+)', output)
+    assert len(etags) == 2
+    assert etags[0] == etags[1]
+
+
+def test_not_modified():
+    """Verify a request with the ETag of the response gets 304"""
+
+    output = atf.run_command_output("SLURMRESTD_RESPONSE_CACHE_TTL=60 slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n", fatal=True)
+    etag = re.search(r'ETag: (\S+)', output).group(1)
+
+    output = atf.run_command_output("SLURMRESTD_RESPONSE_CACHE_TTL=60 slurmrestd -a rest_auth/local", input=f"GET /openapi HTTP/1.1\r\nIf-None-Match: {etag}\r\nConnection: Close\r\n\r\n", fatal=True)
+    assert re.search(r'HTTP/1.1 304', output) is not None
+    assert re.search(r'HTTP/1.1 200', output) is None
+
+
+def _get(proc, path):
+    """Sends a GET to a slurmrestd on a pipe and returns the response"""
+
+    proc.stdin.write(f"GET {path} HTTP/1.1\r\n\r\n".encode())
+    proc.stdin.flush()
+
+    response = b""
+    while b"\r\n\r\n" not in response:
+        data = os.read(proc.stdout.fileno(), 65536)
+        assert data, "slurmrestd closed the connection"
+        response += data
+    headers, body = response.split(b"\r\n\r\n", 1)
+    length = int(re.search(rb'Content-Length: (\d+)', headers).group(1))
+    while len(body) < length:
+        data = os.read(proc.stdout.fileno(), 65536)
+        assert data, "slurmrestd closed the connection"
+        body += data
+
+    return headers.decode(), body.decode()
+
+
+def _has_job(body, job_id):
+    return re.search(rf'"job_id":\s*{job_id}\b', body) is not None
+
+
+def test_stale_cached_response():
+    """Verify changed content is only seen once the cached response expires"""
+
+    proc = subprocess.Popen(["slurmrestd", "-a", "rest_auth/local"],
+                            env=dict(os.environ,
+                                     SLURMRESTD_RESPONSE_CACHE_TTL="600"),
+                            stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL)
+    try:
+        headers, body = _get(proc, jobs_path)
+        assert re.search(r'HTTP/1.1 200 OK', headers) is not None
+        etag = re.search(r'ETag: (\S+)', headers).group(1)
+
+        job_id = atf.submit_job("--hold --wrap=\"true\"", fatal=True)
+
+        # Within the TTL the response from before the submit is served
+        headers, body = _get(proc, jobs_path)
+        assert re.search(r'ETag: (\S+)', headers).group(1) == etag
+        assert not _has_job(body, job_id), \
+            "Cached response should not contain the new job"
+    finally:
+        proc.kill()
+        proc.wait()
+
+    # Without the cache the new job is returned
+    output = atf.run_command_output("slurmrestd -a rest_auth/local", input=f"GET {jobs_path} HTTP/1.1\r\nConnection: Close\r\n\r\n", fatal=True)
+    assert _has_job(output, job_id)
+
+    atf.cancel_jobs([job_id])
+
+
+def test_no_cache_by_default():
+    """Verify responses are not cached without SLURMRESTD_RESPONSE_CACHE_TTL"""
+
+    output = atf.run_command_output("slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n", fatal=True)
+
+    assert re.search(r'HTTP/1.1 200 OK', output) is not None
+    assert re.search(r'ETag:', output) is None
@@ -0,0 +1,130 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import os
+import pytest
+import shutil
+import signal
+import socket
+import subprocess
+import time
+
+
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_slurm_running()
+
+
+def test_invalid_workers():
+    """Verify invalid SLURMRESTD_WORKERS is rejected"""
+
+    assert atf.run_command_exit("SLURMRESTD_WORKERS=invalid slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n") != 0
+    assert atf.run_command_exit("SLURMRESTD_WORKERS=-1 slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n") != 0
+
+
+def test_workers_require_listen():
+    """Verify SLURMRESTD_WORKERS is rejected without listening sockets"""
+
+    assert atf.run_command_exit("SLURMRESTD_WORKERS=2 slurmrestd -a rest_auth/local", input="GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n") != 0
+    assert atf.run_command_exit("SLURMRESTD_WORKERS=2 slurmrestd -a rest_auth/local unix:/dev/null/invalid") != 0
+
+
+def _free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
+        s.bind(("localhost", 0))
+        return s.getsockname()[1]
+
+
+def _request(port):
+    """Returns True if a worker accepted and answered the connection"""
+
+    try:
+        with socket.create_connection(("localhost", port), timeout=5) as s:
+            s.sendall(b"GET /openapi HTTP/1.1\r\nConnection: Close\r\n\r\n")
+            s.recv(1024)
+            return True
+    except OSError:
+        return False
+
+
+def _workers(pid):
+    return set(atf.run_command_output(f"pgrep -P {pid}").split())
+
+
+def _reload(proc, port, timeout=30):
+    """Sends SIGHUP and returns False if any connection failed during reload"""
+
+    old = _workers(proc.pid)
+    proc.send_signal(signal.SIGHUP)
+
+    served = True
+    begin = time.time()
+    while time.time() - begin < timeout:
+        served = _request(port) and served
+        if not (_workers(proc.pid) & old):
+            break
+        time.sleep(.1)
+
+    return served
+
+
+@pytest.fixture
+def slurmrestd(tmp_path):
+    """Starts slurmrestd with 2 workers using a copy of the configuration"""
+
+    conf_dir = str(tmp_path / "etc")
+    shutil.copytree(atf.properties['slurm-config-dir'], conf_dir)
+    port = _free_port()
+
+    proc = subprocess.Popen(
+        ["slurmrestd", "-f", f"{conf_dir}/slurm.conf", "-a",
+         "rest_auth/local", f"localhost:{port}"],
+        env=dict(os.environ, SLURMRESTD_WORKERS="2"),
+        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+    atf.repeat_until(lambda: _request(port), lambda served: served,
+                     timeout=30, fatal=True)
+
+    yield proc, port, conf_dir
+
+    if proc.poll() is None:
+        proc.kill()
+        proc.wait()
+
+
+def test_workers_reload(slurmrestd):
+    """Verify SIGHUP replaces the workers without refusing connections"""
+
+    proc, port, conf_dir = slurmrestd
+    old = _workers(proc.pid)
+    assert len(old) == 2
+
+    assert _reload(proc, port), "Connection failed during reload"
+    new = _workers(proc.pid)
+    assert len(new) == 2
+    assert not (new & old), "Old workers were not replaced"
+    assert _request(port)
+
+    proc.send_signal(signal.SIGTERM)
+    assert proc.wait(timeout=60) == 0
+
+
+def test_workers_reload_invalid_config(slurmrestd):
+    """Verify SIGHUP with a broken configuration keeps the current workers"""
+
+    proc, port, conf_dir = slurmrestd
+    old = _workers(proc.pid)
+
+    with open(f"{conf_dir}/slurm.conf", "w") as f:
+        f.write("InvalidParameter=invalid\n")
+
+    proc.send_signal(signal.SIGHUP)
+    # replacement workers fail to load the configuration and are stopped
+    time.sleep(5)
+    assert proc.poll() is None, "slurmrestd stopped after failed reload"
+    assert _workers(proc.pid) == old
+    assert _request(port)
+
+    proc.send_signal(signal.SIGTERM)
+    assert proc.wait(timeout=60) == 0
@@ -0,0 +1,70 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import pytest
+import re
+
+line_count = 20000
+large_count = 300000
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_nodes(1, [('CPUs', 2)])
+    atf.require_slurm_running()
+
+
+def test_invalid_io_coalesce():
+    """Verify an unknown --io-coalesce type is rejected"""
+
+    result = atf.run_command("srun --io-coalesce=invalid true")
+    assert result['exit_code'] != 0
+    assert re.search(r'Invalid --io-coalesce specification',
+                     result['stderr']) is not None
+
+
+def _task_lines(output, task):
+    prefix = f"{task}: "
+    return [line[len(prefix):] for line in output.splitlines()
+            if line.startswith(prefix)]
+
+
+@pytest.mark.parametrize("io_coalesce", ["--io-coalesce",
+                                         "--io-coalesce=none",
+                                         "--io-coalesce=lz4"])
+def test_interleaved_output(tmp_path, io_coalesce):
+    """Verify interleaved stdout and stderr of each task arrive intact"""
+
+    script = str(tmp_path / "interleaved.sh")
+    atf.make_bash_script(script, f"""for i in $(seq 1 {line_count}); do
+    echo "out $i"
+    echo "err $i" >&2
+done
+""")
+
+    result = atf.run_command(f"srun -n2 -l {io_coalesce} {script}",
+                             fatal=True)
+    for task in range(2):
+        assert _task_lines(result['stdout'], task) == \
+            [f"out {i}" for i in range(1, line_count + 1)], \
+            f"stdout of task {task} was not received intact"
+        assert _task_lines(result['stderr'], task) == \
+            [f"err {i}" for i in range(1, line_count + 1)], \
+            f"stderr of task {task} was not received intact"
+
+
+@pytest.mark.parametrize("io_coalesce", ["--io-coalesce",
+                                         "--io-coalesce=lz4"])
+def test_large_output(io_coalesce):
+    """Verify large stdout and stderr arrive intact"""
+
+    result = atf.run_command(f"srun {io_coalesce} bash -c \"seq 1 {large_count}; seq {large_count} -1 1 >&2\"",
+                             fatal=True)
+    assert result['stdout'] == \
+        "".join(f"{i}\n" for i in range(1, large_count + 1)), \
+        "stdout was not received intact"
+    assert result['stderr'] == \
+        "".join(f"{i}\n" for i in range(large_count, 0, -1)), \
+        "stderr was not received intact"
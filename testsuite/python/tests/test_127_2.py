@@ -0,0 +1,117 @@
+############################################################################
+# Copyright (C) SchedMD LLC.
+############################################################################
+import atf
+import os
+import pytest
+import re
+import time
+
+node_count = 3
+# Smaller than node_count, so the job's nodes form a tree: the nodes after
+# the first one are leaves relaying their completion to the first one.
+tree_width = 2
+slow_epilog_time = 8
+verbose_levels = ["verbose", "debug", "debug2", "debug3", "debug4", "debug5"]
+
+
+# Setup
+@pytest.fixture(scope="module", autouse=True)
+def setup():
+    atf.require_auto_config("wants to set the Epilog")
+    atf.require_config_parameter_includes("SlurmdParameters",
+                                          f"batch_epilog_complete={tree_width}")
+    atf.require_config_parameter_includes("DebugFlags", "Route")
+    atf.require_config_parameter("SlurmctldDebug", "verbose",
+                                 lambda level: level in verbose_levels)
+    atf.require_nodes(node_count)
+    atf.require_slurm_running()
+
+
+def _batches(job_id):
+    """Returns the node counts of the epilog completion batches of a job"""
+
+    log_file = atf.get_config_parameter("SlurmctldLogFile")
+    output = atf.run_command_output(f"cat {log_file}",
+                                    user=atf.properties['slurm-user'],
+                                    quiet=True)
+    return [int(cnt) for cnt in re.findall(
+        rf"_slurm_rpc_epilog_complete_batch: JobId={job_id} node_cnt=(\d+)",
+        output)]
+
+
+def _job_nodes(job_id):
+    node_list = atf.get_job_parameter(job_id, "NodeList")
+    return atf.run_command_output(f"scontrol show hostnames {node_list}",
+                                  fatal=True).split()
+
+
+def test_relayed_epilog_complete(tmp_path):
+    """Verify leaves relay their epilog completion through the root node"""
+
+    epilog = str(tmp_path / 'epilog.sh')
+    atf.make_bash_script(epilog, "exit 0\n")
+    atf.set_config_parameter('Epilog', epilog)
+
+    job_id = atf.submit_job(f"-N{node_count} --wrap=\"true\"", fatal=True)
+    atf.wait_for_job_state(job_id, "DONE", fatal=True)
+
+    # The root sends the completion of every node in a single batch
+    assert atf.repeat_until(lambda: _batches(job_id),
+                            lambda batches: batches == [node_count],
+                            timeout=10), \
+        f"Expected one batch of {node_count} nodes, got {_batches(job_id)}"
+
+
+def test_slow_epilog_complete(tmp_path):
+    """Verify a slow leaf does not hold back the completion of the others"""
+
+    slow_node_file = str(tmp_path / 'slow_node')
+    epilog = str(tmp_path / 'epilog.sh')
+    atf.make_bash_script(epilog, f"""if [ "$SLURMD_NODENAME" = "$(cat {slow_node_file} 2>/dev/null)" ]; then
+    sleep {slow_epilog_time}
+fi
+touch {tmp_path}/epilog_done_$SLURMD_NODENAME
+exit 0
+""")
+    atf.set_config_parameter('Epilog', epilog)
+
+    job_id = atf.submit_job(f"-N{node_count} --wrap=\"sleep 5\"",
+                            fatal=True)
+    atf.wait_for_job_state(job_id, "RUNNING", fatal=True)
+    nodes = _job_nodes(job_id)
+    assert len(nodes) == node_count
+
+    # Delay the epilog of a leaf, which relays through the first node
+    slow_node = nodes[-1]
+    with open(slow_node_file, 'w') as f:
+        f.write(slow_node)
+    os.chmod(slow_node_file, 0o644)
+
+    # The fast nodes finish their epilog but the job waits for the slow one
+    for node in nodes[:-1]:
+        assert atf.wait_for_file(str(tmp_path / f"epilog_done_{node}")), \
+            f"Epilog of node {node} did not run"
+    time.sleep(1)
+    assert atf.get_job_parameter(job_id, "JobState") == "COMPLETING", \
+        "Job should wait for the epilog of the slow node"
+
+    # The slow completion is relayed later and the job still completes
+    assert atf.wait_for_file(str(tmp_path / f"epilog_done_{slow_node}"),
+                             timeout=slow_epilog_time + 10), \
+        f"Epilog of node {slow_node} did not run"
+    assert atf.wait_for_job_state(job_id, "DONE",
+                                  timeout=slow_epilog_time + 10, fatal=True)
+
+    # The root relays the other leaf first, then the slow one on its own
+    assert atf.repeat_until(lambda: _batches(job_id),
+                            lambda batches: batches == [node_count - 1, 1],
+                            timeout=10), \
+        f"Unexpected epilog completion batches {_batches(job_id)}"
+
+    # Every node must have been released by its epilog completion
+    for node in nodes:
+        assert atf.repeat_until(
+            lambda: atf.get_node_parameter(node, "State"),
+            lambda state: "COMPLETING" not in state and "DRAIN" not in state,
+            timeout=10), f"Node {node} did not finish completing"
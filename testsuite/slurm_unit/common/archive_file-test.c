@@ -0,0 +1,153 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <src/common/archive_file.h>
+#include <src/common/log.h>
+#include <src/common/xmalloc.h>
+#include <src/common/xstring.h>
+
+#include <check.h>
+
+#define TEST_ROWS 25
+#define TEST_CHUNK_ROWS 7
+
+static char *cols[] = { "id_job", "`partition`", "name" };
+static char path[PATH_MAX];
+
+static void _write_file(void)
+{
+	archive_file_t *af;
+	int fd;
+
+	snprintf(path, sizeof(path), "/tmp/archive_file-test.XXXXXX");
+	fd = mkstemp(path);
+
+	ck_assert_int_ge(fd, 0);
+	close(fd);
+
+	af = archive_file_create(path, "cluster", "job_table", 1, 0,
+				 cols, 3, TEST_CHUNK_ROWS);
+	ck_assert_ptr_nonnull(af);
+
+	for (int i = 0; i < TEST_ROWS; i++) {
+		char id[16], part[16];
+		char *row[] = { id, part, (i % 5) ? "it's" : NULL };
+
+		snprintf(id, sizeof(id), "%d", i);
+		snprintf(part, sizeof(part), "%s", (i % 2) ? "" : "debug");
+		ck_assert_int_eq(archive_file_add_row(af, row), 0);
+	}
+
+	ck_assert_int_eq(archive_file_close(af), 0);
+	ck_assert(archive_file_is_columnar(path));
+}
+
+START_TEST(test_round_trip)
+{
+	archive_file_t *af = NULL;
+	archive_chunk_t *chunk = NULL;
+	int rows = 0, chunks = 0;
+
+	_write_file();
+
+	ck_assert_int_eq(archive_file_open(path, &af), 0);
+	ck_assert_str_eq(af->cluster_name, "cluster");
+	ck_assert_str_eq(af->table, "job_table");
+	ck_assert_int_eq(af->col_cnt, 3);
+	ck_assert_str_eq(af->columns[1], "`partition`");
+
+	while (!archive_file_read_chunk(af, &chunk) && chunk) {
+		ck_assert_int_eq(archive_chunk_unpack(af, chunk), 0);
+		for (int i = 0; i < chunk->row_cnt; i++, rows++) {
+			char **row = &chunk->values[i * af->col_cnt];
+			char *id = xstrdup_printf("%d", rows);
+
+			ck_assert_str_eq(row[0], id);
+			ck_assert_str_eq(row[1], (rows % 2) ? "" : "debug");
+			if (rows % 5)
+				ck_assert_str_eq(row[2], "it's");
+			else
+				ck_assert_ptr_null(row[2]);
+			xfree(id);
+		}
+		archive_chunk_free(chunk);
+		chunks++;
+	}
+
+	ck_assert_int_eq(rows, TEST_ROWS);
+	ck_assert_int_eq(chunks,
+			 (TEST_ROWS + TEST_CHUNK_ROWS - 1) / TEST_CHUNK_ROWS);
+	archive_file_free(af);
+	unlink(path);
+}
+END_TEST
+
+START_TEST(test_truncated)
+{
+	archive_file_t *af = NULL;
+	archive_chunk_t *chunk = NULL;
+	int rc;
+
+	_write_file();
+	/* drop the end of the file */
+	ck_assert_int_eq(truncate(path, 100), 0);
+
+	ck_assert_int_eq(archive_file_open(path, &af), 0);
+	while (!(rc = archive_file_read_chunk(af, &chunk)) && chunk)
+		archive_chunk_free(chunk);
+	ck_assert_int_ne(rc, 0);
+
+	archive_file_free(af);
+	unlink(path);
+}
+END_TEST
+
+START_TEST(test_bad_row_cnt)
+{
+	archive_file_t *af = NULL;
+	archive_chunk_t *chunk = NULL;
+
+	_write_file();
+
+	ck_assert_int_eq(archive_file_open(path, &af), 0);
+	ck_assert_int_eq(archive_file_read_chunk(af, &chunk), 0);
+	ck_assert_ptr_nonnull(chunk);
+
+	/* a corrupt row count must not be trusted for allocations */
+	chunk->row_cnt = UINT32_MAX;
+	ck_assert_int_ne(archive_chunk_unpack(af, chunk), 0);
+
+	archive_chunk_free(chunk);
+	archive_file_free(af);
+	unlink(path);
+}
+END_TEST
+
+int main(void)
+{
+	int number_failed;
+
+	log_options_t log_opts = LOG_OPTS_INITIALIZER;
+	log_opts.stderr_level = LOG_LEVEL_DEBUG5;
+	log_init("archive_file-test", log_opts, 0, NULL);
+
+	Suite *s = suite_create("archive_file");
+	TCase *tc_core = tcase_create("archive_file");
+
+	tcase_add_test(tc_core, test_round_trip);
+	tcase_add_test(tc_core, test_truncated);
+	tcase_add_test(tc_core, test_bad_row_cnt);
+
+	suite_add_tcase(s, tc_core);
+
+	SRunner *sr = srunner_create(s);
+
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
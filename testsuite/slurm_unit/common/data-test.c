@@ -40,6 +40,7 @@
 #include "slurm/slurm_errno.h"
 #include "src/common/data.h"
 #include "src/common/log.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -236,6 +237,268 @@ START_TEST(test_dict_iteration)
 }
 END_TEST
 
+static data_for_each_cmd_t
+	_check_dict_order(const char *key, const data_t *data, void *arg)
+{
+	int *next = arg;
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "key%d", *next);
+	ck_assert_str_eq(key, buf);
+	ck_assert_msg(data_get_int(data) == *next, "check value");
+
+	/* only even keys remain after the odd keys were removed */
+	*next += 2;
+	return DATA_FOR_EACH_CONT;
+}
+
+static data_for_each_cmd_t
+	_del_dict_div_four(const char *key, data_t *data, void *arg)
+{
+	if (!(data_get_int(data) % 4))
+		return DATA_FOR_EACH_DELETE;
+
+	return DATA_FOR_EACH_CONT;
+}
+
+START_TEST(test_dict_large)
+{
+	const int count = 10000;
+	int next = 0;
+	data_t *d = data_set_dict(data_new());
+	data_t *c;
+
+	for (int i = 0; i < count; i++)
+		data_set_int(data_key_set_int(d, i), i);
+	ck_assert_msg(data_get_dict_length(d) == count, "dict cardinality");
+
+	/* setting existing keys must not create new entries */
+	for (int i = 0; i < count; i++)
+		ck_assert_msg(data_get_int(data_key_set_int(d, i)) == i,
+			      "existing key %d", i);
+	ck_assert_msg(data_get_dict_length(d) == count, "dict cardinality");
+
+	for (int i = 0; i < count; i++) {
+		char buf[32];
+
+		snprintf(buf, sizeof(buf), "key%d", i);
+		ck_assert_msg(!data_key_get(d, buf), "missing key %s", buf);
+		ck_assert_msg(data_get_int(data_key_get_int(d, i)) == i,
+			      "find key %d", i);
+	}
+
+	/* remove the odd keys */
+	for (int i = 1; i < count; i += 2) {
+		char buf[32];
+
+		snprintf(buf, sizeof(buf), "%d", i);
+		ck_assert_msg(data_key_unset(d, buf), "unset key %s", buf);
+		ck_assert_msg(!data_key_unset(d, buf), "unset key %s again",
+			      buf);
+	}
+	ck_assert_msg(data_get_dict_length(d) == (count / 2),
+		      "dict cardinality after unset");
+
+	/* renamed copy of remaining keys */
+	c = data_set_dict(data_new());
+	for (int i = 0; i < count; i++) {
+		char buf[32];
+		data_t *e = data_key_get_int(d, i);
+
+		ck_assert_msg(!e == (i % 2), "find key %d after unset", i);
+		if (!e)
+			continue;
+
+		snprintf(buf, sizeof(buf), "key%d", i);
+		data_set_int(data_key_set(c, buf), data_get_int(e));
+	}
+	FREE_NULL_DATA(d);
+
+	ck_assert_msg(data_get_dict_length(c) == (count / 2),
+		      "dict cardinality");
+	ck_assert_msg(data_dict_for_each_const(c, _check_dict_order, &next) ==
+		      (count / 2), "insertion order");
+
+	/* copies must match and keep order */
+	d = data_new();
+	data_copy(d, c);
+	ck_assert_msg(data_check_match(c, d, false), "copy matches");
+	next = 0;
+	ck_assert_msg(data_dict_for_each_const(d, _check_dict_order, &next) ==
+		      (count / 2), "copy insertion order");
+
+	data_dict_for_each(c, _del_dict_div_four, NULL);
+	ck_assert_msg(data_get_dict_length(c) == (count / 4),
+		      "dict cardinality after delete");
+	for (int i = 0; i < count; i += 2) {
+		char buf[32];
+
+		snprintf(buf, sizeof(buf), "key%d", i);
+		ck_assert_msg(!data_key_get(c, buf) == !(i % 4),
+			      "find key %s after delete", buf);
+	}
+
+	FREE_NULL_DATA(c);
+	FREE_NULL_DATA(d);
+}
+END_TEST
+
+START_TEST(test_arena)
+{
+	const int count = 5000;
+	data_t *d = data_new_arena();
+	data_t *list, *dict, *copy, *item;
+	char key[64];
+
+	data_set_dict(d);
+	list = data_set_list(data_key_set(d, "list"));
+	dict = data_set_dict(data_key_set(d, "dict"));
+
+	for (int i = 0; i < count; i++) {
+		data_t *entry = data_set_dict(data_list_append(list));
+
+		data_set_int(data_key_set(entry, "id"), i);
+		data_set_string_fmt(data_key_set(entry, "name"), "name_%d", i);
+		data_set_bool(data_key_set(entry, "even"), !(i % 2));
+
+		snprintf(key, sizeof(key), "key_%d", i);
+		data_set_string(data_key_set(dict, key), key);
+	}
+
+	ck_assert(data_get_list_length(list) == count);
+	ck_assert(data_get_dict_length(dict) == count);
+
+	for (int i = 0; i < count; i++) {
+		snprintf(key, sizeof(key), "key_%d", i);
+		ck_assert(!xstrcmp(data_get_string(data_key_get(dict, key)),
+				   key));
+	}
+
+	/* replace and remove children */
+	for (int i = 0; i < count; i += 2) {
+		snprintf(key, sizeof(key), "key_%d", i);
+		ck_assert(data_key_unset(dict, key));
+		snprintf(key, sizeof(key), "key_%d", (i + 1));
+		data_set_int(data_key_set(dict, key), (i + 1));
+	}
+	ck_assert(data_get_dict_length(dict) == (count / 2));
+	ck_assert(!data_key_get(dict, "key_0"));
+	ck_assert(data_get_int(data_key_get(dict, "key_1")) == 1);
+
+	/* dequeued children stay valid until the root is freed */
+	item = data_list_dequeue(list);
+	ck_assert(data_get_int(data_key_get(item, "id")) == 0);
+	ck_assert(!xstrcmp(data_get_string(data_key_get(item, "name")),
+			   "name_0"));
+	FREE_NULL_DATA(item);
+	ck_assert(data_get_list_length(list) == (count - 1));
+
+	/* copy between arena and regular trees */
+	copy = data_new();
+	data_copy(copy, d);
+	FREE_NULL_DATA(d);
+
+	ck_assert(data_get_list_length(data_key_get(copy, "list")) ==
+		  (count - 1));
+	ck_assert(data_get_int(data_key_get(data_key_get(copy, "dict"),
+					    "key_3")) == 3);
+
+	d = data_new_arena();
+	data_copy(d, copy);
+	FREE_NULL_DATA(copy);
+
+	item = data_get_list_last(data_key_get(d, "list"));
+	ck_assert(data_get_int(data_key_get(item, "id")) == (count - 1));
+	ck_assert(data_get_bool(data_key_get(item, "even")) ==
+		  !((count - 1) % 2));
+
+	/* changing type of arena node */
+	data_set_null(data_key_get(d, "list"));
+	ck_assert(data_get_type(data_key_get(d, "list")) == DATA_TYPE_NULL);
+
+	FREE_NULL_DATA(d);
+}
+END_TEST
+
+START_TEST(test_dict_large_benchmark)
+{
+	const int sizes[] = { 8, 64, 1024, 16384, 65536 };
+
+	for (int s = 0; s < ARRAY_SIZE(sizes); s++) {
+		DEF_TIMERS;
+		const int count = sizes[s];
+		const int lookups = 1000000;
+		long insert_usec, lookup_usec;
+		char **keys = xcalloc(count, sizeof(*keys));
+		data_t *d = data_set_dict(data_new());
+
+		for (int i = 0; i < count; i++)
+			keys[i] = xstrdup_printf("benchmark_key_%d", i);
+
+		START_TIMER;
+		for (int i = 0; i < count; i++)
+			data_set_int(data_key_set(d, keys[i]), i);
+		END_TIMER;
+		insert_usec = DELTA_TIMER;
+
+		START_TIMER;
+		for (int i = 0; i < lookups; i++) {
+			const int k = ((uint64_t) i * 7919) % count;
+
+			ck_assert(data_get_int(data_key_get(d, keys[k])) == k);
+		}
+		END_TIMER;
+		lookup_usec = DELTA_TIMER;
+
+		info("%s: %d keys: insert %.3f usec/key lookup %.3f usec/key",
+		     __func__, count, ((double) insert_usec / count),
+		     ((double) lookup_usec / lookups));
+
+		FREE_NULL_DATA(d);
+		for (int i = 0; i < count; i++)
+			xfree(keys[i]);
+		xfree(keys);
+	}
+}
+END_TEST
+
+START_TEST(test_arena_benchmark)
+{
+	const int count = 1000000;
+
+	for (int arena = 0; arena < 2; arena++) {
+		DEF_TIMERS;
+		long build_usec, free_usec;
+		data_t *d = (arena ? data_new_arena() : data_new());
+
+		data_set_list(d);
+
+		START_TIMER;
+		for (int i = 0; i < count; i++) {
+			data_t *entry = data_set_dict(data_list_append(d));
+
+			data_set_int(data_key_set(entry, "job_id"), i);
+			data_set_string(data_key_set(entry, "name"), "benchmark");
+			data_set_string(data_key_set(entry, "partition"),
+					"debug");
+			data_set_bool(data_key_set(entry, "requeue"), true);
+		}
+		END_TIMER;
+		build_usec = DELTA_TIMER;
+
+		START_TIMER;
+		FREE_NULL_DATA(d);
+		END_TIMER;
+		free_usec = DELTA_TIMER;
+
+		info("%s: %s: %d dictionaries: build %.3f usec/dict free %.3f usec/dict",
+		     __func__, (arena ? "arena" : "heap"), count,
+		     ((double) build_usec / count),
+		     ((double) free_usec / count));
+	}
+}
+END_TEST
+
 START_TEST(test_dict_typeset)
 {
 	data_t *d = data_new();
@@ -342,8 +605,18 @@ Suite *suite_data(void)
 	tcase_add_test(tc_core, test_dict_typeset);
 	tcase_add_test(tc_core, test_dict_iteration);
 	tcase_add_test(tc_core, test_list_iteration);
+	tcase_add_test(tc_core, test_dict_large);
+	tcase_add_test(tc_core, test_arena);
+
+	suite_add_tcase(s, tc_core);
 
+	/* benchmark is only informational but gets its own time limit */
+	tc_core = tcase_create("Benchmark");
+	tcase_set_timeout(tc_core, 300);
+	tcase_add_test(tc_core, test_dict_large_benchmark);
+	tcase_add_test(tc_core, test_arena_benchmark);
 	suite_add_tcase(s, tc_core);
+
 	return s;
 }
 
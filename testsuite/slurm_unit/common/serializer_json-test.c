@@ -0,0 +1,439 @@
+/*****************************************************************************\
+ *  serializer_json-test.c - compare JSON parser against json-c
+ *****************************************************************************
+ *  Copyright (C) SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if HAVE_JSON_C_INC
+#include <json-c/json.h>
+#else
+#include <json/json.h>
+#endif
+
+/* test parser directly as plugins are not installed yet */
+#include "src/plugins/serializer/json/serializer_json.c"
+
+#include "src/common/timers.h"
+
+#define FUZZ_ITERATIONS 200000
+
+static const char *valid[] = {
+	"{}",
+	"[]",
+	"null",
+	"true",
+	"False",
+	"NULL",
+	"0",
+	"-0",
+	"12345",
+	"-9223372036854775808",
+	"9223372036854775807",
+	"99999999999999999999",
+	"-99999999999999999999",
+	"1.5",
+	"-2.25e10",
+	"1E-5",
+	"\"\"",
+	"\"simple\"",
+	"\"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t\"",
+	"\"unicode \\u00e9 \\u20ac \\ud83d\\ude00\"",
+	"\"lone \\ud83d surrogate\"",
+	"\"lone \\ude00 low\"",
+	"\"pair \\ud83d\\u0041 broken\"",
+	"'single quoted'",
+	"[1, 2, 3,]",
+	"{\"a\": 1,}",
+	"  \n\t{ \"a\" : [ 1 , { \"b\" : null } ] }  ",
+	"{\"a\": 1, \"a\": 2, \"b\": 3}",
+	"{\"\": 1, \"c\": 2}",
+	"/* comment */ [1, // line comment\n 2]",
+	"[true, false, null, \"x\", 1, 1.25, [], {}]",
+	"{\"job\": {\"name\": \"test\", \"nodes\": \"1-4\", \"environment\": [\"PATH=/bin:/usr/bin\", \"HOME=/tmp\"], \"time_limit\": 60}}",
+	"[1] trailing",
+	"[[[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]]]",
+};
+
+static const char *invalid[] = {
+	"",
+	"   ",
+	"{",
+	"[1, 2",
+	"{\"a\" 1}",
+	"{\"a\": }",
+	"{a: 1}",
+	"[1 2]",
+	"[,1]",
+	"\"unterminated",
+	"\"bad escape \\x\"",
+	"\"bad unicode \\u12G4\"",
+	"tru",
+	"nul",
+	"-",
+	"/* unterminated comment",
+};
+
+static data_t *_json_c_to_data(json_object *jobj, data_t *d)
+{
+	switch (json_object_get_type(jobj)) {
+	case json_type_null:
+		data_set_null(d);
+		break;
+	case json_type_boolean:
+		data_set_bool(d, json_object_get_boolean(jobj));
+		break;
+	case json_type_double:
+		data_set_float(d, json_object_get_double(jobj));
+		break;
+	case json_type_int:
+		data_set_int(d, json_object_get_int64(jobj));
+		break;
+	case json_type_object:
+	{
+		struct json_object_iterator i = json_object_iter_begin(jobj);
+		struct json_object_iterator end = json_object_iter_end(jobj);
+
+		data_set_dict(d);
+
+		for (; !json_object_iter_equal(&i, &end);
+		     json_object_iter_next(&i)) {
+			const char *key = json_object_iter_peek_name(&i);
+
+			/* data_t does not allow empty keys */
+			if (key[0])
+				_json_c_to_data(json_object_iter_peek_value(&i),
+						data_key_set(d, key));
+		}
+		break;
+	}
+	case json_type_array:
+		data_set_list(d);
+		for (size_t i = 0; i < json_object_array_length(jobj); i++)
+			_json_c_to_data(json_object_array_get_idx(jobj, i),
+					data_list_append(d));
+		break;
+	case json_type_string:
+		data_set_string(d, json_object_get_string(jobj));
+		break;
+	default:
+		ck_abort_msg("unknown JSON type");
+	}
+
+	return d;
+}
+
+/* parse with json-c and convert the same way the plugin used to */
+static data_t *_parse_json_c(const char *src)
+{
+	data_t *data = NULL;
+	struct json_tokener *tok = json_tokener_new();
+	/* include terminator to end top level numbers and literals */
+	json_object *jobj = json_tokener_parse_ex(tok, src, (strlen(src) + 1));
+
+	/* json-c returns NULL for a valid null document */
+	if (json_tokener_get_error(tok) == json_tokener_success)
+		data = _json_c_to_data(jobj, data_new());
+	json_object_put(jobj);
+
+	json_tokener_free(tok);
+	return data;
+}
+
+static data_t *_parse(const char *src)
+{
+	data_t *data = NULL;
+
+	ck_assert(!serialize_p_string_to_data(&data, src, strlen(src)));
+
+	return data;
+}
+
+static char *_dump(const data_t *data)
+{
+	char *str = NULL;
+
+	if (!data)
+		return xstrdup("(rejected)");
+
+	ck_assert(!serialize_p_data_to_string(&str, NULL, data,
+					      SER_FLAGS_COMPACT));
+	return str;
+}
+
+/* Returns true if both parsers gave same result */
+static bool _compare(const char *src, bool *accepted, bool *json_c_accepted)
+{
+	data_t *a = _parse(src);
+	data_t *b = _parse_json_c(src);
+	char *sa = _dump(a);
+	char *sb = _dump(b);
+	bool match = !xstrcmp(sa, sb);
+
+	if (accepted)
+		*accepted = !!a;
+	if (json_c_accepted)
+		*json_c_accepted = !!b;
+
+	if (!match && a && b)
+		error("%s: mismatch for %s: %s != %s", __func__, src, sa, sb);
+
+	FREE_NULL_DATA(a);
+	FREE_NULL_DATA(b);
+	xfree(sa);
+	xfree(sb);
+
+	return match;
+}
+
+START_TEST(test_valid)
+{
+	for (int i = 0; i < ARRAY_SIZE(valid); i++) {
+		bool accepted = false, json_c_accepted = false;
+
+		ck_assert_msg(_compare(valid[i], &accepted, &json_c_accepted),
+			      "mismatch parsing: %s", valid[i]);
+		ck_assert_msg(accepted && json_c_accepted,
+			      "rejected: %s", valid[i]);
+	}
+}
+END_TEST
+
+START_TEST(test_invalid)
+{
+	for (int i = 0; i < ARRAY_SIZE(invalid); i++) {
+		bool accepted = true, json_c_accepted = true;
+
+		ck_assert_msg(_compare(invalid[i], &accepted, &json_c_accepted),
+			      "mismatch parsing: %s", invalid[i]);
+		ck_assert_msg(!accepted && !json_c_accepted,
+			      "accepted: %s", invalid[i]);
+	}
+}
+END_TEST
+
+START_TEST(test_depth)
+{
+	char *deep = NULL;
+	data_t *data = NULL;
+
+	for (int i = 0; i <= READER_MAX_DEPTH; i++)
+		xstrcat(deep, "[");
+
+	ck_assert(!serialize_p_string_to_data(&data, deep, strlen(deep)));
+	ck_assert(!data);
+	xfree(deep);
+}
+END_TEST
+
+START_TEST(test_length)
+{
+	const char *src = "[1, 2] [3]";
+	data_t *data = NULL;
+
+	/* only the given length is parsed */
+	ck_assert(!serialize_p_string_to_data(&data, src, 4));
+	ck_assert(!data);
+
+	ck_assert(!serialize_p_string_to_data(&data, src, 6));
+	ck_assert(data_get_list_length(data) == 2);
+	FREE_NULL_DATA(data);
+}
+END_TEST
+
+static uint64_t _rand(uint64_t *state)
+{
+	/* xorshift64 keeps the fuzzing reproducible */
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+/*
+ * Randomly mutate valid documents and verify that the parser never crashes
+ * and that any document accepted by both parsers gives the same data. json-c
+ * is more lenient with malformed numbers (it parses the valid prefix) so
+ * documents only accepted by one parser are counted but not fatal.
+ */
+START_TEST(test_fuzz)
+{
+	static const char chars[] = "{}[]:,\"'\\/*-+.eE019uatfnlIN \n";
+	uint64_t state = 0x2545F4914F6CDD1DULL;
+	int both = 0, neither = 0, only = 0, only_json_c = 0;
+	log_options_t log_opts = LOG_OPTS_INITIALIZER;
+
+	/* avoid logging every parsing error */
+	log_opts.stderr_level = LOG_LEVEL_FATAL;
+	log_alter(log_opts, 0, NULL);
+
+	for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+		const char *seed = valid[_rand(&state) % ARRAY_SIZE(valid)];
+		int mutations = 1 + (_rand(&state) % 3);
+		char *src = xstrdup(seed);
+		bool accepted, json_c_accepted;
+
+		for (int m = 0; m < mutations; m++) {
+			size_t len = strlen(src);
+			size_t pos = len ? (_rand(&state) % len) : 0;
+			char c = chars[_rand(&state) % (sizeof(chars) - 1)];
+
+			switch (_rand(&state) % 3) {
+			case 0: /* replace */
+				if (len)
+					src[pos] = c;
+				break;
+			case 1: /* insert */
+			{
+				char *n = xstrdup_printf("%.*s%c%s", (int) pos,
+							 src, c, (src + pos));
+				xfree(src);
+				src = n;
+				break;
+			}
+			case 2: /* delete */
+				if (len)
+					memmove((src + pos), (src + pos + 1),
+						(len - pos));
+				break;
+			}
+		}
+
+		if (!_compare(src, &accepted, &json_c_accepted))
+			ck_assert_msg(!accepted || !json_c_accepted,
+				      "mismatch parsing: %s", src);
+
+		if (accepted && json_c_accepted)
+			both++;
+		else if (accepted)
+			only++;
+		else if (json_c_accepted)
+			only_json_c++;
+		else
+			neither++;
+
+		xfree(src);
+	}
+
+	log_opts.stderr_level = LOG_LEVEL_INFO;
+	log_alter(log_opts, 0, NULL);
+
+	info("%s: %d mutations: accepted by both:%d neither:%d only parser:%d only json-c:%d",
+	     __func__, FUZZ_ITERATIONS, both, neither, only, only_json_c);
+}
+END_TEST
+
+START_TEST(test_benchmark)
+{
+	const int count = 100000;
+	char *src = NULL, *pos = NULL;
+	long parse_usec, json_c_usec;
+	data_t *data;
+	DEF_TIMERS;
+
+	xstrcatat(src, &pos, "{\"jobs\": [");
+	for (int i = 0; i < count; i++)
+		xstrfmtcatat(src, &pos, "%s{\"job_id\": %d, \"name\": \"benchmark \\u00e9 %d\", \"partition\": \"debug\", \"requeue\": true, \"time_limit\": %d.5, \"nodes\": [\"node%d\", \"node%d\"]}",
+			     (i ? ", " : ""), i, i, i, i, (i + 1));
+	xstrcatat(src, &pos, "]}");
+
+	START_TIMER;
+	data = _parse(src);
+	END_TIMER;
+	parse_usec = DELTA_TIMER;
+	ck_assert(data);
+	FREE_NULL_DATA(data);
+
+	START_TIMER;
+	data = _parse_json_c(src);
+	END_TIMER;
+	json_c_usec = DELTA_TIMER;
+	ck_assert(data);
+	FREE_NULL_DATA(data);
+
+	info("%s: %zu bytes: parser %ld usec json-c %ld usec",
+	     __func__, strlen(src), parse_usec, json_c_usec);
+
+	xfree(src);
+}
+END_TEST
+
+Suite *suite_serializer_json(void)
+{
+	Suite *s = suite_create("Serializer JSON");
+	TCase *tc_core = tcase_create("Parse");
+
+	tcase_add_test(tc_core, test_valid);
+	tcase_add_test(tc_core, test_invalid);
+	tcase_add_test(tc_core, test_depth);
+	tcase_add_test(tc_core, test_length);
+	tcase_add_test(tc_core, test_fuzz);
+	tcase_set_timeout(tc_core, 300);
+	suite_add_tcase(s, tc_core);
+
+	tc_core = tcase_create("Benchmark");
+	tcase_set_timeout(tc_core, 300);
+	tcase_add_test(tc_core, test_benchmark);
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
+
+int main(void)
+{
+	int number_failed;
+	log_options_t log_opts = LOG_OPTS_INITIALIZER;
+
+	log_opts.stderr_level = LOG_LEVEL_INFO;
+	log_init("serializer_json-test", log_opts, 0, NULL);
+
+	if (data_init()) {
+		error("data_init() failed");
+		return EXIT_FAILURE;
+	}
+
+	SRunner *sr = srunner_create(suite_serializer_json());
+
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	data_fini();
+	log_fini();
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}